@@ -0,0 +1,179 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Runtime.Intrinsics;
+using MSAgentAI.Acs;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// Image decompression and frame rendering throughput for the managed ACS reader, on a
+    /// synthetic character or a real .acs file
+    /// </summary>
+    public static class AcsRendering
+    {
+        public static void Run(int iterations, int warmup, string path)
+        {
+            CheckCompressionRoundTrip();
+
+            byte[] data = path != null ? File.ReadAllBytes(path) : AcsWriter.BuildCharacter(24, 24);
+            var file = AcsFile.Load(data);
+            var frames = new List<AcsFrame>();
+            foreach (var animation in file.Animations.Values)
+            {
+                frames.AddRange(animation.Frames);
+            }
+
+            Console.WriteLine($"ACS decode and render, .NET {Environment.Version} on {System.Runtime.InteropServices.RuntimeInformation.OSDescription}");
+            Console.WriteLine($"Character: {(path != null ? Path.GetFileName(path) : "synthetic")}, {file.Width}x{file.Height}, {file.ImageCount} images, {file.Animations.Count} animations, {frames.Count} frames, {data.Length / 1024} KB");
+            Console.WriteLine($"SIMD: Vector128 {(Vector128.IsHardwareAccelerated ? "accelerated" : "not accelerated, 64-bit word path")}");
+            Console.WriteLine();
+
+            Console.WriteLine("| Stage                           |     count |    seconds |        per s |       MB/s |");
+            Console.WriteLine("|---------------------------------|----------:|-----------:|-------------:|-----------:|");
+            Console.WriteLine(MeasureDecode(data, Math.Max(1, iterations / Math.Max(1, file.ImageCount)), Math.Max(1, warmup / Math.Max(1, file.ImageCount))));
+
+            var renderer = new AcsRenderer(file);
+            var reference = new ReferenceRenderer(file);
+            CheckRender(frames, renderer, reference);
+
+            int pixels = file.Width * file.Height;
+            Console.WriteLine(MeasureRender("Render, per-pixel reference", frames, iterations, warmup, pixels, (frame, mouth) => reference.Render(frame, mouth)));
+            var output = new uint[pixels];
+            Console.WriteLine(MeasureRender("Render, AcsRenderer", frames, iterations, warmup, pixels, (frame, mouth) => renderer.Render(frame, output, mouth)));
+            Console.WriteLine(MeasureRender("Compose only (indices)", frames, iterations, warmup, pixels, (frame, mouth) => renderer.Compose(frame, mouth)));
+        }
+
+        private static string MeasureDecode(byte[] data, int rounds, int warmupRounds)
+        {
+            long images = 0, bytes = 0;
+            Stopwatch stopwatch = null;
+            for (int round = 0; round < warmupRounds + rounds; round++)
+            {
+                if (round == warmupRounds)
+                {
+                    images = 0;
+                    bytes = 0;
+                    stopwatch = Stopwatch.StartNew();
+                }
+
+                // A fresh file each round, since images are cached once decoded
+                var file = AcsFile.Load(data);
+                for (int i = 0; i < file.ImageCount; i++)
+                {
+                    var image = file.GetImage(i);
+                    images++;
+                    bytes += image.Pixels.Length;
+                }
+            }
+            return Row("Decode images", images, stopwatch.Elapsed.TotalSeconds, bytes);
+        }
+
+        private static string MeasureRender(string name, List<AcsFrame> frames, int iterations, int warmup, int pixels, Action<AcsFrame, AcsMouthShape?> render)
+        {
+            Stopwatch stopwatch = null;
+            for (int i = 0; i < warmup + iterations; i++)
+            {
+                if (i == warmup)
+                {
+                    stopwatch = Stopwatch.StartNew();
+                }
+
+                // Every other frame is drawn speaking, with a mouth overlay
+                render(frames[i % frames.Count], i % 2 == 0 ? (AcsMouthShape?)null : (AcsMouthShape)(i / 2 % 7));
+            }
+            return Row(name, iterations, stopwatch.Elapsed.TotalSeconds, (long)iterations * pixels * 4);
+        }
+
+        private static string Row(string name, long count, double seconds, long bytes)
+        {
+            return string.Format(CultureInfo.InvariantCulture, "| {0,-31} | {1,9} | {2,10:F3} | {3,12:N0} | {4,10:F1} |",
+                name, count, seconds, count / seconds, bytes / seconds / 1e6);
+        }
+
+        private static void CheckCompressionRoundTrip()
+        {
+            var random = new Random(7);
+            foreach (int size in new[] { 1, 7, 64, 1000, 70000 })
+            {
+                var original = new byte[size];
+                for (int i = 0; i < size; i++)
+                {
+                    // Mix of runs, repeats and noise, with repeats far enough back for 20-bit offsets
+                    original[i] = i > 6000 && i % 3 == 0 ? original[i - 5000] : random.Next(4) == 0 ? (byte)random.Next(256) : (byte)(i / 50);
+                }
+                var compressed = AcsWriter.Compress(original);
+                var decoded = new byte[size];
+                int written = AcsDecompressor.Decompress(compressed, 0, compressed.Length, decoded);
+                if (written != size || !original.AsSpan().SequenceEqual(decoded))
+                    throw new InvalidOperationException($"Compression round trip failed for {size} bytes");
+            }
+        }
+
+        private static void CheckRender(List<AcsFrame> frames, AcsRenderer renderer, ReferenceRenderer reference)
+        {
+            var output = new uint[renderer.Width * renderer.Height];
+            for (int i = 0; i < frames.Count * 2; i++)
+            {
+                AcsMouthShape? mouth = i % 2 == 0 ? null : (AcsMouthShape)(i % 7);
+                renderer.Render(frames[i / 2], output, mouth);
+                if (!reference.Render(frames[i / 2], mouth).AsSpan().SequenceEqual(output))
+                    throw new InvalidOperationException($"AcsRenderer and the reference differ on frame {i / 2}");
+            }
+        }
+
+        /// <summary>
+        /// The obvious implementation: every layer straight to 32-bit pixels, one pixel at a time
+        /// </summary>
+        private sealed class ReferenceRenderer
+        {
+            private readonly AcsFile _file;
+            private readonly uint[] _pixels;
+
+            public ReferenceRenderer(AcsFile file)
+            {
+                _file = file;
+                _pixels = new uint[file.Width * file.Height];
+            }
+
+            public uint[] Render(AcsFrame frame, AcsMouthShape? mouth)
+            {
+                uint clear = _file.Palette[_file.TransparentIndex];
+                for (int i = 0; i < _pixels.Length; i++)
+                {
+                    _pixels[i] = clear;
+                }
+
+                var overlay = mouth.HasValue ? frame.FindOverlay(mouth.Value) : null;
+                int last = overlay != null && overlay.ReplacesTopImage ? 1 : 0;
+                for (int i = frame.Images.Count - 1; i >= last; i--)
+                {
+                    Draw(_file.GetImage(frame.Images[i].ImageIndex), frame.Images[i].X, frame.Images[i].Y);
+                }
+                if (overlay != null)
+                {
+                    Draw(_file.GetImage(overlay.ImageIndex), overlay.X, overlay.Y);
+                }
+                return _pixels;
+            }
+
+            private void Draw(AcsImage image, int left, int top)
+            {
+                for (int y = 0; y < image.Height; y++)
+                {
+                    for (int x = 0; x < image.Width; x++)
+                    {
+                        int tx = left + x, ty = top + y;
+                        byte index = image.Pixels[y * image.Width + x];
+                        if (tx >= 0 && ty >= 0 && tx < _file.Width && ty < _file.Height && index != _file.TransparentIndex)
+                        {
+                            _pixels[ty * _file.Width + tx] = _file.Palette[index];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,394 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// Builds synthetic ACS characters so the decoder and renderer can be measured without
+    /// Agent's character files, which can't be redistributed. Images are compressed with a
+    /// greedy encoder for the same bit stream AcsDecompressor reads.
+    /// </summary>
+    public static class AcsWriter
+    {
+        public const int Size = 128;
+        private const byte Transparent = 0xFE;
+
+        /// <summary>
+        /// A 128x128 character with bodies, arms and mouth overlays, and animations that use
+        /// branches, exit frames and overlays
+        /// </summary>
+        public static byte[] BuildCharacter(int animationCount, int framesPerAnimation, int seed = 1)
+        {
+            var random = new Random(seed);
+            var images = new List<(int Width, int Height, byte[] Pixels)>();
+
+            // Bodies fill most of the frame; arms and mouths are small layers on top
+            for (int i = 0; i < 16; i++)
+            {
+                images.Add((Size, Size, Blob(Size, Size, 0.45 + 0.02 * (i % 4), random)));
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                images.Add((40, 56, Blob(40, 56, 0.4, random)));
+            }
+            int firstMouth = images.Count;
+            for (int i = 0; i < 7; i++)
+            {
+                images.Add((24, 12, Blob(24, 12, 0.5, random)));
+            }
+
+            var animations = new List<byte[]>();
+            var names = new List<string>();
+            for (int a = 0; a < animationCount; a++)
+            {
+                names.Add($"ANIM{a}");
+                animations.Add(Animation($"Anim{a}", framesPerAnimation, firstMouth, random));
+            }
+
+            return Assemble(images, names, animations);
+        }
+
+        private static byte[] Blob(int width, int height, double radius, Random random)
+        {
+            var pixels = new byte[width * height];
+            double cx = width / 2.0, cy = height / 2.0;
+            byte baseColor = (byte)random.Next(16, 200);
+            for (int y = 0; y < height; y++)
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    double dx = (x - cx) / width, dy = (y - cy) / height;
+                    double distance = Math.Sqrt(dx * dx + dy * dy);
+                    if (distance > radius)
+                    {
+                        pixels[y * width + x] = Transparent;
+                    }
+                    else
+                    {
+                        // Shading bands with a little dither, like hand-drawn sprites
+                        int band = (int)(distance * 12);
+                        pixels[y * width + x] = (byte)(baseColor + band + (random.Next(8) == 0 ? 1 : 0));
+                    }
+                }
+            }
+            return pixels;
+        }
+
+        private static byte[] Animation(string name, int frameCount, int firstMouth, Random random)
+        {
+            using (var stream = new MemoryStream())
+            using (var writer = new BinaryWriter(stream))
+            {
+                WriteString(writer, name);
+                writer.Write((byte)1);
+                WriteString(writer, string.Empty);
+                writer.Write((ushort)frameCount);
+                for (int f = 0; f < frameCount; f++)
+                {
+                    // Arm, then body: the list is topmost first
+                    writer.Write((ushort)2);
+                    writer.Write(16 + random.Next(16));
+                    writer.Write((short)(random.Next(2) == 0 ? -8 : 96));
+                    writer.Write((short)(30 + random.Next(20)));
+                    writer.Write(random.Next(16));
+                    writer.Write((short)0);
+                    writer.Write((short)0);
+
+                    writer.Write((ushort)0xFFFF);
+                    writer.Write((ushort)10);
+                    writer.Write((short)(f + 1 < frameCount ? frameCount - 1 : -1));
+
+                    bool branch = f > 0 && f % 4 == 0;
+                    writer.Write((byte)(branch ? 1 : 0));
+                    if (branch)
+                    {
+                        writer.Write((ushort)(f - 2));
+                        writer.Write((ushort)50);
+                    }
+
+                    writer.Write((byte)7);
+                    for (int m = 0; m < 7; m++)
+                    {
+                        writer.Write((byte)m);
+                        writer.Write((byte)0);
+                        writer.Write((ushort)(firstMouth + m));
+                        writer.Write((byte)0);
+                        writer.Write((byte)0);
+                        writer.Write((short)52);
+                        writer.Write((short)70);
+                        writer.Write((ushort)24);
+                        writer.Write((ushort)12);
+                    }
+                }
+                writer.Flush();
+                return stream.ToArray();
+            }
+        }
+
+        private static byte[] Assemble(List<(int Width, int Height, byte[] Pixels)> images, List<string> names, List<byte[]> animations)
+        {
+            using (var stream = new MemoryStream())
+            using (var writer = new BinaryWriter(stream))
+            {
+                writer.Write(0xABCDABC3);
+                writer.Write(new byte[32]);
+
+                long localized = stream.Position;
+                writer.Write((ushort)1);
+                writer.Write((ushort)0x0409);
+                WriteString(writer, "Bench");
+                WriteString(writer, "Synthetic benchmark character");
+                WriteString(writer, string.Empty);
+                long localizedEnd = stream.Position;
+
+                long character = stream.Position;
+                writer.Write((ushort)0);
+                writer.Write((ushort)2);
+                writer.Write((uint)localized);
+                writer.Write((uint)(localizedEnd - localized));
+                writer.Write(Guid.NewGuid().ToByteArray());
+                writer.Write((ushort)Size);
+                writer.Write((ushort)Size);
+                writer.Write(Transparent);
+                writer.Write(0x200u);
+                writer.Write((ushort)2);
+                writer.Write((ushort)0);
+
+                // Word balloon
+                writer.Write((byte)2);
+                writer.Write((byte)32);
+                writer.Write(0u);
+                writer.Write(0x00E1FFFFu);
+                writer.Write(0u);
+                WriteString(writer, "Tahoma");
+                writer.Write(-13);
+                writer.Write(400);
+                writer.Write((byte)0);
+                writer.Write((byte)0);
+
+                writer.Write(256u);
+                for (int i = 0; i < 256; i++)
+                {
+                    writer.Write((byte)(i * 3));
+                    writer.Write((byte)(i * 5));
+                    writer.Write((byte)(i * 7));
+                    writer.Write((byte)0);
+                }
+                writer.Write((byte)0);
+                writer.Write((ushort)1);
+                WriteString(writer, "Speaking");
+                writer.Write((ushort)1);
+                WriteString(writer, names[0]);
+                long characterEnd = stream.Position;
+
+                var animationLocators = new List<(long, long)>();
+                foreach (var animation in animations)
+                {
+                    animationLocators.Add((stream.Position, animation.Length));
+                    writer.Write(animation);
+                }
+                long animationList = stream.Position;
+                writer.Write((uint)animations.Count);
+                for (int i = 0; i < animations.Count; i++)
+                {
+                    WriteString(writer, names[i]);
+                    writer.Write((uint)animationLocators[i].Item1);
+                    writer.Write((uint)animationLocators[i].Item2);
+                }
+                long animationListEnd = stream.Position;
+
+                var imageLocators = new List<(long, long)>();
+                foreach (var image in images)
+                {
+                    long start = stream.Position;
+                    int stride = (image.Width + 3) & ~3;
+                    var bottomUp = new byte[stride * image.Height];
+                    for (int y = 0; y < image.Height; y++)
+                    {
+                        Buffer.BlockCopy(image.Pixels, y * image.Width, bottomUp, (image.Height - 1 - y) * stride, image.Width);
+                    }
+                    byte[] compressed = Compress(bottomUp);
+
+                    writer.Write((byte)0);
+                    writer.Write((ushort)image.Width);
+                    writer.Write((ushort)image.Height);
+                    writer.Write((byte)1);
+                    writer.Write(compressed.Length);
+                    writer.Write(compressed);
+                    writer.Write(0u);
+                    writer.Write(0u);
+                    imageLocators.Add((start, stream.Position - start));
+                }
+                long imageList = stream.Position;
+                writer.Write((uint)images.Count);
+                foreach (var locator in imageLocators)
+                {
+                    writer.Write((uint)locator.Item1);
+                    writer.Write((uint)locator.Item2);
+                    writer.Write(0u);
+                }
+                long imageListEnd = stream.Position;
+
+                long audioList = stream.Position;
+                writer.Write(0u);
+                long audioListEnd = stream.Position;
+
+                stream.Position = 4;
+                foreach (var (start, end) in new[] { (character, characterEnd), (animationList, animationListEnd), (imageList, imageListEnd), (audioList, audioListEnd) })
+                {
+                    writer.Write((uint)start);
+                    writer.Write((uint)(end - start));
+                }
+                writer.Flush();
+                return stream.ToArray();
+            }
+        }
+
+        private static void WriteString(BinaryWriter writer, string value)
+        {
+            writer.Write((uint)value.Length);
+            if (value.Length > 0)
+            {
+                writer.Write(Encoding.Unicode.GetBytes(value));
+                writer.Write((ushort)0);
+            }
+        }
+
+        /// <summary>
+        /// Greedy LZ77 with a 3-byte hash, emitting Agent's bit stream
+        /// </summary>
+        public static byte[] Compress(byte[] data)
+        {
+            var bits = new BitWriter();
+            var last = new Dictionary<int, int>();
+            int position = 0;
+            while (position < data.Length)
+            {
+                int bestLength = 0, bestDistance = 0;
+                if (position + 3 <= data.Length)
+                {
+                    int key = data[position] | data[position + 1] << 8 | data[position + 2] << 16;
+                    if (last.TryGetValue(key, out int candidate) && position - candidate <= 4673 + 0xFFFFE)
+                    {
+                        int length = 0;
+                        while (position + length < data.Length && length < 4096 && data[candidate + length] == data[position + length])
+                        {
+                            length++;
+                        }
+                        bestLength = length;
+                        bestDistance = position - candidate;
+                    }
+                    // Runs are cheapest as a copy from one byte back
+                    if (position > 0 && data[position - 1] == data[position])
+                    {
+                        int length = 0;
+                        while (position + length < data.Length && length < 4096 && data[position - 1 + length] == data[position + length])
+                        {
+                            length++;
+                        }
+                        if (length >= bestLength)
+                        {
+                            bestLength = length;
+                            bestDistance = 1;
+                        }
+                    }
+                    last[key] = position;
+                }
+
+                int minimum = bestDistance > 4672 ? 3 : 2;
+                if (bestLength >= minimum)
+                {
+                    WriteMatch(bits, bestDistance, bestLength);
+                    position += bestLength;
+                }
+                else
+                {
+                    bits.Write(0, 1);
+                    bits.Write(data[position], 8);
+                    position++;
+                }
+            }
+
+            bits.Write(1, 1);
+            bits.Write(0b111, 3);
+            bits.Write(0xFFFFF, 20);
+            return bits.ToArray();
+        }
+
+        private static void WriteMatch(BitWriter bits, int distance, int length)
+        {
+            bits.Write(1, 1);
+            if (distance <= 64)
+            {
+                bits.Write(0b0, 1);
+                bits.Write((uint)(distance - 1), 6);
+                length -= 2;
+            }
+            else if (distance <= 576)
+            {
+                bits.Write(0b01, 2);
+                bits.Write((uint)(distance - 65), 9);
+                length -= 2;
+            }
+            else if (distance <= 4672)
+            {
+                bits.Write(0b011, 3);
+                bits.Write((uint)(distance - 577), 12);
+                length -= 2;
+            }
+            else
+            {
+                bits.Write(0b111, 3);
+                bits.Write((uint)(distance - 4673), 20);
+                length -= 3;
+            }
+
+            int ones = 0;
+            while (ones < 11 && length >= (1 << (ones + 1)) - 1)
+            {
+                ones++;
+            }
+            bits.Write((uint)((1 << ones) - 1), ones);
+            if (ones < 11)
+            {
+                bits.Write(0, 1);
+            }
+            bits.Write((uint)(length - ((1 << ones) - 1)), ones);
+        }
+
+        /// <summary>
+        /// Writes values least significant bit first, after the leading zero byte
+        /// </summary>
+        private sealed class BitWriter
+        {
+            private readonly List<byte> _bytes = new List<byte> { 0 };
+            private ulong _pending;
+            private int _count;
+
+            public void Write(uint value, int count)
+            {
+                _pending |= (ulong)value << _count;
+                _count += count;
+                while (_count >= 8)
+                {
+                    _bytes.Add((byte)_pending);
+                    _pending >>= 8;
+                    _count -= 8;
+                }
+            }
+
+            public byte[] ToArray()
+            {
+                if (_count > 0)
+                {
+                    _bytes.Add((byte)_pending);
+                    _pending = 0;
+                    _count = 0;
+                }
+                return _bytes.ToArray();
+            }
+        }
+    }
+}
@@ -0,0 +1,149 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading.Tasks;
+using MSAgentAI.Client;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// PING throughput over TCP with PipelineClient, against the connect-per-command pattern
+    /// most integrations use today
+    /// </summary>
+    public static class ClientThroughput
+    {
+        private const int InFlight = 64;
+
+        public static async Task RunAsync(int iterations, int warmup, int port)
+        {
+            // Each connection leaves a socket in TIME_WAIT, so keep this one small enough to rerun
+            int connectIterations = Math.Min(iterations, 5000);
+
+            using (var server = new PipelineServer("TCP", "127.0.0.1", port, PipelineServer.PipeName))
+            {
+                server.Start();
+                await Task.Delay(200);
+
+                Console.WriteLine($"PING throughput, {iterations} commands after {warmup} warmup, .NET {Environment.Version} on {System.Runtime.InteropServices.RuntimeInformation.OSDescription}");
+                Console.WriteLine();
+                Console.WriteLine("| Pattern                         |  commands |    seconds |   commands/s | us/command |");
+                Console.WriteLine("|---------------------------------|----------:|-----------:|-------------:|-----------:|");
+
+                Console.WriteLine(await MeasureAsync("Connect per command", connectIterations, Math.Min(warmup, 500),
+                    count => ConnectPerCommandAsync(port, count)));
+
+                var options = PipelineClientOptions.ForTcp("127.0.0.1", port);
+                using (var client = new PipelineClient(options))
+                {
+                    Console.WriteLine(await MeasureAsync("PipelineClient, one at a time", iterations, warmup,
+                        count => SequentialAsync(client, count)));
+                    Console.WriteLine(await MeasureAsync($"PipelineClient, {InFlight} in flight", iterations, warmup,
+                        count => PipelinedAsync(client, count)));
+                    Console.WriteLine(await MeasureAsync($"PipelineClient, batches of {InFlight}", iterations, warmup,
+                        count => BatchedAsync(client, count)));
+                }
+
+                options.PoolSize = 4;
+                using (var pooled = new PipelineClient(options))
+                {
+                    await pooled.ConnectAsync();
+                    Console.WriteLine(await MeasureAsync($"Pool of 4, {InFlight} in flight", iterations, warmup,
+                        count => PipelinedAsync(pooled, count)));
+                }
+
+                Console.WriteLine();
+                Console.WriteLine($"Server: {server.GetStats()}");
+            }
+        }
+
+        private static async Task<string> MeasureAsync(string name, int iterations, int warmup, Func<int, Task> run)
+        {
+            await run(warmup);
+
+            var stopwatch = Stopwatch.StartNew();
+            await run(iterations);
+            stopwatch.Stop();
+
+            return string.Format(CultureInfo.InvariantCulture, "| {0,-31} | {1,9} | {2,10:F3} | {3,12:N0} | {4,10:F1} |",
+                name, iterations, stopwatch.Elapsed.TotalSeconds, iterations / stopwatch.Elapsed.TotalSeconds,
+                stopwatch.Elapsed.TotalMilliseconds * 1000 / iterations);
+        }
+
+        /// <summary>
+        /// What the PIPELINE.md examples do: open, send one line, read one line, close
+        /// </summary>
+        private static async Task ConnectPerCommandAsync(int port, int count)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                using (var client = new TcpClient { NoDelay = true })
+                {
+                    await client.ConnectAsync("127.0.0.1", port);
+                    using (var stream = client.GetStream())
+                    using (var reader = new StreamReader(stream, Encoding.UTF8))
+                    using (var writer = new StreamWriter(stream, new UTF8Encoding(false)) { AutoFlush = true })
+                    {
+                        await writer.WriteLineAsync("PING");
+                        Expect(await reader.ReadLineAsync());
+                    }
+                }
+            }
+        }
+
+        private static async Task SequentialAsync(PipelineClient client, int count)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                Expect(await client.PingAsync());
+            }
+        }
+
+        /// <summary>
+        /// Keeps InFlight requests outstanding, starting a new one as each response arrives
+        /// </summary>
+        private static async Task PipelinedAsync(PipelineClient client, int count)
+        {
+            var window = new Queue<Task<string>>(InFlight);
+            for (int i = 0; i < count; i++)
+            {
+                if (window.Count == InFlight)
+                {
+                    Expect(await window.Dequeue());
+                }
+                window.Enqueue(client.PingAsync());
+            }
+            while (window.Count > 0)
+            {
+                Expect(await window.Dequeue());
+            }
+        }
+
+        private static async Task BatchedAsync(PipelineClient client, int count)
+        {
+            var batch = new List<string>(InFlight);
+            for (int sent = 0; sent < count; sent += batch.Count)
+            {
+                batch.Clear();
+                for (int i = 0; i < InFlight && sent + i < count; i++)
+                {
+                    batch.Add("PING");
+                }
+                foreach (var response in await client.SendBatchAsync(batch))
+                {
+                    Expect(response);
+                }
+            }
+        }
+
+        private static void Expect(string response)
+        {
+            if (response != "PONG")
+                throw new InvalidOperationException($"Expected PONG, got {response ?? "end of stream"}");
+        }
+    }
+}
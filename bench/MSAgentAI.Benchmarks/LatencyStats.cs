@@ -0,0 +1,79 @@
+using System;
+using System.Diagnostics;
+using System.Globalization;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// Collects round-trip samples and reports their distribution in microseconds
+    /// </summary>
+    public class LatencyStats
+    {
+        private readonly long[] _samples;
+        private int _count;
+
+        public LatencyStats(string name, int capacity)
+        {
+            Name = name;
+            _samples = new long[capacity];
+        }
+
+        public string Name { get; }
+        public int Count => _count;
+
+        /// <summary>
+        /// Records one sample measured with Stopwatch.GetTimestamp
+        /// </summary>
+        public void Add(long startTimestamp, long endTimestamp)
+        {
+            if (_count < _samples.Length)
+            {
+                _samples[_count++] = endTimestamp - startTimestamp;
+            }
+        }
+
+        public double Percentile(double p)
+        {
+            if (_count == 0)
+                return 0;
+
+            var sorted = new long[_count];
+            Array.Copy(_samples, sorted, _count);
+            Array.Sort(sorted);
+            int index = (int)Math.Ceiling(p / 100.0 * _count) - 1;
+            return ToMicroseconds(sorted[Math.Max(0, Math.Min(_count - 1, index))]);
+        }
+
+        public double Mean
+        {
+            get
+            {
+                if (_count == 0)
+                    return 0;
+
+                double total = 0;
+                for (int i = 0; i < _count; i++)
+                {
+                    total += _samples[i];
+                }
+                return ToMicroseconds(total / _count);
+            }
+        }
+
+        public static string Header =>
+            string.Format(CultureInfo.InvariantCulture, "| {0,-22} | {1,8} | {2,9} | {3,9} | {4,9} | {5,9} | {6,9} |",
+                "Transport", "n", "mean us", "p50 us", "p90 us", "p99 us", "max us") + Environment.NewLine +
+            "|------------------------|---------:|----------:|----------:|----------:|----------:|----------:|";
+
+        public override string ToString()
+        {
+            return string.Format(CultureInfo.InvariantCulture, "| {0,-22} | {1,8} | {2,9:F1} | {3,9:F1} | {4,9:F1} | {5,9:F1} | {6,9:F1} |",
+                Name, _count, Mean, Percentile(50), Percentile(90), Percentile(99), Percentile(100));
+        }
+
+        private static double ToMicroseconds(double ticks)
+        {
+            return ticks * 1_000_000.0 / Stopwatch.Frequency;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+using System;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// Benchmark runner. The first argument picks the suite; the rest are --name value options.
+    /// </summary>
+    public static class Program
+    {
+        private const string Usage =
+            "Usage: MSAgentAI.Benchmarks <suite> [options]\n" +
+            "\n" +
+            "Suites:\n" +
+            "  transport   PING round trip over TCP, WebSocket and HTTP, plus WebSocket event push\n" +
+            "  ring        One-way latency and throughput of the shared-memory ring against TCP and named pipe\n" +
+            "  client      PipelineClient throughput (sequential, pipelined, batched, pooled) against connect-per-command\n" +
+            "  acs         ACS image decompression and frame rendering (frames/sec), synthetic or --file\n" +
+            "  drain       Stop with a command running on TCP, HTTP and WebSocket; exits 1 if any is cut off\n" +
+            "\n" +
+            "Options:\n" +
+            "  --iterations N   Measured round trips per transport (default 20000)\n" +
+            "  --warmup N       Unmeasured round trips first (default 2000)\n" +
+            "  --port N         First of the ports used on 127.0.0.1 (default 18765)\n" +
+            "  --file PATH      Character for the acs suite (default: a generated one)";
+
+        public static async Task<int> Main(string[] args)
+        {
+            if (args.Length == 0)
+            {
+                Console.Error.WriteLine(Usage);
+                return 2;
+            }
+
+            int iterations = 20000;
+            int warmup = 2000;
+            int port = 18765;
+            string file = null;
+
+            try
+            {
+                for (int i = 1; i < args.Length; i++)
+                {
+                    string value = i + 1 < args.Length ? args[i + 1] : null;
+                    switch (args[i])
+                    {
+                        case "--iterations":
+                            iterations = ParsePositive(args[i], value);
+                            i++;
+                            break;
+                        case "--warmup":
+                            warmup = ParsePositive(args[i], value);
+                            i++;
+                            break;
+                        case "--port":
+                            port = ParsePositive(args[i], value);
+                            i++;
+                            break;
+                        case "--file":
+                            file = value ?? throw new ArgumentException("--file needs a path");
+                            i++;
+                            break;
+                        default:
+                            throw new ArgumentException($"Unknown option {args[i]}");
+                    }
+                }
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                Console.Error.WriteLine();
+                Console.Error.WriteLine(Usage);
+                return 2;
+            }
+
+            switch (args[0].ToLowerInvariant())
+            {
+                case "transport":
+                    await TransportLatency.RunAsync(iterations, warmup, port);
+                    return 0;
+
+                case "ring":
+                    await RingTransport.RunAsync(iterations, warmup, port);
+                    return 0;
+
+                case "client":
+                    await ClientThroughput.RunAsync(iterations, warmup, port);
+                    return 0;
+
+                case "acs":
+                    AcsRendering.Run(iterations, warmup, file);
+                    return 0;
+
+                case "drain":
+                    return await ShutdownDrain.RunAsync(port) ? 0 : 1;
+
+                default:
+                    Console.Error.WriteLine($"Unknown suite {args[0]}");
+                    Console.Error.WriteLine();
+                    Console.Error.WriteLine(Usage);
+                    return 2;
+            }
+        }
+
+        private static int ParsePositive(string name, string value)
+        {
+            if (!int.TryParse(value, out int result) || result <= 0)
+                throw new ArgumentException($"{name} needs a positive number");
+            return result;
+        }
+    }
+}
@@ -0,0 +1,259 @@
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.IO.Pipes;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// One-way delivery of BENCH:timestamp commands into PipelineServer.ProcessCommand over
+    /// the shared-memory ring, TCP and the named pipe. Latency is measured from just before the
+    /// send to the server raising OnCustomCommand; throughput from the first send to the last
+    /// command handled.
+    /// </summary>
+    public static class RingTransport
+    {
+        private static long _handled;
+        private static LatencyStats _current;
+
+        public static async Task RunAsync(int iterations, int warmup, int basePort)
+        {
+            bool windows = Environment.OSVersion.Platform == PlatformID.Win32NT;
+            string ringPath = windows ? null : Path.Combine(Path.GetTempPath(), $"msagentai-bench-{Environment.ProcessId}.ring");
+            string pipeName = $"MSAgentAI.Bench.{Environment.ProcessId}";
+
+            Console.WriteLine($"One-way delivery, {iterations} commands after {warmup} warmup, .NET {Environment.Version} on {System.Runtime.InteropServices.RuntimeInformation.OSDescription}, {Environment.ProcessorCount} CPU");
+            Console.WriteLine($"Ring: {(ringPath == null ? "named mapping" : "file-backed " + ringPath)}");
+            Console.WriteLine();
+
+            using (var tcpServer = CreateServer("TCP", basePort, pipeName, ringPath))
+            {
+                Console.WriteLine("Latency (one command in flight at a time):");
+                Console.WriteLine();
+                Console.WriteLine(LatencyStats.Header);
+
+                using (var ring = SharedMemoryRing.Open(tcpServer.RingName, ringPath))
+                {
+                    Console.WriteLine(await MeasureLatencyAsync("Shared-memory ring", iterations, warmup, line => { WriteRing(ring, line); return Task.CompletedTask; }));
+                }
+
+                using (var tcp = await TcpSender.ConnectAsync(basePort))
+                {
+                    Console.WriteLine(await MeasureLatencyAsync("TCP line", iterations, warmup, tcp.SendAsync));
+                }
+            }
+
+            if (windows)
+            {
+                using (var pipeServer = CreateServer("NamedPipe", basePort, pipeName, ringPath))
+                using (var pipe = await PipeSender.ConnectAsync(pipeName))
+                {
+                    Console.WriteLine(await MeasureLatencyAsync("Named pipe", iterations, warmup, pipe.SendAsync));
+                }
+            }
+            else
+            {
+                Console.WriteLine("| Named pipe             | skipped: message-mode pipes need Windows                                |");
+            }
+
+            using (var tcpServer = CreateServer("TCP", basePort, pipeName, ringPath))
+            {
+                Console.WriteLine();
+                Console.WriteLine("Throughput (sender never waits for delivery):");
+                Console.WriteLine();
+                Console.WriteLine("| Transport              |  commands |    seconds |   commands/s |");
+                Console.WriteLine("|------------------------|----------:|-----------:|-------------:|");
+
+                using (var ring = SharedMemoryRing.Open(tcpServer.RingName, ringPath))
+                {
+                    Console.WriteLine(await MeasureThroughputAsync("Shared-memory ring", iterations, line => { WriteRing(ring, line); return Task.CompletedTask; }));
+                }
+
+                using (var tcp = await TcpSender.ConnectAsync(basePort))
+                {
+                    Console.WriteLine(await MeasureThroughputAsync("TCP line", iterations, tcp.SendAsync));
+                }
+            }
+
+            if (windows)
+            {
+                using (var pipeServer = CreateServer("NamedPipe", basePort, pipeName, ringPath))
+                using (var pipe = await PipeSender.ConnectAsync(pipeName))
+                {
+                    Console.WriteLine(await MeasureThroughputAsync("Named pipe", iterations, pipe.SendAsync));
+                }
+            }
+
+            if (ringPath != null)
+            {
+                File.Delete(ringPath);
+            }
+        }
+
+        private static PipelineServer CreateServer(string protocol, int port, string pipeName, string ringPath)
+        {
+            var server = new PipelineServer(protocol, "127.0.0.1", port, pipeName)
+            {
+                RingEnabled = protocol == "TCP",
+                RingName = pipeName,
+                RingPath = ringPath
+            };
+            server.OnCustomCommand += (s, command) =>
+            {
+                long end = Stopwatch.GetTimestamp();
+                if (command.Command == "BENCH")
+                {
+                    _current?.Add(long.Parse(command.Data, CultureInfo.InvariantCulture), end);
+                    Interlocked.Increment(ref _handled);
+                }
+            };
+            server.Start();
+            Thread.Sleep(200);
+            return server;
+        }
+
+        private static async Task<LatencyStats> MeasureLatencyAsync(string name, int iterations, int warmup, Func<string, Task> send)
+        {
+            var stats = new LatencyStats(name, iterations);
+            for (int i = 0; i < warmup + iterations; i++)
+            {
+                _current = i >= warmup ? stats : null;
+                long expected = Interlocked.Read(ref _handled) + 1;
+                await send("BENCH:" + Stopwatch.GetTimestamp().ToString(CultureInfo.InvariantCulture));
+
+                var spin = new SpinWait();
+                while (Interlocked.Read(ref _handled) < expected)
+                {
+                    spin.SpinOnce();
+                }
+            }
+            _current = null;
+            return stats;
+        }
+
+        private static async Task<string> MeasureThroughputAsync(string name, int iterations, Func<string, Task> send)
+        {
+            _current = null;
+            long target = Interlocked.Read(ref _handled) + iterations;
+            string line = "BENCH:" + Stopwatch.GetTimestamp().ToString(CultureInfo.InvariantCulture);
+
+            var stopwatch = Stopwatch.StartNew();
+            for (int i = 0; i < iterations; i++)
+            {
+                await send(line);
+            }
+
+            var spin = new SpinWait();
+            while (Interlocked.Read(ref _handled) < target)
+            {
+                spin.SpinOnce();
+            }
+            stopwatch.Stop();
+
+            return string.Format(CultureInfo.InvariantCulture, "| {0,-22} | {1,9} | {2,10:F3} | {3,12:N0} |",
+                name, iterations, stopwatch.Elapsed.TotalSeconds, iterations / stopwatch.Elapsed.TotalSeconds);
+        }
+
+        /// <summary>
+        /// Retries while the ring is full, as a mod that must not lose events would
+        /// </summary>
+        private static void WriteRing(SharedMemoryRing ring, string line)
+        {
+            var spin = new SpinWait();
+            while (!ring.TryWrite(line))
+            {
+                spin.SpinOnce();
+            }
+        }
+
+        /// <summary>
+        /// Line sender that drains responses in the background so the server never blocks on them
+        /// </summary>
+        private sealed class TcpSender : IDisposable
+        {
+            private readonly TcpClient _client;
+            private readonly StreamWriter _writer;
+            private readonly Task _drain;
+
+            private TcpSender(TcpClient client)
+            {
+                _client = client;
+                var stream = client.GetStream();
+                _writer = new StreamWriter(stream, new UTF8Encoding(false)) { AutoFlush = true };
+                _drain = Drain(stream);
+            }
+
+            public static async Task<TcpSender> ConnectAsync(int port)
+            {
+                var client = new TcpClient { NoDelay = true };
+                await client.ConnectAsync("127.0.0.1", port);
+                return new TcpSender(client);
+            }
+
+            public Task SendAsync(string line)
+            {
+                return _writer.WriteLineAsync(line);
+            }
+
+            public void Dispose()
+            {
+                _client.Dispose();
+            }
+        }
+
+        private sealed class PipeSender : IDisposable
+        {
+            private readonly NamedPipeClientStream _pipe;
+            private readonly StreamWriter _writer;
+            private readonly Task _drain;
+
+            private PipeSender(NamedPipeClientStream pipe)
+            {
+                _pipe = pipe;
+                _writer = new StreamWriter(pipe, new UTF8Encoding(false)) { AutoFlush = true };
+                _drain = Drain(pipe);
+            }
+
+            public static async Task<PipeSender> ConnectAsync(string pipeName)
+            {
+                var pipe = new NamedPipeClientStream(".", pipeName, PipeDirection.InOut, PipeOptions.Asynchronous);
+                await pipe.ConnectAsync(5000);
+                return new PipeSender(pipe);
+            }
+
+            public Task SendAsync(string line)
+            {
+                return _writer.WriteLineAsync(line);
+            }
+
+            public void Dispose()
+            {
+                _pipe.Dispose();
+            }
+        }
+
+        private static Task Drain(Stream stream)
+        {
+            return Task.Run(async () =>
+            {
+                var buffer = new byte[64 * 1024];
+                try
+                {
+                    while (await stream.ReadAsync(buffer, 0, buffer.Length) > 0)
+                    {
+                    }
+                }
+                catch (Exception)
+                {
+                    // Connection closed
+                }
+            });
+        }
+    }
+}
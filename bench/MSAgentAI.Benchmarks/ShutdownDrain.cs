@@ -0,0 +1,183 @@
+using System;
+using System.IO;
+using System.Net.Http;
+using System.Net.Sockets;
+using System.Net.WebSockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// Stops a PipelineServer while a command is running on each of TCP, HTTP POST and a
+    /// WebSocket, and checks that Stop waits for every one to send its response, that idle
+    /// connections are closed, and that a request arriving during the drain is turned away
+    /// with 503. The app exits right after Stop, so a response sent later is lost.
+    /// </summary>
+    public static class ShutdownDrain
+    {
+        // Long enough for Stop to start while every slow command is still running
+        private static readonly TimeSpan CommandTime = TimeSpan.FromMilliseconds(500);
+
+        public static async Task<bool> RunAsync(int basePort)
+        {
+            int tcpPort = basePort;
+            int httpPort = basePort + 2;
+            bool passed = true;
+
+            Console.WriteLine($"Shutdown drain, .NET {Environment.Version} on {System.Runtime.InteropServices.RuntimeInformation.OSDescription}");
+            Console.WriteLine();
+
+            using (var running = new CountdownEvent(3))
+            using (var server = new PipelineServer("TCP", "127.0.0.1", tcpPort, PipelineServer.PipeName))
+            using (var http = new HttpClient { BaseAddress = new Uri($"http://127.0.0.1:{httpPort}/") })
+            using (var tcp = new TcpClient { NoDelay = true })
+            using (var idleTcp = new TcpClient())
+            using (var ws = new ClientWebSocket())
+            using (var idleWs = new ClientWebSocket())
+            {
+                server.HttpEnabled = true;
+                server.HttpPort = httpPort;
+                server.DrainTimeout = TimeSpan.FromSeconds(5);
+                server.OnCustomCommand += (sender, command) =>
+                {
+                    if (command.Command == "SLOW")
+                    {
+                        running.Signal();
+                        Thread.Sleep(CommandTime);
+                    }
+                };
+                server.Start();
+                await Task.Delay(200);
+
+                await tcp.ConnectAsync("127.0.0.1", tcpPort);
+                await idleTcp.ConnectAsync("127.0.0.1", tcpPort);
+                await ws.ConnectAsync(new Uri($"ws://127.0.0.1:{httpPort}/ws"), CancellationToken.None);
+                await idleWs.ConnectAsync(new Uri($"ws://127.0.0.1:{httpPort}/ws"), CancellationToken.None);
+
+                // A round trip on each idle connection, so the server has accepted them before Stop
+                var idleWriter = new StreamWriter(idleTcp.GetStream(), new UTF8Encoding(false)) { AutoFlush = true };
+                await idleWriter.WriteLineAsync("PING");
+                Expect("PONG", await new StreamReader(idleTcp.GetStream(), Encoding.UTF8).ReadLineAsync());
+                await SendAsync(idleWs, "PING");
+                Expect("PONG", await ReceiveAsync(idleWs));
+
+                var tcpStream = tcp.GetStream();
+                var tcpReader = new StreamReader(tcpStream, Encoding.UTF8);
+                var tcpWriter = new StreamWriter(tcpStream, new UTF8Encoding(false)) { AutoFlush = true };
+                await tcpWriter.WriteLineAsync("SLOW");
+                var tcpResponse = tcpReader.ReadLineAsync();
+                var httpResponse = PostAsync(http, "SLOW");
+                await SendAsync(ws, "SLOW");
+                var wsResponse = ReceiveAsync(ws);
+
+                if (!running.Wait(TimeSpan.FromSeconds(5)))
+                    throw new InvalidOperationException("The slow commands never started");
+
+                var stop = Task.Run(() => server.Stop());
+                await Task.Delay(100);
+                var late = await PostAsync(http, "PING");
+
+                var result = await stop;
+                Console.WriteLine($"Stop took {result.Elapsed.TotalMilliseconds:F0} ms: {result.Drained} drained, {result.Aborted} aborted");
+                Console.WriteLine();
+
+                passed &= Check("TCP command finishes", "OK:CUSTOM:SLOW", await BeforeStopAsync(tcpResponse));
+                passed &= Check("HTTP POST command finishes", "200 OK:CUSTOM:SLOW", await BeforeStopAsync(httpResponse));
+                passed &= Check("WebSocket command finishes", "OK:CUSTOM:SLOW", await BeforeStopAsync(wsResponse));
+                passed &= Check("HTTP POST during drain", "503 ERROR:Server stopping", late);
+                passed &= Check("Idle TCP closed", "closed", await ReadClosedAsync(idleTcp));
+                passed &= Check("Idle WebSocket closed", "closed", await ReceiveAsync(idleWs));
+            }
+
+            Console.WriteLine();
+            Console.WriteLine(passed ? "All checks passed" : "Some checks failed");
+            return passed;
+        }
+
+        /// <summary>
+        /// The response, if it arrived by the time Stop returned (give or take the loopback hop)
+        /// </summary>
+        private static async Task<string> BeforeStopAsync(Task<string> response)
+        {
+            await Task.WhenAny(response, Task.Delay(100));
+            return response.IsCompleted ? await response : "still running when Stop returned";
+        }
+
+        private static async Task<string> PostAsync(HttpClient http, string command)
+        {
+            try
+            {
+                using (var response = await http.PostAsync("command", new StringContent(command)))
+                {
+                    return $"{(int)response.StatusCode} {await response.Content.ReadAsStringAsync()}";
+                }
+            }
+            catch (HttpRequestException ex)
+            {
+                return ex.Message;
+            }
+        }
+
+        private static Task SendAsync(ClientWebSocket socket, string message)
+        {
+            return socket.SendAsync(new ArraySegment<byte>(Encoding.UTF8.GetBytes(message)), WebSocketMessageType.Text, true, CancellationToken.None);
+        }
+
+        /// <summary>
+        /// The next text message, or "closed" once the server has gone
+        /// </summary>
+        private static async Task<string> ReceiveAsync(ClientWebSocket socket)
+        {
+            var buffer = new byte[1024];
+            try
+            {
+                var result = await socket.ReceiveAsync(new ArraySegment<byte>(buffer), CancellationToken.None);
+                return result.MessageType == WebSocketMessageType.Close ? "closed" : Encoding.UTF8.GetString(buffer, 0, result.Count);
+            }
+            catch (WebSocketException)
+            {
+                return "closed";
+            }
+        }
+
+        /// <summary>
+        /// "closed" once the server has closed the connection without sending a response.
+        /// A UTF-8 byte order mark, which the server writes ahead of its first line, is skipped.
+        /// </summary>
+        private static async Task<string> ReadClosedAsync(TcpClient client)
+        {
+            var received = new MemoryStream();
+            var buffer = new byte[64];
+            try
+            {
+                int read;
+                while ((read = await client.GetStream().ReadAsync(buffer, 0, buffer.Length)) > 0)
+                {
+                    received.Write(buffer, 0, read);
+                }
+                string text = Encoding.UTF8.GetString(received.ToArray()).TrimStart('\uFEFF');
+                return text.Length == 0 ? "closed" : "got " + text;
+            }
+            catch (IOException)
+            {
+                return "closed";
+            }
+        }
+
+        private static void Expect(string expected, string actual)
+        {
+            if (actual != expected)
+                throw new InvalidOperationException($"Expected '{expected}' but got '{actual}'");
+        }
+
+        private static bool Check(string name, string expected, string actual)
+        {
+            bool ok = actual == expected;
+            Console.WriteLine($"{(ok ? "PASS" : "FAIL")}  {name}" + (ok ? string.Empty : $": expected '{expected}', got '{actual}'"));
+            return ok;
+        }
+    }
+}
@@ -0,0 +1,168 @@
+using System;
+using System.Diagnostics;
+using System.IO;
+using System.Net.Http;
+using System.Net.Sockets;
+using System.Net.WebSockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.Benchmarks
+{
+    /// <summary>
+    /// Round-trip latency of one PING over each pipeline transport, against a real
+    /// PipelineServer on loopback. Every client keeps its connection open and sends
+    /// the next command only after the previous response arrives.
+    /// </summary>
+    public static class TransportLatency
+    {
+        public static async Task RunAsync(int iterations, int warmup, int basePort)
+        {
+            int tcpPort = basePort;
+            int httpPort = basePort + 2;
+
+            using (var server = new PipelineServer("TCP", "127.0.0.1", tcpPort, PipelineServer.PipeName))
+            {
+                server.HttpEnabled = true;
+                server.HttpPort = httpPort;
+                server.Start();
+                await Task.Delay(200);
+
+                Console.WriteLine($"Transport round trip, {iterations} iterations after {warmup} warmup, .NET {Environment.Version} on {System.Runtime.InteropServices.RuntimeInformation.OSDescription}");
+                Console.WriteLine();
+                Console.WriteLine(LatencyStats.Header);
+
+                Console.WriteLine(await MeasureTcpAsync(tcpPort, iterations, warmup));
+                Console.WriteLine(await MeasureWebSocketAsync(httpPort, iterations, warmup));
+                Console.WriteLine(await MeasureHttpAsync(httpPort, iterations, warmup));
+                Console.WriteLine(await MeasurePushAsync(server, httpPort, iterations, warmup));
+
+                Console.WriteLine();
+                Console.WriteLine($"Server: {server.GetStats()}");
+            }
+        }
+
+        private static async Task<LatencyStats> MeasureTcpAsync(int port, int iterations, int warmup)
+        {
+            var stats = new LatencyStats("TCP line (PING)", iterations);
+            using (var client = new TcpClient { NoDelay = true })
+            {
+                await client.ConnectAsync("127.0.0.1", port);
+                using (var stream = client.GetStream())
+                using (var reader = new StreamReader(stream, Encoding.UTF8))
+                using (var writer = new StreamWriter(stream, new UTF8Encoding(false)) { AutoFlush = true })
+                {
+                    for (int i = 0; i < warmup + iterations; i++)
+                    {
+                        long start = Stopwatch.GetTimestamp();
+                        await writer.WriteLineAsync("PING");
+                        string response = await reader.ReadLineAsync();
+                        long end = Stopwatch.GetTimestamp();
+
+                        Expect("PONG", response);
+                        if (i >= warmup)
+                        {
+                            stats.Add(start, end);
+                        }
+                    }
+                }
+            }
+            return stats;
+        }
+
+        private static async Task<LatencyStats> MeasureWebSocketAsync(int port, int iterations, int warmup)
+        {
+            var stats = new LatencyStats("WebSocket (PING)", iterations);
+            byte[] ping = Encoding.UTF8.GetBytes("PING");
+            var buffer = new byte[1024];
+
+            using (var socket = new ClientWebSocket())
+            {
+                await socket.ConnectAsync(new Uri($"ws://127.0.0.1:{port}/ws"), CancellationToken.None);
+                for (int i = 0; i < warmup + iterations; i++)
+                {
+                    long start = Stopwatch.GetTimestamp();
+                    await socket.SendAsync(new ArraySegment<byte>(ping), WebSocketMessageType.Text, true, CancellationToken.None);
+                    var result = await socket.ReceiveAsync(new ArraySegment<byte>(buffer), CancellationToken.None);
+                    long end = Stopwatch.GetTimestamp();
+
+                    Expect("PONG", Encoding.UTF8.GetString(buffer, 0, result.Count));
+                    if (i >= warmup)
+                    {
+                        stats.Add(start, end);
+                    }
+                }
+                await socket.CloseAsync(WebSocketCloseStatus.NormalClosure, null, CancellationToken.None);
+            }
+            return stats;
+        }
+
+        private static async Task<LatencyStats> MeasureHttpAsync(int port, int iterations, int warmup)
+        {
+            var stats = new LatencyStats("HTTP POST (PING)", iterations);
+            var handler = new SocketsHttpHandler { MaxConnectionsPerServer = 1 };
+
+            using (var http = new HttpClient(handler) { BaseAddress = new Uri($"http://127.0.0.1:{port}/") })
+            {
+                for (int i = 0; i < warmup + iterations; i++)
+                {
+                    long start = Stopwatch.GetTimestamp();
+                    using (var response = await http.PostAsync("command", new StringContent("PING")))
+                    {
+                        string body = await response.Content.ReadAsStringAsync();
+                        long end = Stopwatch.GetTimestamp();
+
+                        Expect("PONG", body);
+                        if (i >= warmup)
+                        {
+                            stats.Add(start, end);
+                        }
+                    }
+                }
+            }
+            return stats;
+        }
+
+        /// <summary>
+        /// Time from PublishEvent on the server to the event arriving at a WebSocket client
+        /// </summary>
+        private static async Task<LatencyStats> MeasurePushAsync(PipelineServer server, int port, int iterations, int warmup)
+        {
+            var stats = new LatencyStats("WebSocket event push", iterations);
+            var buffer = new byte[1024];
+
+            using (var socket = new ClientWebSocket())
+            {
+                await socket.ConnectAsync(new Uri($"ws://127.0.0.1:{port}/ws"), CancellationToken.None);
+
+                // Wait until the server has registered the session
+                await socket.SendAsync(new ArraySegment<byte>(Encoding.UTF8.GetBytes("PING")), WebSocketMessageType.Text, true, CancellationToken.None);
+                await socket.ReceiveAsync(new ArraySegment<byte>(buffer), CancellationToken.None);
+
+                for (int i = 0; i < warmup + iterations; i++)
+                {
+                    long start = Stopwatch.GetTimestamp();
+                    server.PublishEvent("BENCH", i.ToString());
+                    var result = await socket.ReceiveAsync(new ArraySegment<byte>(buffer), CancellationToken.None);
+                    long end = Stopwatch.GetTimestamp();
+
+                    Expect("EVENT:BENCH:" + i, Encoding.UTF8.GetString(buffer, 0, result.Count));
+                    if (i >= warmup)
+                    {
+                        stats.Add(start, end);
+                    }
+                }
+                await socket.CloseAsync(WebSocketCloseStatus.NormalClosure, null, CancellationToken.None);
+            }
+            return stats;
+        }
+
+        private static void Expect(string expected, string actual)
+        {
+            if (actual != expected)
+                throw new InvalidOperationException($"Expected '{expected}' but got '{actual}'");
+        }
+    }
+}
@@ -0,0 +1,166 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using Newtonsoft.Json;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// One measured case: median time and bytes allocated per operation
+    /// </summary>
+    public sealed class BenchmarkResult
+    {
+        public BenchmarkResult(string name, double nanoseconds, long bytes)
+        {
+            Name = name;
+            Nanoseconds = nanoseconds;
+            Bytes = bytes;
+        }
+
+        public string Name { get; }
+        public double Nanoseconds { get; }
+        public long Bytes { get; }
+    }
+
+    /// <summary>
+    /// Saves results as JSON and compares a run against saved ones. Allocations are checked
+    /// strictly because they are the same on any machine; time only fails the comparison when
+    /// asked to, since CI runners are too noisy for a fixed limit.
+    /// </summary>
+    public static class BenchmarkResults
+    {
+        // Allowed growth in allocations before a case counts as a regression
+        private const double AllocationTolerance = 0.05;
+        private const long AllocationSlackBytes = 16;
+
+        public static void Save(string path, string suite, List<BenchmarkResult> results)
+        {
+            var text = new StringWriter(CultureInfo.InvariantCulture);
+            using (var writer = new JsonTextWriter(text) { Formatting = Formatting.Indented })
+            {
+                writer.WriteStartObject();
+                writer.WritePropertyName("suite");
+                writer.WriteValue(suite);
+                writer.WritePropertyName("runtime");
+                writer.WriteValue(RuntimeInformation.FrameworkDescription);
+                writer.WritePropertyName("os");
+                writer.WriteValue(RuntimeInformation.OSDescription);
+                writer.WritePropertyName("results");
+                writer.WriteStartArray();
+                foreach (var result in results)
+                {
+                    writer.WriteStartObject();
+                    writer.WritePropertyName("name");
+                    writer.WriteValue(result.Name);
+                    writer.WritePropertyName("ns");
+                    writer.WriteValue(Math.Round(result.Nanoseconds, 1));
+                    writer.WritePropertyName("bytes");
+                    writer.WriteValue(result.Bytes);
+                    writer.WriteEndObject();
+                }
+                writer.WriteEndArray();
+                writer.WriteEndObject();
+            }
+
+            string directory = Path.GetDirectoryName(Path.GetFullPath(path));
+            Directory.CreateDirectory(directory);
+            File.WriteAllText(path, text.ToString() + Environment.NewLine);
+            Console.WriteLine($"Saved results to {path}");
+        }
+
+        public static List<BenchmarkResult> Load(string path)
+        {
+            var results = new List<BenchmarkResult>();
+            using (var reader = new JsonTextReader(new StreamReader(path)))
+            {
+                string name = null;
+                double nanoseconds = 0;
+                long bytes = 0;
+                bool inResults = false;
+                while (reader.Read())
+                {
+                    if (reader.TokenType == JsonToken.PropertyName)
+                    {
+                        switch ((string)reader.Value)
+                        {
+                            case "results":
+                                inResults = true;
+                                break;
+                            case "name" when inResults:
+                                name = reader.ReadAsString();
+                                break;
+                            case "ns" when inResults:
+                                nanoseconds = reader.ReadAsDouble() ?? 0;
+                                break;
+                            case "bytes" when inResults:
+                                bytes = (long)(reader.ReadAsDouble() ?? 0);
+                                break;
+                            default:
+                                reader.Skip();
+                                break;
+                        }
+                    }
+                    else if (reader.TokenType == JsonToken.EndObject && inResults && name != null)
+                    {
+                        results.Add(new BenchmarkResult(name, nanoseconds, bytes));
+                        name = null;
+                    }
+                }
+            }
+            return results;
+        }
+
+        /// <summary>
+        /// Prints each case against the baseline and returns false if any regressed. With
+        /// maxSlowdownPercent null, time is shown but never fails.
+        /// </summary>
+        public static bool Compare(string baselinePath, List<BenchmarkResult> results, double? maxSlowdownPercent)
+        {
+            var baseline = Load(baselinePath).ToDictionary(r => r.Name);
+            var table = new StringBuilder();
+            table.AppendLine($"Compared with {Path.GetFileName(baselinePath)}" +
+                (maxSlowdownPercent.HasValue ? $", time may grow by {maxSlowdownPercent}%" : ", time for information only"));
+            table.AppendLine();
+            table.AppendLine("| Case | baseline ns | ns | time | baseline B | B | allocations |");
+            table.AppendLine("|------|------------:|---:|-----:|-----------:|--:|:------------|");
+
+            bool passed = true;
+            foreach (var result in results)
+            {
+                if (!baseline.TryGetValue(result.Name, out var before))
+                {
+                    table.AppendLine(string.Format(CultureInfo.InvariantCulture, "| {0} | | {1:N0} | new | | {2:N0} | new |",
+                        result.Name, result.Nanoseconds, result.Bytes));
+                    continue;
+                }
+
+                double change = (result.Nanoseconds - before.Nanoseconds) / before.Nanoseconds * 100;
+                bool slower = maxSlowdownPercent.HasValue && change > maxSlowdownPercent.Value;
+                bool allocates = result.Bytes > before.Bytes * (1 + AllocationTolerance) + AllocationSlackBytes;
+                passed &= !slower && !allocates;
+
+                string allocations = allocates ? "**REGRESSED**"
+                    : result.Bytes < before.Bytes - AllocationSlackBytes ? "better" : "same";
+                table.AppendLine(string.Format(CultureInfo.InvariantCulture, "| {0} | {1:N0} | {2:N0} | {3:+0;-0;0}%{4} | {5:N0} | {6:N0} | {7} |",
+                    result.Name, before.Nanoseconds, result.Nanoseconds, change, slower ? " **REGRESSED**" : "",
+                    before.Bytes, result.Bytes, allocations));
+            }
+            table.AppendLine();
+            table.AppendLine(passed ? "No regressions." : "Regressions found.");
+
+            Console.Write(table.ToString());
+
+            // Shown on the workflow run's summary page when run in GitHub Actions
+            string summary = Environment.GetEnvironmentVariable("GITHUB_STEP_SUMMARY");
+            if (!string.IsNullOrEmpty(summary))
+            {
+                File.AppendAllText(summary, table.ToString());
+            }
+            return passed;
+        }
+    }
+}
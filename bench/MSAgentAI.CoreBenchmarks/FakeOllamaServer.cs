@@ -0,0 +1,180 @@
+using System;
+using System.IO;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// Just enough of Ollama's HTTP API for OllamaClient: chat answers after a fixed delay, as if
+    /// the model took that long, and tags, show and ps answer at once. Counts the connections and
+    /// requests in flight, so a client-side connection limit shows up as a low peak.
+    /// </summary>
+    public sealed class FakeOllamaServer : IDisposable
+    {
+        private const string ChatResponse = "{\"model\":\"bench\",\"message\":{\"role\":\"assistant\",\"content\":\"&&Wave Hello there! It is a lovely day to sit on your desktop.\"},\"done\":true,\"done_reason\":\"stop\",\"prompt_eval_count\":180,\"eval_count\":16}";
+        private const string TagsResponse = "{\"models\":[{\"name\":\"bench\",\"size\":1000000,\"details\":{\"parameter_size\":\"1B\",\"quantization_level\":\"Q4_0\"}}]}";
+        private const string ShowResponse = "{\"model_info\":{\"general.architecture\":\"llama\",\"llama.context_length\":8192}}";
+        private const string PsResponse = "{\"models\":[{\"name\":\"bench\"}]}";
+
+        private readonly TcpListener _listener;
+        private readonly CancellationTokenSource _cancellation = new CancellationTokenSource();
+        private readonly int _delayMs;
+        private int _connections;
+        private int _inFlight;
+        private int _peakInFlight;
+        private long _chats;
+
+        public FakeOllamaServer(int port, int delayMs)
+        {
+            _delayMs = delayMs;
+            _listener = new TcpListener(IPAddress.Loopback, port);
+            _listener.Start();
+            Url = $"http://127.0.0.1:{port}";
+            _ = AcceptLoopAsync();
+        }
+
+        public string Url { get; }
+
+        /// <summary>
+        /// Connections opened by clients so far
+        /// </summary>
+        public int Connections => Volatile.Read(ref _connections);
+
+        /// <summary>
+        /// Most chat requests that were being answered at once
+        /// </summary>
+        public int PeakInFlight => Volatile.Read(ref _peakInFlight);
+
+        public long Chats => Interlocked.Read(ref _chats);
+
+        public void ResetPeak()
+        {
+            Volatile.Write(ref _peakInFlight, 0);
+        }
+
+        private async Task AcceptLoopAsync()
+        {
+            while (!_cancellation.IsCancellationRequested)
+            {
+                TcpClient client;
+                try
+                {
+                    client = await _listener.AcceptTcpClientAsync();
+                }
+                catch (Exception) when (_cancellation.IsCancellationRequested)
+                {
+                    return;
+                }
+                catch (SocketException)
+                {
+                    continue;
+                }
+
+                Interlocked.Increment(ref _connections);
+                _ = ServeAsync(client);
+            }
+        }
+
+        /// <summary>
+        /// Answers requests on one kept-alive connection until the client closes it
+        /// </summary>
+        private async Task ServeAsync(TcpClient client)
+        {
+            using (client)
+            {
+                client.NoDelay = true;
+                var stream = client.GetStream();
+                var reader = new StreamReader(stream, new UTF8Encoding(false), false, 4096, leaveOpen: true);
+                var body = new char[4096];
+                try
+                {
+                    while (!_cancellation.IsCancellationRequested)
+                    {
+                        string requestLine = await reader.ReadLineAsync();
+                        if (string.IsNullOrEmpty(requestLine))
+                            return;
+
+                        int contentLength = 0;
+                        string header;
+                        while (!string.IsNullOrEmpty(header = await reader.ReadLineAsync()))
+                        {
+                            if (header.StartsWith("Content-Length:", StringComparison.OrdinalIgnoreCase))
+                            {
+                                int.TryParse(header.Substring(15).Trim(), out contentLength);
+                            }
+                        }
+
+                        // Content-Length counts UTF-8 bytes, and the system prompt isn't all ASCII.
+                        // Asking for no more chars than bytes left never reads into the next request.
+                        int remaining = contentLength;
+                        while (remaining > 0)
+                        {
+                            int n = await reader.ReadAsync(body, 0, Math.Min(body.Length, remaining));
+                            if (n == 0)
+                                return;
+                            remaining -= Encoding.UTF8.GetByteCount(body, 0, n);
+                        }
+
+                        string path = requestLine.Split(' ')[1];
+                        string response = await AnswerAsync(path);
+                        byte[] payload = Encoding.UTF8.GetBytes(response);
+                        byte[] head = Encoding.ASCII.GetBytes(
+                            $"HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {payload.Length}\r\nConnection: keep-alive\r\n\r\n");
+                        await stream.WriteAsync(head, 0, head.Length);
+                        await stream.WriteAsync(payload, 0, payload.Length);
+                    }
+                }
+                catch (IOException)
+                {
+                }
+                catch (ObjectDisposedException)
+                {
+                }
+            }
+        }
+
+        private async Task<string> AnswerAsync(string path)
+        {
+            switch (path)
+            {
+                case "/api/chat":
+                    int inFlight = Interlocked.Increment(ref _inFlight);
+                    int peak;
+                    while (inFlight > (peak = Volatile.Read(ref _peakInFlight)) && Interlocked.CompareExchange(ref _peakInFlight, inFlight, peak) != peak)
+                    {
+                    }
+                    try
+                    {
+                        if (_delayMs > 0)
+                        {
+                            await Task.Delay(_delayMs);
+                        }
+                        Interlocked.Increment(ref _chats);
+                        return ChatResponse;
+                    }
+                    finally
+                    {
+                        Interlocked.Decrement(ref _inFlight);
+                    }
+                case "/api/tags":
+                    return TagsResponse;
+                case "/api/show":
+                    return ShowResponse;
+                case "/api/ps":
+                    return PsResponse;
+                default:
+                    return "{}";
+            }
+        }
+
+        public void Dispose()
+        {
+            _cancellation.Cancel();
+            _listener.Stop();
+        }
+    }
+}
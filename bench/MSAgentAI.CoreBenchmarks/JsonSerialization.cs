@@ -0,0 +1,349 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Text;
+using MSAgentAI.AI;
+using MSAgentAI.Config;
+using Newtonsoft.Json;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// The hand-written serializers for settings, memories and chat requests/responses against
+    /// JsonConvert on the same types, as the app used before. Checks the output is identical,
+    /// then measures warm cost per call and the cost of the first call in a fresh process.
+    /// </summary>
+    public static class JsonSerialization
+    {
+        private const int MemoryCount = 500;
+        private const int ColdRuns = 5;
+        private static readonly string[] Steps = { "settings load", "settings save", "memories load", "memories save", "chat request", "chat response" };
+
+        private const string ChatResponse = "{\"model\":\"llama3.2\",\"created_at\":\"2026-10-18T05:23:31.8260523Z\",\"message\":{\"role\":\"assistant\",\"content\":\"&&Wave Hello there! It's a /emp/ lovely day to sit on your desktop and watch you work. What are you up to?\"},\"done_reason\":\"stop\",\"done\":true,\"total_duration\":1843262917,\"load_duration\":21672083,\"prompt_eval_count\":412,\"prompt_eval_duration\":188000000,\"eval_count\":31,\"eval_duration\":1622000000}";
+
+        public static void Run(int iterations, int warmup)
+        {
+            var settings = CreateSettings();
+            var memories = CreateMemories();
+            var messages = CreateMessages();
+            var options = new OllamaOptions { NumPredict = 150, Temperature = 0.8, NumContext = 4096 };
+            byte[] responseBytes = Encoding.UTF8.GetBytes(ChatResponse);
+
+            string settingsJson = AppSettingsJson.Serialize(settings);
+            string memoriesJson = MemoryJson.Serialize(memories);
+
+            if (!Verify(settings, settingsJson, memories, memoriesJson, messages, options, responseBytes))
+            {
+                Environment.ExitCode = 1;
+                return;
+            }
+
+            Console.WriteLine($"Warm, {iterations} calls each after {warmup} warmup. Settings {settingsJson.Length / 1024.0:F1} KB, {MemoryCount} memories {memoriesJson.Length / 1024.0:F1} KB, chat request with {messages.Count} messages.");
+            Console.WriteLine();
+            Console.WriteLine("| Operation      | JsonConvert us | alloc B | Hand-written us | alloc B | Speedup |");
+            Console.WriteLine("|----------------|---------------:|--------:|----------------:|--------:|--------:|");
+
+            Compare("settings load", iterations, warmup,
+                () => JsonConvert.DeserializeObject<AppSettings>(settingsJson),
+                () => AppSettingsJson.Deserialize(settingsJson));
+            Compare("settings save", iterations, warmup,
+                () => JsonConvert.SerializeObject(settings, Formatting.Indented),
+                () => AppSettingsJson.Serialize(settings));
+            Compare("memories load", Math.Max(1, iterations / 20), Math.Max(1, warmup / 20),
+                () => JsonConvert.DeserializeObject<List<Memory>>(memoriesJson),
+                () => MemoryJson.Deserialize(memoriesJson));
+            Compare("memories save", Math.Max(1, iterations / 20), Math.Max(1, warmup / 20),
+                () => JsonConvert.SerializeObject(memories, Formatting.Indented),
+                () => MemoryJson.Serialize(memories));
+            Compare("chat request", iterations, warmup,
+                () => ReflectionRequest(messages, options).Dispose(),
+                () => OllamaJson.CreateChatContent("llama3.2", messages, options).Dispose());
+            Compare("chat response", iterations, warmup,
+                () => JsonConvert.DeserializeObject<OllamaClient.OllamaChatResponse>(Encoding.UTF8.GetString(responseBytes)),
+                () => OllamaJson.ReadChatResponse(Encoding.UTF8.GetString(responseBytes)));
+
+            Console.WriteLine();
+            RunCold(settingsJson, memoriesJson);
+        }
+
+        /// <summary>
+        /// Child process: the first call of each step, with one serializer only
+        /// </summary>
+        public static void RunColdChild(string mode, string directory)
+        {
+            string settingsJson = File.ReadAllText(Path.Combine(directory, "settings.json"));
+            string memoriesJson = File.ReadAllText(Path.Combine(directory, "memories.json"));
+            byte[] responseBytes = File.ReadAllBytes(Path.Combine(directory, "response.json"));
+            var messages = CreateMessages();
+            var options = new OllamaOptions { NumPredict = 150, Temperature = 0.8, NumContext = 4096 };
+            bool reflection = mode == "reflection";
+
+            var times = new double[Steps.Length];
+            long start = Stopwatch.GetTimestamp();
+            var settings = reflection ? JsonConvert.DeserializeObject<AppSettings>(settingsJson) : AppSettingsJson.Deserialize(settingsJson);
+            times[0] = Lap(ref start);
+            GC.KeepAlive(reflection ? JsonConvert.SerializeObject(settings, Formatting.Indented) : AppSettingsJson.Serialize(settings));
+            times[1] = Lap(ref start);
+            var memories = reflection ? JsonConvert.DeserializeObject<List<Memory>>(memoriesJson) : MemoryJson.Deserialize(memoriesJson);
+            times[2] = Lap(ref start);
+            GC.KeepAlive(reflection ? JsonConvert.SerializeObject(memories, Formatting.Indented) : MemoryJson.Serialize(memories));
+            times[3] = Lap(ref start);
+            (reflection ? ReflectionRequest(messages, options) : OllamaJson.CreateChatContent("llama3.2", messages, options)).Dispose();
+            times[4] = Lap(ref start);
+            GC.KeepAlive(reflection
+                ? JsonConvert.DeserializeObject<OllamaClient.OllamaChatResponse>(Encoding.UTF8.GetString(responseBytes))
+                : OllamaJson.ReadChatResponse(Encoding.UTF8.GetString(responseBytes)));
+            times[5] = Lap(ref start);
+
+            Console.WriteLine(string.Join(" ", times.Select(t => t.ToString("F0", CultureInfo.InvariantCulture))));
+        }
+
+        /// <summary>
+        /// The request as OllamaClient built it before: anonymous objects through JsonConvert
+        /// </summary>
+        private static HttpContent ReflectionRequest(List<OllamaClient.ChatMessage> messages, OllamaOptions options)
+        {
+            var anonymous = new List<object>(messages.Count);
+            foreach (var message in messages)
+            {
+                anonymous.Add(new { role = message.Role, content = message.Content });
+            }
+
+            var request = new
+            {
+                model = "llama3.2",
+                messages = anonymous,
+                stream = false,
+                options = new Dictionary<string, object>
+                {
+                    ["num_predict"] = options.NumPredict,
+                    ["temperature"] = options.Temperature,
+                    ["num_ctx"] = options.NumContext
+                }
+            };
+
+            return new StringContent(JsonConvert.SerializeObject(request), Encoding.UTF8, "application/json");
+        }
+
+        private static bool Verify(AppSettings settings, string settingsJson, List<Memory> memories, string memoriesJson,
+            List<OllamaClient.ChatMessage> messages, OllamaOptions options, byte[] responseBytes)
+        {
+            var failures = new List<string>();
+            if (settingsJson != JsonConvert.SerializeObject(settings, Formatting.Indented))
+                failures.Add("settings: output differs from JsonConvert (a property missing from AppSettingsJson?)");
+            if (AppSettingsJson.Serialize(AppSettingsJson.Deserialize(settingsJson)) != settingsJson)
+                failures.Add("settings: a load and save changes the file");
+            if (memoriesJson != JsonConvert.SerializeObject(memories, Formatting.Indented))
+                failures.Add("memories: output differs from JsonConvert");
+            if (MemoryJson.Serialize(MemoryJson.Deserialize(memoriesJson)) != memoriesJson)
+                failures.Add("memories: a load and save changes the file");
+
+            using (var before = ReflectionRequest(messages, options))
+            using (var after = OllamaJson.CreateChatContent("llama3.2", messages, options))
+            {
+                if (!before.ReadAsByteArrayAsync().Result.SequenceEqual(after.ReadAsByteArrayAsync().Result))
+                    failures.Add("chat request: body differs from JsonConvert");
+                if (before.Headers.ContentType.ToString() != after.Headers.ContentType.ToString())
+                    failures.Add($"chat request: Content-Type {after.Headers.ContentType} instead of {before.Headers.ContentType}");
+            }
+
+            var expected = JsonConvert.DeserializeObject<OllamaClient.OllamaChatResponse>(Encoding.UTF8.GetString(responseBytes));
+            var actual = OllamaJson.ReadChatResponse(Encoding.UTF8.GetString(responseBytes));
+            if (expected.Message.Content != actual.Message.Content || expected.DoneReason != actual.DoneReason ||
+                expected.PromptEvalCount != actual.PromptEvalCount || expected.EvalCount != actual.EvalCount)
+                failures.Add("chat response: fields differ from JsonConvert");
+
+            foreach (string failure in failures)
+            {
+                Console.Error.WriteLine("MISMATCH " + failure);
+            }
+            return failures.Count == 0;
+        }
+
+        private static void Compare(string name, int iterations, int warmup, Action before, Action after)
+        {
+            var (beforeUs, beforeBytes) = Measure(before, iterations, warmup);
+            var (afterUs, afterBytes) = Measure(after, iterations, warmup);
+            Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+                "| {0,-14} | {1,14:F1} | {2,7:N0} | {3,15:F1} | {4,7:N0} | {5,6:F1}x |",
+                name, beforeUs, beforeBytes, afterUs, afterBytes, beforeUs / afterUs));
+        }
+
+        private static (double microseconds, long bytes) Measure(Action action, int iterations, int warmup)
+        {
+            for (int i = 0; i < warmup; i++)
+            {
+                action();
+            }
+
+            long allocated = AllocatedBytes();
+            long start = Stopwatch.GetTimestamp();
+            for (int i = 0; i < iterations; i++)
+            {
+                action();
+            }
+            long end = Stopwatch.GetTimestamp();
+            long bytes = AllocatedBytes() - allocated;
+
+            return ((end - start) * 1_000_000.0 / Stopwatch.Frequency / iterations, bytes / iterations);
+        }
+
+        internal static long AllocatedBytes()
+        {
+#if NET
+            return GC.GetAllocatedBytesForCurrentThread();
+#else
+            AppDomain.MonitoringIsEnabled = true;
+            return AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+#endif
+        }
+
+        /// <summary>
+        /// Starts this benchmark again once per serializer and run, so each first call pays for
+        /// loading, JIT and (for JsonConvert) building its contracts, as the app does at startup
+        /// </summary>
+        private static void RunCold(string settingsJson, string memoriesJson)
+        {
+            string directory = Path.Combine(Path.GetTempPath(), "MSAgentAI.CoreBenchmarks." + Process.GetCurrentProcess().Id);
+            Directory.CreateDirectory(directory);
+            try
+            {
+                File.WriteAllText(Path.Combine(directory, "settings.json"), settingsJson);
+                File.WriteAllText(Path.Combine(directory, "memories.json"), memoriesJson);
+                File.WriteAllText(Path.Combine(directory, "response.json"), ChatResponse);
+
+                var reflection = RunChildren("reflection", directory);
+                var streaming = RunChildren("streaming", directory);
+
+                Console.WriteLine($"First call in a fresh process, median of {ColdRuns} runs:");
+                Console.WriteLine();
+                Console.WriteLine("| Operation      | JsonConvert us | Hand-written us |");
+                Console.WriteLine("|----------------|---------------:|----------------:|");
+                for (int i = 0; i < Steps.Length; i++)
+                {
+                    Console.WriteLine(string.Format(CultureInfo.InvariantCulture, "| {0,-14} | {1,14:F0} | {2,15:F0} |",
+                        Steps[i], reflection[i], streaming[i]));
+                }
+                Console.WriteLine(string.Format(CultureInfo.InvariantCulture, "| {0,-14} | {1,14:F0} | {2,15:F0} |",
+                    "total", reflection.Sum(), streaming.Sum()));
+            }
+            finally
+            {
+                Directory.Delete(directory, true);
+            }
+        }
+
+        private static double[] RunChildren(string mode, string directory)
+        {
+            string host = Process.GetCurrentProcess().MainModule.FileName;
+            string arguments = $"json-cold {mode} \"{directory}\"";
+            if (string.Equals(Path.GetFileNameWithoutExtension(host), "dotnet", StringComparison.OrdinalIgnoreCase))
+            {
+                arguments = $"\"{typeof(JsonSerialization).Assembly.Location}\" " + arguments;
+            }
+
+            var runs = new List<double[]>();
+            for (int run = 0; run < ColdRuns; run++)
+            {
+                var info = new ProcessStartInfo(host, arguments)
+                {
+                    UseShellExecute = false,
+                    RedirectStandardOutput = true
+                };
+                using (var child = Process.Start(info))
+                {
+                    string line = child.StandardOutput.ReadToEnd().Trim();
+                    child.WaitForExit();
+                    runs.Add(line.Split(' ').Select(t => double.Parse(t, CultureInfo.InvariantCulture)).ToArray());
+                }
+            }
+
+            var medians = new double[Steps.Length];
+            for (int i = 0; i < Steps.Length; i++)
+            {
+                var sorted = runs.Select(r => r[i]).OrderBy(t => t).ToArray();
+                medians[i] = sorted[sorted.Length / 2];
+            }
+            return medians;
+        }
+
+        private static double Lap(ref long start)
+        {
+            long now = Stopwatch.GetTimestamp();
+            double microseconds = (now - start) * 1_000_000.0 / Stopwatch.Frequency;
+            start = now;
+            return microseconds;
+        }
+
+        /// <summary>
+        /// Defaults plus what a user who has had the app a while has added
+        /// </summary>
+        private static AppSettings CreateSettings()
+        {
+            var settings = new AppSettings
+            {
+                SelectedCharacterFile = @"C:\Windows\msagent\chars\Merlin.acs",
+                UserName = "Sam",
+                UserDescription = "Plays a lot of strategy games and likes retro computers.",
+                EnableOllamaChat = true,
+                EnableMemories = true,
+                OllamaModel = "llama3.2"
+            };
+            settings.AdditionalCharacterFiles.Add(@"C:\Windows\msagent\chars\Genie.acs");
+            settings.PipelineMacros["greet"] = "SPEAK:Hello!|ANIMATION:Wave";
+            settings.PipelineCommandCosts["CHAT"] = 60;
+            settings.PipelineEvents["raid"] = new PipelineEventSettings
+            {
+                Lines = new List<string> { "Welcome, ##from## and friends!", "A raid of ##viewers##!" },
+                Prompt = "##from## raided with ##viewers## viewers. Greet them."
+            };
+            for (int i = 0; i < 20; i++)
+            {
+                settings.PronunciationDictionary["Word" + i] = "Pronounced " + i;
+                settings.Jokes.Add($"Joke number {i}, which is about as funny as the last one.");
+            }
+            return settings;
+        }
+
+        private static List<Memory> CreateMemories()
+        {
+            var random = new Random(42);
+            string[] categories = { "user_info", "preference", "important", "recurring", "conversation" };
+            var memories = new List<Memory>(MemoryCount);
+            var start = new DateTime(2026, 1, 1, 9, 0, 0, DateTimeKind.Local);
+            for (int i = 0; i < MemoryCount; i++)
+            {
+                memories.Add(new Memory
+                {
+                    Content = $"User said: I like playing chess on weekends with my friend number {i} \"quoted\"",
+                    Category = categories[i % categories.Length],
+                    Importance = 5 + random.Next(50) / 10.0,
+                    Timestamp = start.AddMinutes(i * 37),
+                    LastAccessed = start.AddMinutes(i * 53).AddTicks(random.Next(10_000_000)),
+                    AccessCount = random.Next(20),
+                    Tags = i % 3 == 0 ? new[] { "games", "weekend" } : Array.Empty<string>()
+                });
+            }
+            return memories;
+        }
+
+        private static List<OllamaClient.ChatMessage> CreateMessages()
+        {
+            var messages = new List<OllamaClient.ChatMessage>
+            {
+                new OllamaClient.ChatMessage { Role = "system", Content = new string('x', 1800) + " NEVER use em dashes (\u2014) or emojis." }
+            };
+            for (int i = 0; i < 5; i++)
+            {
+                messages.Add(new OllamaClient.ChatMessage { Role = "user", Content = $"What do you think about question {i}? It's \"interesting\"." });
+                messages.Add(new OllamaClient.ChatMessage { Role = "assistant", Content = $"&&Think Hmm, question {i} is a /emp/ good one. I'd say yes!" });
+            }
+            messages.Add(new OllamaClient.ChatMessage { Role = "user", Content = "Tell me a joke about computers." });
+            return messages;
+        }
+    }
+}
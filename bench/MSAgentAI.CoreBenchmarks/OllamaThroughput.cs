@@ -0,0 +1,115 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.AI;
+using MSAgentAI.Benchmarks;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// OllamaClient.ChatAsync throughput with several chats at once, against a fake server that
+    /// takes a fixed time per answer. Shows what the HTTP stack costs per request and how many
+    /// requests it lets reach the server together.
+    /// </summary>
+    public static class OllamaThroughput
+    {
+        private static readonly int[] Concurrency = { 1, 4, 8, 16 };
+
+        public static async Task RunAsync(int chats, int warmup, int port, int delayMs, string ollamaUrl)
+        {
+            FakeOllamaServer server = ollamaUrl == null ? new FakeOllamaServer(port, delayMs) : null;
+            try
+            {
+                using (var client = new OllamaClient
+                {
+                    BaseUrl = ollamaUrl ?? server.Url,
+                    Model = ollamaUrl == null ? "bench" : "llama3.2",
+                    PersonalityPrompt = "You are a helpful and friendly desktop companion. Keep responses short and conversational."
+                })
+                {
+                    client.AvailableAnimations = new List<string> { "Greet", "Wave", "Pleased", "Surprised", "Think", "Explain" };
+
+                    string target = server != null ? $"fake server, {delayMs} ms per answer" : ollamaUrl;
+                    Console.WriteLine($"ChatAsync throughput, {chats} chats per row after {warmup} warmup, against {target}");
+                    Console.WriteLine();
+                    Console.WriteLine("| Chats at once |  chats | failed |  seconds |  chats/s |  p50 ms |  p99 ms | at server |");
+                    Console.WriteLine("|--------------:|-------:|-------:|---------:|---------:|--------:|--------:|----------:|");
+
+                    foreach (int concurrency in Concurrency)
+                    {
+                        await MeasureAsync(client, concurrency, warmup, null);
+                        server?.ResetPeak();
+
+                        var stats = new LatencyStats(concurrency.ToString(CultureInfo.InvariantCulture), chats);
+                        var stopwatch = Stopwatch.StartNew();
+                        int failed = await MeasureAsync(client, concurrency, chats, stats);
+                        double seconds = stopwatch.Elapsed.TotalSeconds;
+
+                        Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+                            "| {0,13} | {1,6} | {2,6} | {3,8:F2} | {4,8:F1} | {5,7:F2} | {6,7:F2} | {7,9} |",
+                            concurrency, chats, failed, seconds, chats / seconds,
+                            stats.Percentile(50) / 1000, stats.Percentile(99) / 1000,
+                            server != null ? server.PeakInFlight.ToString(CultureInfo.InvariantCulture) : "-"));
+                    }
+
+                    if (server != null)
+                    {
+                        Console.WriteLine();
+                        Console.WriteLine($"Connections opened: {server.Connections}");
+                    }
+                }
+            }
+            finally
+            {
+                server?.Dispose();
+            }
+        }
+
+        /// <summary>
+        /// Runs count chats spread over concurrency workers, each in its own conversation.
+        /// Returns how many got no answer.
+        /// </summary>
+        private static async Task<int> MeasureAsync(OllamaClient client, int concurrency, int count, LatencyStats stats)
+        {
+            int remaining = count;
+            int failed = 0;
+            var workers = new Task[concurrency];
+            for (int w = 0; w < concurrency; w++)
+            {
+                workers[w] = Task.Run(async () =>
+                {
+                    var session = new ChatSession();
+                    int turn = 0;
+                    while (Interlocked.Decrement(ref remaining) >= 0)
+                    {
+                        // A short conversation, then a new one, so prompts stay a realistic size
+                        if (++turn % 4 == 0)
+                        {
+                            session.Clear();
+                        }
+
+                        long start = Stopwatch.GetTimestamp();
+                        string response = await client.ChatAsync(session, "What do you think about the weather today?", null, CancellationToken.None);
+                        long end = Stopwatch.GetTimestamp();
+                        if (stats != null)
+                        {
+                            lock (stats)
+                            {
+                                stats.Add(start, end);
+                            }
+                        }
+                        if (response == null)
+                        {
+                            Interlocked.Increment(ref failed);
+                        }
+                    }
+                });
+            }
+            await Task.WhenAll(workers);
+            return failed;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading.Tasks;
+using MSAgentAI.Agent;
+using MSAgentAI.Benchmarks;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// Commands per second through PipelineServer over TCP, from one and from several clients
+    /// that each wait for every response, as game mods do
+    /// </summary>
+    public static class PipelineThroughput
+    {
+        private static readonly int[] Connections = { 1, 4, 16 };
+        private static readonly string[] Commands = { "PING", "SPEAK:Hello there, how are you today?", "STATE", "ANIMATION:Wave" };
+
+        public static async Task RunAsync(int iterations, int warmup, int port)
+        {
+            var state = new AgentState(1, "Bench", true, 100, 100, null, null, 0, 0);
+            using (var server = new PipelineServer("TCP", "127.0.0.1", port, PipelineServer.PipeName))
+            {
+                server.OnSpeakCommand += (s, command) => { };
+                server.OnAnimationCommand += (s, command) => { };
+                server.StateProvider = character => state.Format();
+                server.RateLimiter = null;
+                server.Start();
+                await Task.Delay(200);
+
+                Console.WriteLine($"Pipeline throughput, {iterations} commands per row after {warmup} warmup, PING/SPEAK/STATE/ANIMATION in turn");
+                Console.WriteLine();
+                Console.WriteLine("| Connections |  commands |  seconds |  commands/s |  p50 us |  p99 us |");
+                Console.WriteLine("|------------:|----------:|---------:|------------:|--------:|--------:|");
+
+                foreach (int connections in Connections)
+                {
+                    await MeasureAsync(port, connections, warmup, null);
+
+                    var stats = new LatencyStats(connections.ToString(CultureInfo.InvariantCulture), iterations);
+                    var stopwatch = Stopwatch.StartNew();
+                    await MeasureAsync(port, connections, iterations, stats);
+                    double seconds = stopwatch.Elapsed.TotalSeconds;
+
+                    Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+                        "| {0,11} | {1,9} | {2,8:F2} | {3,11:N0} | {4,7:F1} | {5,7:F1} |",
+                        connections, iterations, seconds, iterations / seconds, stats.Percentile(50), stats.Percentile(99)));
+                }
+            }
+        }
+
+        private static async Task MeasureAsync(int port, int connections, int count, LatencyStats stats)
+        {
+            var clients = new Task[connections];
+            for (int c = 0; c < connections; c++)
+            {
+                int share = count / connections + (c < count % connections ? 1 : 0);
+                clients[c] = Task.Run(() => RunClientAsync(port, share, stats));
+            }
+            await Task.WhenAll(clients);
+        }
+
+        private static async Task RunClientAsync(int port, int count, LatencyStats stats)
+        {
+            using (var client = new TcpClient { NoDelay = true })
+            {
+                await client.ConnectAsync("127.0.0.1", port);
+                var stream = client.GetStream();
+                var reader = new StreamReader(stream, new UTF8Encoding(false));
+                var writer = new StreamWriter(stream, new UTF8Encoding(false)) { AutoFlush = true, NewLine = "\n" };
+
+                for (int i = 0; i < count; i++)
+                {
+                    long start = Stopwatch.GetTimestamp();
+                    await writer.WriteLineAsync(Commands[i % Commands.Length]);
+                    if (await reader.ReadLineAsync() == null)
+                        throw new IOException("Pipeline closed the connection");
+                    long end = Stopwatch.GetTimestamp();
+
+                    // LatencyStats isn't thread-safe; clients share it
+                    if (stats != null)
+                    {
+                        lock (stats)
+                        {
+                            stats.Add(start, end);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,165 @@
+using System;
+using System.Reflection;
+using System.Runtime.InteropServices;
+using System.Runtime.Versioning;
+using System.Threading.Tasks;
+using MSAgentAI.AI;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// Benchmark runner for MSAgentAI.Core. Run it once per target framework to compare runtimes.
+    /// </summary>
+    public static class Program
+    {
+        private const string Usage =
+            "Usage: MSAgentAI.CoreBenchmarks <suite> [options]\n" +
+            "\n" +
+            "Suites:\n" +
+            "  pipeline    Commands/sec through PipelineServer over TCP from 1, 4 and 16 connections\n" +
+            "  ollama      OllamaClient chats/sec with 1 to 16 chats at once, against a fake server or --ollama\n" +
+            "  json        Settings, memories and chat JSON: hand-written serializers against JsonConvert, warm and cold\n" +
+            "  text        ns/op and B/op of the per-line text, prompt, command and request building paths\n" +
+            "\n" +
+            "Options:\n" +
+            "  --iterations N   Measured commands (pipeline, default 50000), chats (ollama, default 400), calls (json, default 2000)\n" +
+            "                   or batches (text, default 20) per row\n" +
+            "  --warmup N       Unmeasured commands, chats or calls first (default 2000 / 40 / 200)\n" +
+            "  --port N         Port on 127.0.0.1 for the server (default 18865)\n" +
+            "  --delay-ms N     How long the fake Ollama takes per answer (default 50)\n" +
+            "  --ollama URL     Use a real Ollama instead of the fake one\n" +
+            "  --save FILE      Write the text results to FILE as JSON\n" +
+            "  --compare FILE   Compare the text results with FILE; exits 1 if allocations grew\n" +
+            "  --max-slowdown P With --compare, also exit 1 if a case got more than P percent slower";
+
+        public static async Task<int> Main(string[] args)
+        {
+            if (args.Length == 0)
+            {
+                Console.Error.WriteLine(Usage);
+                return 2;
+            }
+
+            // Started by the json suite, once per serializer, to time first calls
+            if (args[0] == "json-cold" && args.Length == 3)
+            {
+                JsonSerialization.RunColdChild(args[1], args[2]);
+                return 0;
+            }
+
+            int? iterations = null;
+            int? warmup = null;
+            int port = 18865;
+            int delayMs = 50;
+            string ollamaUrl = null;
+            string savePath = null;
+            string comparePath = null;
+            int? maxSlowdown = null;
+
+            try
+            {
+                for (int i = 1; i < args.Length; i++)
+                {
+                    string value = i + 1 < args.Length ? args[i + 1] : null;
+                    switch (args[i])
+                    {
+                        case "--iterations":
+                            iterations = ParseNumber(args[i], value, 1);
+                            i++;
+                            break;
+                        case "--warmup":
+                            warmup = ParseNumber(args[i], value, 0);
+                            i++;
+                            break;
+                        case "--port":
+                            port = ParseNumber(args[i], value, 1);
+                            i++;
+                            break;
+                        case "--delay-ms":
+                            delayMs = ParseNumber(args[i], value, 0);
+                            i++;
+                            break;
+                        case "--ollama":
+                            ollamaUrl = value ?? throw new ArgumentException("--ollama needs a URL");
+                            i++;
+                            break;
+                        case "--save":
+                            savePath = value ?? throw new ArgumentException("--save needs a file");
+                            i++;
+                            break;
+                        case "--compare":
+                            comparePath = value ?? throw new ArgumentException("--compare needs a file");
+                            i++;
+                            break;
+                        case "--max-slowdown":
+                            maxSlowdown = ParseNumber(args[i], value, 0);
+                            i++;
+                            break;
+                        default:
+                            throw new ArgumentException($"Unknown option {args[i]}");
+                    }
+                }
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                Console.Error.WriteLine();
+                Console.Error.WriteLine(Usage);
+                return 2;
+            }
+
+            PrintRuntime();
+
+            switch (args[0].ToLowerInvariant())
+            {
+                case "pipeline":
+                    await PipelineThroughput.RunAsync(iterations ?? 50000, warmup ?? 2000, port);
+                    return 0;
+
+                case "ollama":
+                    await OllamaThroughput.RunAsync(iterations ?? 400, warmup ?? 40, port, delayMs, ollamaUrl);
+                    return 0;
+
+                case "json":
+                    JsonSerialization.Run(iterations ?? 2000, warmup ?? 200);
+                    return Environment.ExitCode;
+
+                case "text":
+                    var results = TextHotPaths.Run(iterations ?? 20);
+                    if (savePath != null)
+                    {
+                        BenchmarkResults.Save(savePath, "text", results);
+                    }
+                    if (comparePath != null && !BenchmarkResults.Compare(comparePath, results, maxSlowdown))
+                        return 1;
+                    return 0;
+
+                default:
+                    Console.Error.WriteLine($"Unknown suite {args[0]}");
+                    Console.Error.WriteLine();
+                    Console.Error.WriteLine(Usage);
+                    return 2;
+            }
+        }
+
+        /// <summary>
+        /// Shows which runtime is running and which build of the core it loaded, so results from
+        /// different runs can be told apart
+        /// </summary>
+        private static void PrintRuntime()
+        {
+            string core = typeof(OllamaClient).Assembly.GetCustomAttribute<TargetFrameworkAttribute>()?.FrameworkName ?? "unknown";
+            Console.WriteLine($"Runtime: {RuntimeInformation.FrameworkDescription} ({RuntimeInformation.ProcessArchitecture})");
+            Console.WriteLine($"OS:      {RuntimeInformation.OSDescription}");
+            Console.WriteLine($"Core:    {core}");
+            Console.WriteLine();
+        }
+
+        private static int ParseNumber(string name, string value, int minimum)
+        {
+            if (!int.TryParse(value, out int result) || result < minimum)
+                throw new ArgumentException($"{name} needs a number of at least {minimum}");
+            return result;
+        }
+    }
+}
@@ -0,0 +1,223 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using MSAgentAI.Agent;
+using MSAgentAI.AI;
+using MSAgentAI.Config;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.CoreBenchmarks
+{
+    /// <summary>
+    /// Per-call cost of the text work done for every line the agent says and every command it
+    /// gets: pronunciation and animation processing, sentence splitting, response cleanup, the
+    /// system prompt, pipeline command dispatch and the chat request body. Each case runs in
+    /// batches sized to about 10 ms and reports the median batch as ns/op, plus bytes allocated
+    /// per op, which unlike time doesn't depend on the machine.
+    /// </summary>
+    public static class TextHotPaths
+    {
+        private const double BatchMilliseconds = 10;
+
+        // Long enough for tiered JIT to replace the first, unoptimized code
+        private const double WarmupMilliseconds = 300;
+
+        // A typical reply from the model, before and after CleanResponse
+        private const string RawReply = "&&Wave Oh, hello there ##! I just read that the new NVIDIA GPU runs AI models twice as fast — /emp/ amazing. " +
+            "Want me to open the API docs on GitHub?** I could also explain how Ollama loads a model... It's easier than it sounds! \U0001F600 &&Explain";
+        private static readonly string CleanedReply = OllamaClient.CleanResponse(RawReply);
+
+        // What people add to the dictionary: streamers, games, tech words and names the voice gets wrong
+        private static readonly string[] Pronunciations =
+        {
+            "NVIDIA", "En Vidia", "GPU", "Gee Pee You", "CPU", "See Pee You", "SQL", "Sequel", "GIF", "Jif", "JSON", "Jason",
+            "Linux", "Linnux", "Ubuntu", "Oo Boon Too", "GitHub", "Git Hub", "YouTube", "You Tube", "Twitch", "Twitch",
+            "OBS", "Oh Bee Ess", "Minecraft", "Mine Craft", "Fortnite", "Fort Night", "Valorant", "Val Oh Rant",
+            "Skyrim", "Sky Rim", "Genshin", "Gen Shin", "Steam", "Steem", "Discord", "Dis Cord", "Reddit", "Red It",
+            "Windows", "Win Doze", "macOS", "Mack Oh Ess", "iOS", "Eye Oh Ess", "SSD", "Ess Ess Dee", "RAM", "Ram",
+            "USB", "You Ess Bee", "HDMI", "Aitch Dee Em Eye", "WiFi", "Why Fye", "LLM", "El El Em", "ChatGPT", "Chat Gee Pee Tee",
+            "Merlin", "Mer Lin", "Genie", "Jee Nee", "Peedy", "Pee Dee", "Clippy", "Clip Ee", "Rover", "Roe Ver",
+            "Cortana", "Cor Tah Na", "Alexa", "Ah Lex Ah", "Siri", "Seer Ee", "emoji", "Ee Moe Jee", "meme", "Meem",
+            "sudo", "Sue Doo", "nginx", "Engine X", "kubectl", "Cube Control", "Qt", "Cute", "SaaS", "Sass"
+        };
+
+        private sealed class Case
+        {
+            public Case(string name, Action action)
+            {
+                Name = name;
+                Action = action;
+            }
+
+            public string Name { get; }
+            public Action Action { get; }
+        }
+
+        public static List<BenchmarkResult> Run(int batches)
+        {
+            string memoriesPath = Path.Combine(Path.GetTempPath(), $"MSAgentAI.CoreBenchmarks.{Process.GetCurrentProcess().Id}.memories.json");
+            try
+            {
+                var cases = CreateCases(memoriesPath);
+                Console.WriteLine($"Text hot paths, median of {batches} batches of about {BatchMilliseconds} ms each");
+                Console.WriteLine();
+                Console.WriteLine("| Case                                |      ns/op |    B/op |");
+                Console.WriteLine("|-------------------------------------|-----------:|--------:|");
+
+                var results = new List<BenchmarkResult>();
+                foreach (var c in cases)
+                {
+                    var result = Measure(c, batches);
+                    results.Add(result);
+                    Console.WriteLine(string.Format(CultureInfo.InvariantCulture, "| {0,-35} | {1,10:N0} | {2,7:N0} |",
+                        result.Name, result.Nanoseconds, result.Bytes));
+                }
+                Console.WriteLine();
+                return results;
+            }
+            finally
+            {
+                File.Delete(memoriesPath);
+            }
+        }
+
+        private static List<Case> CreateCases(string memoriesPath)
+        {
+            var defaults = new AppSettings { UserName = "Sam" };
+            var large = new AppSettings { UserName = "Sam", UserNamePronunciation = "Sahm" };
+            for (int i = 0; i < Pronunciations.Length; i += 2)
+            {
+                large.PronunciationDictionary[Pronunciations[i]] = Pronunciations[i + 1];
+            }
+
+            var animations = Enumerable.Range(0, 50).Select(i => "Animation" + i).ToList();
+            var client = new OllamaClient
+            {
+                PersonalityPrompt = AppSettings.PersonalityPresets.Values.First(),
+                UserDescription = "Plays a lot of strategy games and likes retro computers.",
+                AvailableAnimations = animations
+            };
+
+            File.WriteAllText(memoriesPath, MemoryJson.Serialize(CreateMemories(200)));
+            var remembering = new OllamaClient
+            {
+                PersonalityPrompt = client.PersonalityPrompt,
+                UserDescription = client.UserDescription,
+                AvailableAnimations = animations,
+                MemoryManager = new MemoryManager(memoriesPath) { Enabled = true }
+            };
+
+            var state = new AgentState(1, "Bench", true, 100, 100, null, null, 0, 0);
+            var server = new PipelineServer("TCP", "127.0.0.1", 0, PipelineServer.PipeName);
+            server.OnSpeakCommand += (s, command) => { };
+            server.OnAnimationCommand += (s, command) => { };
+            server.StateProvider = character => state.Format();
+            server.RateLimiter = null;
+            var connection = new PipelineConnection("bench");
+
+            var messages = CreateMessages(client.BuildSystemPrompt());
+            var options = new OllamaOptions { NumPredict = 150, Temperature = 0.8, NumContext = 4096 };
+
+            return new List<Case>
+            {
+                new Case($"ProcessText {defaults.PronunciationDictionary.Count} words", () => defaults.ProcessText(CleanedReply)),
+                new Case($"ProcessText {large.PronunciationDictionary.Count} words", () => large.ProcessText(CleanedReply)),
+                new Case("ExtractAnimationTriggers", () => AppSettings.ExtractAnimationTriggers(CleanedReply)),
+                new Case("SplitIntoSentences", () => AppSettings.SplitIntoSentences(CleanedReply)),
+                new Case("CleanResponse", () => OllamaClient.CleanResponse(RawReply)),
+                new Case("BuildSystemPrompt", () => client.BuildSystemPrompt()),
+                new Case("BuildSystemPrompt 200 memories", () => remembering.BuildSystemPrompt()),
+                new Case("ProcessCommand PING", () => server.ProcessCommand("PING", connection)),
+                new Case("ProcessCommand SPEAK", () => server.ProcessCommand("SPEAK:Hello there, how are you today?", connection)),
+                new Case("ProcessCommand ANIMATION", () => server.ProcessCommand("ANIMATION:Wave", connection)),
+                new Case("ProcessCommand STATE", () => server.ProcessCommand("STATE", connection)),
+                new Case($"Chat request {messages.Count} messages", () => OllamaJson.CreateChatContent("llama3.2", messages, options).Dispose())
+            };
+        }
+
+        /// <summary>
+        /// Warms up, sizes a batch to about BatchMilliseconds, then times that many batches.
+        /// Allocations are counted over all of them.
+        /// </summary>
+        private static BenchmarkResult Measure(Case c, int batches)
+        {
+            var warmup = Stopwatch.StartNew();
+            while (warmup.Elapsed.TotalMilliseconds < WarmupMilliseconds)
+            {
+                c.Action();
+            }
+
+            int perBatch = 1;
+            while (true)
+            {
+                long start = Stopwatch.GetTimestamp();
+                for (int i = 0; i < perBatch; i++)
+                {
+                    c.Action();
+                }
+                double milliseconds = (Stopwatch.GetTimestamp() - start) * 1000.0 / Stopwatch.Frequency;
+                if (milliseconds >= BatchMilliseconds / 4 || perBatch >= 1 << 24)
+                {
+                    perBatch = Math.Max(1, (int)(perBatch * BatchMilliseconds / Math.Max(milliseconds, 0.001)));
+                    break;
+                }
+                perBatch *= 4;
+            }
+
+            var times = new double[batches];
+            long allocated = JsonSerialization.AllocatedBytes();
+            for (int b = 0; b < batches; b++)
+            {
+                long start = Stopwatch.GetTimestamp();
+                for (int i = 0; i < perBatch; i++)
+                {
+                    c.Action();
+                }
+                times[b] = (Stopwatch.GetTimestamp() - start) * 1_000_000_000.0 / Stopwatch.Frequency / perBatch;
+            }
+            long bytes = JsonSerialization.AllocatedBytes() - allocated;
+
+            Array.Sort(times);
+            return new BenchmarkResult(c.Name, times[batches / 2], (long)Math.Round((double)bytes / batches / perBatch));
+        }
+
+        private static List<Memory> CreateMemories(int count)
+        {
+            var random = new Random(42);
+            string[] categories = { "user_info", "preference", "important", "recurring", "conversation" };
+            var memories = new List<Memory>(count);
+            var start = DateTime.Now.AddDays(-60);
+            for (int i = 0; i < count; i++)
+            {
+                memories.Add(new Memory
+                {
+                    Content = $"User said: I like playing chess on weekends with my friend number {i}",
+                    Category = categories[i % categories.Length],
+                    Importance = 5 + random.Next(50) / 10.0,
+                    Timestamp = start.AddMinutes(i * 300),
+                    LastAccessed = start.AddMinutes(i * 400),
+                    AccessCount = random.Next(20)
+                });
+            }
+            return memories;
+        }
+
+        private static List<OllamaClient.ChatMessage> CreateMessages(string systemPrompt)
+        {
+            var messages = new List<OllamaClient.ChatMessage>
+            {
+                new OllamaClient.ChatMessage { Role = "system", Content = systemPrompt }
+            };
+            for (int i = 0; i < 5; i++)
+            {
+                messages.Add(new OllamaClient.ChatMessage { Role = "user", Content = $"What do you think about question {i}? It's \"interesting\"." });
+                messages.Add(new OllamaClient.ChatMessage { Role = "assistant", Content = CleanedReply });
+            }
+            messages.Add(new OllamaClient.ChatMessage { Role = "user", Content = "Tell me a joke about computers." });
+            return messages;
+        }
+    }
+}
@@ -0,0 +1,276 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Net.Sockets;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Client
+{
+    /// <summary>
+    /// Sends commands to MSAgent AI over persistent connections. Requests can be issued from
+    /// any thread and overlap: each is written as soon as the connection is free and awaits its
+    /// own response. Lost connections are reopened on the next request, backing off between
+    /// failed attempts.
+    /// </summary>
+    public sealed class PipelineClient : IDisposable
+    {
+        private static readonly Random Jitter = new Random();
+
+        private readonly PipelineClientOptions _options;
+        private readonly Slot[] _slots;
+        private long _sent;
+        private long _reconnects;
+        private volatile bool _disposed;
+
+        public PipelineClient()
+            : this(new PipelineClientOptions())
+        {
+        }
+
+        public PipelineClient(PipelineClientOptions options)
+        {
+            _options = (options ?? throw new ArgumentNullException(nameof(options))).Validate();
+            _slots = new Slot[options.PoolSize];
+            for (int i = 0; i < _slots.Length; i++)
+            {
+                _slots[i] = new Slot();
+            }
+        }
+
+        public PipelineClientOptions Options => _options;
+
+        /// <summary>
+        /// Commands written to the server
+        /// </summary>
+        public long Sent => Interlocked.Read(ref _sent);
+
+        /// <summary>
+        /// Times a lost connection was opened again
+        /// </summary>
+        public long Reconnects => Interlocked.Read(ref _reconnects);
+
+        /// <summary>
+        /// Opens every pooled connection now rather than on first use
+        /// </summary>
+        public async Task ConnectAsync(CancellationToken cancellationToken = default)
+        {
+            foreach (var slot in _slots)
+            {
+                await GetOpenConnectionAsync(slot, cancellationToken).ConfigureAwait(false);
+            }
+        }
+
+        /// <summary>
+        /// Sends one command line and returns the server's response, e.g. OK:SPEAK or
+        /// ERROR:message. Throws PipelineClientException if the connection fails and
+        /// TimeoutException if no response arrives within RequestTimeout.
+        /// </summary>
+        public async Task<string> SendAsync(string command, CancellationToken cancellationToken = default)
+        {
+            var responses = await WriteAsync(new[] { CheckLine(command) }, cancellationToken).ConfigureAwait(false);
+            return await WaitAsync(responses[0], cancellationToken).ConfigureAwait(false);
+        }
+
+        /// <summary>
+        /// Sends several commands in one write on one connection and returns their responses in
+        /// the same order. The server runs them one after another, as if sent separately.
+        /// </summary>
+        public async Task<IReadOnlyList<string>> SendBatchAsync(IEnumerable<string> commands, CancellationToken cancellationToken = default)
+        {
+            if (commands == null)
+                throw new ArgumentNullException(nameof(commands));
+
+            var lines = new List<string>();
+            foreach (var command in commands)
+            {
+                lines.Add(CheckLine(command));
+            }
+            if (lines.Count == 0)
+                return new string[0];
+
+            var responses = await WriteAsync(lines, cancellationToken).ConfigureAwait(false);
+            return await WaitAsync(Task.WhenAll(responses), cancellationToken).ConfigureAwait(false);
+        }
+
+        public Task<string> PingAsync(CancellationToken cancellationToken = default)
+        {
+            return SendAsync("PING", cancellationToken);
+        }
+
+        public Task<string> SpeakAsync(string text, CancellationToken cancellationToken = default)
+        {
+            return SendAsync("SPEAK:" + text, cancellationToken);
+        }
+
+        public Task<string> PlayAnimationAsync(string animation, CancellationToken cancellationToken = default)
+        {
+            return SendAsync("ANIMATION:" + animation, cancellationToken);
+        }
+
+        /// <summary>
+        /// Queues a prompt for the AI. The response only confirms it was queued.
+        /// </summary>
+        public Task<string> ChatAsync(string prompt, CancellationToken cancellationToken = default)
+        {
+            return SendAsync("CHAT:" + prompt, cancellationToken);
+        }
+
+        private static string CheckLine(string command)
+        {
+            if (string.IsNullOrEmpty(command))
+                throw new ArgumentException("Commands can't be empty");
+            if (command.IndexOf('\n') >= 0 || command.IndexOf('\r') >= 0)
+                throw new ArgumentException("Commands can't contain line breaks");
+            return command;
+        }
+
+        private async Task<Task<string>[]> WriteAsync(IReadOnlyList<string> lines, CancellationToken cancellationToken)
+        {
+            for (int attempt = 1; ; attempt++)
+            {
+                if (_disposed)
+                    throw new ObjectDisposedException(nameof(PipelineClient));
+
+                var connection = await GetOpenConnectionAsync(PickSlot(), cancellationToken).ConfigureAwait(false);
+                var responses = await connection.WriteAsync(lines, cancellationToken).ConfigureAwait(false);
+                if (responses != null)
+                {
+                    Interlocked.Add(ref _sent, lines.Count);
+                    return responses;
+                }
+
+                // The connection dropped before anything was written, so it is safe to try again
+                if (attempt >= _options.ConnectAttempts)
+                    throw new PipelineClientException($"The connection to {_options} keeps closing");
+            }
+        }
+
+        /// <summary>
+        /// The connection with the fewest requests waiting; a closed one counts as idle, so it
+        /// gets reopened
+        /// </summary>
+        private Slot PickSlot()
+        {
+            if (_slots.Length == 1)
+                return _slots[0];
+
+            Slot best = null;
+            int bestPending = int.MaxValue;
+            foreach (var slot in _slots)
+            {
+                var connection = slot.Connection;
+                int pending = connection != null && connection.IsOpen ? connection.PendingCount : 0;
+                if (pending < bestPending)
+                {
+                    best = slot;
+                    bestPending = pending;
+                }
+            }
+            return best;
+        }
+
+        private async Task<PipelineClientConnection> GetOpenConnectionAsync(Slot slot, CancellationToken cancellationToken)
+        {
+            var connection = slot.Connection;
+            if (connection != null && connection.IsOpen)
+                return connection;
+
+            await slot.ConnectLock.WaitAsync(cancellationToken).ConfigureAwait(false);
+            try
+            {
+                // Another request may have reconnected while we waited
+                connection = slot.Connection;
+                if (connection != null && connection.IsOpen)
+                    return connection;
+
+                bool reconnecting = connection != null;
+                connection?.Dispose();
+
+                for (int attempt = 0; ; attempt++)
+                {
+                    try
+                    {
+                        connection = await PipelineClientConnection.ConnectAsync(_options, cancellationToken).ConfigureAwait(false);
+                        break;
+                    }
+                    catch (Exception ex) when (ex is IOException || ex is SocketException || ex is TimeoutException || ex is UnauthorizedAccessException)
+                    {
+                        if (attempt + 1 >= _options.ConnectAttempts)
+                            throw new PipelineClientException($"Could not connect to {_options} after {attempt + 1} attempt(s)", ex);
+                        await Task.Delay(GetBackoff(attempt), cancellationToken).ConfigureAwait(false);
+                    }
+                }
+
+                if (_disposed)
+                {
+                    connection.Dispose();
+                    throw new ObjectDisposedException(nameof(PipelineClient));
+                }
+                if (reconnecting)
+                {
+                    Interlocked.Increment(ref _reconnects);
+                }
+                slot.Connection = connection;
+                return connection;
+            }
+            finally
+            {
+                slot.ConnectLock.Release();
+            }
+        }
+
+        /// <summary>
+        /// ReconnectDelay doubled per failed attempt, capped, with +/-20% jitter so clients
+        /// dropped together don't all retry together
+        /// </summary>
+        private TimeSpan GetBackoff(int attempt)
+        {
+            double delay = _options.ReconnectDelay.TotalMilliseconds * Math.Pow(2, Math.Min(attempt, 16));
+            delay = Math.Min(delay, _options.MaxReconnectDelay.TotalMilliseconds);
+            double jitter;
+            lock (Jitter)
+            {
+                jitter = 0.8 + Jitter.NextDouble() * 0.4;
+            }
+            return TimeSpan.FromMilliseconds(delay * jitter);
+        }
+
+        /// <summary>
+        /// Waits for a response with the request timeout. A response that arrives after its
+        /// caller gave up is still taken off the connection, so later responses stay in step.
+        /// </summary>
+        private async Task<T> WaitAsync<T>(Task<T> response, CancellationToken cancellationToken)
+        {
+            if (response.IsCompleted || (_options.RequestTimeout == Timeout.InfiniteTimeSpan && !cancellationToken.CanBeCanceled))
+                return await response.ConfigureAwait(false);
+
+            using (var timeout = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken))
+            {
+                var delay = Task.Delay(_options.RequestTimeout, timeout.Token);
+                if (await Task.WhenAny(response, delay).ConfigureAwait(false) != response)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    throw new TimeoutException($"No response from {_options} within {_options.RequestTimeout.TotalSeconds:0.#}s");
+                }
+                timeout.Cancel();
+                return await response.ConfigureAwait(false);
+            }
+        }
+
+        public void Dispose()
+        {
+            _disposed = true;
+            foreach (var slot in _slots)
+            {
+                slot.Connection?.Dispose();
+            }
+        }
+
+        private sealed class Slot
+        {
+            public readonly SemaphoreSlim ConnectLock = new SemaphoreSlim(1, 1);
+            public volatile PipelineClientConnection Connection;
+        }
+    }
+}
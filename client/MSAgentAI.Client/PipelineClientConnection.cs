@@ -0,0 +1,228 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Pipes;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Client
+{
+    /// <summary>
+    /// One persistent connection. The server answers each line in the order it was sent, so a
+    /// response belongs to the oldest request still waiting; that lets any number of requests
+    /// be in flight without ids in the protocol.
+    /// </summary>
+    internal sealed class PipelineClientConnection : IDisposable
+    {
+        private static readonly UTF8Encoding Utf8 = new UTF8Encoding(false);
+
+        private readonly Stream _stream;
+        private readonly ConcurrentQueue<TaskCompletionSource<string>> _pending = new ConcurrentQueue<TaskCompletionSource<string>>();
+        private readonly SemaphoreSlim _writeLock = new SemaphoreSlim(1, 1);
+        private byte[] _buffer = new byte[1024];
+        private int _pendingCount;
+        private Exception _fault;
+
+        private PipelineClientConnection(Stream stream)
+        {
+            _stream = stream;
+            _ = ReadResponsesAsync();
+        }
+
+        public bool IsOpen => Volatile.Read(ref _fault) == null;
+
+        /// <summary>
+        /// Requests sent and not yet answered
+        /// </summary>
+        public int PendingCount => Volatile.Read(ref _pendingCount);
+
+        public static async Task<PipelineClientConnection> ConnectAsync(PipelineClientOptions options, CancellationToken cancellationToken)
+        {
+            switch (options.Transport)
+            {
+                case PipelineTransport.Tcp:
+                    return new PipelineClientConnection(await ConnectTcpAsync(options, cancellationToken).ConfigureAwait(false));
+
+                case PipelineTransport.UnixSocket:
+#if NET
+                    var socket = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+                    try
+                    {
+                        using (var timeout = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken))
+                        {
+                            timeout.CancelAfter(options.ConnectTimeout);
+                            await socket.ConnectAsync(new UnixDomainSocketEndPoint(options.SocketPath), timeout.Token).ConfigureAwait(false);
+                        }
+                    }
+                    catch (OperationCanceledException) when (!cancellationToken.IsCancellationRequested)
+                    {
+                        socket.Dispose();
+                        throw new TimeoutException($"Timed out connecting to {options}");
+                    }
+                    catch
+                    {
+                        socket.Dispose();
+                        throw;
+                    }
+                    return new PipelineClientConnection(new NetworkStream(socket, ownsSocket: true));
+#else
+                    throw new PlatformNotSupportedException("Unix sockets need the .NET 8 build of MSAgentAI.Client");
+#endif
+
+                default:
+                    var pipe = new NamedPipeClientStream(options.PipeServer, options.PipeName, PipeDirection.InOut, PipeOptions.Asynchronous);
+                    try
+                    {
+                        await pipe.ConnectAsync((int)options.ConnectTimeout.TotalMilliseconds, cancellationToken).ConfigureAwait(false);
+                    }
+                    catch
+                    {
+                        pipe.Dispose();
+                        throw;
+                    }
+                    return new PipelineClientConnection(pipe);
+            }
+        }
+
+        private static async Task<Stream> ConnectTcpAsync(PipelineClientOptions options, CancellationToken cancellationToken)
+        {
+            var client = new TcpClient { NoDelay = true };
+            try
+            {
+                var connect = client.ConnectAsync(options.Host, options.Port);
+                var timeout = Task.Delay(options.ConnectTimeout, cancellationToken);
+                if (await Task.WhenAny(connect, timeout).ConfigureAwait(false) != connect)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    throw new TimeoutException($"Timed out connecting to {options}");
+                }
+                await connect.ConfigureAwait(false);
+                return client.GetStream();
+            }
+            catch
+            {
+                // Also abandons a connect still in progress after a timeout
+                client.Dispose();
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Writes the lines in one go and returns a task per line for its response. Returns
+        /// null if the connection was already lost, in which case nothing was sent.
+        /// </summary>
+        public async Task<Task<string>[]> WriteAsync(IReadOnlyList<string> lines, CancellationToken cancellationToken)
+        {
+            await _writeLock.WaitAsync(cancellationToken).ConfigureAwait(false);
+            try
+            {
+                if (!IsOpen)
+                    return null;
+
+                int length = Encode(lines);
+                var responses = new Task<string>[lines.Count];
+                for (int i = 0; i < lines.Count; i++)
+                {
+                    var response = new TaskCompletionSource<string>(TaskCreationOptions.RunContinuationsAsynchronously);
+                    _pending.Enqueue(response);
+                    Interlocked.Increment(ref _pendingCount);
+                    responses[i] = response.Task;
+                }
+
+                try
+                {
+                    // Not cancellable: stopping halfway through a line would corrupt the stream
+                    await _stream.WriteAsync(_buffer, 0, length).ConfigureAwait(false);
+                    await _stream.FlushAsync().ConfigureAwait(false);
+                }
+                catch (Exception ex) when (ex is IOException || ex is ObjectDisposedException || ex is InvalidOperationException)
+                {
+                    Fault(ex);
+                }
+
+                // Lost while writing: the reader may already have failed what was queued before us
+                if (!IsOpen)
+                {
+                    FailPending();
+                }
+                return responses;
+            }
+            finally
+            {
+                _writeLock.Release();
+            }
+        }
+
+        private int Encode(IReadOnlyList<string> lines)
+        {
+            int length = 0;
+            for (int i = 0; i < lines.Count; i++)
+            {
+                length += Utf8.GetByteCount(lines[i]) + 1;
+            }
+            if (_buffer.Length < length)
+            {
+                _buffer = new byte[Math.Max(length, _buffer.Length * 2)];
+            }
+
+            int offset = 0;
+            for (int i = 0; i < lines.Count; i++)
+            {
+                offset += Utf8.GetBytes(lines[i], 0, lines[i].Length, _buffer, offset);
+                _buffer[offset++] = (byte)'\n';
+            }
+            return offset;
+        }
+
+        private async Task ReadResponsesAsync()
+        {
+            try
+            {
+                using (var reader = new StreamReader(_stream, Utf8, true, 4096, leaveOpen: true))
+                {
+                    string line;
+                    while ((line = await reader.ReadLineAsync().ConfigureAwait(false)) != null)
+                    {
+                        if (_pending.TryDequeue(out var response))
+                        {
+                            Interlocked.Decrement(ref _pendingCount);
+                            response.TrySetResult(line);
+                        }
+                    }
+                }
+                Fault(new IOException("The server closed the connection"));
+            }
+            catch (Exception ex)
+            {
+                Fault(ex);
+            }
+        }
+
+        private void Fault(Exception ex)
+        {
+            if (Interlocked.CompareExchange(ref _fault, ex, null) == null)
+            {
+                _stream.Dispose();
+            }
+            FailPending();
+        }
+
+        private void FailPending()
+        {
+            var fault = Volatile.Read(ref _fault);
+            while (_pending.TryDequeue(out var response))
+            {
+                Interlocked.Decrement(ref _pendingCount);
+                response.TrySetException(new PipelineClientException("The connection was lost before the response arrived", fault));
+            }
+        }
+
+        public void Dispose()
+        {
+            Fault(new ObjectDisposedException(nameof(PipelineClient)));
+        }
+    }
+}
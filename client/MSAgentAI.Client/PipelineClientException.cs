@@ -0,0 +1,21 @@
+using System;
+
+namespace MSAgentAI.Client
+{
+    /// <summary>
+    /// The client could not connect, or lost its connection before a response arrived. A
+    /// command that fails this way may or may not have run.
+    /// </summary>
+    public class PipelineClientException : Exception
+    {
+        public PipelineClientException(string message)
+            : base(message)
+        {
+        }
+
+        public PipelineClientException(string message, Exception innerException)
+            : base(message, innerException)
+        {
+        }
+    }
+}
@@ -0,0 +1,117 @@
+using System;
+using System.Threading;
+
+namespace MSAgentAI.Client
+{
+    /// <summary>
+    /// How the client reaches the pipeline
+    /// </summary>
+    public enum PipelineTransport
+    {
+        NamedPipe,
+        Tcp,
+
+        /// <summary>
+        /// Unix domain socket, for hosts that listen on one (.NET 8 builds only)
+        /// </summary>
+        UnixSocket
+    }
+
+    /// <summary>
+    /// Settings for a PipelineClient. The defaults match the app's defaults.
+    /// </summary>
+    public sealed class PipelineClientOptions
+    {
+        public PipelineTransport Transport { get; set; } = PipelineTransport.NamedPipe;
+
+        /// <summary>
+        /// Pipe name for NamedPipe (PipelineName in the app's settings)
+        /// </summary>
+        public string PipeName { get; set; } = "MSAgentAI";
+
+        /// <summary>
+        /// Machine the named pipe is on; "." for this one
+        /// </summary>
+        public string PipeServer { get; set; } = ".";
+
+        public string Host { get; set; } = "127.0.0.1";
+        public int Port { get; set; } = 8765;
+
+        /// <summary>
+        /// Socket file for UnixSocket
+        /// </summary>
+        public string SocketPath { get; set; }
+
+        /// <summary>
+        /// Persistent connections to spread requests over. The app serves one named pipe
+        /// client at a time, so more than one only helps over TCP.
+        /// </summary>
+        public int PoolSize { get; set; } = 1;
+
+        public TimeSpan ConnectTimeout { get; set; } = TimeSpan.FromSeconds(5);
+
+        /// <summary>
+        /// How long to wait for a response; Timeout.InfiniteTimeSpan to wait forever
+        /// </summary>
+        public TimeSpan RequestTimeout { get; set; } = TimeSpan.FromSeconds(30);
+
+        /// <summary>
+        /// Connection attempts before a request fails, with the delay doubling after each
+        /// </summary>
+        public int ConnectAttempts { get; set; } = 5;
+
+        public TimeSpan ReconnectDelay { get; set; } = TimeSpan.FromMilliseconds(100);
+        public TimeSpan MaxReconnectDelay { get; set; } = TimeSpan.FromSeconds(5);
+
+        public static PipelineClientOptions ForNamedPipe(string pipeName = "MSAgentAI")
+        {
+            return new PipelineClientOptions { Transport = PipelineTransport.NamedPipe, PipeName = pipeName };
+        }
+
+        public static PipelineClientOptions ForTcp(string host = "127.0.0.1", int port = 8765)
+        {
+            return new PipelineClientOptions { Transport = PipelineTransport.Tcp, Host = host, Port = port };
+        }
+
+        public static PipelineClientOptions ForUnixSocket(string socketPath)
+        {
+            return new PipelineClientOptions { Transport = PipelineTransport.UnixSocket, SocketPath = socketPath };
+        }
+
+        /// <summary>
+        /// The endpoint, for error messages
+        /// </summary>
+        public override string ToString()
+        {
+            switch (Transport)
+            {
+                case PipelineTransport.Tcp:
+                    return $"tcp://{Host}:{Port}";
+                case PipelineTransport.UnixSocket:
+                    return $"unix:{SocketPath}";
+                default:
+                    return $@"\\{PipeServer}\pipe\{PipeName}";
+            }
+        }
+
+        internal PipelineClientOptions Validate()
+        {
+            switch (Transport)
+            {
+                case PipelineTransport.NamedPipe when string.IsNullOrEmpty(PipeName):
+                    throw new ArgumentException("PipeName is required for named pipes");
+                case PipelineTransport.Tcp when string.IsNullOrEmpty(Host) || Port <= 0 || Port > 65535:
+                    throw new ArgumentException("Host and a port from 1 to 65535 are required for TCP");
+                case PipelineTransport.UnixSocket when string.IsNullOrEmpty(SocketPath):
+                    throw new ArgumentException("SocketPath is required for Unix sockets");
+            }
+            if (PoolSize < 1)
+                throw new ArgumentException("PoolSize must be at least 1");
+            if (ConnectAttempts < 1)
+                throw new ArgumentException("ConnectAttempts must be at least 1");
+            if (RequestTimeout <= TimeSpan.Zero && RequestTimeout != Timeout.InfiniteTimeSpan)
+                throw new ArgumentException("RequestTimeout must be positive or infinite");
+            return this;
+        }
+    }
+}
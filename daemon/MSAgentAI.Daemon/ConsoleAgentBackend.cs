@@ -0,0 +1,261 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text.RegularExpressions;
+using MSAgentAI.Acs;
+using MSAgentAI.Agent;
+using MSAgentAI.Logging;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Daemon
+{
+    /// <summary>
+    /// A character with no window: what it says and plays is written as text, and each request
+    /// takes about as long as MS Agent would take, so STATE, speaking and queue depth behave like
+    /// the real thing for clients that wait on them. Characters are read with the managed ACS
+    /// reader for their name and animations, so it runs anywhere .NET does.
+    /// </summary>
+    public sealed class ConsoleAgentBackend : IAgentBackend
+    {
+        private const int ShowHideMs = 300;
+        private const int AnimationMs = 1500;
+        private const int MinimumSpeechMs = 600;
+
+        // SAPI4 tags from AppSettings.ProcessText: \map="spoken"="word"\ shows the word, the rest go
+        private static readonly Regex MapTag = new Regex(@"\\map=""[^""]*""=""([^""]*)""\\", RegexOptions.IgnoreCase);
+        private static readonly Regex OtherTag = new Regex(@"\\[A-Za-z]+(=[^\\]*)?\\");
+
+        private readonly object _lock = new object();
+        private readonly TextWriter _output;
+        private readonly Queue<Request> _queue = new Queue<Request>();
+        private readonly IClockTimer _timer;
+        private List<string> _animations = new List<string>();
+        private string _name;
+        private bool _visible;
+        private long _version;
+        private bool _disposed;
+        private volatile AgentState _state = AgentState.Unloaded;
+
+        /// <param name="output">Where speech and animations are written, or null to only log them</param>
+        public ConsoleAgentBackend(TextWriter output) : this(output, SystemClock.Instance)
+        {
+        }
+
+        /// <param name="output">Where speech and animations are written, or null to only log them</param>
+        /// <param name="clock">Times each request; a VirtualClock lets a simulation skip the waits</param>
+        public ConsoleAgentBackend(TextWriter output, IClock clock)
+        {
+            _output = output;
+            _timer = clock.CreateTimer(TimeSpan.Zero, OnRequestDone);
+        }
+
+        /// <summary>
+        /// Speaking rate used to time Speak requests, as in the voice settings
+        /// </summary>
+        public int WordsPerMinute { get; set; } = 150;
+
+        public bool IsLoaded => _name != null;
+        public string CharacterFile { get; private set; }
+        public AgentState State => _state;
+
+        /// <summary>
+        /// Reads the character's name and animations. A file that is missing or can't be read
+        /// still gives a character named after the file, without animations, so the daemon can
+        /// run where the characters aren't installed.
+        /// </summary>
+        public void LoadCharacter(string characterPath)
+        {
+            string name = Path.GetFileNameWithoutExtension(characterPath.Replace('\\', Path.DirectorySeparatorChar));
+            var animations = new List<string>();
+            try
+            {
+                if (File.Exists(characterPath))
+                {
+                    var file = AcsFile.Load(characterPath);
+                    name = string.IsNullOrEmpty(file.Name) ? name : file.Name;
+                    animations.AddRange(file.Animations.Keys);
+                    animations.Sort(StringComparer.OrdinalIgnoreCase);
+                }
+                else
+                {
+                    Logger.LogWarning($"Character file not found, running {name} without animations: {characterPath}");
+                }
+            }
+            catch (Exception ex)
+            {
+                // Damaged characters can fail anywhere in decoding
+                Logger.LogWarning($"Could not read {characterPath}, running {name} without animations: {ex.Message}");
+            }
+
+            lock (_lock)
+            {
+                _queue.Clear();
+                _timer.Stop();
+                _name = name;
+                _animations = animations;
+                _visible = false;
+                CharacterFile = characterPath;
+                Publish(null);
+            }
+            Logger.Log($"Loaded headless character {name} ({animations.Count} animations)");
+        }
+
+        public void Show(bool fast = false)
+        {
+            Enqueue("Show", null, fast ? 0 : ShowHideMs, $"[{_name}] appears");
+        }
+
+        public void Hide(bool fast = false)
+        {
+            Enqueue("Hide", null, fast ? 0 : ShowHideMs, $"[{_name}] hides");
+        }
+
+        public void Speak(string text)
+        {
+            if (!string.IsNullOrEmpty(text))
+            {
+                text = OtherTag.Replace(MapTag.Replace(text, "$1"), string.Empty);
+                Enqueue("Speak", null, GetSpeechMs(text), $"[{_name}] {text}");
+            }
+        }
+
+        public void SpeakSentences(List<string> sentences)
+        {
+            if (sentences == null)
+                return;
+
+            foreach (var sentence in sentences)
+            {
+                Speak(sentence);
+            }
+        }
+
+        public void PlayAnimation(string animationName)
+        {
+            if (!string.IsNullOrEmpty(animationName))
+            {
+                Enqueue("Play", animationName, AnimationMs, $"[{_name}] *{animationName}*");
+            }
+        }
+
+        public List<string> GetAnimations()
+        {
+            lock (_lock)
+            {
+                return new List<string>(_animations);
+            }
+        }
+
+        private int GetSpeechMs(string text)
+        {
+            int words = text.Split((char[])null, StringSplitOptions.RemoveEmptyEntries).Length;
+            return Math.Max(MinimumSpeechMs, (int)(words * 60000L / Math.Max(1, WordsPerMinute)));
+        }
+
+        private void Enqueue(string kind, string animation, int durationMs, string line)
+        {
+            lock (_lock)
+            {
+                if (_disposed || _name == null)
+                    return;
+
+                _queue.Enqueue(new Request(kind, animation, durationMs, line));
+                if (_queue.Count == 1)
+                {
+                    StartNext();
+                }
+                else
+                {
+                    Publish(_queue.Peek());
+                }
+            }
+        }
+
+        /// <summary>
+        /// Starts the request at the head of the queue; called with the lock held
+        /// </summary>
+        private void StartNext()
+        {
+            var request = _queue.Peek();
+            if (request.Kind == "Show")
+                _visible = true;
+            else if (request.Kind == "Hide")
+                _visible = false;
+
+            if (_output != null)
+            {
+                _output.WriteLine(request.Line);
+            }
+            else
+            {
+                Logger.Log(request.Line);
+            }
+            Publish(request);
+            _timer.Interval = TimeSpan.FromMilliseconds(request.DurationMs);
+            _timer.Start();
+        }
+
+        private void OnRequestDone()
+        {
+            lock (_lock)
+            {
+                // One tick per request
+                _timer.Stop();
+                if (_disposed || _queue.Count == 0)
+                    return;
+
+                _queue.Dequeue();
+                if (_queue.Count > 0)
+                    StartNext();
+                else
+                    Publish(null);
+            }
+        }
+
+        /// <summary>
+        /// Swaps in a new state snapshot; called with the lock held
+        /// </summary>
+        private void Publish(Request current)
+        {
+            int speech = 0;
+            foreach (var request in _queue)
+            {
+                if (request.Kind == "Speak")
+                    speech++;
+            }
+            _state = new AgentState(++_version, _name, _visible, 0, 0, current?.Kind, current?.Animation, _queue.Count, speech);
+        }
+
+        public void Dispose()
+        {
+            lock (_lock)
+            {
+                if (_disposed)
+                    return;
+
+                _disposed = true;
+                _queue.Clear();
+                _name = null;
+                CharacterFile = null;
+                _state = AgentState.Unloaded;
+            }
+            _timer.Dispose();
+        }
+
+        private sealed class Request
+        {
+            public Request(string kind, string animation, int durationMs, string line)
+            {
+                Kind = kind;
+                Animation = animation;
+                DurationMs = durationMs;
+                Line = line;
+            }
+
+            public string Kind { get; }
+            public string Animation { get; }
+            public int DurationMs { get; }
+            public string Line { get; }
+        }
+    }
+}
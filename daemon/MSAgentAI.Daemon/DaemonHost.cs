@@ -0,0 +1,470 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Agent;
+using MSAgentAI.AI;
+using MSAgentAI.Config;
+using MSAgentAI.Logging;
+using MSAgentAI.Pipeline;
+using MSAgentAI.Resources;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Daemon
+{
+    /// <summary>
+    /// The pipeline, Ollama client and memories wired to agent backends the way MainForm wires
+    /// them to MS Agent, without a window or message loop. Backends are called straight from
+    /// pipeline and chat threads, so they must be thread-safe.
+    /// </summary>
+    public sealed class DaemonHost : IDisposable
+    {
+        private readonly AppSettings _settings;
+        private readonly string _settingsPath;
+        private readonly Func<IAgentBackend> _createBackend;
+        private readonly ConcurrentDictionary<string, ChatSession> _chatSessions = new ConcurrentDictionary<string, ChatSession>(StringComparer.OrdinalIgnoreCase);
+        private readonly CancellationTokenSource _cancellationTokenSource = new CancellationTokenSource();
+        private readonly object _saveLock = new object();
+
+        // A client setting up macros sends a burst of DEFINEs; they are saved once it's over
+        private static readonly TimeSpan MacroSaveDelay = TimeSpan.FromSeconds(2);
+
+        // The primary character first; replaced rather than modified, so lookups don't lock
+        private volatile IAgentBackend[] _characters = new IAgentBackend[0];
+
+        private OllamaClient _ollamaClient;
+        private MemoryManager _memoryManager;
+        private PipelineServer _pipelineServer;
+        private ChatScheduler _chatScheduler;
+        private MemoryBudget _memoryBudget;
+        private IClockTimer _macroSaveTimer;
+        private bool _disposed;
+
+        /// <param name="settings">Settings to run with</param>
+        /// <param name="settingsPath">File macros defined by clients are saved back to</param>
+        /// <param name="createBackend">Makes the backend for each character</param>
+        public DaemonHost(AppSettings settings, string settingsPath, Func<IAgentBackend> createBackend)
+        {
+            _settings = settings ?? throw new ArgumentNullException(nameof(settings));
+            _settingsPath = settingsPath;
+            _createBackend = createBackend ?? throw new ArgumentNullException(nameof(createBackend));
+        }
+
+        /// <summary>
+        /// Character to load instead of SelectedCharacterFile; settings are left as they are
+        /// </summary>
+        public string PrimaryCharacter { get; set; }
+
+        public PipelineServer PipelineServer => _pipelineServer;
+
+        /// <summary>
+        /// Loads the characters and starts the pipeline. Throws if the pipeline can't listen.
+        /// </summary>
+        public void Start()
+        {
+            InitializeManagers();
+            LoadCharacters();
+            InitializePipeline();
+            InitializeMemoryBudget();
+        }
+
+        private void InitializeManagers()
+        {
+            _ollamaClient = new OllamaClient
+            {
+                BaseUrl = _settings.OllamaUrl,
+                Model = _settings.OllamaModel,
+                PersonalityPrompt = _settings.PersonalityPrompt,
+                AdaptiveContext = _settings.OllamaAdaptiveContext,
+                UserDescription = _settings.UserDescription
+            };
+            _ollamaClient.ContextBudget.MaxContextLength = _settings.OllamaMaxContextLength;
+            _ollamaClient.ContextBudget.RandomDialogMaxTokens = _settings.RandomDialogMaxTokens;
+
+            if (_settings.EnableOllamaChat)
+            {
+                _ollamaClient.Models.StartBackgroundRefresh(TimeSpan.FromSeconds(30));
+            }
+
+            _memoryManager = new MemoryManager
+            {
+                Enabled = _settings.EnableMemories,
+                MemoryThreshold = _settings.MemoryThreshold
+            };
+            _ollamaClient.MemoryManager = _memoryManager;
+        }
+
+        /// <summary>
+        /// The selected character and the additional ones, each in its own backend. One that
+        /// fails to load is logged and skipped.
+        /// </summary>
+        private void LoadCharacters()
+        {
+            string primary = PrimaryCharacter ?? _settings.SelectedCharacterFile;
+            var paths = new List<string> { string.IsNullOrWhiteSpace(primary) ? "Agent" : primary };
+            if (_settings.AdditionalCharacterFiles != null)
+            {
+                paths.AddRange(_settings.AdditionalCharacterFiles);
+            }
+
+            var loaded = new List<IAgentBackend>();
+            var names = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+            foreach (string path in paths)
+            {
+                if (string.IsNullOrWhiteSpace(path))
+                    continue;
+
+                IAgentBackend agent = null;
+                try
+                {
+                    agent = _createBackend();
+                    agent.LoadCharacter(path.Trim());
+
+                    // Two characters with one name couldn't be told apart by COMMAND@Name
+                    if (!names.Add(agent.State.Character))
+                    {
+                        Logger.LogWarning($"Skipping {path}: a character named {agent.State.Character} is already loaded");
+                        agent.Dispose();
+                        continue;
+                    }
+                    agent.Show(false);
+                    loaded.Add(agent);
+                }
+                catch (Exception ex)
+                {
+                    agent?.Dispose();
+                    Logger.LogError($"Failed to load character {path}", ex);
+                }
+            }
+            _characters = loaded.ToArray();
+
+            if (loaded.Count > 0)
+            {
+                _ollamaClient.AvailableAnimations = loaded[0].GetAnimations();
+                for (int i = 1; i < loaded.Count; i++)
+                {
+                    GetChatSession(loaded[i]).AvailableAnimations = loaded[i].GetAnimations();
+                }
+            }
+        }
+
+        private void InitializePipeline()
+        {
+            _pipelineServer = new PipelineServer(
+                _settings.PipelineProtocol,
+                _settings.PipelineIPAddress,
+                _settings.PipelinePort,
+                _settings.PipelineName
+            );
+            _pipelineServer.UdpEnabled = _settings.PipelineUdpEnabled;
+            _pipelineServer.UdpPort = _settings.PipelineUdpPort;
+            _pipelineServer.RingEnabled = _settings.PipelineRingEnabled;
+            _pipelineServer.RingName = _settings.PipelineRingName;
+            _pipelineServer.RingCapacity = Math.Max(64, _settings.PipelineRingSizeKb) * 1024L;
+            _pipelineServer.HttpEnabled = _settings.PipelineHttpEnabled;
+            _pipelineServer.HttpPort = _settings.PipelineHttpPort;
+            _pipelineServer.HttpAllowedOrigins = _settings.PipelineHttpAllowedOrigins?.ToArray();
+            _pipelineServer.DrainTimeout = TimeSpan.FromMilliseconds(Math.Max(0, _settings.PipelineDrainTimeoutMs));
+
+            _pipelineServer.OnSpeakCommand += (s, command) => RunOnCharacter(command, agent => SpeakWithAnimations(agent, command.Data));
+            _pipelineServer.OnAnimationCommand += (s, command) => RunOnCharacter(command, agent => {
+                agent.PlayAnimation(command.Data);
+                _pipelineServer.PublishEvent(GetEventName("ANIMATION", agent), command.Data);
+            });
+            _pipelineServer.OnHideCommand += (s, command) => RunOnCharacter(command, agent => agent.Hide(false));
+            _pipelineServer.OnShowCommand += (s, command) => RunOnCharacter(command, agent => agent.Show(false));
+            _pipelineServer.OnPokeCommand += (s, command) => RunOnCharacter(command, agent => _ = PokeAsync(agent));
+
+            _chatScheduler = new ChatScheduler(async (item, ct) => {
+                var agent = FindCharacter(item.Character);
+                var usage = new OllamaUsage();
+                var response = await _ollamaClient.ChatAsync(GetChatSession(agent), item.Prompt, usage, ct);
+                if (!string.IsNullOrEmpty(response) && agent?.IsLoaded == true)
+                {
+                    SpeakWithAnimations(agent, response);
+                }
+                return usage.TotalTokens;
+            });
+            _chatScheduler.EstimateCost = prompt => _ollamaClient.EstimateChatCost(prompt);
+            _chatScheduler.TokensPerMinute = _settings.PipelineChatTokensPerMinute;
+            _chatScheduler.MaxQueuedPerClient = _settings.PipelineChatQueueLimit;
+            _pipelineServer.ChatScheduler = _chatScheduler;
+            _pipelineServer.DefaultChatTtl = _settings.PipelineChatDefaultTtlMs > 0
+                ? TimeSpan.FromMilliseconds(_settings.PipelineChatDefaultTtlMs)
+                : (TimeSpan?)null;
+
+            _pipelineServer.StateProvider = character => (FindCharacter(character)?.State ?? AgentState.Unloaded).Format();
+            _pipelineServer.CharacterResolver = name => {
+                var state = FindCharacter(name)?.State;
+                return state != null && state.IsLoaded ? state.Character : null;
+            };
+            _pipelineServer.CharactersProvider = GetNames;
+
+            _pipelineServer.LoadMacros(_settings.PipelineMacros);
+            _macroSaveTimer = SystemClock.Instance.CreateTimer(MacroSaveDelay, SavePipelineMacros);
+            _pipelineServer.OnMacrosChanged += (s, e) => _macroSaveTimer.Start();
+
+            RegisterPipelineEvents();
+            ApplyPipelineRateLimits();
+
+            _pipelineServer.Start();
+            if (_settings.PipelineRecordEnabled)
+            {
+                string folder = Path.Combine(AppDomain.CurrentDomain.BaseDirectory, "recordings");
+                Directory.CreateDirectory(folder);
+                _pipelineServer.StartRecording(Path.Combine(folder, $"pipeline-{DateTime.Now:yyyyMMdd-HHmmss}.pipelog"));
+            }
+            Logger.Log("Communication pipeline initialized");
+        }
+
+        /// <summary>
+        /// Keeps chat history and event caches within MemoryBudgetMb over weeks of running
+        /// </summary>
+        private void InitializeMemoryBudget()
+        {
+            _memoryBudget = new MemoryBudget(SystemClock.Instance)
+            {
+                BudgetBytes = Math.Max(1, _settings.MemoryBudgetMb) * 1024L * 1024L,
+                HighMemoryLoadPercent = _settings.MemoryHighLoadPercent
+            };
+            _memoryBudget.Register("chat.history", CachePriority.Normal, () => {
+                long bytes = 0;
+                foreach (var session in GetAllChatSessions())
+                {
+                    bytes += session.EstimatedBytes;
+                }
+                return bytes;
+            }, wanted => {
+                long freed = 0;
+                foreach (var session in GetAllChatSessions())
+                {
+                    long before = session.EstimatedBytes;
+                    session.TrimHistory(OllamaClient.MaxHistoryMessages);
+                    freed += before - session.EstimatedBytes;
+                }
+                return freed;
+            });
+            _memoryBudget.Register("pipeline.events", CachePriority.Low,
+                () => _pipelineServer.EventRegistry.EstimateCacheBytes(),
+                wanted => _pipelineServer.EventRegistry.ClearCaches());
+            _pipelineServer.StatsProvider = _memoryBudget.FormatStats;
+            _memoryBudget.Start();
+        }
+
+        private IEnumerable<ChatSession> GetAllChatSessions()
+        {
+            yield return _ollamaClient.DefaultSession;
+            foreach (var session in _chatSessions.Values)
+            {
+                yield return session;
+            }
+        }
+
+        private void ApplyPipelineRateLimits()
+        {
+            if (!_settings.PipelineRateLimitEnabled)
+                return;
+
+            if (!Enum.TryParse(_settings.PipelineRateLimitPolicy, true, out RateLimitPolicy policy))
+            {
+                Logger.LogWarning($"Unknown pipeline rate limit policy '{_settings.PipelineRateLimitPolicy}', using Delay");
+                policy = RateLimitPolicy.Delay;
+            }
+
+            var limiter = new PipelineRateLimiter(_settings.PipelineRateLimitPerConnection, _settings.PipelineRateLimitGlobal, _settings.PipelineRateLimitBurstSeconds);
+            limiter.SetCosts(_settings.PipelineCommandCosts);
+            limiter.Policy = policy;
+            limiter.MaxDelay = TimeSpan.FromMilliseconds(Math.Max(0, _settings.PipelineRateLimitMaxDelayMs));
+            _pipelineServer.RateLimiter = limiter;
+        }
+
+        private void RegisterPipelineEvents()
+        {
+            if (_settings.PipelineEvents == null)
+                return;
+
+            foreach (var entry in _settings.PipelineEvents)
+            {
+                try
+                {
+                    _pipelineServer.EventRegistry.Register(entry.Key, entry.Value?.Lines, entry.Value?.Prompt);
+                }
+                catch (ArgumentException ex)
+                {
+                    Logger.LogWarning($"Pipeline: Skipping event '{entry.Key}': {ex.Message}");
+                }
+            }
+        }
+
+        /// <summary>
+        /// The loaded character with this name or file name, or the primary one for null
+        /// </summary>
+        private IAgentBackend FindCharacter(string name)
+        {
+            var characters = _characters;
+            if (characters.Length == 0)
+                return null;
+            if (name == null)
+                return characters[0];
+
+            foreach (var agent in characters)
+            {
+                string file = agent.CharacterFile?.Replace('\\', Path.DirectorySeparatorChar);
+                if (string.Equals(agent.State.Character, name, StringComparison.OrdinalIgnoreCase)
+                    || (file != null && string.Equals(Path.GetFileNameWithoutExtension(file), name, StringComparison.OrdinalIgnoreCase)))
+                    return agent;
+            }
+            return null;
+        }
+
+        private IEnumerable<string> GetNames()
+        {
+            var names = new List<string>();
+            foreach (var agent in _characters)
+            {
+                if (agent.IsLoaded)
+                {
+                    names.Add(agent.State.Character);
+                }
+            }
+            return names;
+        }
+
+        private bool IsPrimary(IAgentBackend agent)
+        {
+            var characters = _characters;
+            return characters.Length > 0 && agent == characters[0];
+        }
+
+        private void RunOnCharacter(PipelineCommand command, Action<IAgentBackend> action)
+        {
+            var agent = FindCharacter(command.Character);
+            if (agent != null)
+            {
+                action(agent);
+            }
+        }
+
+        private string GetEventName(string name, IAgentBackend agent)
+        {
+            return IsPrimary(agent) ? name : name + "@" + agent.State.Character;
+        }
+
+        /// <summary>
+        /// The primary character talks in the client's own conversation; the others each keep one
+        /// in their own persona, as in the desktop app
+        /// </summary>
+        private ChatSession GetChatSession(IAgentBackend agent)
+        {
+            if (agent == null || IsPrimary(agent))
+                return null;
+
+            return _chatSessions.GetOrAdd(agent.State.Character, name => new ChatSession(name)
+            {
+                PersonalityPrompt = $"{_settings.PersonalityPrompt}\n\nYou are {name}. Other characters share the screen with you; stay in character as {name}.".Trim()
+            });
+        }
+
+        private async Task PokeAsync(IAgentBackend agent)
+        {
+            var prompt = AppSettings.GetRandomLine(_settings.RandomDialogPrompts);
+            if (!_settings.EnableOllamaChat || string.IsNullOrEmpty(prompt))
+                return;
+
+            try
+            {
+                var response = await _ollamaClient.GenerateRandomDialogAsync(prompt, GetChatSession(agent), _cancellationTokenSource.Token);
+                if (!string.IsNullOrEmpty(response) && agent.IsLoaded)
+                {
+                    SpeakWithAnimations(agent, response);
+                }
+            }
+            catch (OperationCanceledException)
+            {
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError($"Poke for {agent.State.Character} failed", ex);
+            }
+        }
+
+        /// <summary>
+        /// Plays the first &amp;&amp;Animation trigger and speaks the rest, as MainForm does
+        /// </summary>
+        private void SpeakWithAnimations(IAgentBackend agent, string text)
+        {
+            if (agent?.IsLoaded != true || string.IsNullOrEmpty(text))
+                return;
+
+            var (cleanText, animations) = AppSettings.ExtractAnimationTriggers(text);
+            string caption = string.IsNullOrWhiteSpace(_settings.UserName) ? cleanText : cleanText.Replace("##", _settings.UserName);
+            cleanText = _settings.ProcessText(cleanText);
+
+            if (animations.Count > 0)
+            {
+                agent.PlayAnimation(animations[0]);
+                _pipelineServer?.PublishEvent(GetEventName("ANIMATION", agent), animations[0]);
+            }
+
+            if (_settings.TruncateSpeech)
+                agent.SpeakSentences(AppSettings.SplitIntoSentences(cleanText));
+            else
+                agent.Speak(cleanText);
+
+            _pipelineServer?.PublishEvent(GetEventName("SPEAK", agent), caption);
+        }
+
+        /// <summary>
+        /// Writes the macros to the settings file, once per burst of DEFINE commands
+        /// </summary>
+        private void SavePipelineMacros()
+        {
+            _macroSaveTimer.Stop();
+            lock (_saveLock)
+            {
+                _settings.PipelineMacros = _pipelineServer.GetMacroDefinitions();
+                if (_settingsPath != null)
+                {
+                    _settings.Save(_settingsPath);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Stops the pipeline, letting clients finish their current command, then the rest
+        /// </summary>
+        public void Dispose()
+        {
+            if (_disposed)
+                return;
+            _disposed = true;
+
+            _cancellationTokenSource.Cancel();
+            _memoryBudget?.Dispose();
+            _pipelineServer?.Dispose();
+            _chatScheduler?.Dispose();
+
+            // Macros defined since the last save would otherwise be lost
+            if (_macroSaveTimer != null)
+            {
+                bool pending = _macroSaveTimer.Enabled;
+                _macroSaveTimer.Dispose();
+                if (pending)
+                {
+                    SavePipelineMacros();
+                }
+            }
+
+            var characters = _characters;
+            _characters = new IAgentBackend[0];
+            foreach (var agent in characters)
+            {
+                agent.Dispose();
+            }
+            _ollamaClient?.Dispose();
+            _cancellationTokenSource.Dispose();
+        }
+    }
+}
@@ -0,0 +1,78 @@
+using System;
+
+namespace MSAgentAI.Daemon
+{
+    /// <summary>
+    /// Command line options for the daemon
+    /// </summary>
+    public class DaemonOptions
+    {
+        // Settings file shared with the desktop app unless given
+        public string SettingsPath { get; set; }
+
+        // Log file; null keeps MSAgentAI.log next to the executable
+        public string LogPath { get; set; }
+
+        // Replaces SelectedCharacterFile from settings
+        public string Character { get; set; }
+
+        // "console" writes what characters say to stdout, "log" only to the log file
+        public string Backend { get; set; } = "console";
+
+        // Keeps log lines off stdout
+        public bool Quiet { get; set; }
+
+        public const string Usage =
+@"Usage: MSAgentAI.Daemon [options]
+
+  --settings <path>    Settings file (default %AppData%\MSAgentAI\settings.json)
+  --log <path>         Log file (default MSAgentAI.log next to the executable)
+  --character <path>   Character to load instead of the one in settings
+  --backend <name>     console (default) or log: where the characters' speech goes
+  --quiet              Don't echo log lines to stdout";
+
+        /// <summary>
+        /// Parses command line arguments, throwing ArgumentException on bad input
+        /// </summary>
+        public static DaemonOptions Parse(string[] args)
+        {
+            var options = new DaemonOptions();
+
+            for (int i = 0; i < args.Length; i++)
+            {
+                string arg = args[i];
+                string Next()
+                {
+                    if (i + 1 >= args.Length)
+                        throw new ArgumentException($"{arg} requires a value");
+                    return args[++i];
+                }
+
+                switch (arg)
+                {
+                    case "--settings":
+                        options.SettingsPath = Next();
+                        break;
+                    case "--log":
+                        options.LogPath = Next();
+                        break;
+                    case "--character":
+                        options.Character = Next();
+                        break;
+                    case "--backend":
+                        options.Backend = Next().ToLowerInvariant();
+                        if (options.Backend != "console" && options.Backend != "log")
+                            throw new ArgumentException($"Unknown backend '{options.Backend}'");
+                        break;
+                    case "--quiet":
+                        options.Quiet = true;
+                        break;
+                    default:
+                        throw new ArgumentException($"Unknown option '{arg}'");
+                }
+            }
+
+            return options;
+        }
+    }
+}
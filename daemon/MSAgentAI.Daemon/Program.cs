@@ -0,0 +1,98 @@
+using System;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using System.Threading;
+using MSAgentAI.Agent;
+using MSAgentAI.Config;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Daemon
+{
+    /// <summary>
+    /// Runs the pipeline, AI and memories without the desktop app, for servers, containers and
+    /// machines where nothing is on screen. Stops cleanly on Ctrl+C or SIGTERM.
+    /// </summary>
+    public static class Program
+    {
+        public static int Main(string[] args)
+        {
+            DaemonOptions options;
+            try
+            {
+                options = DaemonOptions.Parse(args);
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                Console.Error.WriteLine();
+                Console.Error.WriteLine(DaemonOptions.Usage);
+                return 2;
+            }
+
+            var startup = Stopwatch.StartNew();
+            Logger.EchoToConsole = !options.Quiet;
+            Logger.Initialize(options.LogPath);
+            Logger.Log("Daemon starting...");
+
+            string settingsPath = options.SettingsPath ?? AppSettings.DefaultPath;
+            var settings = AppSettings.Load(settingsPath);
+            Logger.Log($"Settings: {settingsPath}");
+
+            using (var stopping = new ManualResetEventSlim())
+            using (var host = new DaemonHost(settings, settingsPath, () => CreateBackend(options, settings)))
+            {
+                host.PrimaryCharacter = options.Character;
+
+                Console.CancelKeyPress += (s, e) =>
+                {
+                    e.Cancel = true;
+                    stopping.Set();
+                };
+                PosixSignalRegistration sigterm = null;
+                try
+                {
+                    // What service managers send to stop us; handled so the pipeline drains first
+                    sigterm = PosixSignalRegistration.Create(PosixSignal.SIGTERM, context =>
+                    {
+                        context.Cancel = true;
+                        stopping.Set();
+                    });
+                }
+                catch (PlatformNotSupportedException)
+                {
+                }
+
+                try
+                {
+                    host.Start();
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("Daemon failed to start", ex);
+                    sigterm?.Dispose();
+                    return 1;
+                }
+
+                using (var process = Process.GetCurrentProcess())
+                {
+                    Logger.Log($"Daemon ready in {startup.ElapsedMilliseconds} ms, {process.WorkingSet64 / (1024 * 1024)} MB working set");
+                }
+
+                stopping.Wait();
+                Logger.Log("Daemon stopping...");
+                sigterm?.Dispose();
+            }
+
+            Logger.Log("Daemon stopped.");
+            return 0;
+        }
+
+        private static IAgentBackend CreateBackend(DaemonOptions options, AppSettings settings)
+        {
+            return new ConsoleAgentBackend(options.Backend == "console" ? Console.Out : null)
+            {
+                WordsPerMinute = settings.VoiceSpeed
+            };
+        }
+    }
+}
@@ -0,0 +1,123 @@
+using System;
+using System.Collections.Generic;
+
+namespace MSAgentAI.AI
+{
+    /// <summary>
+    /// One conversation with the AI: its history and, optionally, its own personality and
+    /// animations. Each character on screen talks through its own session, so their
+    /// conversations don't bleed into each other. A session is used by one request at a time,
+    /// but its history may be trimmed from any thread.
+    /// </summary>
+    public class ChatSession
+    {
+        /// <summary>
+        /// Messages kept before the oldest are dropped. Only the last few are ever sent, so
+        /// this just stops a conversation running for weeks from growing without bound.
+        /// </summary>
+        public const int MaxStoredMessages = 64;
+
+        // Per message, beside its text: the message object, two strings and the list slot
+        private const int MessageOverheadBytes = 96;
+
+        private readonly object _lock = new object();
+        private readonly List<OllamaClient.ChatMessage> _history = new List<OllamaClient.ChatMessage>();
+
+        public ChatSession(string name = null)
+        {
+            Name = name;
+        }
+
+        /// <summary>
+        /// Character the session belongs to, or null for the client's own conversation
+        /// </summary>
+        public string Name { get; }
+
+        /// <summary>
+        /// Replaces the client's PersonalityPrompt when set
+        /// </summary>
+        public string PersonalityPrompt { get; set; }
+
+        /// <summary>
+        /// Replaces the client's AvailableAnimations when set
+        /// </summary>
+        public List<string> AvailableAnimations { get; set; }
+
+        // System prompt and history tokens sent with the last chat, for cost estimates
+        internal int LastContextTokens { get; set; }
+
+        public int MessageCount
+        {
+            get { lock (_lock) return _history.Count; }
+        }
+
+        /// <summary>
+        /// Rough memory held by the history, for the memory budget
+        /// </summary>
+        public long EstimatedBytes
+        {
+            get
+            {
+                lock (_lock)
+                {
+                    long bytes = 0;
+                    foreach (var message in _history)
+                    {
+                        bytes += MessageOverheadBytes + 2L * ((message.Content?.Length ?? 0) + (message.Role?.Length ?? 0));
+                    }
+                    return bytes;
+                }
+            }
+        }
+
+        /// <summary>
+        /// The newest messages, oldest first
+        /// </summary>
+        internal List<OllamaClient.ChatMessage> GetRecent(int count)
+        {
+            lock (_lock)
+            {
+                int start = Math.Max(0, _history.Count - count);
+                return _history.GetRange(start, _history.Count - start);
+            }
+        }
+
+        internal void AddExchange(OllamaClient.ChatMessage user, OllamaClient.ChatMessage assistant)
+        {
+            lock (_lock)
+            {
+                _history.Add(user);
+                _history.Add(assistant);
+                if (_history.Count > MaxStoredMessages)
+                {
+                    _history.RemoveRange(0, _history.Count - MaxStoredMessages);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Drops all but the newest messages. Returns how many were dropped.
+        /// </summary>
+        public int TrimHistory(int keepMessages)
+        {
+            lock (_lock)
+            {
+                int remove = _history.Count - Math.Max(0, keepMessages);
+                if (remove <= 0)
+                    return 0;
+
+                _history.RemoveRange(0, remove);
+                return remove;
+            }
+        }
+
+        public void Clear()
+        {
+            lock (_lock)
+            {
+                _history.Clear();
+            }
+            LastContextTokens = 0;
+        }
+    }
+}
@@ -0,0 +1,252 @@
+using System;
+using System.Collections.Generic;
+
+namespace MSAgentAI.AI
+{
+    /// <summary>
+    /// Kind of request sent to Ollama, used to pick the generation budget
+    /// </summary>
+    public enum OllamaRequestKind
+    {
+        Chat,
+        RandomDialog
+    }
+
+    /// <summary>
+    /// Token counts Ollama reported for one request
+    /// </summary>
+    public class OllamaUsage
+    {
+        public int PromptTokens { get; set; }
+        public int ResponseTokens { get; set; }
+        public int TotalTokens => PromptTokens + ResponseTokens;
+    }
+
+    /// <summary>
+    /// Sizes num_ctx and num_predict for each Ollama request.
+    /// Prompt size comes from a character-based estimate that is calibrated against the
+    /// prompt_eval_count Ollama reports, so small prompts get a small KV cache and large
+    /// prompts get a context big enough that the server doesn't silently truncate them.
+    /// </summary>
+    public class ContextBudget
+    {
+        // Ollama reloads the model whenever num_ctx changes, so the context only shrinks
+        // after this many consecutive requests would have fit in half of it
+        private const int ShrinkAfterRequests = 8;
+
+        // Headroom for chat template tokens the estimate can't see
+        private const int TemplateOverheadTokens = 8;
+        private const int SafetyMarginTokens = 64;
+
+        // Smallest generation budget we fall back to when the prompt barely fits
+        private const int MinPredictTokens = 32;
+
+        private readonly object _lock = new object();
+        private double _charsPerToken = 4.0;
+        private int _currentContext;
+        private int _smallerFitStreak;
+
+        /// <summary>
+        /// Smallest num_ctx ever requested
+        /// </summary>
+        public int MinContextLength { get; set; } = 2048;
+
+        /// <summary>
+        /// Largest num_ctx ever requested (caps KV cache memory)
+        /// </summary>
+        public int MaxContextLength { get; set; } = 8192;
+
+        /// <summary>
+        /// The model's trained context length when known (0 = unknown).
+        /// Requests never ask for more than this, even if MaxContextLength is larger.
+        /// </summary>
+        public int ModelContextLength { get; set; }
+
+        /// <summary>
+        /// The context limit actually used for sizing and history budgeting
+        /// </summary>
+        public int EffectiveMaxContextLength
+        {
+            get
+            {
+                int model = ModelContextLength;
+                return model > 0 ? Math.Min(MaxContextLength, model) : MaxContextLength;
+            }
+        }
+
+        /// <summary>
+        /// Generation budget for random dialog / poke requests
+        /// </summary>
+        public int RandomDialogMaxTokens { get; set; } = 100;
+
+        /// <summary>
+        /// Current calibrated characters-per-token ratio
+        /// </summary>
+        public double CharsPerToken
+        {
+            get { lock (_lock) { return _charsPerToken; } }
+        }
+
+        /// <summary>
+        /// The num_ctx value sent with the most recent request (0 before the first)
+        /// </summary>
+        public int CurrentContextLength
+        {
+            get { lock (_lock) { return _currentContext; } }
+        }
+
+        /// <summary>
+        /// Estimates the token count of a single message
+        /// </summary>
+        public int EstimateTokens(string text)
+        {
+            if (string.IsNullOrEmpty(text))
+                return TemplateOverheadTokens;
+
+            double ratio;
+            lock (_lock) { ratio = _charsPerToken; }
+
+            return (int)Math.Ceiling(text.Length / ratio) + TemplateOverheadTokens;
+        }
+
+        /// <summary>
+        /// Estimates the token count of several messages
+        /// </summary>
+        public int EstimateTokens(IEnumerable<string> texts)
+        {
+            int total = 0;
+            foreach (var text in texts)
+            {
+                total += EstimateTokens(text);
+            }
+            return total;
+        }
+
+        /// <summary>
+        /// Calibrates the estimator from a measured prompt_eval_count
+        /// </summary>
+        public void RecordPromptEval(int promptChars, int messageCount, int promptEvalCount)
+        {
+            int contentTokens = promptEvalCount - messageCount * TemplateOverheadTokens;
+            if (promptChars <= 0 || contentTokens <= 0)
+                return;
+
+            // Ollama only counts tokens it actually evaluated, so a prompt that reuses a
+            // cached prefix looks far cheaper than it is. Ignore implausible samples.
+            double sample = (double)promptChars / contentTokens;
+            if (sample < 1.5 || sample > 8.0)
+                return;
+
+            lock (_lock)
+            {
+                // Exponential moving average, biased towards the more conservative value
+                double weight = sample < _charsPerToken ? 0.5 : 0.2;
+                _charsPerToken = _charsPerToken * (1 - weight) + sample * weight;
+            }
+        }
+
+        /// <summary>
+        /// Gets the generation budget for a request kind
+        /// </summary>
+        public int GetPredictTokens(OllamaRequestKind kind, int maxTokens)
+        {
+            switch (kind)
+            {
+                case OllamaRequestKind.RandomDialog:
+                    return Math.Max(MinPredictTokens, Math.Min(maxTokens, RandomDialogMaxTokens));
+                default:
+                    return Math.Max(MinPredictTokens, maxTokens);
+            }
+        }
+
+        /// <summary>
+        /// Gets how many prompt tokens fit alongside the given generation budget
+        /// </summary>
+        public int GetPromptBudget(int predictTokens)
+        {
+            return Math.Max(0, EffectiveMaxContextLength - predictTokens - SafetyMarginTokens);
+        }
+
+        /// <summary>
+        /// Shrinks the generation budget when the prompt leaves too little room for it.
+        /// Returns the original budget when everything fits.
+        /// </summary>
+        public int FitPredictTokens(int promptTokens, int predictTokens)
+        {
+            int room = EffectiveMaxContextLength - promptTokens - SafetyMarginTokens;
+            if (room >= predictTokens)
+                return predictTokens;
+
+            return Math.Max(MinPredictTokens, room);
+        }
+
+        /// <summary>
+        /// How many tokens the prompt runs past what the context holds alongside the smallest
+        /// generation budget (0 when it fits). Ollama truncates such a prompt.
+        /// </summary>
+        public int GetPromptOverflow(int promptTokens)
+        {
+            return Math.Max(0, promptTokens + MinPredictTokens + SafetyMarginTokens - EffectiveMaxContextLength);
+        }
+
+        /// <summary>
+        /// Chooses num_ctx for a request. Grows immediately when the request needs more
+        /// room and only shrinks after several requests in a row would fit in half.
+        /// </summary>
+        public int SizeContext(int promptTokens, int predictTokens)
+        {
+            int needed = promptTokens + predictTokens + SafetyMarginTokens;
+            int max = EffectiveMaxContextLength;
+            int bucket = RoundUpToBucket(needed, max);
+
+            lock (_lock)
+            {
+                if (_currentContext == 0 || bucket > _currentContext || _currentContext > max)
+                {
+                    _currentContext = bucket;
+                    _smallerFitStreak = 0;
+                }
+                else if (bucket < _currentContext)
+                {
+                    if (++_smallerFitStreak >= ShrinkAfterRequests)
+                    {
+                        _currentContext = Math.Max(bucket, _currentContext / 2);
+                        _smallerFitStreak = 0;
+                    }
+                }
+                else
+                {
+                    _smallerFitStreak = 0;
+                }
+
+                return _currentContext;
+            }
+        }
+
+        /// <summary>
+        /// Forgets the sticky context size and calibration (e.g. after a model change)
+        /// </summary>
+        public void Reset()
+        {
+            lock (_lock)
+            {
+                _charsPerToken = 4.0;
+                _currentContext = 0;
+                _smallerFitStreak = 0;
+            }
+            ModelContextLength = 0;
+        }
+
+        private int RoundUpToBucket(int tokens, int max)
+        {
+            int bucket = Math.Max(256, Math.Min(MinContextLength, max));
+
+            while (bucket < tokens && bucket < max)
+            {
+                bucket *= 2;
+            }
+
+            return Math.Min(bucket, max);
+        }
+    }
+}
@@ -70,9 +70,14 @@ namespace MSAgentAI.AI
         /// Increments the access count and updates last accessed time
         /// </summary>
         public void MarkAccessed()
+        {
+            MarkAccessed(DateTime.Now);
+        }
+
+        public void MarkAccessed(DateTime now)
         {
             AccessCount++;
-            LastAccessed = DateTime.Now;
+            LastAccessed = now;
         }
 
         public override string ToString()
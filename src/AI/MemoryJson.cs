@@ -0,0 +1,173 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using Newtonsoft.Json;
+
+namespace MSAgentAI.AI
+{
+    /// <summary>
+    /// Reads and writes memories.json without reflection, in the same indented format and
+    /// property order JsonConvert used for the [JsonProperty] names on Memory
+    /// </summary>
+    internal static class MemoryJson
+    {
+        // Property names come back as these strings instead of a new one per memory
+        private static readonly DefaultJsonNameTable Names = CreateNames();
+
+        public static string Serialize(List<Memory> memories)
+        {
+            var text = new StringWriter(CultureInfo.InvariantCulture);
+            using (var writer = new JsonTextWriter(text) { Formatting = Formatting.Indented })
+            {
+                writer.WriteStartArray();
+                foreach (var memory in memories)
+                {
+                    Write(writer, memory);
+                }
+                writer.WriteEndArray();
+            }
+            return text.ToString();
+        }
+
+        /// <summary>
+        /// Reads a list of memories; null for empty or null JSON
+        /// </summary>
+        public static List<Memory> Deserialize(string json)
+        {
+            using (var reader = new JsonTextReader(new StringReader(json)) { PropertyNameTable = Names })
+            {
+                if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                    return null;
+                if (reader.TokenType != JsonToken.StartArray)
+                    throw new JsonSerializationException($"Memories must be a JSON array, not {reader.TokenType}");
+
+                var memories = new List<Memory>();
+                while (reader.Read() && reader.TokenType != JsonToken.EndArray)
+                {
+                    memories.Add(reader.TokenType == JsonToken.Null ? null : Read(reader));
+                }
+                return memories;
+            }
+        }
+
+        private static void Write(JsonWriter writer, Memory memory)
+        {
+            if (memory == null)
+            {
+                writer.WriteNull();
+                return;
+            }
+
+            writer.WriteStartObject();
+            writer.WritePropertyName("id");
+            writer.WriteValue(memory.Id);
+            writer.WritePropertyName("content");
+            writer.WriteValue(memory.Content);
+            writer.WritePropertyName("timestamp");
+            writer.WriteValue(memory.Timestamp);
+            writer.WritePropertyName("importance");
+            writer.WriteValue(memory.Importance);
+            writer.WritePropertyName("category");
+            writer.WriteValue(memory.Category);
+            writer.WritePropertyName("tags");
+            if (memory.Tags == null)
+            {
+                writer.WriteNull();
+            }
+            else
+            {
+                writer.WriteStartArray();
+                foreach (string tag in memory.Tags)
+                {
+                    writer.WriteValue(tag);
+                }
+                writer.WriteEndArray();
+            }
+            writer.WritePropertyName("access_count");
+            writer.WriteValue(memory.AccessCount);
+            writer.WritePropertyName("last_accessed");
+            writer.WriteValue(memory.LastAccessed);
+            writer.WriteEndObject();
+        }
+
+        /// <summary>
+        /// Reads one memory object. Anything missing keeps the value a new Memory starts with.
+        /// </summary>
+        private static Memory Read(JsonReader reader)
+        {
+            if (reader.TokenType != JsonToken.StartObject)
+                throw new JsonSerializationException($"Expected a memory at {reader.Path}");
+
+            var memory = new Memory();
+            while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+            {
+                string name = (string)reader.Value;
+                if (!ReadProperty(reader, name, memory) && !ReadProperty(reader, name.ToLowerInvariant(), memory))
+                {
+                    reader.Skip();
+                }
+            }
+            return memory;
+        }
+
+        private static bool ReadProperty(JsonReader reader, string name, Memory memory)
+        {
+            switch (name)
+            {
+                case "id":
+                    memory.Id = reader.ReadAsString();
+                    return true;
+                case "content":
+                    memory.Content = reader.ReadAsString();
+                    return true;
+                case "timestamp":
+                    memory.Timestamp = reader.ReadAsDateTime() ?? memory.Timestamp;
+                    return true;
+                case "importance":
+                    memory.Importance = reader.ReadAsDouble() ?? memory.Importance;
+                    return true;
+                case "category":
+                    memory.Category = reader.ReadAsString();
+                    return true;
+                case "tags":
+                    memory.Tags = ReadTags(reader);
+                    return true;
+                case "access_count":
+                    memory.AccessCount = reader.ReadAsInt32() ?? memory.AccessCount;
+                    return true;
+                case "last_accessed":
+                    memory.LastAccessed = reader.ReadAsDateTime() ?? memory.LastAccessed;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        private static string[] ReadTags(JsonReader reader)
+        {
+            if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                return null;
+            if (reader.TokenType != JsonToken.StartArray)
+                throw new JsonSerializationException($"Expected a list of tags at {reader.Path}");
+
+            List<string> tags = null;
+            string tag;
+            while ((tag = reader.ReadAsString()) != null || reader.TokenType == JsonToken.Null)
+            {
+                (tags ?? (tags = new List<string>())).Add(tag);
+            }
+            return tags?.ToArray() ?? Array.Empty<string>();
+        }
+
+        private static DefaultJsonNameTable CreateNames()
+        {
+            var names = new DefaultJsonNameTable();
+            foreach (string name in new[] { "id", "content", "timestamp", "importance", "category", "tags", "access_count", "last_accessed" })
+            {
+                names.Add(name);
+            }
+            return names;
+        }
+    }
+}
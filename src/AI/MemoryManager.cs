@@ -2,7 +2,7 @@ using System;
 using System.Collections.Generic;
 using System.IO;
 using System.Linq;
-using Newtonsoft.Json;
+using MSAgentAI.Timing;
 
 namespace MSAgentAI.AI
 {
@@ -26,13 +26,24 @@ namespace MSAgentAI.AI
         /// </summary>
         public double MemoryThreshold { get; set; }
 
-        public MemoryManager()
+        /// <summary>
+        /// Time new memories are stamped with and recency is scored against
+        /// </summary>
+        public IClock Clock { get; set; } = SystemClock.Instance;
+
+        public MemoryManager() : this(Path.Combine(
+            Environment.GetFolderPath(Environment.SpecialFolder.ApplicationData),
+            "MSAgentAI",
+            "memories.json"))
+        {
+        }
+
+        /// <summary>
+        /// Keeps memories in the given file instead of the one in %AppData%
+        /// </summary>
+        public MemoryManager(string memoriesPath)
         {
-            _memoriesPath = Path.Combine(
-                Environment.GetFolderPath(Environment.SpecialFolder.ApplicationData),
-                "MSAgentAI",
-                "memories.json"
-            );
+            _memoriesPath = memoriesPath;
 
             _memories = new List<Memory>();
             Enabled = false;
@@ -79,7 +90,7 @@ namespace MSAgentAI.AI
             // Mark memories as accessed
             foreach (var memory in scoredMemories)
             {
-                memory.MarkAccessed();
+                memory.MarkAccessed(Clock.Now);
             }
 
             return scoredMemories;
@@ -94,7 +105,7 @@ namespace MSAgentAI.AI
             double score = memory.Importance;
 
             // Bonus for recent memories (decay over 30 days)
-            var daysSinceCreation = (DateTime.Now - memory.Timestamp).TotalDays;
+            var daysSinceCreation = (Clock.Now - memory.Timestamp).TotalDays;
             var recencyBonus = Math.Max(0, 1.0 - (daysSinceCreation / 30.0));
             score += recencyBonus;
 
@@ -117,8 +128,11 @@ namespace MSAgentAI.AI
             if (importance < MemoryThreshold)
                 return false;
 
+            var now = Clock.Now;
             var memory = new Memory
             {
+                Timestamp = now,
+                LastAccessed = now,
                 Content = content,
                 Importance = importance,
                 Category = category,
@@ -204,8 +218,8 @@ namespace MSAgentAI.AI
             {
                 TotalMemories = _memories.Count,
                 AverageImportance = _memories.Count > 0 ? _memories.Average(m => m.Importance) : 0,
-                OldestMemory = _memories.Count > 0 ? _memories.Min(m => m.Timestamp) : DateTime.Now,
-                NewestMemory = _memories.Count > 0 ? _memories.Max(m => m.Timestamp) : DateTime.Now,
+                OldestMemory = _memories.Count > 0 ? _memories.Min(m => m.Timestamp) : Clock.Now,
+                NewestMemory = _memories.Count > 0 ? _memories.Max(m => m.Timestamp) : Clock.Now,
                 CategoriesCount = _memories.Select(m => m.Category).Distinct().Count()
             };
         }
@@ -223,7 +237,7 @@ namespace MSAgentAI.AI
                     Directory.CreateDirectory(directory);
                 }
 
-                var json = JsonConvert.SerializeObject(_memories, Formatting.Indented);
+                var json = MemoryJson.Serialize(_memories);
                 File.WriteAllText(_memoriesPath, json);
             }
             catch (Exception ex)
@@ -242,7 +256,7 @@ namespace MSAgentAI.AI
                 if (File.Exists(_memoriesPath))
                 {
                     var json = File.ReadAllText(_memoriesPath);
-                    _memories = JsonConvert.DeserializeObject<List<Memory>>(json) ?? new List<Memory>();
+                    _memories = MemoryJson.Deserialize(json) ?? new List<Memory>();
                 }
             }
             catch (Exception ex)
@@ -257,7 +271,7 @@ namespace MSAgentAI.AI
         /// </summary>
         public void ExportMemories(string filePath)
         {
-            var json = JsonConvert.SerializeObject(_memories, Formatting.Indented);
+            var json = MemoryJson.Serialize(_memories);
             File.WriteAllText(filePath, json);
         }
 
@@ -267,7 +281,7 @@ namespace MSAgentAI.AI
         public void ImportMemories(string filePath)
         {
             var json = File.ReadAllText(filePath);
-            var importedMemories = JsonConvert.DeserializeObject<List<Memory>>(json);
+            var importedMemories = MemoryJson.Deserialize(json);
             if (importedMemories != null)
             {
                 // Avoid duplicates by checking if a memory with the same ID already exists
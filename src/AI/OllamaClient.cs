@@ -1,11 +1,14 @@
 using System;
 using System.Collections.Generic;
 using System.IO;
+using System.Net;
 using System.Net.Http;
 using System.Text;
 using System.Text.RegularExpressions;
 using System.Threading;
 using System.Threading.Tasks;
+using MSAgentAI.Logging;
+using MSAgentAI.Timing;
 using Newtonsoft.Json;
 
 namespace MSAgentAI.AI
@@ -17,12 +20,62 @@ namespace MSAgentAI.AI
     {
         private readonly HttpClient _httpClient;
         private bool _disposed;
+        private string _model = "llama2";
+        private string _baseUrl = "http://localhost:11434";
+
+        // Upper bound on history messages sent with each chat request
+        public const int MaxHistoryMessages = 10;
+
+        // Chats, random dialog, memory extraction and model polling can all be in flight at once
+        private const int MaxConnectionsPerServer = 8;
+
+        public string BaseUrl
+        {
+            get => _baseUrl;
+            set
+            {
+                if (!string.Equals(_baseUrl, value, StringComparison.Ordinal))
+                {
+                    _baseUrl = value;
+                    AllowConnections(value);
+                    Models?.Invalidate();
+                    ContextBudget.ModelContextLength = 0;
+                }
+            }
+        }
+
+        public string Model
+        {
+            get => _model;
+            set
+            {
+                if (!string.Equals(_model, value, StringComparison.Ordinal))
+                {
+                    _model = value;
+                    ContextBudget.Reset();
+                }
+            }
+        }
 
-        public string BaseUrl { get; set; } = "http://localhost:11434";
-        public string Model { get; set; } = "llama2";
         public string PersonalityPrompt { get; set; } = "";
         public int MaxTokens { get; set; } = 150;
         public double Temperature { get; set; } = 0.8;
+
+        /// <summary>
+        /// When enabled, num_ctx is sized per request from the prompt size instead of
+        /// leaving Ollama to allocate its default KV cache
+        /// </summary>
+        public bool AdaptiveContext { get; set; } = true;
+
+        /// <summary>
+        /// Context and generation sizing shared by all requests
+        /// </summary>
+        public ContextBudget ContextBudget { get; } = new ContextBudget();
+
+        /// <summary>
+        /// Cached model inventory, metadata and load state
+        /// </summary>
+        public OllamaModelCatalog Models { get; }
         
         // Available animations for AI to use
         public List<string> AvailableAnimations { get; set; } = new List<string>();
@@ -33,7 +86,17 @@ namespace MSAgentAI.AI
         // User description for context
         public string UserDescription { get; set; } = "";
 
-        private List<ChatMessage> _conversationHistory = new List<ChatMessage>();
+        // The conversation used when no session is given (chat window, tray menu, default character)
+        private readonly ChatSession _defaultSession = new ChatSession();
+
+        // The same oversized system prompt goes out with every request, so it's reported once
+        // until a prompt fits again
+        private volatile bool _promptOverflowReported;
+
+        /// <summary>
+        /// The conversation used when no session is given
+        /// </summary>
+        public ChatSession DefaultSession => _defaultSession;
 
         // Enforced system prompt additions
         private const string ENFORCED_RULES = @"
@@ -45,23 +108,65 @@ IMPORTANT RULES YOU MUST FOLLOW:
 5. Speak naturally as a desktop companion character.
 ";
 
-        public OllamaClient()
+        public OllamaClient() : this(CreateHandler())
+        {
+        }
+
+        /// <summary>
+        /// Sends every request through the given handler, e.g. a stub that answers in-process
+        /// </summary>
+        /// <param name="clock">Times the model catalog's caches and refresh, or null for the system clock</param>
+        public OllamaClient(HttpMessageHandler handler, IClock clock = null)
         {
-            _httpClient = new HttpClient
+            _httpClient = new HttpClient(handler ?? throw new ArgumentNullException(nameof(handler)))
             {
                 Timeout = TimeSpan.FromSeconds(120)
             };
+            AllowConnections(_baseUrl);
+            Models = new OllamaModelCatalog(_httpClient, () => BaseUrl, clock);
         }
 
         /// <summary>
-        /// Tests the connection to Ollama
+        /// On .NET 8, SocketsHttpHandler pools connections and recycles them now and then, so a
+        /// restarted server or a changed address is picked up without restarting the app
+        /// </summary>
+        private static HttpMessageHandler CreateHandler()
+        {
+#if NET
+            return new SocketsHttpHandler
+            {
+                MaxConnectionsPerServer = MaxConnectionsPerServer,
+                PooledConnectionLifetime = TimeSpan.FromMinutes(5),
+                PooledConnectionIdleTimeout = TimeSpan.FromSeconds(90)
+            };
+#else
+            return new HttpClientHandler();
+#endif
+        }
+
+        /// <summary>
+        /// .NET Framework allows two connections per host unless told otherwise, which queues a
+        /// chat behind a model poll and a random dialog. SocketsHttpHandler ignores this.
+        /// </summary>
+        private static void AllowConnections(string baseUrl)
+        {
+#if !NET
+            if (Uri.TryCreate(baseUrl, UriKind.Absolute, out var uri) && (uri.Scheme == Uri.UriSchemeHttp || uri.Scheme == Uri.UriSchemeHttps))
+            {
+                var servicePoint = ServicePointManager.FindServicePoint(uri);
+                servicePoint.ConnectionLimit = Math.Max(servicePoint.ConnectionLimit, MaxConnectionsPerServer);
+            }
+#endif
+        }
+
+        /// <summary>
+        /// Tests the connection to Ollama (always hits the server, and refreshes the model cache)
         /// </summary>
         public async Task<bool> TestConnectionAsync()
         {
             try
             {
-                var response = await _httpClient.GetAsync($"{BaseUrl}/api/tags");
-                return response.IsSuccessStatusCode;
+                return await Models.RefreshAsync();
             }
             catch
             {
@@ -70,31 +175,17 @@ IMPORTANT RULES YOU MUST FOLLOW:
         }
 
         /// <summary>
-        /// Gets available models from Ollama
+        /// Gets available models from Ollama, served from cache while it's fresh
         /// </summary>
-        public async Task<List<string>> GetAvailableModelsAsync()
+        public async Task<List<string>> GetAvailableModelsAsync(bool forceRefresh = false)
         {
             var models = new List<string>();
 
             try
             {
-                var response = await _httpClient.GetAsync($"{BaseUrl}/api/tags");
-                if (response.IsSuccessStatusCode)
+                foreach (var model in await Models.GetModelsAsync(forceRefresh))
                 {
-                    var content = await response.Content.ReadAsStringAsync();
-                    var result = JsonConvert.DeserializeObject<OllamaTagsResponse>(content);
-                    if (result?.Models != null)
-                    {
-                        foreach (var model in result.Models)
-                        {
-                            // Only add the base model name (before the colon for versions)
-                            string modelName = model.Name;
-                            if (!string.IsNullOrEmpty(modelName))
-                            {
-                                models.Add(modelName);
-                            }
-                        }
-                    }
+                    models.Add(model.Name);
                 }
             }
             catch { }
@@ -102,16 +193,30 @@ IMPORTANT RULES YOU MUST FOLLOW:
             return models;
         }
 
+        /// <summary>
+        /// Feeds the current model's real context length into history budgeting
+        /// </summary>
+        private async Task ApplyModelContextAsync(CancellationToken cancellationToken)
+        {
+            var info = await Models.GetModelInfoAsync(Model, cancellationToken);
+            if (info != null && info.ContextLength > 0)
+            {
+                ContextBudget.ModelContextLength = info.ContextLength;
+            }
+        }
+
         /// <summary>
         /// Builds the full system prompt with personality and rules
         /// </summary>
-        private string BuildSystemPrompt()
+        internal string BuildSystemPrompt(ChatSession session = null)
         {
             var prompt = new StringBuilder();
+            string personality = session?.PersonalityPrompt ?? PersonalityPrompt;
+            var animations = session?.AvailableAnimations ?? AvailableAnimations;
             
-            if (!string.IsNullOrEmpty(PersonalityPrompt))
+            if (!string.IsNullOrEmpty(personality))
             {
-                prompt.AppendLine(PersonalityPrompt);
+                prompt.AppendLine(personality);
                 prompt.AppendLine();
             }
             
@@ -140,10 +245,10 @@ IMPORTANT RULES YOU MUST FOLLOW:
             
             prompt.AppendLine(ENFORCED_RULES);
             
-            if (AvailableAnimations.Count > 0)
+            if (animations.Count > 0)
             {
                 prompt.AppendLine();
-                prompt.AppendLine("Available animations you can use with && prefix: " + string.Join(", ", AvailableAnimations.GetRange(0, Math.Min(20, AvailableAnimations.Count))));
+                prompt.AppendLine("Available animations you can use with && prefix: " + string.Join(", ", animations.GetRange(0, Math.Min(20, animations.Count))));
             }
             
             return prompt.ToString();
@@ -197,63 +302,99 @@ IMPORTANT RULES YOU MUST FOLLOW:
         /// <summary>
         /// Sends a chat message to Ollama and gets a response
         /// </summary>
-        public async Task<string> ChatAsync(string message, CancellationToken cancellationToken = default)
+        public Task<string> ChatAsync(string message, CancellationToken cancellationToken = default)
+        {
+            return ChatAsync(message, null, cancellationToken);
+        }
+
+        /// <summary>
+        /// Sends a chat message to Ollama and gets a response, filling in the token
+        /// counts Ollama reported when usage is not null
+        /// </summary>
+        public Task<string> ChatAsync(string message, OllamaUsage usage, CancellationToken cancellationToken)
+        {
+            return ChatAsync(_defaultSession, message, usage, cancellationToken);
+        }
+
+        /// <summary>
+        /// Sends a chat message as part of the given conversation, which keeps its own history
+        /// </summary>
+        public async Task<string> ChatAsync(ChatSession session, string message, OllamaUsage usage, CancellationToken cancellationToken)
         {
+            session = session ?? _defaultSession;
+            var history = session.GetRecent(MaxHistoryMessages);
             try
             {
+                await ApplyModelContextAsync(cancellationToken);
+
                 // Build the messages list with personality and history
-                var messages = new List<object>();
+                var messages = new List<ChatMessage>();
+                string systemPrompt = BuildSystemPrompt(session);
+
+                int predictTokens = ContextBudget.GetPredictTokens(OllamaRequestKind.Chat, MaxTokens);
+                int promptTokens = ContextBudget.EstimateTokens(message);
+                int promptChars = message.Length;
 
                 // Add system message with personality and rules
-                string systemPrompt = BuildSystemPrompt();
                 if (!string.IsNullOrEmpty(systemPrompt))
                 {
-                    messages.Add(new { role = "system", content = systemPrompt });
+                    messages.Add(new ChatMessage { Role = "system", Content = systemPrompt });
+                    promptTokens += ContextBudget.EstimateTokens(systemPrompt);
+                    promptChars += systemPrompt.Length;
                 }
 
-                // Add conversation history (limit to last 10 messages)
-                int startIndex = Math.Max(0, _conversationHistory.Count - 10);
-                for (int i = startIndex; i < _conversationHistory.Count; i++)
+                // Add conversation history, newest first, while it fits in the prompt budget
+                int historyBudget = ContextBudget.GetPromptBudget(predictTokens) - promptTokens;
+                int oldestAllowed = Math.Max(0, history.Count - MaxHistoryMessages);
+                int startIndex = history.Count;
+                while (startIndex > oldestAllowed)
                 {
-                    messages.Add(new
-                    {
-                        role = _conversationHistory[i].Role,
-                        content = _conversationHistory[i].Content
-                    });
+                    int cost = ContextBudget.EstimateTokens(history[startIndex - 1].Content);
+                    if (cost > historyBudget)
+                        break;
+
+                    historyBudget -= cost;
+                    promptTokens += cost;
+                    promptChars += history[startIndex - 1].Content.Length;
+                    startIndex--;
                 }
 
-                // Add the new user message
-                messages.Add(new { role = "user", content = message });
+                if (startIndex > oldestAllowed)
+                {
+                    System.Diagnostics.Debug.WriteLine($"Ollama: dropped {startIndex - oldestAllowed} history message(s) to fit the context window");
+                }
+
+                session.LastContextTokens = promptTokens - ContextBudget.EstimateTokens(message);
 
-                var request = new
+                for (int i = startIndex; i < history.Count; i++)
                 {
-                    model = Model,
-                    messages = messages,
-                    stream = false,
-                    options = new
-                    {
-                        num_predict = MaxTokens,
-                        temperature = Temperature
-                    }
-                };
+                    messages.Add(history[i]);
+                }
+
+                // Add the new user message
+                messages.Add(new ChatMessage { Role = "user", Content = message });
+
+                var content = OllamaJson.CreateChatContent(Model, messages, BuildOptions(promptTokens, predictTokens, Temperature));
 
-                var json = JsonConvert.SerializeObject(request);
-                var content = new StringContent(json, Encoding.UTF8, "application/json");
+                // Don't start generating if the caller's deadline passed while the prompt was built
+                cancellationToken.ThrowIfCancellationRequested();
 
                 var response = await _httpClient.PostAsync($"{BaseUrl}/api/chat", content, cancellationToken);
 
                 if (response.IsSuccessStatusCode)
                 {
                     var responseContent = await response.Content.ReadAsStringAsync();
-                    var result = JsonConvert.DeserializeObject<OllamaChatResponse>(responseContent);
+                    var result = OllamaJson.ReadChatResponse(responseContent);
+                    RecordUsage(result, promptChars, messages.Count, usage);
 
                     if (result?.Message?.Content != null)
                     {
                         string cleanedResponse = CleanResponse(result.Message.Content);
                         
                         // Add to conversation history
-                        _conversationHistory.Add(new ChatMessage { Role = "user", Content = message });
-                        _conversationHistory.Add(new ChatMessage { Role = "assistant", Content = cleanedResponse });
+                        session.AddExchange(
+                            new ChatMessage { Role = "user", Content = message },
+                            new ChatMessage { Role = "assistant", Content = cleanedResponse });
                         
                         // Try to create a memory from this conversation
                         await TryCreateMemoryAsync(message, cleanedResponse, cancellationToken);
@@ -269,8 +410,9 @@ IMPORTANT RULES YOU MUST FOLLOW:
 
                 return null;
             }
-            catch (TaskCanceledException)
+            catch (OperationCanceledException)
             {
+                // Cancelled or past its deadline; closing the request also stops generation in Ollama
                 return null;
             }
             catch (Exception ex)
@@ -283,44 +425,47 @@ IMPORTANT RULES YOU MUST FOLLOW:
         /// <summary>
         /// Generates a random dialog using Ollama
         /// </summary>
-        public async Task<string> GenerateRandomDialogAsync(string customPrompt = null, CancellationToken cancellationToken = default)
+        public Task<string> GenerateRandomDialogAsync(string customPrompt = null, CancellationToken cancellationToken = default)
+        {
+            return GenerateRandomDialogAsync(customPrompt, null, cancellationToken);
+        }
+
+        /// <summary>
+        /// Generates a random dialog in a session's personality; the session's history is left alone
+        /// </summary>
+        public async Task<string> GenerateRandomDialogAsync(string customPrompt, ChatSession session, CancellationToken cancellationToken)
         {
             string prompt = customPrompt ?? "Say something short, interesting, and in-character. Use /emp/ for emphasis and optionally include an &&animation trigger.";
 
             try
             {
-                var messages = new List<object>();
+                await ApplyModelContextAsync(cancellationToken);
+
+                var messages = new List<ChatMessage>();
+                int predictTokens = ContextBudget.GetPredictTokens(OllamaRequestKind.RandomDialog, MaxTokens);
+                int promptTokens = ContextBudget.EstimateTokens(prompt);
+                int promptChars = prompt.Length;
 
                 // Add system prompt with personality and rules
-                string systemPrompt = BuildSystemPrompt();
+                string systemPrompt = BuildSystemPrompt(session);
                 if (!string.IsNullOrEmpty(systemPrompt))
                 {
-                    messages.Add(new { role = "system", content = systemPrompt });
+                    messages.Add(new ChatMessage { Role = "system", Content = systemPrompt });
+                    promptTokens += ContextBudget.EstimateTokens(systemPrompt);
+                    promptChars += systemPrompt.Length;
                 }
 
-                messages.Add(new { role = "user", content = prompt });
+                messages.Add(new ChatMessage { Role = "user", Content = prompt });
 
-                var request = new
-                {
-                    model = Model,
-                    messages = messages,
-                    stream = false,
-                    options = new
-                    {
-                        num_predict = 100,
-                        temperature = 1.0
-                    }
-                };
-
-                var json = JsonConvert.SerializeObject(request);
-                var content = new StringContent(json, Encoding.UTF8, "application/json");
+                var content = OllamaJson.CreateChatContent(Model, messages, BuildOptions(promptTokens, predictTokens, 1.0));
 
                 var response = await _httpClient.PostAsync($"{BaseUrl}/api/chat", content, cancellationToken);
 
                 if (response.IsSuccessStatusCode)
                 {
                     var responseContent = await response.Content.ReadAsStringAsync();
-                    var result = JsonConvert.DeserializeObject<OllamaChatResponse>(responseContent);
+                    var result = OllamaJson.ReadChatResponse(responseContent);
+                    RecordUsage(result, promptChars, messages.Count, null);
                     return CleanResponse(result?.Message?.Content);
                 }
 
@@ -332,12 +477,79 @@ IMPORTANT RULES YOU MUST FOLLOW:
             }
         }
 
+        /// <summary>
+        /// Estimates the total tokens a chat request for this message will cost, using the
+        /// system prompt and history size of the previous request
+        /// </summary>
+        public int EstimateChatCost(string message, ChatSession session = null)
+        {
+            return ContextBudget.EstimateTokens(message)
+                + (session ?? _defaultSession).LastContextTokens
+                + ContextBudget.GetPredictTokens(OllamaRequestKind.Chat, MaxTokens);
+        }
+
+        /// <summary>
+        /// Builds the request options, sizing num_ctx and num_predict for this prompt
+        /// </summary>
+        private OllamaOptions BuildOptions(int promptTokens, int predictTokens, double temperature)
+        {
+            int overflow = ContextBudget.GetPromptOverflow(promptTokens);
+            if (overflow == 0)
+            {
+                _promptOverflowReported = false;
+            }
+            else if (!_promptOverflowReported)
+            {
+                _promptOverflowReported = true;
+                Logger.LogWarning($"Ollama: the system prompt and message come to ~{promptTokens} tokens, too many for the {ContextBudget.EffectiveMaxContextLength}-token context to hold with room for a reply, so Ollama will truncate them. Shorten the personality or raise the maximum context length.");
+            }
+
+            int fittedPredict = ContextBudget.FitPredictTokens(promptTokens, predictTokens);
+            if (fittedPredict < predictTokens)
+            {
+                System.Diagnostics.Debug.WriteLine($"Ollama: prompt of ~{promptTokens} tokens leaves room for only {fittedPredict} response tokens");
+            }
+
+            return new OllamaOptions
+            {
+                NumPredict = fittedPredict,
+                Temperature = temperature,
+                NumContext = AdaptiveContext ? ContextBudget.SizeContext(promptTokens, fittedPredict) : 0
+            };
+        }
+
+
+        /// <summary>
+        /// Feeds measured token counts back into the context budget
+        /// </summary>
+        private void RecordUsage(OllamaChatResponse result, int promptChars, int messageCount, OllamaUsage usage)
+        {
+            if (result == null)
+                return;
+
+            if (usage != null)
+            {
+                usage.PromptTokens = result.PromptEvalCount;
+                usage.ResponseTokens = result.EvalCount;
+            }
+
+            if (result.PromptEvalCount > 0)
+            {
+                ContextBudget.RecordPromptEval(promptChars, messageCount, result.PromptEvalCount);
+            }
+
+            if (result.DoneReason == "length")
+            {
+                System.Diagnostics.Debug.WriteLine($"Ollama: response stopped at the num_predict limit ({result.EvalCount} tokens)");
+            }
+        }
+
         /// <summary>
         /// Clears the conversation history
         /// </summary>
         public void ClearHistory()
         {
-            _conversationHistory.Clear();
+            _defaultSession.Clear();
         }
 
         /// <summary>
@@ -422,37 +634,35 @@ IMPORTANT RULES YOU MUST FOLLOW:
         {
             if (!_disposed)
             {
+                Models?.Dispose();
                 _httpClient?.Dispose();
                 _disposed = true;
             }
         }
 
-        // Response classes for JSON deserialization
-        private class OllamaTagsResponse
-        {
-            [JsonProperty("models")]
-            public List<OllamaModel> Models { get; set; }
-        }
-
-        private class OllamaModel
-        {
-            [JsonProperty("name")]
-            public string Name { get; set; }
-        }
-
-        private class OllamaChatResponse
+        // Response classes, read by OllamaJson
+        internal class OllamaChatResponse
         {
             [JsonProperty("message")]
             public OllamaChatMessage Message { get; set; }
+
+            [JsonProperty("done_reason")]
+            public string DoneReason { get; set; }
+
+            [JsonProperty("prompt_eval_count")]
+            public int PromptEvalCount { get; set; }
+
+            [JsonProperty("eval_count")]
+            public int EvalCount { get; set; }
         }
 
-        private class OllamaChatMessage
+        internal class OllamaChatMessage
         {
             [JsonProperty("content")]
             public string Content { get; set; }
         }
 
-        private class ChatMessage
+        internal class ChatMessage
         {
             public string Role { get; set; }
             public string Content { get; set; }
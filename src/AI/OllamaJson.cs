@@ -0,0 +1,158 @@
+using System.Collections.Generic;
+using System.IO;
+using System.Net.Http;
+using System.Net.Http.Headers;
+using System.Text;
+using Newtonsoft.Json;
+
+namespace MSAgentAI.AI
+{
+    /// <summary>
+    /// Sampling options sent with a chat request
+    /// </summary>
+    internal struct OllamaOptions
+    {
+        public int NumPredict { get; set; }
+        public double Temperature { get; set; }
+        public int NumContext { get; set; } // 0 leaves num_ctx to the model's default
+    }
+
+    /// <summary>
+    /// Writes /api/chat requests and reads their responses without reflection. Requests are the
+    /// same bytes JsonConvert wrote for the anonymous request objects, written straight to UTF-8.
+    /// </summary>
+    internal static class OllamaJson
+    {
+        private static readonly UTF8Encoding Utf8 = new UTF8Encoding(false);
+
+        // Everything Ollama puts in a chat response, so reading one allocates no property names
+        private static readonly DefaultJsonNameTable ResponseNames = CreateResponseNames();
+
+        /// <summary>
+        /// Builds the body of a non-streaming chat request
+        /// </summary>
+        public static HttpContent CreateChatContent(string model, List<OllamaClient.ChatMessage> messages, OllamaOptions options)
+        {
+            int capacity = 256;
+            foreach (var message in messages)
+            {
+                capacity += 32 + (message.Content?.Length ?? 0);
+            }
+
+            var body = new MemoryStream(capacity);
+            using (var text = new StreamWriter(body, Utf8, 1024, leaveOpen: true))
+            using (var writer = new JsonTextWriter(text))
+            {
+                writer.WriteStartObject();
+                writer.WritePropertyName("model");
+                writer.WriteValue(model);
+                writer.WritePropertyName("messages");
+                writer.WriteStartArray();
+                foreach (var message in messages)
+                {
+                    writer.WriteStartObject();
+                    writer.WritePropertyName("role");
+                    writer.WriteValue(message.Role);
+                    writer.WritePropertyName("content");
+                    writer.WriteValue(message.Content);
+                    writer.WriteEndObject();
+                }
+                writer.WriteEndArray();
+                writer.WritePropertyName("stream");
+                writer.WriteValue(false);
+                writer.WritePropertyName("options");
+                writer.WriteStartObject();
+                writer.WritePropertyName("num_predict");
+                writer.WriteValue(options.NumPredict);
+                writer.WritePropertyName("temperature");
+                writer.WriteValue(options.Temperature);
+                if (options.NumContext > 0)
+                {
+                    writer.WritePropertyName("num_ctx");
+                    writer.WriteValue(options.NumContext);
+                }
+                writer.WriteEndObject();
+                writer.WriteEndObject();
+            }
+
+            var content = new ByteArrayContent(body.GetBuffer(), 0, (int)body.Length);
+            content.Headers.ContentType = new MediaTypeHeaderValue("application/json") { CharSet = "utf-8" };
+            return content;
+        }
+
+        /// <summary>
+        /// Reads the fields OllamaClient uses from a chat response and skips the rest.
+        /// Returns null for an empty or null body.
+        /// </summary>
+        public static OllamaClient.OllamaChatResponse ReadChatResponse(string json)
+        {
+            using (var reader = new JsonTextReader(new StringReader(json)) { PropertyNameTable = ResponseNames, DateParseHandling = DateParseHandling.None })
+            {
+                if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                    return null;
+                if (reader.TokenType != JsonToken.StartObject)
+                    throw new JsonSerializationException($"Expected a chat response, not {reader.TokenType}");
+
+                var response = new OllamaClient.OllamaChatResponse();
+                while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+                {
+                    switch ((string)reader.Value)
+                    {
+                        case "message":
+                            response.Message = ReadMessage(reader);
+                            break;
+                        case "done_reason":
+                            response.DoneReason = reader.ReadAsString();
+                            break;
+                        case "prompt_eval_count":
+                            response.PromptEvalCount = reader.ReadAsInt32() ?? 0;
+                            break;
+                        case "eval_count":
+                            response.EvalCount = reader.ReadAsInt32() ?? 0;
+                            break;
+                        default:
+                            reader.Skip();
+                            break;
+                    }
+                }
+                return response;
+            }
+        }
+
+        private static OllamaClient.OllamaChatMessage ReadMessage(JsonReader reader)
+        {
+            if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                return null;
+            if (reader.TokenType != JsonToken.StartObject)
+                throw new JsonSerializationException($"Expected a message at {reader.Path}");
+
+            var message = new OllamaClient.OllamaChatMessage();
+            while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+            {
+                if ((string)reader.Value == "content")
+                {
+                    message.Content = reader.ReadAsString();
+                }
+                else
+                {
+                    reader.Skip();
+                }
+            }
+            return message;
+        }
+
+        private static DefaultJsonNameTable CreateResponseNames()
+        {
+            var names = new DefaultJsonNameTable();
+            foreach (string name in new[]
+            {
+                "model", "created_at", "message", "role", "content", "thinking", "images", "tool_calls", "done", "done_reason",
+                "total_duration", "load_duration", "prompt_eval_count", "prompt_eval_duration", "eval_count", "eval_duration"
+            })
+            {
+                names.Add(name);
+            }
+            return names;
+        }
+    }
+}
@@ -0,0 +1,621 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Net.Http;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Timing;
+using Newtonsoft.Json;
+
+namespace MSAgentAI.AI
+{
+    /// <summary>
+    /// Whether a model is currently resident in Ollama's memory
+    /// </summary>
+    public enum ModelLoadState
+    {
+        Unknown,
+        Cold,
+        Loaded
+    }
+
+    /// <summary>
+    /// Metadata about an installed Ollama model
+    /// </summary>
+    public class OllamaModelInfo
+    {
+        public string Name { get; set; }
+        public long Size { get; set; }
+        public string Digest { get; set; }
+        public DateTime ModifiedAt { get; set; }
+        public string Family { get; set; }
+        public string ParameterSize { get; set; }
+        public string QuantizationLevel { get; set; }
+
+        /// <summary>
+        /// Trained context length from /api/show (0 until details are loaded)
+        /// </summary>
+        public int ContextLength { get; set; }
+
+        /// <summary>
+        /// num_ctx from the model's Modelfile parameters, if set (0 otherwise)
+        /// </summary>
+        public int DefaultNumCtx { get; set; }
+
+        public override string ToString()
+        {
+            return $"{Name} ({ParameterSize ?? "?"}, {QuantizationLevel ?? "?"}, ctx {(ContextLength > 0 ? ContextLength.ToString() : "?")})";
+        }
+    }
+
+    /// <summary>
+    /// Caches Ollama's model inventory (/api/tags), per-model details (/api/show) and
+    /// load state (/api/ps) with TTLs, and optionally keeps them fresh in the background
+    /// so the settings dialog and request paths don't hit the server every time.
+    /// </summary>
+    public class OllamaModelCatalog : IDisposable
+    {
+        private readonly HttpClient _httpClient;
+        private readonly Func<string> _baseUrl;
+        private readonly IClock _clock;
+        private readonly object _lock = new object();
+
+        private List<OllamaModelInfo> _models = new List<OllamaModelInfo>();
+        private DateTime _modelsFetchedAt = DateTime.MinValue;
+        private Task<bool> _tagsRefresh;
+
+        private readonly Dictionary<string, OllamaModelInfo> _details = new Dictionary<string, OllamaModelInfo>(StringComparer.OrdinalIgnoreCase);
+        private readonly Dictionary<string, DateTime> _detailsFetchedAt = new Dictionary<string, DateTime>(StringComparer.OrdinalIgnoreCase);
+        private readonly Dictionary<string, DateTime> _showFailedAt = new Dictionary<string, DateTime>(StringComparer.OrdinalIgnoreCase);
+
+        private HashSet<string> _loadedModels = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+        private DateTime _loadStateFetchedAt = DateTime.MinValue;
+
+        private IClockTimer _refreshTimer;
+        private int _refreshing;
+        private bool _disposed;
+
+        /// <summary>
+        /// How long the model list stays fresh
+        /// </summary>
+        public TimeSpan TagsTtl { get; set; } = TimeSpan.FromMinutes(5);
+
+        /// <summary>
+        /// How long /api/show details stay fresh
+        /// </summary>
+        public TimeSpan ShowTtl { get; set; } = TimeSpan.FromHours(1);
+
+        /// <summary>
+        /// How long a failed /api/show (unknown model, server down) is remembered before retrying
+        /// </summary>
+        public TimeSpan ShowFailureTtl { get; set; } = TimeSpan.FromMinutes(1);
+
+        /// <summary>
+        /// How long the loaded/cold state stays fresh
+        /// </summary>
+        public TimeSpan LoadStateTtl { get; set; } = TimeSpan.FromSeconds(15);
+
+        /// <summary>
+        /// Whether the last /api/tags request succeeded
+        /// </summary>
+        public bool IsReachable { get; private set; }
+
+        /// <summary>
+        /// Raised after the model list or load state changes
+        /// </summary>
+        public event EventHandler ModelsChanged;
+
+        /// <param name="clock">Times the TTLs and background refresh, or null for the system clock</param>
+        public OllamaModelCatalog(HttpClient httpClient, Func<string> baseUrl, IClock clock = null)
+        {
+            _httpClient = httpClient ?? throw new ArgumentNullException(nameof(httpClient));
+            _baseUrl = baseUrl ?? throw new ArgumentNullException(nameof(baseUrl));
+            _clock = clock ?? SystemClock.Instance;
+        }
+
+        /// <summary>
+        /// Gets the installed models, from cache when it's still fresh
+        /// </summary>
+        public async Task<List<OllamaModelInfo>> GetModelsAsync(bool forceRefresh = false)
+        {
+            if (forceRefresh || IsExpired(_modelsFetchedAt, TagsTtl))
+            {
+                await RefreshTagsAsync(forceRefresh);
+            }
+
+            lock (_lock)
+            {
+                return new List<OllamaModelInfo>(_models);
+            }
+        }
+
+        /// <summary>
+        /// Gets a model's metadata including context length, loading /api/show if needed.
+        /// Returns null if the model is unknown or the server is unreachable.
+        /// </summary>
+        public async Task<OllamaModelInfo> GetModelInfoAsync(string model, CancellationToken cancellationToken = default)
+        {
+            if (string.IsNullOrEmpty(model))
+                return null;
+
+            lock (_lock)
+            {
+                if (_details.TryGetValue(model, out var cached) &&
+                    _detailsFetchedAt.TryGetValue(model, out var fetchedAt) &&
+                    !IsExpired(fetchedAt, ShowTtl))
+                {
+                    return cached;
+                }
+
+                // Don't ask again on every request while the model is missing or the server is down
+                if (_showFailedAt.TryGetValue(model, out var failedAt) && !IsExpired(failedAt, ShowFailureTtl))
+                {
+                    return cached;
+                }
+            }
+
+            var info = await FetchShowAsync(model, cancellationToken);
+            if (info == null)
+            {
+                // Keep serving stale details rather than nothing
+                lock (_lock)
+                {
+                    if (!cancellationToken.IsCancellationRequested)
+                    {
+                        _showFailedAt[model] = _clock.UtcNow;
+                    }
+                    return _details.TryGetValue(model, out var stale) ? stale : null;
+                }
+            }
+
+            lock (_lock)
+            {
+                _details[model] = info;
+                _detailsFetchedAt[model] = _clock.UtcNow;
+                _showFailedAt.Remove(model);
+            }
+
+            return info;
+        }
+
+        /// <summary>
+        /// Gets cached metadata without any network access (null if not cached)
+        /// </summary>
+        public OllamaModelInfo GetCachedModelInfo(string model)
+        {
+            if (string.IsNullOrEmpty(model))
+                return null;
+
+            lock (_lock)
+            {
+                if (_details.TryGetValue(model, out var info))
+                    return info;
+
+                return _models.FirstOrDefault(m => string.Equals(m.Name, model, StringComparison.OrdinalIgnoreCase));
+            }
+        }
+
+        /// <summary>
+        /// Gets whether a model is loaded, refreshing /api/ps if the cached state is stale
+        /// </summary>
+        public async Task<ModelLoadState> GetLoadStateAsync(string model)
+        {
+            if (IsExpired(_loadStateFetchedAt, LoadStateTtl))
+            {
+                await RefreshLoadStateAsync();
+            }
+
+            return GetCachedLoadState(model);
+        }
+
+        /// <summary>
+        /// Gets the last known load state without any network access
+        /// </summary>
+        public ModelLoadState GetCachedLoadState(string model)
+        {
+            if (string.IsNullOrEmpty(model))
+                return ModelLoadState.Unknown;
+
+            lock (_lock)
+            {
+                // Treat very old data as unknown rather than trusting it
+                if (IsExpired(_loadStateFetchedAt, TimeSpan.FromTicks(LoadStateTtl.Ticks * 4)))
+                    return ModelLoadState.Unknown;
+
+                return _loadedModels.Contains(model) || _loadedModels.Contains(model + ":latest")
+                    ? ModelLoadState.Loaded
+                    : ModelLoadState.Cold;
+            }
+        }
+
+        /// <summary>
+        /// Refreshes the model list and load state immediately.
+        /// Returns true if the server answered.
+        /// </summary>
+        public async Task<bool> RefreshAsync()
+        {
+            bool reachable = await RefreshTagsAsync(true);
+            if (reachable)
+            {
+                await RefreshLoadStateAsync();
+            }
+            return reachable;
+        }
+
+        /// <summary>
+        /// Starts refreshing the inventory and load state on a background timer
+        /// </summary>
+        public void StartBackgroundRefresh(TimeSpan interval)
+        {
+            if (_disposed)
+                return;
+
+            if (_refreshTimer == null)
+            {
+                _refreshTimer = _clock.CreateTimer(interval, OnRefreshTimer);
+            }
+            else
+            {
+                _refreshTimer.Interval = interval;
+            }
+            _refreshTimer.Start();
+
+            // The timer first ticks after one interval; refresh now as well
+            OnRefreshTimer();
+        }
+
+        /// <summary>
+        /// Stops background refreshing
+        /// </summary>
+        public void StopBackgroundRefresh()
+        {
+            _refreshTimer?.Dispose();
+            _refreshTimer = null;
+        }
+
+        /// <summary>
+        /// Drops all cached data (e.g. after the Ollama URL changes)
+        /// </summary>
+        public void Invalidate()
+        {
+            lock (_lock)
+            {
+                _models = new List<OllamaModelInfo>();
+                _modelsFetchedAt = DateTime.MinValue;
+                _details.Clear();
+                _detailsFetchedAt.Clear();
+                _showFailedAt.Clear();
+                _loadedModels = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+                _loadStateFetchedAt = DateTime.MinValue;
+                IsReachable = false;
+            }
+        }
+
+        private async void OnRefreshTimer()
+        {
+            // Skip the tick if the previous refresh is still running
+            if (Interlocked.Exchange(ref _refreshing, 1) == 1)
+                return;
+
+            try
+            {
+                if (IsExpired(_modelsFetchedAt, TagsTtl))
+                {
+                    await RefreshTagsAsync(false);
+                }
+                await RefreshLoadStateAsync();
+            }
+            catch (Exception ex)
+            {
+                System.Diagnostics.Debug.WriteLine($"Model catalog refresh error: {ex.Message}");
+            }
+            finally
+            {
+                Interlocked.Exchange(ref _refreshing, 0);
+            }
+        }
+
+        private Task<bool> RefreshTagsAsync(bool force)
+        {
+            // Coalesce concurrent refreshes into a single request
+            lock (_lock)
+            {
+                if (_tagsRefresh != null && !_tagsRefresh.IsCompleted)
+                    return _tagsRefresh;
+
+                if (!force && !IsExpired(_modelsFetchedAt, TagsTtl))
+                    return Task.FromResult(IsReachable);
+
+                _tagsRefresh = FetchTagsAsync();
+                return _tagsRefresh;
+            }
+        }
+
+        private async Task<bool> FetchTagsAsync()
+        {
+            try
+            {
+                var response = await _httpClient.GetAsync($"{_baseUrl()}/api/tags");
+                if (!response.IsSuccessStatusCode)
+                {
+                    IsReachable = false;
+                    return false;
+                }
+
+                var content = await response.Content.ReadAsStringAsync();
+                var result = JsonConvert.DeserializeObject<TagsResponse>(content);
+
+                var models = new List<OllamaModelInfo>();
+                if (result?.Models != null)
+                {
+                    foreach (var model in result.Models)
+                    {
+                        if (string.IsNullOrEmpty(model.Name))
+                            continue;
+
+                        models.Add(new OllamaModelInfo
+                        {
+                            Name = model.Name,
+                            Size = model.Size,
+                            Digest = model.Digest,
+                            ModifiedAt = model.ModifiedAt,
+                            Family = model.Details?.Family,
+                            ParameterSize = model.Details?.ParameterSize,
+                            QuantizationLevel = model.Details?.QuantizationLevel
+                        });
+                    }
+                }
+
+                bool changed;
+                lock (_lock)
+                {
+                    changed = !_models.Select(m => m.Name + "@" + m.Digest)
+                        .SequenceEqual(models.Select(m => m.Name + "@" + m.Digest));
+
+                    // Details for a model whose digest changed (re-pulled) are stale
+                    foreach (var model in models)
+                    {
+                        if (_details.TryGetValue(model.Name, out var known) && known.Digest != null && known.Digest != model.Digest)
+                        {
+                            _details.Remove(model.Name);
+                            _detailsFetchedAt.Remove(model.Name);
+                        }
+                    }
+
+                    // A model that was just pulled, or a server that came back, is worth asking about again
+                    if (changed || !IsReachable)
+                    {
+                        _showFailedAt.Clear();
+                    }
+
+                    _models = models;
+                    _modelsFetchedAt = _clock.UtcNow;
+                    IsReachable = true;
+                }
+
+                if (changed)
+                {
+                    ModelsChanged?.Invoke(this, EventArgs.Empty);
+                }
+                return true;
+            }
+            catch (Exception ex)
+            {
+                System.Diagnostics.Debug.WriteLine($"Ollama tags error: {ex.Message}");
+                IsReachable = false;
+                return false;
+            }
+        }
+
+        private async Task<OllamaModelInfo> FetchShowAsync(string model, CancellationToken cancellationToken)
+        {
+            try
+            {
+                var json = JsonConvert.SerializeObject(new { model = model });
+                var content = new StringContent(json, Encoding.UTF8, "application/json");
+                var response = await _httpClient.PostAsync($"{_baseUrl()}/api/show", content, cancellationToken);
+                if (!response.IsSuccessStatusCode)
+                    return null;
+
+                var body = await response.Content.ReadAsStringAsync();
+                var result = JsonConvert.DeserializeObject<ShowResponse>(body);
+                if (result == null)
+                    return null;
+
+                var info = new OllamaModelInfo
+                {
+                    Name = model,
+                    Family = result.Details?.Family,
+                    ParameterSize = result.Details?.ParameterSize,
+                    QuantizationLevel = result.Details?.QuantizationLevel,
+                    ContextLength = ParseContextLength(result.ModelInfo),
+                    DefaultNumCtx = ParseNumCtx(result.Parameters)
+                };
+
+                // Carry over inventory fields /api/show doesn't return
+                lock (_lock)
+                {
+                    var listed = _models.FirstOrDefault(m => string.Equals(m.Name, model, StringComparison.OrdinalIgnoreCase));
+                    if (listed != null)
+                    {
+                        info.Size = listed.Size;
+                        info.Digest = listed.Digest;
+                        info.ModifiedAt = listed.ModifiedAt;
+                    }
+                }
+
+                return info;
+            }
+            catch (OperationCanceledException)
+            {
+                return null;
+            }
+            catch (Exception ex)
+            {
+                System.Diagnostics.Debug.WriteLine($"Ollama show error: {ex.Message}");
+                return null;
+            }
+        }
+
+        private async Task RefreshLoadStateAsync()
+        {
+            try
+            {
+                var response = await _httpClient.GetAsync($"{_baseUrl()}/api/ps");
+                if (!response.IsSuccessStatusCode)
+                    return;
+
+                var content = await response.Content.ReadAsStringAsync();
+                var result = JsonConvert.DeserializeObject<PsResponse>(content);
+
+                var loaded = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+                if (result?.Models != null)
+                {
+                    foreach (var model in result.Models)
+                    {
+                        if (!string.IsNullOrEmpty(model.Name))
+                            loaded.Add(model.Name);
+                        if (!string.IsNullOrEmpty(model.Model))
+                            loaded.Add(model.Model);
+                    }
+                }
+
+                bool changed;
+                lock (_lock)
+                {
+                    changed = !loaded.SetEquals(_loadedModels);
+                    _loadedModels = loaded;
+                    _loadStateFetchedAt = _clock.UtcNow;
+                }
+
+                if (changed)
+                {
+                    ModelsChanged?.Invoke(this, EventArgs.Empty);
+                }
+            }
+            catch (Exception ex)
+            {
+                System.Diagnostics.Debug.WriteLine($"Ollama ps error: {ex.Message}");
+            }
+        }
+
+        private static int ParseContextLength(Dictionary<string, object> modelInfo)
+        {
+            if (modelInfo == null)
+                return 0;
+
+            // Keys are architecture-prefixed, e.g. "llama.context_length"
+            foreach (var entry in modelInfo)
+            {
+                if (entry.Key.EndsWith(".context_length", StringComparison.Ordinal) && entry.Value != null)
+                {
+                    try
+                    {
+                        return Convert.ToInt32(entry.Value);
+                    }
+                    catch
+                    {
+                        return 0;
+                    }
+                }
+            }
+
+            return 0;
+        }
+
+        private static int ParseNumCtx(string parameters)
+        {
+            if (string.IsNullOrEmpty(parameters))
+                return 0;
+
+            // Modelfile parameters come back as "name value" lines
+            foreach (var line in parameters.Split('\n'))
+            {
+                var parts = line.Split(new[] { ' ', '\t' }, StringSplitOptions.RemoveEmptyEntries);
+                if (parts.Length == 2 && parts[0] == "num_ctx" && int.TryParse(parts[1], out int value))
+                    return value;
+            }
+
+            return 0;
+        }
+
+        private bool IsExpired(DateTime fetchedAtUtc, TimeSpan ttl)
+        {
+            return _clock.UtcNow - fetchedAtUtc > ttl;
+        }
+
+        public void Dispose()
+        {
+            if (!_disposed)
+            {
+                _disposed = true;
+                StopBackgroundRefresh();
+            }
+        }
+
+        // Response classes for JSON deserialization
+        private class TagsResponse
+        {
+            [JsonProperty("models")]
+            public List<TagsModel> Models { get; set; }
+        }
+
+        private class TagsModel
+        {
+            [JsonProperty("name")]
+            public string Name { get; set; }
+
+            [JsonProperty("size")]
+            public long Size { get; set; }
+
+            [JsonProperty("digest")]
+            public string Digest { get; set; }
+
+            [JsonProperty("modified_at")]
+            public DateTime ModifiedAt { get; set; }
+
+            [JsonProperty("details")]
+            public ModelDetails Details { get; set; }
+        }
+
+        private class ModelDetails
+        {
+            [JsonProperty("family")]
+            public string Family { get; set; }
+
+            [JsonProperty("parameter_size")]
+            public string ParameterSize { get; set; }
+
+            [JsonProperty("quantization_level")]
+            public string QuantizationLevel { get; set; }
+        }
+
+        private class ShowResponse
+        {
+            [JsonProperty("parameters")]
+            public string Parameters { get; set; }
+
+            [JsonProperty("details")]
+            public ModelDetails Details { get; set; }
+
+            [JsonProperty("model_info")]
+            public Dictionary<string, object> ModelInfo { get; set; }
+        }
+
+        private class PsResponse
+        {
+            [JsonProperty("models")]
+            public List<PsModel> Models { get; set; }
+        }
+
+        private class PsModel
+        {
+            [JsonProperty("name")]
+            public string Name { get; set; }
+
+            [JsonProperty("model")]
+            public string Model { get; set; }
+        }
+    }
+}
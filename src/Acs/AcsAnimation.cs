@@ -0,0 +1,262 @@
+using System;
+using System.Collections.Generic;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// How an animation gets back to the rest pose
+    /// </summary>
+    public enum AcsTransition : byte
+    {
+        /// <summary>
+        /// Play ReturnAnimation afterwards
+        /// </summary>
+        ReturnAnimation = 0,
+
+        /// <summary>
+        /// Follow each frame's exit branch
+        /// </summary>
+        ExitBranches = 1,
+
+        None = 2
+    }
+
+    /// <summary>
+    /// Mouth overlays shown on a frame while the character speaks
+    /// </summary>
+    public enum AcsMouthShape : byte
+    {
+        Closed = 0,
+        Wide1 = 1,
+        Wide2 = 2,
+        Wide3 = 3,
+        Wide4 = 4,
+        Medium = 5,
+        Narrow = 6
+    }
+
+    public sealed class AcsAnimation
+    {
+        internal AcsAnimation(string name, AcsTransition transition, string returnAnimation, AcsFrame[] frames)
+        {
+            Name = name;
+            Transition = transition;
+            ReturnAnimation = returnAnimation;
+            Frames = frames;
+        }
+
+        public string Name { get; }
+        public AcsTransition Transition { get; }
+
+        /// <summary>
+        /// Animation played afterwards when Transition is ReturnAnimation
+        /// </summary>
+        public string ReturnAnimation { get; }
+
+        public IReadOnlyList<AcsFrame> Frames { get; }
+
+        /// <summary>
+        /// The frame that follows frameIndex: its exit branch when exiting, otherwise one of
+        /// its branches picked by probability, otherwise the next frame. Returns -1 at the end.
+        /// </summary>
+        public int NextFrame(int frameIndex, Random random, bool exiting = false)
+        {
+            var frame = Frames[frameIndex];
+            if (exiting && frame.ExitFrame >= 0)
+                return frame.ExitFrame < Frames.Count ? frame.ExitFrame : -1;
+
+            if (frame.Branches.Count > 0)
+            {
+                // Probabilities are percentages; whatever they leave over falls through
+                int roll = random.Next(100);
+                foreach (var branch in frame.Branches)
+                {
+                    if (roll < branch.Probability)
+                        return branch.FrameIndex < Frames.Count ? branch.FrameIndex : -1;
+                    roll -= branch.Probability;
+                }
+            }
+
+            return frameIndex + 1 < Frames.Count ? frameIndex + 1 : -1;
+        }
+
+        /// <summary>
+        /// Reads an ANIMATIONINFO block
+        /// </summary>
+        internal static AcsAnimation Read(AcsReader reader)
+        {
+            string name = reader.ReadString();
+            var transition = (AcsTransition)reader.ReadByte();
+            string returnAnimation = reader.ReadString();
+
+            var frames = new AcsFrame[reader.ReadUInt16()];
+            for (int i = 0; i < frames.Length; i++)
+            {
+                frames[i] = AcsFrame.Read(reader);
+            }
+            return new AcsAnimation(name, transition, returnAnimation, frames);
+        }
+    }
+
+    public sealed class AcsFrame
+    {
+        private static readonly AcsBranch[] NoBranches = new AcsBranch[0];
+        private static readonly AcsOverlay[] NoOverlays = new AcsOverlay[0];
+
+        internal AcsFrame(AcsFrameImage[] images, int audioIndex, int duration, int exitFrame, AcsBranch[] branches, AcsOverlay[] overlays)
+        {
+            Images = images;
+            AudioIndex = audioIndex;
+            Duration = duration;
+            ExitFrame = exitFrame;
+            Branches = branches;
+            Overlays = overlays;
+        }
+
+        /// <summary>
+        /// Images making up the frame, topmost first
+        /// </summary>
+        public IReadOnlyList<AcsFrameImage> Images { get; }
+
+        /// <summary>
+        /// Sound started with the frame, or -1
+        /// </summary>
+        public int AudioIndex { get; }
+
+        /// <summary>
+        /// In hundredths of a second
+        /// </summary>
+        public int Duration { get; }
+
+        /// <summary>
+        /// Frame to go to when the animation is asked to stop, or -1
+        /// </summary>
+        public int ExitFrame { get; }
+
+        public IReadOnlyList<AcsBranch> Branches { get; }
+        public IReadOnlyList<AcsOverlay> Overlays { get; }
+
+        public AcsOverlay FindOverlay(AcsMouthShape shape)
+        {
+            foreach (var overlay in Overlays)
+            {
+                if (overlay.Shape == shape)
+                    return overlay;
+            }
+            return null;
+        }
+
+        /// <summary>
+        /// Reads a FRAMEINFO
+        /// </summary>
+        internal static AcsFrame Read(AcsReader reader)
+        {
+            var images = new AcsFrameImage[reader.ReadUInt16()];
+            for (int i = 0; i < images.Length; i++)
+            {
+                images[i] = new AcsFrameImage(reader.ReadInt32(), reader.ReadInt16(), reader.ReadInt16());
+            }
+
+            ushort audio = reader.ReadUInt16();
+            int duration = reader.ReadUInt16();
+            int exitFrame = reader.ReadInt16();
+
+            int branchCount = reader.ReadByte();
+            var branches = branchCount == 0 ? NoBranches : new AcsBranch[branchCount];
+            for (int i = 0; i < branchCount; i++)
+            {
+                branches[i] = new AcsBranch(reader.ReadUInt16(), reader.ReadUInt16());
+            }
+
+            int overlayCount = reader.ReadByte();
+            var overlays = overlayCount == 0 ? NoOverlays : new AcsOverlay[overlayCount];
+            for (int i = 0; i < overlayCount; i++)
+            {
+                overlays[i] = AcsOverlay.Read(reader);
+            }
+
+            return new AcsFrame(images, audio == 0xFFFF ? -1 : audio, duration, exitFrame, branches, overlays);
+        }
+    }
+
+    /// <summary>
+    /// An image placed on a frame, relative to the character's top-left corner
+    /// </summary>
+    public struct AcsFrameImage
+    {
+        public AcsFrameImage(int imageIndex, int x, int y)
+        {
+            ImageIndex = imageIndex;
+            X = x;
+            Y = y;
+        }
+
+        public int ImageIndex { get; }
+        public int X { get; }
+        public int Y { get; }
+    }
+
+    public struct AcsBranch
+    {
+        public AcsBranch(int frameIndex, int probability)
+        {
+            FrameIndex = frameIndex;
+            Probability = probability;
+        }
+
+        public int FrameIndex { get; }
+
+        /// <summary>
+        /// Chance of taking the branch, in percent
+        /// </summary>
+        public int Probability { get; }
+    }
+
+    public sealed class AcsOverlay
+    {
+        internal AcsOverlay(AcsMouthShape shape, bool replacesTopImage, int imageIndex, int x, int y, int width, int height)
+        {
+            Shape = shape;
+            ReplacesTopImage = replacesTopImage;
+            ImageIndex = imageIndex;
+            X = x;
+            Y = y;
+            Width = width;
+            Height = height;
+        }
+
+        public AcsMouthShape Shape { get; }
+
+        /// <summary>
+        /// Draw the overlay instead of the frame's topmost image rather than over it
+        /// </summary>
+        public bool ReplacesTopImage { get; }
+
+        public int ImageIndex { get; }
+        public int X { get; }
+        public int Y { get; }
+        public int Width { get; }
+        public int Height { get; }
+
+        /// <summary>
+        /// Reads an OVERLAYINFO
+        /// </summary>
+        internal static AcsOverlay Read(AcsReader reader)
+        {
+            var shape = (AcsMouthShape)reader.ReadByte();
+            bool replaces = reader.ReadBool();
+            int imageIndex = reader.ReadUInt16();
+            reader.ReadByte();
+            bool hasRegion = reader.ReadBool();
+            int x = reader.ReadInt16();
+            int y = reader.ReadInt16();
+            int width = reader.ReadUInt16();
+            int height = reader.ReadUInt16();
+            if (hasRegion)
+            {
+                reader.Skip(reader.ReadInt32());
+            }
+            return new AcsOverlay(shape, replaces, imageIndex, x, y, width, height);
+        }
+    }
+}
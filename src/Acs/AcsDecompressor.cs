@@ -0,0 +1,182 @@
+using System.IO;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// Decoder for the LZ77-style compression Agent uses for images and region data. The input
+    /// is a bit stream read from the least significant bit of each byte up, after a leading 0x00:
+    ///   0 + 8 bits                 a literal byte
+    ///   1 + offset + length        copy earlier output
+    /// The offset is a prefix of up to three 1 bits choosing 6, 9, 12 or 20 more bits (biased by
+    /// 1, 65, 577 and 4673); the 20-bit form with every bit set ends the stream. The length is up
+    /// to eleven 1 bits ending in a 0, then that many bits, added to 2 (one more after a 20-bit
+    /// offset).
+    /// </summary>
+    public static class AcsDecompressor
+    {
+        private const uint EndMarker = 0xFFFFF;
+
+        /// <summary>
+        /// Decompresses count bytes at offset into output and returns the number of bytes written
+        /// </summary>
+        public static unsafe int Decompress(byte[] input, int offset, int count, byte[] output)
+        {
+            if (count < 1 || input[offset] != 0)
+                throw new InvalidDataException("Compressed data must start with a zero byte");
+
+            fixed (byte* source = &input[offset])
+            fixed (byte* target = output)
+            {
+                var bits = new BitReader(source, count);
+                bits.Skip(8);
+
+                int written = 0;
+                int capacity = output.Length;
+                while (!bits.Exhausted)
+                {
+                    if (bits.ReadBit() == 0)
+                    {
+                        if (written == capacity)
+                            throw new InvalidDataException("Compressed data decodes to more than the image size");
+                        target[written++] = (byte)bits.Read(8);
+                        continue;
+                    }
+
+                    int prefix = bits.CountOnes(3);
+                    int distance;
+                    switch (prefix)
+                    {
+                        case 0:
+                            distance = (int)bits.Read(6) + 1;
+                            break;
+                        case 1:
+                            distance = (int)bits.Read(9) + 65;
+                            break;
+                        case 2:
+                            distance = (int)bits.Read(12) + 577;
+                            break;
+                        default:
+                            uint value = bits.Read(20);
+                            if (value == EndMarker)
+                                return written;
+                            distance = (int)value + 4673;
+                            break;
+                    }
+
+                    int lengthBits = bits.CountOnes(11);
+                    int length = 2 + (1 << lengthBits) - 1 + (int)bits.Read(lengthBits);
+                    if (prefix == 3)
+                    {
+                        length++;
+                    }
+
+                    if (distance > written)
+                        throw new InvalidDataException($"Back reference of {distance} bytes at output position {written}");
+                    if (length > capacity - written)
+                        throw new InvalidDataException("Compressed data decodes to more than the image size");
+
+                    CopyMatch(target + written, distance, length);
+                    written += length;
+                }
+
+                throw new InvalidDataException("Compressed data ends without an end marker");
+            }
+        }
+
+        /// <summary>
+        /// Copies a back reference. Runs (distance below 8) overlap themselves and must go a
+        /// byte at a time; longer distances are copied eight bytes at a time.
+        /// </summary>
+        private static unsafe void CopyMatch(byte* destination, int distance, int length)
+        {
+            byte* source = destination - distance;
+            if (distance >= 8)
+            {
+                while (length >= 8)
+                {
+                    *(ulong*)destination = *(ulong*)source;
+                    destination += 8;
+                    source += 8;
+                    length -= 8;
+                }
+            }
+            while (length-- > 0)
+            {
+                *destination++ = *source++;
+            }
+        }
+
+        private unsafe struct BitReader
+        {
+            private readonly byte* _data;
+            private readonly long _totalBits;
+            private long _position;
+
+            public BitReader(byte* data, int length)
+            {
+                _data = data;
+                _totalBits = (long)length * 8;
+                _position = 0;
+            }
+
+            public bool Exhausted => _position >= _totalBits;
+
+            public void Skip(int count)
+            {
+                _position += count;
+            }
+
+            public uint ReadBit()
+            {
+                if (_position >= _totalBits)
+                    throw new InvalidDataException("Compressed data ends in the middle of a code");
+                uint bit = (uint)(_data[_position >> 3] >> (int)(_position & 7)) & 1;
+                _position++;
+                return bit;
+            }
+
+            /// <summary>
+            /// Reads up to 24 bits, least significant first
+            /// </summary>
+            public uint Read(int count)
+            {
+                if (count == 0)
+                    return 0;
+                if (_position + count > _totalBits)
+                    throw new InvalidDataException("Compressed data ends in the middle of a code");
+
+                long byteIndex = _position >> 3;
+                int shift = (int)(_position & 7);
+                uint window;
+                if (byteIndex + 4 <= _totalBits >> 3)
+                {
+                    window = *(uint*)(_data + byteIndex);
+                }
+                else
+                {
+                    window = 0;
+                    for (int i = 0; byteIndex + i < _totalBits >> 3; i++)
+                    {
+                        window |= (uint)_data[byteIndex + i] << (8 * i);
+                    }
+                }
+
+                _position += count;
+                return (window >> shift) & ((1u << count) - 1);
+            }
+
+            /// <summary>
+            /// Counts 1 bits up to max, consuming the 0 that ends a shorter run
+            /// </summary>
+            public int CountOnes(int max)
+            {
+                int ones = 0;
+                while (ones < max && ReadBit() == 1)
+                {
+                    ones++;
+                }
+                return ones;
+            }
+        }
+    }
+}
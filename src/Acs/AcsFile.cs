@@ -0,0 +1,220 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// A Microsoft Agent character (.acs) read without the Agent COM server. Character data
+    /// and animations are parsed on load; images are decompressed on first use and kept.
+    /// </summary>
+    public sealed class AcsFile
+    {
+        public const uint Signature = 0xABCDABC3;
+
+        // ACSCHARACTERINFO flags
+        private const uint VoiceOutputFlag = 0x20;
+        private const uint WordBalloonFlag = 0x200;
+
+        private readonly byte[] _data;
+        private readonly int[] _imageOffsets;
+        private readonly int[] _imageSizes;
+        private readonly AcsImage[] _images;
+        private readonly int[] _audioOffsets;
+        private readonly int[] _audioSizes;
+        private readonly Dictionary<string, AcsAnimation> _animations;
+
+        private AcsFile(byte[] data)
+        {
+            _data = data;
+            var header = new AcsReader(data);
+            if (header.ReadUInt32() != Signature)
+                throw new InvalidDataException("Not an ACS character file");
+
+            var characterBlock = header.ReadLocator();
+            var animationBlock = header.ReadLocator();
+            var imageBlock = header.ReadLocator();
+            var audioBlock = header.ReadLocator();
+
+            ReadCharacter(characterBlock);
+
+            uint animationCount = animationBlock.ReadUInt32();
+            _animations = new Dictionary<string, AcsAnimation>(StringComparer.OrdinalIgnoreCase);
+            for (uint i = 0; i < animationCount; i++)
+            {
+                string name = animationBlock.ReadString();
+                var animation = AcsAnimation.Read(animationBlock.ReadLocator());
+                _animations[name] = animation;
+            }
+
+            ReadLocators(imageBlock, out _imageOffsets, out _imageSizes);
+            _images = new AcsImage[_imageOffsets.Length];
+            ReadLocators(audioBlock, out _audioOffsets, out _audioSizes);
+        }
+
+        public static AcsFile Load(string path)
+        {
+            return new AcsFile(File.ReadAllBytes(path));
+        }
+
+        public static AcsFile Load(byte[] data)
+        {
+            return new AcsFile(data ?? throw new ArgumentNullException(nameof(data)));
+        }
+
+        public string Name { get; private set; }
+        public string Description { get; private set; }
+        public Guid Id { get; private set; }
+        public int Width { get; private set; }
+        public int Height { get; private set; }
+
+        /// <summary>
+        /// Palette index drawn as transparent
+        /// </summary>
+        public byte TransparentIndex { get; private set; }
+
+        /// <summary>
+        /// 256 colours as RGBA packed little-endian (R in the low byte); the transparent index
+        /// has alpha 0, every other entry 255
+        /// </summary>
+        public uint[] Palette { get; private set; }
+
+        /// <summary>
+        /// Animations named for each state (Speaking, IdlingLevel1, ...)
+        /// </summary>
+        public IReadOnlyDictionary<string, IReadOnlyList<string>> States { get; private set; }
+
+        public IReadOnlyDictionary<string, AcsAnimation> Animations => _animations;
+
+        public int ImageCount => _images.Length;
+        public int AudioCount => _audioOffsets.Length;
+
+        /// <summary>
+        /// Decompresses an image the first time it is asked for. Safe to call from any thread.
+        /// </summary>
+        public AcsImage GetImage(int index)
+        {
+            var image = Volatile.Read(ref _images[index]);
+            if (image != null)
+                return image;
+
+            image = AcsImage.Read(new AcsReader(_data, _imageOffsets[index], _imageSizes[index]));
+            return Interlocked.CompareExchange(ref _images[index], image, null) ?? image;
+        }
+
+        /// <summary>
+        /// A sound as a complete WAV file
+        /// </summary>
+        public byte[] GetAudio(int index)
+        {
+            var audio = new byte[_audioSizes[index]];
+            Buffer.BlockCopy(_data, _audioOffsets[index], audio, 0, audio.Length);
+            return audio;
+        }
+
+        private void ReadCharacter(AcsReader reader)
+        {
+            reader.ReadUInt16();
+            reader.ReadUInt16();
+            ReadLocalizedInfo(reader.ReadLocator());
+            Id = reader.ReadGuid();
+            Width = reader.ReadUInt16();
+            Height = reader.ReadUInt16();
+            TransparentIndex = reader.ReadByte();
+            uint flags = reader.ReadUInt32();
+            reader.ReadUInt16();
+            reader.ReadUInt16();
+
+            if ((flags & VoiceOutputFlag) != 0)
+            {
+                reader.Skip(16 + 16 + 4 + 2);
+                if (reader.ReadBool())
+                {
+                    reader.ReadUInt16();
+                    reader.ReadString();
+                    reader.ReadUInt16();
+                    reader.ReadUInt16();
+                    reader.ReadString();
+                }
+            }
+
+            if ((flags & WordBalloonFlag) != 0)
+            {
+                reader.Skip(1 + 1 + 4 + 4 + 4);
+                reader.ReadString();
+                reader.Skip(4 + 4 + 1 + 1);
+            }
+
+            // RGBQUADs: blue, green, red, unused
+            uint colors = reader.ReadUInt32();
+            var palette = new uint[256];
+            for (uint i = 0; i < colors; i++)
+            {
+                uint quad = reader.ReadUInt32();
+                if (i < 256)
+                {
+                    palette[i] = 0xFF000000 | ((quad & 0xFF) << 16) | (quad & 0xFF00) | ((quad >> 16) & 0xFF);
+                }
+            }
+            palette[TransparentIndex] = 0;
+            Palette = palette;
+
+            if (reader.ReadBool())
+            {
+                reader.Skip(reader.ReadInt32());
+                reader.Skip(reader.ReadInt32());
+            }
+
+            var states = new Dictionary<string, IReadOnlyList<string>>(StringComparer.OrdinalIgnoreCase);
+            int stateCount = reader.ReadUInt16();
+            for (int i = 0; i < stateCount; i++)
+            {
+                string state = reader.ReadString();
+                var animations = new string[reader.ReadUInt16()];
+                for (int j = 0; j < animations.Length; j++)
+                {
+                    animations[j] = reader.ReadString();
+                }
+                states[state] = animations;
+            }
+            States = states;
+        }
+
+        /// <summary>
+        /// Takes the name and description from the first language listed
+        /// </summary>
+        private void ReadLocalizedInfo(AcsReader reader)
+        {
+            Name = string.Empty;
+            Description = string.Empty;
+            int count = reader.ReadUInt16();
+            if (count > 0)
+            {
+                reader.ReadUInt16();
+                Name = reader.ReadString();
+                Description = reader.ReadString();
+            }
+        }
+
+        private static void ReadLocators(AcsReader reader, out int[] offsets, out int[] sizes)
+        {
+            uint count = reader.ReadUInt32();
+            if (count > (uint)reader.Remaining / 12)
+                throw new InvalidDataException($"List of {count} entries is larger than its block");
+
+            offsets = new int[count];
+            sizes = new int[count];
+            for (int i = 0; i < count; i++)
+            {
+                uint offset = reader.ReadUInt32();
+                uint size = reader.ReadUInt32();
+                reader.ReadUInt32();
+                if ((ulong)offset + size > (ulong)reader.Data.Length)
+                    throw new InvalidDataException($"Entry {i} at {offset} ({size} bytes) is outside the file");
+                offsets[i] = (int)offset;
+                sizes[i] = (int)size;
+            }
+        }
+    }
+}
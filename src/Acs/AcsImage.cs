@@ -0,0 +1,62 @@
+using System;
+using System.IO;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// One decoded frame image: 8-bit indices into the character's palette, stored top row
+    /// first with no padding (ACS stores them bottom-up in DWORD-aligned rows)
+    /// </summary>
+    public sealed class AcsImage
+    {
+        internal AcsImage(int width, int height, byte[] pixels)
+        {
+            Width = width;
+            Height = height;
+            Pixels = pixels;
+        }
+
+        public int Width { get; }
+        public int Height { get; }
+
+        /// <summary>
+        /// Width * Height palette indices, row by row from the top
+        /// </summary>
+        public byte[] Pixels { get; }
+
+        /// <summary>
+        /// Decodes an IMAGEINFO block
+        /// </summary>
+        internal static AcsImage Read(AcsReader reader)
+        {
+            reader.ReadByte();
+            int width = reader.ReadUInt16();
+            int height = reader.ReadUInt16();
+            bool compressed = reader.ReadBool();
+            int size = reader.ReadInt32();
+            int offset = reader.Take(size);
+
+            int stride = (width + 3) & ~3;
+            var bottomUp = new byte[stride * height];
+            if (compressed)
+            {
+                // A stream that stops short leaves the rest of the image at index 0
+                AcsDecompressor.Decompress(reader.Data, offset, size, bottomUp);
+            }
+            else
+            {
+                if (size < bottomUp.Length)
+                    throw new InvalidDataException($"Image has {size} bytes, expected {bottomUp.Length}");
+                Buffer.BlockCopy(reader.Data, offset, bottomUp, 0, bottomUp.Length);
+            }
+
+            // Region data follows; the renderer uses the transparent index instead of it
+            var pixels = new byte[width * height];
+            for (int y = 0; y < height; y++)
+            {
+                Buffer.BlockCopy(bottomUp, (height - 1 - y) * stride, pixels, y * width, width);
+            }
+            return new AcsImage(width, height, pixels);
+        }
+    }
+}
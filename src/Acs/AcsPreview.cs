@@ -0,0 +1,336 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.Text;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// A small picture of a character for browsing: a thumbnail of its first frame and a strip
+    /// of frames sampled from each animation. Every image is Width x Height palette indices, so
+    /// a preview is a quarter the size of the same pixels in colour and is stored that way.
+    /// </summary>
+    public sealed class AcsPreview
+    {
+        public const int DefaultSize = 64;
+        public const int DefaultStripFrames = 8;
+
+        private const uint Magic = 0x5650414D; // "MAPV"
+        private const ushort Version = 1;
+
+        private readonly Dictionary<string, byte[][]> _strips;
+
+        private AcsPreview(string name, string description, int width, int height, int size, int stripFrames,
+            byte transparentIndex, uint[] palette, byte[] thumbnail, string[] animations, Dictionary<string, byte[][]> strips)
+        {
+            Name = name;
+            Description = description;
+            Width = width;
+            Height = height;
+            Size = size;
+            StripFrames = stripFrames;
+            TransparentIndex = transparentIndex;
+            Palette = palette;
+            Thumbnail = thumbnail;
+            Animations = animations;
+            _strips = strips;
+        }
+
+        public string Name { get; }
+        public string Description { get; }
+
+        /// <summary>
+        /// Dimensions of the thumbnail and of every strip frame
+        /// </summary>
+        public int Width { get; }
+        public int Height { get; }
+
+        /// <summary>
+        /// Size and strip length the preview was built with
+        /// </summary>
+        public int Size { get; }
+        public int StripFrames { get; }
+
+        public byte TransparentIndex { get; }
+
+        /// <summary>
+        /// The character's palette, RGBA as in AcsFile.Palette
+        /// </summary>
+        public uint[] Palette { get; }
+
+        public byte[] Thumbnail { get; }
+
+        /// <summary>
+        /// Animation names, sorted
+        /// </summary>
+        public IReadOnlyList<string> Animations { get; }
+
+        /// <summary>
+        /// False when only the thumbnail was read
+        /// </summary>
+        public bool HasStrips => _strips != null;
+
+        /// <summary>
+        /// Frames sampled from an animation, in playing order; empty if it has no images
+        /// </summary>
+        public IReadOnlyList<byte[]> GetStrip(string animation)
+        {
+            if (_strips == null)
+                throw new InvalidOperationException("Preview was read without its animation strips");
+            return _strips.TryGetValue(animation, out var strip) ? strip : Array.Empty<byte[]>();
+        }
+
+        /// <summary>
+        /// The same preview without its strips, for keeping many thumbnails in memory
+        /// </summary>
+        public AcsPreview WithoutStrips()
+        {
+            return _strips == null ? this : new AcsPreview(Name, Description, Width, Height, Size, StripFrames,
+                TransparentIndex, Palette, Thumbnail, (string[])Animations, null);
+        }
+
+        /// <summary>
+        /// Converts a thumbnail or strip frame to 32-bit pixels; the transparent index gets alpha 0
+        /// </summary>
+        public unsafe uint[] ToPixels(byte[] indices, AcsPixelFormat format = AcsPixelFormat.Rgba)
+        {
+            var palette = format == AcsPixelFormat.Bgra ? AcsRenderer.ToBgra(Palette) : Palette;
+            var pixels = new uint[Width * Height];
+            fixed (byte* source = indices)
+            fixed (uint* target = pixels)
+            fixed (uint* colors = palette)
+            {
+                AcsRenderer.Expand(source, target, Math.Min(indices.Length, pixels.Length), colors);
+            }
+            return pixels;
+        }
+
+        /// <summary>
+        /// Renders the preview: the first frame of RestPose (or of the first animation that
+        /// has one) as the thumbnail, and up to stripFrames frames spread over each animation's
+        /// frames in order. Images are scaled down by nearest neighbour to fit size x size.
+        /// </summary>
+        public static AcsPreview Build(AcsFile file, int size = DefaultSize, int stripFrames = DefaultStripFrames)
+        {
+            if (size < 1)
+                throw new ArgumentOutOfRangeException(nameof(size));
+            if (stripFrames < 1)
+                throw new ArgumentOutOfRangeException(nameof(stripFrames));
+
+            double scale = Math.Min(1.0, Math.Min((double)size / file.Width, (double)size / file.Height));
+            int width = Math.Max(1, (int)(file.Width * scale));
+            int height = Math.Max(1, (int)(file.Height * scale));
+            var renderer = new AcsRenderer(file);
+
+            var names = new List<string>(file.Animations.Keys);
+            names.Sort(StringComparer.OrdinalIgnoreCase);
+            var strips = new Dictionary<string, byte[][]>(StringComparer.OrdinalIgnoreCase);
+            foreach (string name in names)
+            {
+                var frames = file.Animations[name].Frames;
+                var drawn = new List<AcsFrame>();
+                foreach (var frame in frames)
+                {
+                    if (frame.Images.Count > 0)
+                    {
+                        drawn.Add(frame);
+                    }
+                }
+
+                int count = Math.Min(stripFrames, drawn.Count);
+                var strip = new byte[count][];
+                for (int i = 0; i < count; i++)
+                {
+                    renderer.Compose(drawn[count == 1 ? 0 : i * (drawn.Count - 1) / (count - 1)]);
+                    strip[i] = Scale(renderer.Indices, file.Width, file.Height, width, height);
+                }
+                strips[name] = strip;
+            }
+
+            byte[] thumbnail = null;
+            if (strips.TryGetValue("RestPose", out var rest) && rest.Length > 0)
+            {
+                thumbnail = rest[0];
+            }
+            foreach (string name in names)
+            {
+                if (thumbnail != null)
+                    break;
+                if (strips[name].Length > 0)
+                {
+                    thumbnail = strips[name][0];
+                }
+            }
+            if (thumbnail == null)
+            {
+                thumbnail = new byte[width * height];
+                for (int i = 0; i < thumbnail.Length; i++)
+                {
+                    thumbnail[i] = file.TransparentIndex;
+                }
+            }
+
+            return new AcsPreview(file.Name, file.Description, width, height, size, stripFrames,
+                file.TransparentIndex, (uint[])file.Palette.Clone(), thumbnail, names.ToArray(), strips);
+        }
+
+        private static byte[] Scale(byte[] source, int sourceWidth, int sourceHeight, int width, int height)
+        {
+            var scaled = new byte[width * height];
+            if (width == sourceWidth && height == sourceHeight)
+            {
+                Buffer.BlockCopy(source, 0, scaled, 0, scaled.Length);
+                return scaled;
+            }
+
+            var columns = new int[width];
+            for (int x = 0; x < width; x++)
+            {
+                columns[x] = x * sourceWidth / width;
+            }
+            for (int y = 0; y < height; y++)
+            {
+                int row = y * sourceHeight / height * sourceWidth;
+                for (int x = 0; x < width; x++)
+                {
+                    scaled[y * width + x] = source[row + columns[x]];
+                }
+            }
+            return scaled;
+        }
+
+        /// <summary>
+        /// Writes the preview: a header with the thumbnail, then every strip in one deflated block
+        /// </summary>
+        public void Write(Stream stream)
+        {
+            if (_strips == null)
+                throw new InvalidOperationException("Preview was read without its animation strips");
+
+            using (var writer = new BinaryWriter(stream, Encoding.UTF8, leaveOpen: true))
+            {
+                writer.Write(Magic);
+                writer.Write(Version);
+                writer.Write(Name ?? string.Empty);
+                writer.Write(Description ?? string.Empty);
+                writer.Write((ushort)Width);
+                writer.Write((ushort)Height);
+                writer.Write((ushort)Size);
+                writer.Write((ushort)StripFrames);
+                writer.Write(TransparentIndex);
+                foreach (uint color in Palette)
+                {
+                    writer.Write(color);
+                }
+                WriteDeflated(writer, Thumbnail);
+
+                writer.Write(Animations.Count);
+                var all = new MemoryStream();
+                foreach (string name in Animations)
+                {
+                    var strip = _strips[name];
+                    writer.Write(name);
+                    writer.Write((ushort)strip.Length);
+                    foreach (var frame in strip)
+                    {
+                        all.Write(frame, 0, frame.Length);
+                    }
+                }
+                WriteDeflated(writer, all.ToArray());
+            }
+        }
+
+        /// <summary>
+        /// Reads a preview written by Write. Without strips only the header and thumbnail are
+        /// decompressed, which is all a character list needs.
+        /// </summary>
+        public static AcsPreview Read(Stream stream, bool includeStrips)
+        {
+            using (var reader = new BinaryReader(stream, Encoding.UTF8, leaveOpen: true))
+            {
+                if (reader.ReadUInt32() != Magic || reader.ReadUInt16() != Version)
+                    throw new InvalidDataException("Not a character preview, or from another version");
+
+                string name = reader.ReadString();
+                string description = reader.ReadString();
+                int width = reader.ReadUInt16();
+                int height = reader.ReadUInt16();
+                int size = reader.ReadUInt16();
+                int stripFrames = reader.ReadUInt16();
+                byte transparent = reader.ReadByte();
+                var palette = new uint[256];
+                for (int i = 0; i < palette.Length; i++)
+                {
+                    palette[i] = reader.ReadUInt32();
+                }
+                int imageSize = width * height;
+                byte[] thumbnail = ReadDeflated(reader, imageSize);
+
+                var names = new string[reader.ReadInt32()];
+                var counts = new int[names.Length];
+                int total = 0;
+                for (int i = 0; i < names.Length; i++)
+                {
+                    names[i] = reader.ReadString();
+                    counts[i] = reader.ReadUInt16();
+                    total += counts[i];
+                }
+
+                Dictionary<string, byte[][]> strips = null;
+                if (includeStrips)
+                {
+                    byte[] all = ReadDeflated(reader, total * imageSize);
+                    strips = new Dictionary<string, byte[][]>(StringComparer.OrdinalIgnoreCase);
+                    int offset = 0;
+                    for (int i = 0; i < names.Length; i++)
+                    {
+                        var strip = new byte[counts[i]][];
+                        for (int f = 0; f < strip.Length; f++)
+                        {
+                            strip[f] = new byte[imageSize];
+                            Buffer.BlockCopy(all, offset, strip[f], 0, imageSize);
+                            offset += imageSize;
+                        }
+                        strips[names[i]] = strip;
+                    }
+                }
+
+                return new AcsPreview(name, description, width, height, size, stripFrames, transparent, palette, thumbnail, names, strips);
+            }
+        }
+
+        private static void WriteDeflated(BinaryWriter writer, byte[] data)
+        {
+            var compressed = new MemoryStream();
+            using (var deflate = new DeflateStream(compressed, CompressionLevel.Fastest, leaveOpen: true))
+            {
+                deflate.Write(data, 0, data.Length);
+            }
+            writer.Write((int)compressed.Length);
+            writer.Write(compressed.GetBuffer(), 0, (int)compressed.Length);
+        }
+
+        private static byte[] ReadDeflated(BinaryReader reader, int length)
+        {
+            int compressedLength = reader.ReadInt32();
+            var compressed = reader.ReadBytes(compressedLength);
+            if (compressed.Length != compressedLength)
+                throw new InvalidDataException("Preview is truncated");
+
+            var data = new byte[length];
+            using (var deflate = new DeflateStream(new MemoryStream(compressed), CompressionMode.Decompress))
+            {
+                int read = 0;
+                while (read < length)
+                {
+                    int n = deflate.Read(data, read, length - read);
+                    if (n == 0)
+                        throw new InvalidDataException("Preview is truncated");
+                    read += n;
+                }
+            }
+            return data;
+        }
+    }
+}
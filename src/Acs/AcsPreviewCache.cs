@@ -0,0 +1,385 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Logging;
+using MSAgentAI.Resources;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// Character previews kept on disk, one file per character named by the SHA-256 of its
+    /// .acs file, so renamed or copied characters share an entry and a changed file gets a new
+    /// one. An index maps each path, size and write time to its hash, so a character that hasn't
+    /// changed is found without reading it. Thumbnails stay in memory once read; strips are
+    /// read from disk when asked for.
+    /// </summary>
+    public sealed class AcsPreviewCache
+    {
+        private const string IndexFileName = "index.txt";
+        private const string PreviewExtension = ".preview";
+
+        private readonly ConcurrentDictionary<string, IndexEntry> _index = new ConcurrentDictionary<string, IndexEntry>(StringComparer.OrdinalIgnoreCase);
+        private readonly ConcurrentDictionary<string, AcsPreview> _thumbnails = new ConcurrentDictionary<string, AcsPreview>(StringComparer.Ordinal);
+        private readonly ConcurrentDictionary<string, bool> _failed = new ConcurrentDictionary<string, bool>(StringComparer.OrdinalIgnoreCase);
+        private readonly object _saveLock = new object();
+        private int _indexDirty;
+
+        public AcsPreviewCache(string directory, int size = AcsPreview.DefaultSize, int stripFrames = AcsPreview.DefaultStripFrames)
+        {
+            Directory = directory ?? throw new ArgumentNullException(nameof(directory));
+            Size = size;
+            StripFrames = stripFrames;
+            LoadIndex();
+        }
+
+        /// <summary>
+        /// %AppData%\MSAgentAI\previews
+        /// </summary>
+        public static string DefaultDirectory => Path.Combine(
+            Environment.GetFolderPath(Environment.SpecialFolder.ApplicationData),
+            "MSAgentAI",
+            "previews");
+
+        public string Directory { get; }
+        public int Size { get; }
+        public int StripFrames { get; }
+
+        /// <summary>
+        /// Characters generated at once by WarmAsync
+        /// </summary>
+        public int MaxParallelism { get; set; } = Math.Max(1, Environment.ProcessorCount - 1);
+
+        /// <summary>
+        /// Slows WarmAsync down, or holds it, while the machine is busy
+        /// </summary>
+        public ResourceGovernor Governor { get; set; }
+
+        /// <summary>
+        /// Raised on a worker thread with the character's path and thumbnail as WarmAsync
+        /// builds each preview
+        /// </summary>
+        public event Action<string, AcsPreview> PreviewReady;
+
+        /// <summary>
+        /// The thumbnail for a character if it is already cached and the file hasn't changed.
+        /// Never reads or decodes the .acs file, so it is cheap enough for the UI thread.
+        /// </summary>
+        public bool TryGetThumbnail(string path, out AcsPreview preview)
+        {
+            preview = null;
+            if (!TryGetHash(path, out string hash))
+                return false;
+
+            if (_thumbnails.TryGetValue(hash, out preview))
+                return true;
+
+            preview = ReadPreview(hash, includeStrips: false);
+            if (preview == null)
+                return false;
+
+            _thumbnails[hash] = preview;
+            return true;
+        }
+
+        /// <summary>
+        /// Rough memory held by thumbnails, for the memory budget
+        /// </summary>
+        public long ThumbnailBytes
+        {
+            get
+            {
+                long bytes = 0;
+                foreach (var preview in _thumbnails.Values)
+                {
+                    bytes += EstimateBytes(preview);
+                }
+                return bytes;
+            }
+        }
+
+        /// <summary>
+        /// Drops thumbnails from memory; they are read from disk again when next asked for.
+        /// Returns roughly how much was freed.
+        /// </summary>
+        public long ReleaseThumbnails()
+        {
+            long bytes = 0;
+            foreach (string hash in _thumbnails.Keys)
+            {
+                if (_thumbnails.TryRemove(hash, out var preview))
+                {
+                    bytes += EstimateBytes(preview);
+                }
+            }
+            return bytes;
+        }
+
+        private static long EstimateBytes(AcsPreview preview)
+        {
+            // The preview object, its name, description and animation names are small beside the pixels
+            return 256 + (preview.Thumbnail?.Length ?? 0) + 4L * (preview.Palette?.Length ?? 0);
+        }
+
+        /// <summary>
+        /// The full preview with animation strips, building it if needed. Reads and decodes the
+        /// character on a miss, so call it off the UI thread. Returns null if the file can't be
+        /// read as a character.
+        /// </summary>
+        public AcsPreview GetPreview(string path)
+        {
+            if (TryGetHash(path, out string hash))
+            {
+                var cached = ReadPreview(hash, includeStrips: true);
+                if (cached != null)
+                    return cached;
+            }
+            var preview = Generate(path);
+            SaveIndex();
+            return preview;
+        }
+
+        /// <summary>
+        /// Builds previews for every character that doesn't have one, several at a time, raising
+        /// PreviewReady as each is ready. Characters that fail to decode are
+        /// logged and skipped for the rest of the session.
+        /// </summary>
+        public Task WarmAsync(IEnumerable<string> paths, CancellationToken cancellationToken = default)
+        {
+            var missing = new List<string>();
+            foreach (string path in paths)
+            {
+                if (!_failed.ContainsKey(path) && !TryGetThumbnail(path, out _))
+                {
+                    missing.Add(path);
+                }
+            }
+            if (missing.Count == 0)
+                return Task.CompletedTask;
+
+            return Task.Run(() =>
+            {
+                try
+                {
+                    var governor = Governor;
+                    int parallelism = governor?.LimitParallelism(MaxParallelism) ?? MaxParallelism;
+                    var options = new ParallelOptions { MaxDegreeOfParallelism = parallelism, CancellationToken = cancellationToken };
+                    Parallel.ForEach(missing, options, path =>
+                    {
+                        if (governor != null)
+                        {
+                            governor.Run(BackgroundWork.Indexing, () => Warm(path), cancellationToken);
+                        }
+                        else
+                        {
+                            Warm(path);
+                        }
+                    });
+                }
+                finally
+                {
+                    SaveIndex();
+                }
+            }, cancellationToken);
+        }
+
+        private void Warm(string path)
+        {
+            var preview = Generate(path);
+            if (preview != null)
+            {
+                PreviewReady?.Invoke(path, preview.WithoutStrips());
+            }
+        }
+
+        /// <summary>
+        /// Reads, hashes and decodes a character, then writes its preview and keeps the thumbnail
+        /// </summary>
+        private AcsPreview Generate(string path)
+        {
+            try
+            {
+                var info = new FileInfo(path);
+                byte[] data = File.ReadAllBytes(path);
+                string hash = Hash(data);
+
+                // Another path may already have produced this character's preview
+                var preview = ReadPreview(hash, includeStrips: true);
+                if (preview == null)
+                {
+                    preview = AcsPreview.Build(AcsFile.Load(data), Size, StripFrames);
+                    WritePreview(hash, preview);
+                }
+
+                _index[path] = new IndexEntry(info.Length, info.LastWriteTimeUtc.Ticks, hash);
+                _thumbnails[hash] = preview.WithoutStrips();
+                Interlocked.Exchange(ref _indexDirty, 1);
+                return preview;
+            }
+            catch (Exception ex)
+            {
+                // Damaged characters can fail anywhere in decoding; none of it should reach the UI
+                _failed[path] = true;
+                Logger.LogWarning($"No preview for {path}: {ex.Message}");
+                return null;
+            }
+        }
+
+        private bool TryGetHash(string path, out string hash)
+        {
+            hash = null;
+            if (!_index.TryGetValue(path, out var entry))
+                return false;
+
+            try
+            {
+                var info = new FileInfo(path);
+                if (!info.Exists || info.Length != entry.Length || info.LastWriteTimeUtc.Ticks != entry.WriteTicks)
+                    return false;
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                return false;
+            }
+
+            hash = entry.Hash;
+            return true;
+        }
+
+        private static string Hash(byte[] data)
+        {
+            using (var sha = SHA256.Create())
+            {
+                var digest = sha.ComputeHash(data);
+                var builder = new StringBuilder(digest.Length * 2);
+                foreach (byte b in digest)
+                {
+                    builder.Append(b.ToString("x2"));
+                }
+                return builder.ToString();
+            }
+        }
+
+        /// <summary>
+        /// A stored preview, or null if there is none or it was built with other settings
+        /// </summary>
+        private AcsPreview ReadPreview(string hash, bool includeStrips)
+        {
+            string file = Path.Combine(Directory, hash + PreviewExtension);
+            try
+            {
+                if (!File.Exists(file))
+                    return null;
+
+                using (var stream = new FileStream(file, FileMode.Open, FileAccess.Read, FileShare.Read, 16384))
+                {
+                    var preview = AcsPreview.Read(stream, includeStrips);
+                    return preview.Size == Size && preview.StripFrames == StripFrames ? preview : null;
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException || ex is InvalidDataException)
+            {
+                Logger.LogWarning($"Ignoring unreadable preview {file}: {ex.Message}");
+                return null;
+            }
+        }
+
+        private void WritePreview(string hash, AcsPreview preview)
+        {
+            System.IO.Directory.CreateDirectory(Directory);
+            string file = Path.Combine(Directory, hash + PreviewExtension);
+
+            // Written under a unique name and moved into place, so a reader never sees half a file
+            string temp = file + "." + Guid.NewGuid().ToString("N") + ".tmp";
+            using (var stream = new FileStream(temp, FileMode.CreateNew, FileAccess.Write, FileShare.None, 65536))
+            {
+                preview.Write(stream);
+            }
+            try
+            {
+                if (File.Exists(file))
+                {
+                    File.Delete(file);
+                }
+                File.Move(temp, file);
+            }
+            catch (IOException)
+            {
+                // Another thread wrote the same character first
+                File.Delete(temp);
+            }
+        }
+
+        /// <summary>
+        /// One line per character: size, write time (UTC ticks), hash and path, tab-separated
+        /// </summary>
+        private void LoadIndex()
+        {
+            string file = Path.Combine(Directory, IndexFileName);
+            try
+            {
+                if (!File.Exists(file))
+                    return;
+
+                foreach (string line in File.ReadAllLines(file))
+                {
+                    var parts = line.Split(new[] { '\t' }, 4);
+                    if (parts.Length == 4 && long.TryParse(parts[0], out long length) && long.TryParse(parts[1], out long ticks))
+                    {
+                        _index[parts[3]] = new IndexEntry(length, ticks, parts[2]);
+                    }
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+            {
+                Logger.LogWarning($"Could not read preview index: {ex.Message}");
+            }
+        }
+
+        private void SaveIndex()
+        {
+            if (Interlocked.Exchange(ref _indexDirty, 0) == 0)
+                return;
+
+            lock (_saveLock)
+            {
+                try
+                {
+                    System.IO.Directory.CreateDirectory(Directory);
+                    string file = Path.Combine(Directory, IndexFileName);
+                    var lines = _index.Select(entry => $"{entry.Value.Length}\t{entry.Value.WriteTicks}\t{entry.Value.Hash}\t{entry.Key}");
+                    File.WriteAllLines(file + ".tmp", lines);
+                    if (File.Exists(file))
+                    {
+                        File.Delete(file);
+                    }
+                    File.Move(file + ".tmp", file);
+                }
+                catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException)
+                {
+                    Interlocked.Exchange(ref _indexDirty, 1);
+                    Logger.LogWarning($"Could not save preview index: {ex.Message}");
+                }
+            }
+        }
+
+        private sealed class IndexEntry
+        {
+            public IndexEntry(long length, long writeTicks, string hash)
+            {
+                Length = length;
+                WriteTicks = writeTicks;
+                Hash = hash;
+            }
+
+            public long Length { get; }
+            public long WriteTicks { get; }
+            public string Hash { get; }
+        }
+    }
+}
@@ -0,0 +1,136 @@
+using System;
+using System.IO;
+using System.Text;
+
+namespace MSAgentAI.Acs
+{
+    /// <summary>
+    /// Little-endian reader over an ACS file held in memory. Every read is bounds-checked and
+    /// a read past the end throws InvalidDataException, so a truncated or corrupt file can't
+    /// index outside the buffer.
+    /// </summary>
+    internal sealed class AcsReader
+    {
+        private readonly byte[] _data;
+        private readonly int _end;
+        private int _position;
+
+        public AcsReader(byte[] data)
+            : this(data, 0, data.Length)
+        {
+        }
+
+        public AcsReader(byte[] data, int offset, int length)
+        {
+            if (offset < 0 || length < 0 || (long)offset + length > data.Length)
+                throw new InvalidDataException($"Block at {offset} ({length} bytes) is outside the file");
+
+            _data = data;
+            _position = offset;
+            _end = offset + length;
+        }
+
+        public int Position => _position;
+
+        public int Remaining => _end - _position;
+
+        public byte[] Data => _data;
+
+        /// <summary>
+        /// Reader over a block located by an ACSLOCATOR read from this one
+        /// </summary>
+        public AcsReader ReadLocator()
+        {
+            uint offset = ReadUInt32();
+            uint size = ReadUInt32();
+            if (offset > int.MaxValue || size > int.MaxValue)
+                throw new InvalidDataException($"Block at {offset} ({size} bytes) is outside the file");
+            return new AcsReader(_data, (int)offset, (int)size);
+        }
+
+        public byte ReadByte()
+        {
+            Require(1);
+            return _data[_position++];
+        }
+
+        public bool ReadBool()
+        {
+            return ReadByte() != 0;
+        }
+
+        public ushort ReadUInt16()
+        {
+            Require(2);
+            ushort value = (ushort)(_data[_position] | _data[_position + 1] << 8);
+            _position += 2;
+            return value;
+        }
+
+        public short ReadInt16()
+        {
+            return (short)ReadUInt16();
+        }
+
+        public uint ReadUInt32()
+        {
+            Require(4);
+            uint value = (uint)(_data[_position] | _data[_position + 1] << 8 | _data[_position + 2] << 16 | _data[_position + 3] << 24);
+            _position += 4;
+            return value;
+        }
+
+        public int ReadInt32()
+        {
+            return (int)ReadUInt32();
+        }
+
+        public Guid ReadGuid()
+        {
+            Require(16);
+            var bytes = new byte[16];
+            Buffer.BlockCopy(_data, _position, bytes, 0, 16);
+            _position += 16;
+            return new Guid(bytes);
+        }
+
+        /// <summary>
+        /// STRING: a character count, UTF-16 characters, and a null terminator when not empty
+        /// </summary>
+        public string ReadString()
+        {
+            uint length = ReadUInt32();
+            if (length == 0)
+                return string.Empty;
+            if (length > (uint)(_end - _position) / 2)
+                throw new InvalidDataException($"String of {length} characters at {_position} runs past its block");
+
+            string value = Encoding.Unicode.GetString(_data, _position, (int)length * 2);
+            _position += (int)length * 2;
+            Skip(2);
+            return value;
+        }
+
+        /// <summary>
+        /// Returns the offset of the next count bytes and moves past them
+        /// </summary>
+        public int Take(int count)
+        {
+            Require(count);
+            int start = _position;
+            _position += count;
+            return start;
+        }
+
+        public void Skip(int count)
+        {
+            Take(count);
+        }
+
+        private void Require(int count)
+        {
+            if (count < 0 || _end - _position < count)
+                throw new InvalidDataException($"Unexpected end of block at {_position} reading {count} byte(s)");
+        }
+    }
+}
@@ -0,0 +1,179 @@
+using System;
+using System.Collections.Generic;
+using System.Threading;
+using MSAgentAI.AI;
+using MSAgentAI.Config;
+using MSAgentAI.Logging;
+using MSAgentAI.Resources;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Agent
+{
+    /// <summary>
+    /// What the primary character says without being asked: prewritten idle lines, random AI
+    /// dialog, and lines for being clicked or moved. Runs on the timers of the clock it's given,
+    /// so the desktop app and the day simulator share the same behavior.
+    /// </summary>
+    public sealed class AgentBehavior : IDisposable
+    {
+        public static readonly TimeSpan IdleInterval = TimeSpan.FromSeconds(60);
+        public static readonly TimeSpan RandomDialogInterval = TimeSpan.FromSeconds(1);
+
+        // With RandomDialogColdBackoff, how much rarer random dialog is while the model is unloaded
+        public const int ColdModelChanceFactor = 4;
+
+        private readonly AppSettings _settings;
+        private readonly OllamaClient _ollamaClient;
+        private readonly Random _random;
+        private readonly IClockTimer _idleTimer;
+        private readonly IClockTimer _randomDialogTimer;
+        private long _idleLines;
+        private long _randomDialogs;
+        private long _clickedLines;
+        private long _movedLines;
+
+        /// <param name="random">Decides the 1-in-N chances; seed it for a repeatable run</param>
+        public AgentBehavior(AppSettings settings, OllamaClient ollamaClient, IClock clock, Random random = null)
+        {
+            _settings = settings ?? throw new ArgumentNullException(nameof(settings));
+            _ollamaClient = ollamaClient ?? throw new ArgumentNullException(nameof(ollamaClient));
+            _random = random ?? new Random();
+            _idleTimer = clock.CreateTimer(IdleInterval, OnIdleTick);
+            _randomDialogTimer = clock.CreateTimer(RandomDialogInterval, OnRandomDialogTick);
+        }
+
+        /// <summary>
+        /// Says a line on the primary character: text with any &amp;&amp;Animation triggers,
+        /// and the animation to play when it has none
+        /// </summary>
+        public Action<string, string> Speak { get; set; }
+
+        /// <summary>
+        /// Whether the primary character is loaded
+        /// </summary>
+        public Func<bool> IsLoaded { get; set; }
+
+        /// <summary>
+        /// Cancels random dialog still waiting on the model, e.g. at exit
+        /// </summary>
+        public CancellationToken CancellationToken { get; set; }
+
+        /// <summary>
+        /// Holds random dialog back while a game or other heavy program needs the machine
+        /// </summary>
+        public ResourceGovernor Governor { get; set; }
+
+        // Lines said so far, by where they came from
+        public long IdleLines => Interlocked.Read(ref _idleLines);
+        public long RandomDialogs => Interlocked.Read(ref _randomDialogs);
+        public long ClickedLines => Interlocked.Read(ref _clickedLines);
+        public long MovedLines => Interlocked.Read(ref _movedLines);
+
+        /// <summary>
+        /// Starts the idle timer, and the random dialog timer if it's enabled
+        /// </summary>
+        public void Start()
+        {
+            _idleTimer.Start();
+            ApplySettings();
+        }
+
+        public void Stop()
+        {
+            _idleTimer.Stop();
+            _randomDialogTimer.Stop();
+        }
+
+        /// <summary>
+        /// Starts or stops random dialog after the settings changed
+        /// </summary>
+        public void ApplySettings()
+        {
+            if (_settings.EnableRandomDialog)
+                _randomDialogTimer.Start();
+            else
+                _randomDialogTimer.Stop();
+        }
+
+        public void OnClicked()
+        {
+            if (SayLine(_settings.ClickedLines, "Surprised"))
+                Interlocked.Increment(ref _clickedLines);
+        }
+
+        public void OnMoved()
+        {
+            if (SayLine(_settings.MovedLines, null))
+                Interlocked.Increment(ref _movedLines);
+        }
+
+        private void OnIdleTick()
+        {
+            // Only use prewritten idle if enabled, 1 in N ticks (configurable)
+            if (IsLoaded?.Invoke() == true && _settings.EnablePrewrittenIdle && _random.Next(_settings.PrewrittenIdleChance) == 0)
+            {
+                if (SayLine(_settings.IdleLines, "Idle1_1"))
+                    Interlocked.Increment(ref _idleLines);
+            }
+        }
+
+        private async void OnRandomDialogTick()
+        {
+            if (!_settings.EnableRandomDialog || !_settings.EnableOllamaChat)
+                return;
+
+            // 1 in N chance (default 9000). Ollama unloads an idle model after a few minutes,
+            // so it is usually cold exactly when random dialog is due; backing off only makes
+            // the load rarer, never skips it.
+            int chance = _settings.RandomDialogChance;
+            if (_settings.RandomDialogColdBackoff && _ollamaClient.Models.GetCachedLoadState(_ollamaClient.Model) == ModelLoadState.Cold)
+                chance = (int)Math.Min(int.MaxValue, (long)chance * ColdModelChanceFactor);
+
+            if (_random.Next(chance) != 0)
+                return;
+
+            if (Governor?.ShouldRun(BackgroundWork.RandomDialog) == false)
+                return;
+
+            try
+            {
+                var prompt = AppSettings.GetRandomLine(_settings.RandomDialogPrompts);
+                if (!string.IsNullOrEmpty(prompt))
+                {
+                    var response = await _ollamaClient.GenerateRandomDialogAsync(prompt, CancellationToken);
+                    if (!string.IsNullOrEmpty(response) && IsLoaded?.Invoke() == true)
+                    {
+                        Speak?.Invoke(response, null);
+                        Interlocked.Increment(ref _randomDialogs);
+                    }
+                }
+            }
+            catch (OperationCanceledException)
+            {
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("Random dialog failed", ex);
+            }
+        }
+
+        private bool SayLine(List<string> lines, string defaultAnimation)
+        {
+            if (IsLoaded?.Invoke() != true)
+                return false;
+
+            var line = AppSettings.GetRandomLine(lines);
+            if (string.IsNullOrEmpty(line))
+                return false;
+
+            Speak?.Invoke(line, defaultAnimation);
+            return true;
+        }
+
+        public void Dispose()
+        {
+            _idleTimer.Dispose();
+            _randomDialogTimer.Dispose();
+        }
+    }
+}
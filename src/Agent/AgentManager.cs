@@ -2,16 +2,18 @@ using System;
 using System.Collections.Generic;
 using System.IO;
 using System.Runtime.InteropServices;
+using System.Threading;
 using System.Windows.Forms;
 using Microsoft.Win32;
 using MSAgentAI.Logging;
+using MSAgentAI.Timing;
 
 namespace MSAgentAI.Agent
 {
     /// <summary>
     /// Manages MS Agent character loading, display, and interactions
     /// </summary>
-    public class AgentManager : IDisposable
+    public class AgentManager : IAgentBackend
     {
         private dynamic _agentServer;
         private dynamic _character;
@@ -19,11 +21,24 @@ namespace MSAgentAI.Agent
         private bool _isLoaded;
         private bool _disposed;
         private System.Windows.Forms.Timer _clickWatcher;
-        private System.Windows.Forms.Timer _moveWatcher;
+        private IClockTimer _moveWatcher;
+        private readonly IClock _clock;
         private int _lastX = -1;
         private int _lastY = -1;
         private bool _isBeingDragged = false;
         private DateTime _lastMoveEventTime = DateTime.MinValue;
+        
+        // Published state; fields below are only touched on the UI thread
+        private volatile AgentState _state = AgentState.Unloaded;
+        private bool _visible;
+        private string _loadedName;
+        private readonly List<TrackedRequest> _requests = new List<TrackedRequest>();
+        
+        // IAgentCtlRequest.Status values
+        private const int RequestComplete = 0;
+        private const int RequestPending = 2;
+        private const int RequestInProgress = 4;
+        
         private const int MoveEventCooldownMs = 2000; // 2 second cooldown between move events
 
         public event EventHandler<AgentEventArgs> OnClick;
@@ -34,6 +49,16 @@ namespace MSAgentAI.Agent
         public string DefaultCharacterPath { get; set; } = @"C:\Windows\msagent\chars";
 
         public bool IsLoaded => _isLoaded;
+        
+        /// <summary>
+        /// File the loaded character came from, null when none is loaded
+        /// </summary>
+        public string CharacterFile { get; private set; }
+        
+        /// <summary>
+        /// Latest state snapshot; safe to read from any thread
+        /// </summary>
+        public AgentState State => _state;
         public string CharacterName => _isLoaded && _character != null ? GetCharacterName() : string.Empty;
         public string CharacterDescription => _isLoaded && _character != null ? GetCharacterDescription() : string.Empty;
         
@@ -47,8 +72,17 @@ namespace MSAgentAI.Agent
             try { return _character.Description; } catch { return string.Empty; }
         }
 
-        public AgentManager()
+        /// <summary>
+        /// Watches for movement on the thread creating it, which must be the UI thread
+        /// </summary>
+        public AgentManager() : this(new SystemClock(SynchronizationContext.Current))
+        {
+        }
+        
+        /// <param name="clock">Runs the movement watcher and move cooldown; its ticks must arrive on the UI thread</param>
+        public AgentManager(IClock clock)
         {
+            _clock = clock ?? throw new ArgumentNullException(nameof(clock));
             InitializeAgent();
             SetupEventWatchers();
         }
@@ -56,12 +90,11 @@ namespace MSAgentAI.Agent
         private void SetupEventWatchers()
         {
             // Use a timer to check for position changes (movement)
-            _moveWatcher = new System.Windows.Forms.Timer { Interval = 500 };
-            _moveWatcher.Tick += CheckForMovement;
+            _moveWatcher = _clock.CreateTimer(TimeSpan.FromMilliseconds(500), CheckForMovement);
             _moveWatcher.Start();
         }
         
-        private void CheckForMovement(object sender, EventArgs e)
+        private void CheckForMovement()
         {
             if (!_isLoaded || _character == null)
                 return;
@@ -85,9 +118,10 @@ namespace MSAgentAI.Agent
                         // Movement stopped - fire event only if cooldown expired (prevents multiple events)
                         _isBeingDragged = false;
                         
-                        if ((DateTime.Now - _lastMoveEventTime).TotalMilliseconds >= MoveEventCooldownMs)
+                        DateTime now = _clock.Now;
+                        if ((now - _lastMoveEventTime).TotalMilliseconds >= MoveEventCooldownMs)
                         {
-                            _lastMoveEventTime = DateTime.Now;
+                            _lastMoveEventTime = now;
                             OnDragComplete?.Invoke(this, new AgentEventArgs 
                             { 
                                 X = currentX, 
@@ -100,6 +134,12 @@ namespace MSAgentAI.Agent
                 
                 _lastX = currentX;
                 _lastY = currentY;
+                
+                // The user can hide the character from its own menu
+                try { _visible = _character.Visible; } catch { }
+                
+                PruneRequests();
+                PublishState();
             }
             catch
             {
@@ -107,6 +147,82 @@ namespace MSAgentAI.Agent
             }
         }
         
+        /// <summary>
+        /// Remembers a request returned by the character so queue depth can be reported
+        /// </summary>
+        private void TrackRequest(string kind, string animation, dynamic request)
+        {
+            if (request != null)
+            {
+                _requests.Add(new TrackedRequest { Kind = kind, Animation = animation, Request = request });
+            }
+            PublishState();
+        }
+        
+        /// <summary>
+        /// Drops requests the character has finished, failed or interrupted
+        /// </summary>
+        private void PruneRequests()
+        {
+            for (int i = _requests.Count - 1; i >= 0; i--)
+            {
+                int status;
+                try
+                {
+                    status = (int)_requests[i].Request.Status;
+                }
+                catch
+                {
+                    // Request objects not available on this server; can't tell, so stop tracking
+                    status = RequestComplete;
+                }
+                
+                if (status != RequestPending && status != RequestInProgress)
+                {
+                    _requests.RemoveAt(i);
+                }
+            }
+        }
+        
+        /// <summary>
+        /// Swaps in a new snapshot if anything changed since the last one
+        /// </summary>
+        private void PublishState()
+        {
+            var current = _state;
+            if (!_isLoaded)
+            {
+                if (current.IsLoaded)
+                {
+                    _state = new AgentState(current.Version + 1, null, false, 0, 0, null, null, 0, 0);
+                }
+                return;
+            }
+            
+            string request = null;
+            string animation = null;
+            int speechDepth = 0;
+            foreach (var tracked in _requests)
+            {
+                if (request == null)
+                {
+                    request = tracked.Kind;
+                    animation = tracked.Animation;
+                }
+                if (tracked.Kind == "Speak" || tracked.Kind == "Think")
+                {
+                    speechDepth++;
+                }
+            }
+            
+            var next = new AgentState(current.Version + 1, _loadedName, _visible, Math.Max(0, _lastX), Math.Max(0, _lastY),
+                request, animation, _requests.Count, speechDepth);
+            if (!next.SameAs(current))
+            {
+                _state = next;
+            }
+        }
+        
         /// <summary>
         /// Call this method when the character is clicked (from external code)
         /// </summary>
@@ -461,6 +577,11 @@ namespace MSAgentAI.Agent
                     
                     _characterId = charName.GetHashCode();
                     _isLoaded = true;
+                    CharacterFile = characterPath;
+                    _loadedName = GetCharacterName();
+                    if (string.IsNullOrEmpty(_loadedName))
+                        _loadedName = charName;
+                    PublishState();
                     Logger.Log($"SUCCESS: Character '{charName}' loaded successfully");
                     return;
                 }
@@ -487,6 +608,11 @@ namespace MSAgentAI.Agent
                     
                     _characterId = charName.GetHashCode();
                     _isLoaded = true;
+                    CharacterFile = characterPath;
+                    _loadedName = GetCharacterName();
+                    if (string.IsNullOrEmpty(_loadedName))
+                        _loadedName = charName;
+                    PublishState();
                     Logger.Log($"SUCCESS: Character '{charName}' loaded via indexer");
                     return;
                 }
@@ -562,6 +688,13 @@ namespace MSAgentAI.Agent
                 _character = null;
                 _characterId = 0;
                 _isLoaded = false;
+                CharacterFile = null;
+                _loadedName = null;
+                _visible = false;
+                _lastX = -1;
+                _lastY = -1;
+                _requests.Clear();
+                PublishState();
             }
         }
 
@@ -571,7 +704,8 @@ namespace MSAgentAI.Agent
         public void Show(bool fast = false)
         {
             EnsureLoaded();
-            _character.Show(fast);
+            _visible = true;
+            TrackRequest("Show", null, _character.Show(fast));
         }
 
         /// <summary>
@@ -580,7 +714,8 @@ namespace MSAgentAI.Agent
         public void Hide(bool fast = false)
         {
             EnsureLoaded();
-            _character.Hide(fast);
+            _visible = false;
+            TrackRequest("Hide", null, _character.Hide(fast));
         }
 
         /// <summary>
@@ -593,7 +728,7 @@ namespace MSAgentAI.Agent
             if (!string.IsNullOrEmpty(text))
             {
                 // Speak the text - speed/pitch/voice are set via SetSpeechSpeed/SetSpeechPitch/SetTTSModeID
-                _character.Speak(text, null);
+                TrackRequest("Speak", null, _character.Speak(text, null));
             }
         }
 
@@ -612,7 +747,7 @@ namespace MSAgentAI.Agent
             {
                 if (!string.IsNullOrEmpty(sentence))
                 {
-                    _character.Speak(sentence, null);
+                    TrackRequest("Speak", null, _character.Speak(sentence, null));
                 }
             }
         }
@@ -625,7 +760,7 @@ namespace MSAgentAI.Agent
             EnsureLoaded();
             if (!string.IsNullOrEmpty(text))
             {
-                _character.Think(text);
+                TrackRequest("Think", null, _character.Think(text));
             }
         }
 
@@ -639,7 +774,7 @@ namespace MSAgentAI.Agent
             {
                 try
                 {
-                    _character.Play(animationName);
+                    TrackRequest("Play", animationName, _character.Play(animationName));
                 }
                 catch (Exception ex)
                 {
@@ -655,6 +790,8 @@ namespace MSAgentAI.Agent
         {
             EnsureLoaded();
             _character.StopAll(null);
+            _requests.Clear();
+            PublishState();
         }
 
         /// <summary>
@@ -663,7 +800,7 @@ namespace MSAgentAI.Agent
         public void MoveTo(int x, int y, int speed = 100)
         {
             EnsureLoaded();
-            _character.MoveTo((short)x, (short)y, speed);
+            TrackRequest("Move", null, _character.MoveTo((short)x, (short)y, speed));
         }
         
         /// <summary>
@@ -883,7 +1020,7 @@ namespace MSAgentAI.Agent
             if (!string.IsNullOrEmpty(text))
             {
                 // Just call Speak - speed/pitch are already set on character
-                _character.Speak(text, null);
+                TrackRequest("Speak", null, _character.Speak(text, null));
             }
         }
 
@@ -899,7 +1036,6 @@ namespace MSAgentAI.Agent
         {
             if (!_disposed)
             {
-                _moveWatcher?.Stop();
                 _moveWatcher?.Dispose();
                 _clickWatcher?.Stop();
                 _clickWatcher?.Dispose();
@@ -931,6 +1067,16 @@ namespace MSAgentAI.Agent
         }
     }
 
+    /// <summary>
+    /// A queued character request and what it was for
+    /// </summary>
+    internal class TrackedRequest
+    {
+        public string Kind { get; set; }
+        public string Animation { get; set; }
+        public dynamic Request { get; set; }
+    }
+
     /// <summary>
     /// Event arguments for agent events
     /// </summary>
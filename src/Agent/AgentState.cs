@@ -0,0 +1,133 @@
+using System;
+using System.Text;
+
+namespace MSAgentAI.Agent
+{
+    /// <summary>
+    /// Immutable snapshot of what the agent is doing. AgentManager builds a new one on the UI
+    /// thread whenever something changes and swaps it in, so other threads can read it without
+    /// invoking onto the UI thread or making COM calls.
+    /// </summary>
+    public sealed class AgentState
+    {
+        public static readonly AgentState Unloaded = new AgentState(0, null, false, 0, 0, null, null, 0, 0);
+
+        private static readonly DateTime UnixEpoch = new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+
+        private string _formatted;
+
+        public AgentState(long version, string character, bool visible, int x, int y,
+            string request, string animation, int queueDepth, int speechQueueDepth)
+        {
+            Version = version;
+            Character = character ?? string.Empty;
+            Visible = visible;
+            X = x;
+            Y = y;
+            Request = request ?? string.Empty;
+            Animation = animation ?? string.Empty;
+            QueueDepth = queueDepth;
+            SpeechQueueDepth = speechQueueDepth;
+            UpdatedAt = DateTime.UtcNow;
+        }
+
+        /// <summary>
+        /// Increases with every published change
+        /// </summary>
+        public long Version { get; }
+
+        /// <summary>
+        /// Loaded character's name, empty when none is loaded
+        /// </summary>
+        public string Character { get; }
+
+        public bool IsLoaded => Character.Length > 0;
+        public bool Visible { get; }
+
+        /// <summary>
+        /// Screen position as of the last move watcher tick
+        /// </summary>
+        public int X { get; }
+        public int Y { get; }
+
+        /// <summary>
+        /// What the agent is doing now (Speak, Think, Play, Move, Show or Hide), empty when idle
+        /// </summary>
+        public string Request { get; }
+
+        /// <summary>
+        /// Animation name when Request is Play
+        /// </summary>
+        public string Animation { get; }
+
+        /// <summary>
+        /// Requests queued or in progress
+        /// </summary>
+        public int QueueDepth { get; }
+
+        /// <summary>
+        /// Speak and Think requests queued or in progress
+        /// </summary>
+        public int SpeechQueueDepth { get; }
+
+        public bool IsSpeaking => Request == "Speak" || Request == "Think";
+
+        public DateTime UpdatedAt { get; }
+
+        /// <summary>
+        /// Whether the two snapshots describe the same state, ignoring version and time
+        /// </summary>
+        public bool SameAs(AgentState other)
+        {
+            return other != null
+                && Character == other.Character
+                && Visible == other.Visible
+                && X == other.X
+                && Y == other.Y
+                && Request == other.Request
+                && Animation == other.Animation
+                && QueueDepth == other.QueueDepth
+                && SpeechQueueDepth == other.SpeechQueueDepth;
+        }
+
+        /// <summary>
+        /// Semicolon-separated key=value fields, built once per snapshot
+        /// </summary>
+        public string Format()
+        {
+            var formatted = _formatted;
+            if (formatted != null)
+                return formatted;
+
+            var builder = new StringBuilder(160);
+            builder.Append("character=").Append(Clean(Character));
+            builder.Append(";loaded=").Append(IsLoaded ? 1 : 0);
+            builder.Append(";visible=").Append(Visible ? 1 : 0);
+            builder.Append(";speaking=").Append(IsSpeaking ? 1 : 0);
+            builder.Append(";x=").Append(X);
+            builder.Append(";y=").Append(Y);
+            builder.Append(";request=").Append(Request);
+            builder.Append(";animation=").Append(Clean(Animation));
+            builder.Append(";queue=").Append(QueueDepth);
+            builder.Append(";speech.queue=").Append(SpeechQueueDepth);
+            builder.Append(";version=").Append(Version);
+            builder.Append(";updated=").Append((long)(UpdatedAt - UnixEpoch).TotalMilliseconds);
+
+            // Racing threads build identical strings, so whichever lands is fine
+            _formatted = formatted = builder.ToString();
+            return formatted;
+        }
+
+        public override string ToString()
+        {
+            return Format();
+        }
+
+        private static string Clean(string value)
+        {
+            return value.IndexOfAny(new[] { ';', '\r', '\n' }) < 0
+                ? value
+                : value.Replace(';', ',').Replace('\r', ' ').Replace('\n', ' ');
+        }
+    }
+}
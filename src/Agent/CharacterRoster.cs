@@ -0,0 +1,177 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Agent
+{
+    /// <summary>
+    /// The characters on screen at once. The primary character is the one the tray menu, chat
+    /// window and untargeted pipeline commands act on; the others are extra AgentManagers with
+    /// their own connection to the agent server, so each has its own request queue and a long
+    /// speech from one doesn't hold up the rest. Lookups read published state and are safe from
+    /// any thread; loading and unloading happen on the UI thread.
+    /// </summary>
+    public class CharacterRoster : IDisposable
+    {
+        // Replaced rather than modified, so other threads can read it without a lock
+        private volatile AgentManager[] _extras = new AgentManager[0];
+
+        public CharacterRoster(AgentManager primary)
+        {
+            Primary = primary;
+        }
+
+        public AgentManager Primary { get; }
+
+        /// <summary>
+        /// Characters loaded besides the primary one, in load order
+        /// </summary>
+        public IReadOnlyList<AgentManager> Extras => _extras;
+
+        /// <summary>
+        /// Names of the loaded characters, the primary one first
+        /// </summary>
+        public List<string> GetNames()
+        {
+            var names = new List<string>();
+            if (Primary?.State.IsLoaded == true)
+            {
+                names.Add(Primary.State.Character);
+            }
+            foreach (var extra in _extras)
+            {
+                if (extra.State.IsLoaded)
+                {
+                    names.Add(extra.State.Character);
+                }
+            }
+            return names;
+        }
+
+        /// <summary>
+        /// The loaded character with this name or file name (case-insensitive), the primary
+        /// character for null, or null if there is none
+        /// </summary>
+        public AgentManager Find(string name)
+        {
+            if (name == null)
+                return Primary;
+
+            if (Matches(Primary, name))
+                return Primary;
+
+            foreach (var extra in _extras)
+            {
+                if (Matches(extra, name))
+                    return extra;
+            }
+            return null;
+        }
+
+        private static bool Matches(AgentManager agent, string name)
+        {
+            if (agent == null)
+                return false;
+
+            var state = agent.State;
+            if (!state.IsLoaded)
+                return false;
+
+            string file = agent.CharacterFile;
+            return string.Equals(state.Character, name, StringComparison.OrdinalIgnoreCase)
+                || (file != null && string.Equals(Path.GetFileNameWithoutExtension(file), name, StringComparison.OrdinalIgnoreCase));
+        }
+
+        /// <summary>
+        /// Loads the listed characters that aren't on screen and unloads extras no longer listed.
+        /// A character that fails to load is logged and skipped, so one bad file doesn't keep the
+        /// others off screen. Returns the characters it loaded, for the caller to show and set up.
+        /// </summary>
+        public List<AgentManager> Sync(IEnumerable<string> paths)
+        {
+            var wanted = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+            foreach (string path in paths ?? new string[0])
+            {
+                if (!string.IsNullOrWhiteSpace(path))
+                {
+                    wanted.Add(path.Trim());
+                }
+            }
+
+            var kept = new List<AgentManager>();
+            var removed = new List<AgentManager>();
+            foreach (var extra in _extras)
+            {
+                if (extra.CharacterFile != null && wanted.Remove(extra.CharacterFile))
+                {
+                    kept.Add(extra);
+                }
+                else
+                {
+                    removed.Add(extra);
+                }
+            }
+
+            // Out of the published list first, so pipeline threads in Find don't pick up a
+            // character that is being disposed
+            if (removed.Count > 0)
+            {
+                _extras = kept.ToArray();
+                foreach (var extra in removed)
+                {
+                    Logger.Log($"Unloading extra character {extra.State.Character}");
+                    extra.Dispose();
+                }
+            }
+
+            var loaded = new List<AgentManager>();
+            foreach (string path in wanted)
+            {
+                // The primary character can't also be an extra: the name would be ambiguous
+                if (Primary?.CharacterFile != null && string.Equals(Primary.CharacterFile, path, StringComparison.OrdinalIgnoreCase))
+                    continue;
+
+                AgentManager agent = null;
+                try
+                {
+                    if (!File.Exists(path))
+                    {
+                        Logger.LogWarning($"Extra character not found: {path}");
+                        continue;
+                    }
+
+                    agent = new AgentManager
+                    {
+                        DefaultCharacterPath = Primary?.DefaultCharacterPath ?? Path.GetDirectoryName(path)
+                    };
+                    agent.LoadCharacter(path);
+                    kept.Add(agent);
+                    loaded.Add(agent);
+                    Logger.Log($"Loaded extra character {agent.State.Character} from {path}");
+                }
+                catch (Exception ex)
+                {
+                    agent?.Dispose();
+                    Logger.LogError($"Failed to load extra character {path}", ex);
+                }
+            }
+
+            _extras = kept.ToArray();
+            return loaded;
+        }
+
+        /// <summary>
+        /// Unloads the extra characters; the primary one belongs to the caller
+        /// </summary>
+        public void Dispose()
+        {
+            var extras = _extras;
+            _extras = new AgentManager[0];
+            foreach (var extra in extras)
+            {
+                extra.Dispose();
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+using System;
+using System.Collections.Generic;
+
+namespace MSAgentAI.Agent
+{
+    /// <summary>
+    /// What the AI and pipeline need from an on-screen character. AgentManager drives MS Agent
+    /// and is called on the UI thread; the headless daemon plugs in its own backends and calls
+    /// them from pipeline threads, so those must be thread-safe.
+    /// </summary>
+    public interface IAgentBackend : IDisposable
+    {
+        bool IsLoaded { get; }
+
+        /// <summary>
+        /// File the loaded character came from, null when none is loaded
+        /// </summary>
+        string CharacterFile { get; }
+
+        /// <summary>
+        /// Latest state snapshot; safe to read from any thread
+        /// </summary>
+        AgentState State { get; }
+
+        void LoadCharacter(string characterPath);
+        void Show(bool fast = false);
+        void Hide(bool fast = false);
+        void Speak(string text);
+        void SpeakSentences(List<string> sentences);
+        void PlayAnimation(string animationName);
+        List<string> GetAnimations();
+    }
+}
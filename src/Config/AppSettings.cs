@@ -1,9 +1,7 @@
 using System;
 using System.Collections.Generic;
-using System.Drawing;
 using System.IO;
 using System.Text.RegularExpressions;
-using Newtonsoft.Json;
 
 namespace MSAgentAI.Config
 {
@@ -12,9 +10,12 @@ namespace MSAgentAI.Config
     /// </summary>
     public class AppSettings
     {
+        // Each property is also written and read by name in AppSettingsJson
+
         // Agent settings
         public string CharacterPath { get; set; } = @"C:\Windows\msagent\chars";
         public string SelectedCharacterFile { get; set; } = "";
+        public List<string> AdditionalCharacterFiles { get; set; } = new List<string>(); // Extra .acs files shown alongside the selected one; pipeline commands reach them with COMMAND@Name
 
         // User name system (## placeholder)
         public string UserName { get; set; } = "Friend";
@@ -42,6 +43,9 @@ namespace MSAgentAI.Config
         public string OllamaModel { get; set; } = "llama2";
         public string PersonalityPrompt { get; set; } = "You are a helpful and friendly desktop companion. Keep responses short and conversational.";
         public bool EnableOllamaChat { get; set; } = false;
+        public bool OllamaAdaptiveContext { get; set; } = true; // Size num_ctx per request from the prompt size
+        public int OllamaMaxContextLength { get; set; } = 8192; // Upper bound for num_ctx and history budgeting
+        public int RandomDialogMaxTokens { get; set; } = 100; // num_predict for random dialog / poke
         
         // Memory system settings
         public bool EnableMemories { get; set; } = false;
@@ -52,10 +56,33 @@ namespace MSAgentAI.Config
         public string PipelineIPAddress { get; set; } = "127.0.0.1"; // For TCP mode
         public int PipelinePort { get; set; } = 8765; // For TCP mode
         public string PipelineName { get; set; } = "MSAgentAI"; // For Named Pipe mode
+        public bool PipelineUdpEnabled { get; set; } = false; // Fire-and-forget commands, one per datagram
+        public int PipelineUdpPort { get; set; } = 8766; // Bound on PipelineIPAddress
+        public bool PipelineRingEnabled { get; set; } = false; // Shared-memory ring for same-machine mods
+        public string PipelineRingName { get; set; } = "MSAgentAI.Ring"; // Mapping and event name under Local\
+        public int PipelineRingSizeKb { get; set; } = 1024; // Rounded up to a power of two
+        public bool PipelineHttpEnabled { get; set; } = false; // HTTP + WebSocket endpoint for browser sources
+        public int PipelineHttpPort { get; set; } = 8767; // Loopback unless PipelineIPAddress is set otherwise
+        public List<string> PipelineHttpAllowedOrigins { get; set; } = new List<string>(); // Web pages allowed besides loopback; "null" admits local files (and sandboxed frames)
+        public int PipelineChatTokensPerMinute { get; set; } = 0; // Per-client CHAT quota, 0 = unlimited
+        public int PipelineChatQueueLimit { get; set; } = 8; // CHAT requests waiting per client
+        public int PipelineChatDefaultTtlMs { get; set; } = 0; // Deadline for CHAT commands without one, 0 = none
+        public int PipelineDrainTimeoutMs { get; set; } = 5000; // How long stopping waits for in-flight commands
+        public bool PipelineRecordEnabled { get; set; } = false; // Record inbound commands to recordings\pipeline-*.pipelog for replay
+        public bool PipelineRateLimitEnabled { get; set; } = false; // Token-bucket limits on inbound commands
+        public int PipelineRateLimitPerConnection { get; set; } = 200; // Tokens per second per connection, 0 = unlimited
+        public int PipelineRateLimitGlobal { get; set; } = 1000; // Tokens per second across all connections, 0 = unlimited
+        public double PipelineRateLimitBurstSeconds { get; set; } = 2.0; // Seconds of tokens a quiet connection can spend at once
+        public string PipelineRateLimitPolicy { get; set; } = "Delay"; // "Reject", "Delay" or "Drop"
+        public int PipelineRateLimitMaxDelayMs { get; set; } = 250; // Longest the Delay policy holds a command
+        public Dictionary<string, int> PipelineCommandCosts { get; set; } = new Dictionary<string, int>(); // Token cost overrides: command -> cost (default 4, PING 1, CHAT 40)
+        public Dictionary<string, string> PipelineMacros { get; set; } = new Dictionary<string, string>(); // DEFINE'd macros: name -> step|step
+        public Dictionary<string, PipelineEventSettings> PipelineEvents { get; set; } = new Dictionary<string, PipelineEventSettings>(); // EVENT:name|key=value -> lines or AI prompt
 
         // Random dialog settings
         public bool EnableRandomDialog { get; set; } = true;
         public int RandomDialogChance { get; set; } = 9000; // 1 in 9000 chance per second
+        public bool RandomDialogColdBackoff { get; set; } = false; // 4x rarer while Ollama has the model unloaded
         public bool EnablePrewrittenIdle { get; set; } = true;
         public int PrewrittenIdleChance { get; set; } = 30; // 1 in 30 idle ticks
         public List<string> RandomDialogPrompts { get; set; } = new List<string>
@@ -67,6 +94,17 @@ namespace MSAgentAI.Config
             "Share a conspiracy theory you just made up"
         };
 
+        // Background work governor: holds back random dialog and preview indexing for games
+        public bool GovernorEnabled { get; set; } = true;
+        public int GovernorBusyCpuPercent { get; set; } = 70; // Throttle at this system CPU use
+        public int GovernorIdleCpuPercent { get; set; } = 40; // Resume below this...
+        public int GovernorResumeDelaySeconds { get; set; } = 15; // ...once it has stayed there this long
+        public bool GovernorPauseWhenFullScreen { get; set; } = true; // Pause while another program is full-screen
+
+        // Memory budget shared by chat history, previews and other caches
+        public int MemoryBudgetMb { get; set; } = 128; // Trim caches when they hold more than this
+        public int MemoryHighLoadPercent { get; set; } = 90; // Trim harder when system memory use passes this
+
         // Custom presets storage
         public Dictionary<string, string> CustomPersonalityPresets { get; set; } = new Dictionary<string, string>();
 
@@ -166,21 +204,34 @@ namespace MSAgentAI.Config
             "settings.json"
         );
 
+        /// <summary>
+        /// %AppData%\MSAgentAI\settings.json, where Load and Save go by default
+        /// </summary>
+        public static string DefaultPath => SettingsPath;
+
         /// <summary>
         /// Saves settings to disk
         /// </summary>
         public void Save()
+        {
+            Save(SettingsPath);
+        }
+
+        /// <summary>
+        /// Saves settings to the given file
+        /// </summary>
+        public void Save(string path)
         {
             try
             {
-                var directory = Path.GetDirectoryName(SettingsPath);
+                var directory = Path.GetDirectoryName(Path.GetFullPath(path));
                 if (!Directory.Exists(directory))
                 {
                     Directory.CreateDirectory(directory);
                 }
 
-                var json = JsonConvert.SerializeObject(this, Formatting.Indented);
-                File.WriteAllText(SettingsPath, json);
+                var json = AppSettingsJson.Serialize(this);
+                File.WriteAllText(path, json);
             }
             catch (Exception ex)
             {
@@ -192,13 +243,21 @@ namespace MSAgentAI.Config
         /// Loads settings from disk
         /// </summary>
         public static AppSettings Load()
+        {
+            return Load(SettingsPath);
+        }
+
+        /// <summary>
+        /// Loads settings from the given file, or defaults if it is missing or unreadable
+        /// </summary>
+        public static AppSettings Load(string path)
         {
             try
             {
-                if (File.Exists(SettingsPath))
+                if (File.Exists(path))
                 {
-                    var json = File.ReadAllText(SettingsPath);
-                    return JsonConvert.DeserializeObject<AppSettings>(json) ?? new AppSettings();
+                    var json = File.ReadAllText(path);
+                    return AppSettingsJson.Deserialize(json) ?? new AppSettings();
                 }
             }
             catch (Exception ex)
@@ -371,98 +430,15 @@ namespace MSAgentAI.Config
             { "Deep Green", "Deep green theme" },
             { "Pure Black", "Pure black OLED theme" }
         };
-
-        /// <summary>
-        /// Gets the theme colors for a given theme name
-        /// </summary>
-        public static ThemeColors GetThemeColors(string themeName)
-        {
-            switch (themeName)
-            {
-                case "Dark":
-                    return new ThemeColors
-                    {
-                        Background = Color.FromArgb(45, 45, 48),
-                        Foreground = Color.White,
-                        ButtonBackground = Color.FromArgb(60, 60, 65),
-                        ButtonForeground = Color.White,
-                        InputBackground = Color.FromArgb(30, 30, 30),
-                        InputForeground = Color.White
-                    };
-                case "Deep Blue":
-                    return new ThemeColors
-                    {
-                        Background = Color.FromArgb(20, 30, 60),
-                        Foreground = Color.White,
-                        ButtonBackground = Color.FromArgb(30, 50, 100),
-                        ButtonForeground = Color.White,
-                        InputBackground = Color.FromArgb(15, 25, 50),
-                        InputForeground = Color.LightCyan
-                    };
-                case "Deep Purple":
-                    return new ThemeColors
-                    {
-                        Background = Color.FromArgb(40, 20, 60),
-                        Foreground = Color.White,
-                        ButtonBackground = Color.FromArgb(70, 40, 100),
-                        ButtonForeground = Color.White,
-                        InputBackground = Color.FromArgb(30, 15, 45),
-                        InputForeground = Color.Lavender
-                    };
-                case "Wine Red":
-                    return new ThemeColors
-                    {
-                        Background = Color.FromArgb(60, 20, 30),
-                        Foreground = Color.White,
-                        ButtonBackground = Color.FromArgb(100, 40, 50),
-                        ButtonForeground = Color.White,
-                        InputBackground = Color.FromArgb(45, 15, 25),
-                        InputForeground = Color.MistyRose
-                    };
-                case "Deep Green":
-                    return new ThemeColors
-                    {
-                        Background = Color.FromArgb(20, 50, 30),
-                        Foreground = Color.White,
-                        ButtonBackground = Color.FromArgb(40, 80, 50),
-                        ButtonForeground = Color.White,
-                        InputBackground = Color.FromArgb(15, 40, 25),
-                        InputForeground = Color.LightGreen
-                    };
-                case "Pure Black":
-                    return new ThemeColors
-                    {
-                        Background = Color.Black,
-                        Foreground = Color.White,
-                        ButtonBackground = Color.FromArgb(30, 30, 30),
-                        ButtonForeground = Color.White,
-                        InputBackground = Color.FromArgb(10, 10, 10),
-                        InputForeground = Color.White
-                    };
-                default: // Default system theme
-                    return new ThemeColors
-                    {
-                        Background = SystemColors.Control,
-                        Foreground = SystemColors.ControlText,
-                        ButtonBackground = SystemColors.Control,
-                        ButtonForeground = SystemColors.ControlText,
-                        InputBackground = SystemColors.Window,
-                        InputForeground = SystemColors.WindowText
-                    };
-            }
-        }
     }
 
     /// <summary>
-    /// Theme color definition
+    /// What the agent does for one pipeline EVENT. Lines and the prompt may use ##key##
+    /// for the event's parameters and ## for the user's name.
     /// </summary>
-    public class ThemeColors
+    public class PipelineEventSettings
     {
-        public Color Background { get; set; }
-        public Color Foreground { get; set; }
-        public Color ButtonBackground { get; set; }
-        public Color ButtonForeground { get; set; }
-        public Color InputBackground { get; set; }
-        public Color InputForeground { get; set; }
+        public List<string> Lines { get; set; } = new List<string>(); // One is picked at random
+        public string Prompt { get; set; } = ""; // Sent to the AI when set; lines are the fallback
     }
 }
@@ -0,0 +1,601 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using Newtonsoft.Json;
+
+namespace MSAgentAI.Config
+{
+    /// <summary>
+    /// Reads and writes settings.json without reflection. The output is byte for byte what
+    /// JsonConvert.SerializeObject(settings, Formatting.Indented) wrote: the same property names,
+    /// in declaration order, through the same JsonTextWriter. New AppSettings properties need a
+    /// line in Write and a case in ReadProperty.
+    /// </summary>
+    internal static class AppSettingsJson
+    {
+        // Hand-edited files may get the case of a name wrong; Newtonsoft matched those too
+        private static Dictionary<string, string> _namesIgnoringCase;
+
+        public static string Serialize(AppSettings settings)
+        {
+            var text = new StringWriter(CultureInfo.InvariantCulture);
+            using (var writer = new JsonTextWriter(text) { Formatting = Formatting.Indented })
+            {
+                Write(writer, settings);
+            }
+            return text.ToString();
+        }
+
+        /// <summary>
+        /// Reads settings, starting from the defaults for anything the JSON leaves out.
+        /// Returns null for empty or null JSON.
+        /// </summary>
+        public static AppSettings Deserialize(string json)
+        {
+            using (var reader = new JsonTextReader(new StringReader(json)))
+            {
+                if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                    return null;
+                if (reader.TokenType != JsonToken.StartObject)
+                    throw new JsonSerializationException($"Settings must be a JSON object, not {reader.TokenType}");
+
+                var settings = new AppSettings();
+                while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+                {
+                    string name = (string)reader.Value;
+                    if (!ReadProperty(reader, name, settings) &&
+                        !(NamesIgnoringCase.TryGetValue(name, out string canonical) && ReadProperty(reader, canonical, settings)))
+                    {
+                        // Settings from a newer or older version; Newtonsoft ignored them too
+                        reader.Skip();
+                    }
+                }
+                return settings;
+            }
+        }
+
+        private static void Write(JsonWriter writer, AppSettings settings)
+        {
+            writer.WriteStartObject();
+            Write(writer, "CharacterPath", settings.CharacterPath);
+            Write(writer, "SelectedCharacterFile", settings.SelectedCharacterFile);
+            Write(writer, "AdditionalCharacterFiles", settings.AdditionalCharacterFiles);
+            Write(writer, "UserName", settings.UserName);
+            Write(writer, "UserNamePronunciation", settings.UserNamePronunciation);
+            Write(writer, "UserDescription", settings.UserDescription);
+            Write(writer, "SelectedVoiceId", settings.SelectedVoiceId);
+            Write(writer, "VoiceSpeed", settings.VoiceSpeed);
+            Write(writer, "VoicePitch", settings.VoicePitch);
+            Write(writer, "VoiceVolume", settings.VoiceVolume);
+            Write(writer, "SelectedMicrophone", settings.SelectedMicrophone);
+            Write(writer, "SpeechConfidenceThreshold", settings.SpeechConfidenceThreshold);
+            Write(writer, "SilenceDetectionMs", settings.SilenceDetectionMs);
+            Write(writer, "UITheme", settings.UITheme);
+            Write(writer, "OllamaUrl", settings.OllamaUrl);
+            Write(writer, "OllamaModel", settings.OllamaModel);
+            Write(writer, "PersonalityPrompt", settings.PersonalityPrompt);
+            Write(writer, "EnableOllamaChat", settings.EnableOllamaChat);
+            Write(writer, "OllamaAdaptiveContext", settings.OllamaAdaptiveContext);
+            Write(writer, "OllamaMaxContextLength", settings.OllamaMaxContextLength);
+            Write(writer, "RandomDialogMaxTokens", settings.RandomDialogMaxTokens);
+            Write(writer, "EnableMemories", settings.EnableMemories);
+            Write(writer, "MemoryThreshold", settings.MemoryThreshold);
+            Write(writer, "PipelineProtocol", settings.PipelineProtocol);
+            Write(writer, "PipelineIPAddress", settings.PipelineIPAddress);
+            Write(writer, "PipelinePort", settings.PipelinePort);
+            Write(writer, "PipelineName", settings.PipelineName);
+            Write(writer, "PipelineUdpEnabled", settings.PipelineUdpEnabled);
+            Write(writer, "PipelineUdpPort", settings.PipelineUdpPort);
+            Write(writer, "PipelineRingEnabled", settings.PipelineRingEnabled);
+            Write(writer, "PipelineRingName", settings.PipelineRingName);
+            Write(writer, "PipelineRingSizeKb", settings.PipelineRingSizeKb);
+            Write(writer, "PipelineHttpEnabled", settings.PipelineHttpEnabled);
+            Write(writer, "PipelineHttpPort", settings.PipelineHttpPort);
+            Write(writer, "PipelineHttpAllowedOrigins", settings.PipelineHttpAllowedOrigins);
+            Write(writer, "PipelineChatTokensPerMinute", settings.PipelineChatTokensPerMinute);
+            Write(writer, "PipelineChatQueueLimit", settings.PipelineChatQueueLimit);
+            Write(writer, "PipelineChatDefaultTtlMs", settings.PipelineChatDefaultTtlMs);
+            Write(writer, "PipelineDrainTimeoutMs", settings.PipelineDrainTimeoutMs);
+            Write(writer, "PipelineRecordEnabled", settings.PipelineRecordEnabled);
+            Write(writer, "PipelineRateLimitEnabled", settings.PipelineRateLimitEnabled);
+            Write(writer, "PipelineRateLimitPerConnection", settings.PipelineRateLimitPerConnection);
+            Write(writer, "PipelineRateLimitGlobal", settings.PipelineRateLimitGlobal);
+            Write(writer, "PipelineRateLimitBurstSeconds", settings.PipelineRateLimitBurstSeconds);
+            Write(writer, "PipelineRateLimitPolicy", settings.PipelineRateLimitPolicy);
+            Write(writer, "PipelineRateLimitMaxDelayMs", settings.PipelineRateLimitMaxDelayMs);
+            Write(writer, "PipelineCommandCosts", settings.PipelineCommandCosts);
+            Write(writer, "PipelineMacros", settings.PipelineMacros);
+            Write(writer, "PipelineEvents", settings.PipelineEvents);
+            Write(writer, "EnableRandomDialog", settings.EnableRandomDialog);
+            Write(writer, "RandomDialogChance", settings.RandomDialogChance);
+            Write(writer, "RandomDialogColdBackoff", settings.RandomDialogColdBackoff);
+            Write(writer, "EnablePrewrittenIdle", settings.EnablePrewrittenIdle);
+            Write(writer, "PrewrittenIdleChance", settings.PrewrittenIdleChance);
+            Write(writer, "RandomDialogPrompts", settings.RandomDialogPrompts);
+            Write(writer, "GovernorEnabled", settings.GovernorEnabled);
+            Write(writer, "GovernorBusyCpuPercent", settings.GovernorBusyCpuPercent);
+            Write(writer, "GovernorIdleCpuPercent", settings.GovernorIdleCpuPercent);
+            Write(writer, "GovernorResumeDelaySeconds", settings.GovernorResumeDelaySeconds);
+            Write(writer, "GovernorPauseWhenFullScreen", settings.GovernorPauseWhenFullScreen);
+            Write(writer, "MemoryBudgetMb", settings.MemoryBudgetMb);
+            Write(writer, "MemoryHighLoadPercent", settings.MemoryHighLoadPercent);
+            Write(writer, "CustomPersonalityPresets", settings.CustomPersonalityPresets);
+            Write(writer, "PronunciationDictionary", settings.PronunciationDictionary);
+            Write(writer, "WelcomeLines", settings.WelcomeLines);
+            Write(writer, "IdleLines", settings.IdleLines);
+            Write(writer, "MovedLines", settings.MovedLines);
+            Write(writer, "ExitLines", settings.ExitLines);
+            Write(writer, "ClickedLines", settings.ClickedLines);
+            Write(writer, "Jokes", settings.Jokes);
+            Write(writer, "Thoughts", settings.Thoughts);
+            Write(writer, "WindowX", settings.WindowX);
+            Write(writer, "WindowY", settings.WindowY);
+            Write(writer, "AgentSize", settings.AgentSize);
+            Write(writer, "TruncateSpeech", settings.TruncateSpeech);
+            Write(writer, "IdleAnimationSpacing", settings.IdleAnimationSpacing);
+            writer.WriteEndObject();
+        }
+
+        /// <summary>
+        /// Reads the value of one property into settings. Lists and dictionaries replace the
+        /// defaults rather than being added to them.
+        /// </summary>
+        private static bool ReadProperty(JsonReader reader, string name, AppSettings settings)
+        {
+            switch (name)
+            {
+                case "CharacterPath":
+                    settings.CharacterPath = reader.ReadAsString();
+                    return true;
+                case "SelectedCharacterFile":
+                    settings.SelectedCharacterFile = reader.ReadAsString();
+                    return true;
+                case "AdditionalCharacterFiles":
+                    settings.AdditionalCharacterFiles = ReadStringList(reader);
+                    return true;
+                case "UserName":
+                    settings.UserName = reader.ReadAsString();
+                    return true;
+                case "UserNamePronunciation":
+                    settings.UserNamePronunciation = reader.ReadAsString();
+                    return true;
+                case "UserDescription":
+                    settings.UserDescription = reader.ReadAsString();
+                    return true;
+                case "SelectedVoiceId":
+                    settings.SelectedVoiceId = reader.ReadAsString();
+                    return true;
+                case "VoiceSpeed":
+                    settings.VoiceSpeed = reader.ReadAsInt32() ?? settings.VoiceSpeed;
+                    return true;
+                case "VoicePitch":
+                    settings.VoicePitch = reader.ReadAsInt32() ?? settings.VoicePitch;
+                    return true;
+                case "VoiceVolume":
+                    settings.VoiceVolume = reader.ReadAsInt32() ?? settings.VoiceVolume;
+                    return true;
+                case "SelectedMicrophone":
+                    settings.SelectedMicrophone = reader.ReadAsString();
+                    return true;
+                case "SpeechConfidenceThreshold":
+                    settings.SpeechConfidenceThreshold = reader.ReadAsInt32() ?? settings.SpeechConfidenceThreshold;
+                    return true;
+                case "SilenceDetectionMs":
+                    settings.SilenceDetectionMs = reader.ReadAsInt32() ?? settings.SilenceDetectionMs;
+                    return true;
+                case "UITheme":
+                    settings.UITheme = reader.ReadAsString();
+                    return true;
+                case "OllamaUrl":
+                    settings.OllamaUrl = reader.ReadAsString();
+                    return true;
+                case "OllamaModel":
+                    settings.OllamaModel = reader.ReadAsString();
+                    return true;
+                case "PersonalityPrompt":
+                    settings.PersonalityPrompt = reader.ReadAsString();
+                    return true;
+                case "EnableOllamaChat":
+                    settings.EnableOllamaChat = reader.ReadAsBoolean() ?? settings.EnableOllamaChat;
+                    return true;
+                case "OllamaAdaptiveContext":
+                    settings.OllamaAdaptiveContext = reader.ReadAsBoolean() ?? settings.OllamaAdaptiveContext;
+                    return true;
+                case "OllamaMaxContextLength":
+                    settings.OllamaMaxContextLength = reader.ReadAsInt32() ?? settings.OllamaMaxContextLength;
+                    return true;
+                case "RandomDialogMaxTokens":
+                    settings.RandomDialogMaxTokens = reader.ReadAsInt32() ?? settings.RandomDialogMaxTokens;
+                    return true;
+                case "EnableMemories":
+                    settings.EnableMemories = reader.ReadAsBoolean() ?? settings.EnableMemories;
+                    return true;
+                case "MemoryThreshold":
+                    settings.MemoryThreshold = reader.ReadAsDouble() ?? settings.MemoryThreshold;
+                    return true;
+                case "PipelineProtocol":
+                    settings.PipelineProtocol = reader.ReadAsString();
+                    return true;
+                case "PipelineIPAddress":
+                    settings.PipelineIPAddress = reader.ReadAsString();
+                    return true;
+                case "PipelinePort":
+                    settings.PipelinePort = reader.ReadAsInt32() ?? settings.PipelinePort;
+                    return true;
+                case "PipelineName":
+                    settings.PipelineName = reader.ReadAsString();
+                    return true;
+                case "PipelineUdpEnabled":
+                    settings.PipelineUdpEnabled = reader.ReadAsBoolean() ?? settings.PipelineUdpEnabled;
+                    return true;
+                case "PipelineUdpPort":
+                    settings.PipelineUdpPort = reader.ReadAsInt32() ?? settings.PipelineUdpPort;
+                    return true;
+                case "PipelineRingEnabled":
+                    settings.PipelineRingEnabled = reader.ReadAsBoolean() ?? settings.PipelineRingEnabled;
+                    return true;
+                case "PipelineRingName":
+                    settings.PipelineRingName = reader.ReadAsString();
+                    return true;
+                case "PipelineRingSizeKb":
+                    settings.PipelineRingSizeKb = reader.ReadAsInt32() ?? settings.PipelineRingSizeKb;
+                    return true;
+                case "PipelineHttpEnabled":
+                    settings.PipelineHttpEnabled = reader.ReadAsBoolean() ?? settings.PipelineHttpEnabled;
+                    return true;
+                case "PipelineHttpPort":
+                    settings.PipelineHttpPort = reader.ReadAsInt32() ?? settings.PipelineHttpPort;
+                    return true;
+                case "PipelineHttpAllowedOrigins":
+                    settings.PipelineHttpAllowedOrigins = ReadStringList(reader);
+                    return true;
+                case "PipelineChatTokensPerMinute":
+                    settings.PipelineChatTokensPerMinute = reader.ReadAsInt32() ?? settings.PipelineChatTokensPerMinute;
+                    return true;
+                case "PipelineChatQueueLimit":
+                    settings.PipelineChatQueueLimit = reader.ReadAsInt32() ?? settings.PipelineChatQueueLimit;
+                    return true;
+                case "PipelineChatDefaultTtlMs":
+                    settings.PipelineChatDefaultTtlMs = reader.ReadAsInt32() ?? settings.PipelineChatDefaultTtlMs;
+                    return true;
+                case "PipelineDrainTimeoutMs":
+                    settings.PipelineDrainTimeoutMs = reader.ReadAsInt32() ?? settings.PipelineDrainTimeoutMs;
+                    return true;
+                case "PipelineRecordEnabled":
+                    settings.PipelineRecordEnabled = reader.ReadAsBoolean() ?? settings.PipelineRecordEnabled;
+                    return true;
+                case "PipelineRateLimitEnabled":
+                    settings.PipelineRateLimitEnabled = reader.ReadAsBoolean() ?? settings.PipelineRateLimitEnabled;
+                    return true;
+                case "PipelineRateLimitPerConnection":
+                    settings.PipelineRateLimitPerConnection = reader.ReadAsInt32() ?? settings.PipelineRateLimitPerConnection;
+                    return true;
+                case "PipelineRateLimitGlobal":
+                    settings.PipelineRateLimitGlobal = reader.ReadAsInt32() ?? settings.PipelineRateLimitGlobal;
+                    return true;
+                case "PipelineRateLimitBurstSeconds":
+                    settings.PipelineRateLimitBurstSeconds = reader.ReadAsDouble() ?? settings.PipelineRateLimitBurstSeconds;
+                    return true;
+                case "PipelineRateLimitPolicy":
+                    settings.PipelineRateLimitPolicy = reader.ReadAsString();
+                    return true;
+                case "PipelineRateLimitMaxDelayMs":
+                    settings.PipelineRateLimitMaxDelayMs = reader.ReadAsInt32() ?? settings.PipelineRateLimitMaxDelayMs;
+                    return true;
+                case "PipelineCommandCosts":
+                    settings.PipelineCommandCosts = ReadIntMap(reader);
+                    return true;
+                case "PipelineMacros":
+                    settings.PipelineMacros = ReadStringMap(reader);
+                    return true;
+                case "PipelineEvents":
+                    settings.PipelineEvents = ReadEvents(reader);
+                    return true;
+                case "EnableRandomDialog":
+                    settings.EnableRandomDialog = reader.ReadAsBoolean() ?? settings.EnableRandomDialog;
+                    return true;
+                case "RandomDialogChance":
+                    settings.RandomDialogChance = reader.ReadAsInt32() ?? settings.RandomDialogChance;
+                    return true;
+                case "RandomDialogColdBackoff":
+                    settings.RandomDialogColdBackoff = reader.ReadAsBoolean() ?? settings.RandomDialogColdBackoff;
+                    return true;
+                case "EnablePrewrittenIdle":
+                    settings.EnablePrewrittenIdle = reader.ReadAsBoolean() ?? settings.EnablePrewrittenIdle;
+                    return true;
+                case "PrewrittenIdleChance":
+                    settings.PrewrittenIdleChance = reader.ReadAsInt32() ?? settings.PrewrittenIdleChance;
+                    return true;
+                case "RandomDialogPrompts":
+                    settings.RandomDialogPrompts = ReadStringList(reader);
+                    return true;
+                case "GovernorEnabled":
+                    settings.GovernorEnabled = reader.ReadAsBoolean() ?? settings.GovernorEnabled;
+                    return true;
+                case "GovernorBusyCpuPercent":
+                    settings.GovernorBusyCpuPercent = reader.ReadAsInt32() ?? settings.GovernorBusyCpuPercent;
+                    return true;
+                case "GovernorIdleCpuPercent":
+                    settings.GovernorIdleCpuPercent = reader.ReadAsInt32() ?? settings.GovernorIdleCpuPercent;
+                    return true;
+                case "GovernorResumeDelaySeconds":
+                    settings.GovernorResumeDelaySeconds = reader.ReadAsInt32() ?? settings.GovernorResumeDelaySeconds;
+                    return true;
+                case "GovernorPauseWhenFullScreen":
+                    settings.GovernorPauseWhenFullScreen = reader.ReadAsBoolean() ?? settings.GovernorPauseWhenFullScreen;
+                    return true;
+                case "MemoryBudgetMb":
+                    settings.MemoryBudgetMb = reader.ReadAsInt32() ?? settings.MemoryBudgetMb;
+                    return true;
+                case "MemoryHighLoadPercent":
+                    settings.MemoryHighLoadPercent = reader.ReadAsInt32() ?? settings.MemoryHighLoadPercent;
+                    return true;
+                case "CustomPersonalityPresets":
+                    settings.CustomPersonalityPresets = ReadStringMap(reader);
+                    return true;
+                case "PronunciationDictionary":
+                    settings.PronunciationDictionary = ReadStringMap(reader);
+                    return true;
+                case "WelcomeLines":
+                    settings.WelcomeLines = ReadStringList(reader);
+                    return true;
+                case "IdleLines":
+                    settings.IdleLines = ReadStringList(reader);
+                    return true;
+                case "MovedLines":
+                    settings.MovedLines = ReadStringList(reader);
+                    return true;
+                case "ExitLines":
+                    settings.ExitLines = ReadStringList(reader);
+                    return true;
+                case "ClickedLines":
+                    settings.ClickedLines = ReadStringList(reader);
+                    return true;
+                case "Jokes":
+                    settings.Jokes = ReadStringList(reader);
+                    return true;
+                case "Thoughts":
+                    settings.Thoughts = ReadStringList(reader);
+                    return true;
+                case "WindowX":
+                    settings.WindowX = reader.ReadAsInt32() ?? settings.WindowX;
+                    return true;
+                case "WindowY":
+                    settings.WindowY = reader.ReadAsInt32() ?? settings.WindowY;
+                    return true;
+                case "AgentSize":
+                    settings.AgentSize = reader.ReadAsInt32() ?? settings.AgentSize;
+                    return true;
+                case "TruncateSpeech":
+                    settings.TruncateSpeech = reader.ReadAsBoolean() ?? settings.TruncateSpeech;
+                    return true;
+                case "IdleAnimationSpacing":
+                    settings.IdleAnimationSpacing = reader.ReadAsInt32() ?? settings.IdleAnimationSpacing;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        private static Dictionary<string, string> NamesIgnoringCase
+        {
+            get
+            {
+                if (_namesIgnoringCase == null)
+                {
+                    var names = new Dictionary<string, string>(StringComparer.OrdinalIgnoreCase);
+                    foreach (var property in typeof(AppSettings).GetProperties())
+                    {
+                        names[property.Name] = property.Name;
+                    }
+                    _namesIgnoringCase = names;
+                }
+                return _namesIgnoringCase;
+            }
+        }
+
+        private static void Write(JsonWriter writer, string name, string value)
+        {
+            writer.WritePropertyName(name);
+            writer.WriteValue(value);
+        }
+
+        private static void Write(JsonWriter writer, string name, int value)
+        {
+            writer.WritePropertyName(name);
+            writer.WriteValue(value);
+        }
+
+        private static void Write(JsonWriter writer, string name, bool value)
+        {
+            writer.WritePropertyName(name);
+            writer.WriteValue(value);
+        }
+
+        private static void Write(JsonWriter writer, string name, double value)
+        {
+            writer.WritePropertyName(name);
+            writer.WriteValue(value);
+        }
+
+        private static void Write(JsonWriter writer, string name, List<string> values)
+        {
+            writer.WritePropertyName(name);
+            WriteStringList(writer, values);
+        }
+
+        private static void Write(JsonWriter writer, string name, Dictionary<string, string> values)
+        {
+            writer.WritePropertyName(name);
+            if (values == null)
+            {
+                writer.WriteNull();
+                return;
+            }
+
+            writer.WriteStartObject();
+            foreach (var entry in values)
+            {
+                writer.WritePropertyName(entry.Key);
+                writer.WriteValue(entry.Value);
+            }
+            writer.WriteEndObject();
+        }
+
+        private static void Write(JsonWriter writer, string name, Dictionary<string, int> values)
+        {
+            writer.WritePropertyName(name);
+            if (values == null)
+            {
+                writer.WriteNull();
+                return;
+            }
+
+            writer.WriteStartObject();
+            foreach (var entry in values)
+            {
+                writer.WritePropertyName(entry.Key);
+                writer.WriteValue(entry.Value);
+            }
+            writer.WriteEndObject();
+        }
+
+        private static void Write(JsonWriter writer, string name, Dictionary<string, PipelineEventSettings> values)
+        {
+            writer.WritePropertyName(name);
+            if (values == null)
+            {
+                writer.WriteNull();
+                return;
+            }
+
+            writer.WriteStartObject();
+            foreach (var entry in values)
+            {
+                writer.WritePropertyName(entry.Key);
+                if (entry.Value == null)
+                {
+                    writer.WriteNull();
+                    continue;
+                }
+
+                writer.WriteStartObject();
+                writer.WritePropertyName("Lines");
+                WriteStringList(writer, entry.Value.Lines);
+                writer.WritePropertyName("Prompt");
+                writer.WriteValue(entry.Value.Prompt);
+                writer.WriteEndObject();
+            }
+            writer.WriteEndObject();
+        }
+
+        private static void WriteStringList(JsonWriter writer, List<string> values)
+        {
+            if (values == null)
+            {
+                writer.WriteNull();
+                return;
+            }
+
+            writer.WriteStartArray();
+            foreach (string value in values)
+            {
+                writer.WriteValue(value);
+            }
+            writer.WriteEndArray();
+        }
+
+        private static List<string> ReadStringList(JsonReader reader)
+        {
+            if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                return null;
+            if (reader.TokenType != JsonToken.StartArray)
+                throw new JsonSerializationException($"Expected a list at {reader.Path}");
+
+            var values = new List<string>();
+            string value;
+            while ((value = reader.ReadAsString()) != null || reader.TokenType == JsonToken.Null)
+            {
+                values.Add(value);
+            }
+            return values;
+        }
+
+        private static Dictionary<string, string> ReadStringMap(JsonReader reader)
+        {
+            if (!StartMap(reader))
+                return null;
+
+            var values = new Dictionary<string, string>();
+            while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+            {
+                values[(string)reader.Value] = reader.ReadAsString();
+            }
+            return values;
+        }
+
+        private static Dictionary<string, int> ReadIntMap(JsonReader reader)
+        {
+            if (!StartMap(reader))
+                return null;
+
+            var values = new Dictionary<string, int>();
+            while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+            {
+                string key = (string)reader.Value;
+                values[key] = reader.ReadAsInt32() ?? throw new JsonSerializationException($"Expected a number at {reader.Path}");
+            }
+            return values;
+        }
+
+        private static Dictionary<string, PipelineEventSettings> ReadEvents(JsonReader reader)
+        {
+            if (!StartMap(reader))
+                return null;
+
+            var values = new Dictionary<string, PipelineEventSettings>();
+            while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+            {
+                string key = (string)reader.Value;
+                if (!StartMap(reader))
+                {
+                    values[key] = null;
+                    continue;
+                }
+
+                var settings = new PipelineEventSettings();
+                while (reader.Read() && reader.TokenType == JsonToken.PropertyName)
+                {
+                    string name = (string)reader.Value;
+                    if (string.Equals(name, "Lines", StringComparison.OrdinalIgnoreCase))
+                    {
+                        settings.Lines = ReadStringList(reader);
+                    }
+                    else if (string.Equals(name, "Prompt", StringComparison.OrdinalIgnoreCase))
+                    {
+                        settings.Prompt = reader.ReadAsString();
+                    }
+                    else
+                    {
+                        reader.Skip();
+                    }
+                }
+                values[key] = settings;
+            }
+            return values;
+        }
+
+        /// <summary>
+        /// Moves onto a JSON object; false when the value is null
+        /// </summary>
+        private static bool StartMap(JsonReader reader)
+        {
+            if (!reader.Read() || reader.TokenType == JsonToken.Null)
+                return false;
+            if (reader.TokenType != JsonToken.StartObject)
+                throw new JsonSerializationException($"Expected an object at {reader.Path}");
+            return true;
+        }
+    }
+}
@@ -19,17 +19,24 @@ namespace MSAgentAI.Logging
         public static string LogFilePath => _logFilePath;
 
         /// <summary>
-        /// Initializes the logger with the default log file location
+        /// Also writes each line to standard output, for hosts run under a service manager
+        /// that collects it
         /// </summary>
-        public static void Initialize()
+        public static bool EchoToConsole { get; set; }
+
+        /// <summary>
+        /// Initializes the logger, by default with the log file next to the executable
+        /// </summary>
+        public static void Initialize(string logFilePath = null)
         {
             if (_initialized) return;
 
             try
             {
-                // Log file in the same directory as the executable
+                // Log file in the same directory as the executable unless told otherwise
                 string appDir = AppDomain.CurrentDomain.BaseDirectory;
-                _logFilePath = Path.Combine(appDir, "MSAgentAI.log");
+                _logFilePath = string.IsNullOrEmpty(logFilePath) ? Path.Combine(appDir, "MSAgentAI.log") : Path.GetFullPath(logFilePath);
+                Directory.CreateDirectory(Path.GetDirectoryName(_logFilePath));
                 _initialized = true;
 
                 // Write header
@@ -63,17 +70,23 @@ namespace MSAgentAI.Logging
             if (!_initialized) Initialize();
             if (!_initialized) return;
 
+            string line = $"[{DateTime.Now:HH:mm:ss}] {message}";
             try
             {
                 lock (_lock)
                 {
-                    File.AppendAllText(_logFilePath, $"[{DateTime.Now:HH:mm:ss}] {message}{Environment.NewLine}");
+                    File.AppendAllText(_logFilePath, line + Environment.NewLine);
                 }
             }
             catch
             {
                 // Silently fail if we can't write
             }
+
+            if (EchoToConsole)
+            {
+                Console.WriteLine(line);
+            }
         }
 
         /// <summary>
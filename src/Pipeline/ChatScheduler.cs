@@ -0,0 +1,584 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Result of submitting a CHAT request to the scheduler
+    /// </summary>
+    public enum ChatAdmission
+    {
+        Queued,
+        QuotaExceeded,
+        QueueFull,
+        DeadlineExceeded
+    }
+
+    /// <summary>
+    /// A queued CHAT request
+    /// </summary>
+    public class ChatWorkItem
+    {
+        public string ClientId { get; set; }
+
+        /// <summary>
+        /// Character that should answer, or null for the default character
+        /// </summary>
+        public string Character { get; set; }
+
+        public string Prompt { get; set; }
+        public int EstimatedTokens { get; set; }
+        public DateTime EnqueuedAt { get; set; }
+
+        /// <summary>
+        /// UTC time after which the answer is no longer wanted (null = no deadline)
+        /// </summary>
+        public DateTime? Deadline { get; set; }
+    }
+
+    /// <summary>
+    /// Per-client usage snapshot for the STATS command
+    /// </summary>
+    public class ChatClientStats
+    {
+        public string ClientId { get; set; }
+        public int TokensLastMinute { get; set; }
+        public long TotalTokens { get; set; }
+        public long Requests { get; set; }
+        public long Rejected { get; set; }
+        public long Expired { get; set; }
+        public int Queued { get; set; }
+    }
+
+    /// <summary>
+    /// Fair-share scheduler for pipeline CHAT requests.
+    /// Each client gets its own queue and queues are served by deficit round robin,
+    /// weighted by estimated tokens, so a client sending many or very long prompts
+    /// can't starve the others. Clients are also held to a tokens-per-minute quota.
+    /// Requests with a deadline are refused, dropped or cancelled as soon as they
+    /// can no longer be answered in time, using the measured token throughput.
+    /// Each character answers one request at a time, but different characters run
+    /// side by side, so a long answer from one doesn't hold up the others.
+    /// </summary>
+    public class ChatScheduler : IDisposable
+    {
+        // Tokens credited to a client each time the round robin visits it
+        private const int QuantumTokens = 512;
+
+        private static readonly TimeSpan QuotaWindow = TimeSpan.FromMinutes(1);
+
+        // Idle clients are forgotten after this long so the stats don't grow forever
+        private static readonly TimeSpan ForgetIdleAfter = TimeSpan.FromMinutes(10);
+
+        private readonly Func<ChatWorkItem, CancellationToken, Task<int>> _executor;
+        private readonly Dictionary<string, ClientState> _clients = new Dictionary<string, ClientState>(StringComparer.Ordinal);
+        private readonly List<ClientState> _active = new List<ClientState>();
+        private readonly object _lock = new object();
+        private readonly SemaphoreSlim _signal = new SemaphoreSlim(0);
+        private readonly CancellationTokenSource _cancellationTokenSource = new CancellationTokenSource();
+        private readonly Task _dispatchTask;
+        private int _roundRobinIndex;
+        private bool _visitCredited;
+        private int _inFlight;
+        private bool _disposed;
+
+        // Measured tokens per second across recent requests (0 until the first sample)
+        private double _tokensPerSecond;
+
+        // Requests running now and when they started, one per character (empty key = default character)
+        private readonly Dictionary<string, ChatWorkItem> _running = new Dictionary<string, ChatWorkItem>(StringComparer.OrdinalIgnoreCase);
+        private readonly Dictionary<ChatWorkItem, DateTime> _runningSince = new Dictionary<ChatWorkItem, DateTime>();
+
+        /// <summary>
+        /// Token budget per client per minute (0 = unlimited)
+        /// </summary>
+        public int TokensPerMinute { get; set; }
+
+        /// <summary>
+        /// Maximum CHAT requests waiting per client
+        /// </summary>
+        public int MaxQueuedPerClient { get; set; } = 8;
+
+        /// <summary>
+        /// Estimates the token cost of a prompt before it runs
+        /// </summary>
+        public Func<string, int> EstimateCost { get; set; } = prompt => prompt.Length / 4 + 256;
+
+        /// <param name="executor">Runs a request and returns the tokens it actually used (0 if unknown)</param>
+        public ChatScheduler(Func<ChatWorkItem, CancellationToken, Task<int>> executor)
+        {
+            _executor = executor ?? throw new ArgumentNullException(nameof(executor));
+            _dispatchTask = Task.Run(() => DispatchLoopAsync(_cancellationTokenSource.Token));
+        }
+
+        /// <summary>
+        /// Requests waiting across all clients
+        /// </summary>
+        public int QueuedCount
+        {
+            get { lock (_lock) { return _active.Sum(c => c.Queue.Count); } }
+        }
+
+        public int InFlightCount => Volatile.Read(ref _inFlight);
+
+        /// <summary>
+        /// Measured Ollama throughput in tokens per second (0 = not measured yet)
+        /// </summary>
+        public double TokensPerSecond
+        {
+            get { lock (_lock) { return _tokensPerSecond; } }
+        }
+
+        /// <summary>
+        /// Queues a CHAT request for a client. When rejected, reason describes why.
+        /// </summary>
+        public ChatAdmission Enqueue(string clientId, string prompt, DateTime? deadline, out string reason)
+        {
+            return Enqueue(clientId, null, prompt, deadline, out reason);
+        }
+
+        /// <summary>
+        /// Queues a CHAT request for a client, to be answered by the given character
+        /// </summary>
+        public ChatAdmission Enqueue(string clientId, string character, string prompt, DateTime? deadline, out string reason)
+        {
+            int cost = Math.Max(1, EstimateCost(prompt));
+            var now = DateTime.UtcNow;
+            reason = null;
+
+            lock (_lock)
+            {
+                var client = GetClient(clientId, now);
+
+                if (client.Queue.Count >= MaxQueuedPerClient)
+                {
+                    client.Rejected++;
+                    reason = $"queue full ({client.Queue.Count} waiting)";
+                    return ChatAdmission.QueueFull;
+                }
+
+                int quota = TokensPerMinute;
+                if (quota > 0)
+                {
+                    int committed = client.TokensInWindow(now, QuotaWindow) + client.PendingTokens;
+                    if (committed + cost > quota)
+                    {
+                        client.Rejected++;
+                        int retrySeconds = (int)Math.Ceiling(client.TimeUntilFree(committed + cost - quota, now, QuotaWindow).TotalSeconds);
+                        reason = cost > quota
+                            ? $"request needs ~{cost} tokens, quota is {quota}/min"
+                            : $"{committed}/{quota} tokens per minute used, retry in {Math.Max(1, retrySeconds)}s";
+                        return ChatAdmission.QuotaExceeded;
+                    }
+                }
+
+                if (deadline.HasValue)
+                {
+                    // Lower bound: this client's own backlog plus whatever is running now
+                    var earliest = EstimateCompletion(client, character, cost, now);
+                    if (deadline.Value <= earliest)
+                    {
+                        client.Expired++;
+                        reason = deadline.Value <= now
+                            ? "deadline already passed"
+                            : $"can't finish before deadline (needs ~{(earliest - now).TotalSeconds:0.0}s, has {(deadline.Value - now).TotalSeconds:0.0}s)";
+                        return ChatAdmission.DeadlineExceeded;
+                    }
+                }
+
+                client.Queue.Enqueue(new ChatWorkItem
+                {
+                    ClientId = client.Id,
+                    Character = character,
+                    Prompt = prompt,
+                    EstimatedTokens = cost,
+                    EnqueuedAt = now,
+                    Deadline = deadline
+                });
+                client.PendingTokens += cost;
+
+                if (!_active.Contains(client))
+                {
+                    _active.Add(client);
+                }
+            }
+
+            _signal.Release();
+            return ChatAdmission.Queued;
+        }
+
+        /// <summary>
+        /// Gets per-client usage, busiest first
+        /// </summary>
+        public List<ChatClientStats> GetStats()
+        {
+            var now = DateTime.UtcNow;
+            lock (_lock)
+            {
+                ForgetIdleClients(now);
+                return _clients.Values
+                    .Select(c => new ChatClientStats
+                    {
+                        ClientId = c.Id,
+                        TokensLastMinute = c.TokensInWindow(now, QuotaWindow),
+                        TotalTokens = c.TotalTokens,
+                        Requests = c.Requests,
+                        Rejected = c.Rejected,
+                        Expired = c.Expired,
+                        Queued = c.Queue.Count
+                    })
+                    .OrderByDescending(s => s.TokensLastMinute)
+                    .ThenBy(s => s.ClientId, StringComparer.Ordinal)
+                    .ToList();
+            }
+        }
+
+        /// <summary>
+        /// Formats scheduler state as STATS fields
+        /// </summary>
+        public string FormatStats()
+        {
+            var stats = GetStats();
+            var sb = new StringBuilder();
+            sb.Append($"chat.queued={QueuedCount};chat.inflight={InFlightCount};chat.quota={TokensPerMinute};chat.tps={TokensPerSecond:0.0}");
+            foreach (var client in stats)
+            {
+                sb.Append($";client[{client.ClientId}]=tpm:{client.TokensLastMinute},total:{client.TotalTokens},requests:{client.Requests},queued:{client.Queued},rejected:{client.Rejected},expired:{client.Expired}");
+            }
+            return sb.ToString();
+        }
+
+        private async Task DispatchLoopAsync(CancellationToken cancellationToken)
+        {
+            var running = new List<Task>();
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                try
+                {
+                    await _signal.WaitAsync(cancellationToken);
+                }
+                catch (OperationCanceledException)
+                {
+                    break;
+                }
+
+                // Null when the queued requests are all for characters that are busy; the
+                // running request for that character signals again when it finishes
+                var item = Dequeue();
+                if (item == null)
+                    continue;
+
+                running.RemoveAll(t => t.IsCompleted);
+                running.Add(RunAsync(item, cancellationToken));
+            }
+
+            // Dispose waits on this loop, so it also waits for the requests still running
+            await Task.WhenAll(running);
+        }
+
+        private async Task RunAsync(ChatWorkItem item, CancellationToken cancellationToken)
+        {
+            Interlocked.Increment(ref _inFlight);
+            int used = 0;
+            bool expired = false;
+            var stopwatch = Stopwatch.StartNew();
+
+            // The deadline travels with the request as a linked token, so the Ollama call
+            // is cancelled (and generation stopped) the moment the answer stops being useful
+            using (var deadlineSource = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken))
+            {
+                if (item.Deadline.HasValue)
+                {
+                    var remaining = item.Deadline.Value - DateTime.UtcNow;
+                    deadlineSource.CancelAfter(remaining > TimeSpan.Zero ? remaining : TimeSpan.Zero);
+                }
+
+                try
+                {
+                    used = await _executor(item, deadlineSource.Token);
+                }
+                catch (OperationCanceledException) when (cancellationToken.IsCancellationRequested)
+                {
+                    Interlocked.Decrement(ref _inFlight);
+                    return;
+                }
+                catch (OperationCanceledException)
+                {
+                    // Deadline hit inside the executor
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"Pipeline: Chat request from {item.ClientId} failed", ex);
+                }
+
+                Interlocked.Decrement(ref _inFlight);
+                expired = deadlineSource.IsCancellationRequested && !cancellationToken.IsCancellationRequested;
+            }
+
+            if (expired)
+            {
+                Logger.Log($"Pipeline: CHAT from {item.ClientId} cancelled at its deadline after {stopwatch.ElapsedMilliseconds} ms");
+            }
+
+            Complete(item, used > 0 ? used : item.EstimatedTokens, expired ? TimeSpan.Zero : stopwatch.Elapsed, expired);
+
+            // The character is free again; let the loop look at its queued requests
+            if (!cancellationToken.IsCancellationRequested)
+            {
+                _signal.Release();
+            }
+        }
+
+        /// <summary>
+        /// Picks the next request by deficit round robin
+        /// </summary>
+        private ChatWorkItem Dequeue()
+        {
+            lock (_lock)
+            {
+                // Clients passed over in a row because their character is busy
+                int blocked = 0;
+                while (_active.Count > 0 && blocked < _active.Count)
+                {
+                    if (_roundRobinIndex >= _active.Count)
+                    {
+                        _roundRobinIndex = 0;
+                    }
+
+                    var client = _active[_roundRobinIndex];
+                    if (_running.ContainsKey(CharacterKey(client.Queue.Peek())))
+                    {
+                        // Wait for that character without spending the client's turn
+                        blocked++;
+                        _roundRobinIndex++;
+                        _visitCredited = false;
+                        continue;
+                    }
+                    blocked = 0;
+
+                    if (!_visitCredited)
+                    {
+                        client.Deficit += QuantumTokens;
+                        _visitCredited = true;
+                    }
+
+                    var head = client.Queue.Peek();
+
+                    // Drop work that can no longer be answered in time before it costs anything
+                    if (head.Deadline.HasValue && head.Deadline.Value <= EstimateFinish(head, DateTime.UtcNow))
+                    {
+                        client.Queue.Dequeue();
+                        client.PendingTokens = Math.Max(0, client.PendingTokens - head.EstimatedTokens);
+                        client.Expired++;
+                        Logger.Log($"Pipeline: CHAT from {client.Id} dropped, deadline passed after {(DateTime.UtcNow - head.EnqueuedAt).TotalMilliseconds:0} ms in queue");
+
+                        if (client.Queue.Count == 0)
+                        {
+                            client.Deficit = 0;
+                            _active.RemoveAt(_roundRobinIndex);
+                            _visitCredited = false;
+                        }
+                        continue;
+                    }
+
+                    if (head.EstimatedTokens <= client.Deficit)
+                    {
+                        client.Queue.Dequeue();
+                        client.Deficit -= head.EstimatedTokens;
+
+                        // An emptied queue leaves the rotation and loses its credit
+                        if (client.Queue.Count == 0)
+                        {
+                            client.Deficit = 0;
+                            _active.RemoveAt(_roundRobinIndex);
+                            _visitCredited = false;
+                        }
+
+                        _running[CharacterKey(head)] = head;
+                        _runningSince[head] = DateTime.UtcNow;
+                        return head;
+                    }
+
+                    // Not enough credit for the head request, move on to the next client
+                    _roundRobinIndex++;
+                    _visitCredited = false;
+                }
+
+                return null;
+            }
+        }
+
+        private void Complete(ChatWorkItem item, int tokens, TimeSpan elapsed, bool expired)
+        {
+            var now = DateTime.UtcNow;
+            lock (_lock)
+            {
+                var client = GetClient(item.ClientId, now);
+                client.PendingTokens = Math.Max(0, client.PendingTokens - item.EstimatedTokens);
+                client.Record(now, tokens);
+                if (expired)
+                {
+                    client.Expired++;
+                }
+
+                _running.Remove(CharacterKey(item));
+                _runningSince.Remove(item);
+
+                // Calibrate throughput from requests that ran to completion
+                if (elapsed.TotalMilliseconds >= 50)
+                {
+                    double sample = tokens / elapsed.TotalSeconds;
+                    _tokensPerSecond = _tokensPerSecond <= 0 ? sample : _tokensPerSecond * 0.7 + sample * 0.3;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Earliest time a new request could finish: the client's queued work, the remainder
+        /// of the character's running request and the request itself. Ignores other clients'
+        /// queues, so it never refuses a request that could still make it.
+        /// </summary>
+        private DateTime EstimateCompletion(ClientState client, string character, int cost, DateTime now)
+        {
+            double rate = _tokensPerSecond;
+            if (rate <= 0)
+                return now;
+
+            double tokens = client.PendingTokens + cost;
+            if (_running.TryGetValue(character ?? string.Empty, out var running) && running.ClientId != client.Id)
+            {
+                tokens += Math.Max(0, running.EstimatedTokens - (now - _runningSince[running]).TotalSeconds * rate);
+            }
+
+            return now + TimeSpan.FromSeconds(tokens / rate);
+        }
+
+        /// <summary>
+        /// Time a request would finish if started now
+        /// </summary>
+        private DateTime EstimateFinish(ChatWorkItem item, DateTime now)
+        {
+            double rate = _tokensPerSecond;
+            return rate > 0 ? now + TimeSpan.FromSeconds(item.EstimatedTokens / rate) : now;
+        }
+
+        private static string CharacterKey(ChatWorkItem item)
+        {
+            return item.Character ?? string.Empty;
+        }
+
+        private ClientState GetClient(string clientId, DateTime now)
+        {
+            if (!_clients.TryGetValue(clientId, out var client))
+            {
+                client = new ClientState(clientId);
+                _clients[clientId] = client;
+            }
+            client.LastSeen = now;
+            return client;
+        }
+
+        private void ForgetIdleClients(DateTime now)
+        {
+            var idle = _clients.Values
+                .Where(c => c.Queue.Count == 0 && c.PendingTokens == 0 && now - c.LastSeen > ForgetIdleAfter)
+                .Select(c => c.Id)
+                .ToList();
+
+            foreach (var id in idle)
+            {
+                _clients.Remove(id);
+            }
+        }
+
+        public void Dispose()
+        {
+            // The app's clean-up can run more than once on exit
+            if (_disposed)
+                return;
+            _disposed = true;
+
+            _cancellationTokenSource.Cancel();
+            bool finished;
+            try
+            {
+                finished = _dispatchTask.Wait(TimeSpan.FromSeconds(2));
+            }
+            catch (AggregateException)
+            {
+                finished = true;
+            }
+
+            // A request that ignores cancellation keeps the loop running, and the loop still
+            // uses both; they are left to the GC rather than disposed under it
+            if (finished)
+            {
+                _cancellationTokenSource.Dispose();
+                _signal.Dispose();
+            }
+            else
+            {
+                Logger.LogWarning("Pipeline: Chat dispatch loop did not stop within 2 seconds");
+            }
+        }
+
+        private class ClientState
+        {
+            private readonly Queue<KeyValuePair<DateTime, int>> _window = new Queue<KeyValuePair<DateTime, int>>();
+            private int _windowTokens;
+
+            public ClientState(string id)
+            {
+                Id = id;
+            }
+
+            public string Id { get; }
+            public Queue<ChatWorkItem> Queue { get; } = new Queue<ChatWorkItem>();
+            public int Deficit { get; set; }
+            public int PendingTokens { get; set; }
+            public long TotalTokens { get; private set; }
+            public long Requests { get; private set; }
+            public long Rejected { get; set; }
+            public long Expired { get; set; }
+            public DateTime LastSeen { get; set; }
+
+            public void Record(DateTime now, int tokens)
+            {
+                _window.Enqueue(new KeyValuePair<DateTime, int>(now, tokens));
+                _windowTokens += tokens;
+                TotalTokens += tokens;
+                Requests++;
+            }
+
+            public int TokensInWindow(DateTime now, TimeSpan window)
+            {
+                while (_window.Count > 0 && now - _window.Peek().Key >= window)
+                {
+                    _windowTokens -= _window.Dequeue().Value;
+                }
+                return _windowTokens;
+            }
+
+            /// <summary>
+            /// How long until enough recorded usage ages out of the window to free the given tokens
+            /// </summary>
+            public TimeSpan TimeUntilFree(int tokens, DateTime now, TimeSpan window)
+            {
+                int freed = 0;
+                foreach (var entry in _window)
+                {
+                    freed += entry.Value;
+                    if (freed >= tokens)
+                        return entry.Key + window - now;
+                }
+                return window;
+            }
+        }
+    }
+}
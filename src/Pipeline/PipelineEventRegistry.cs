@@ -0,0 +1,278 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Text;
+using System.Threading;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Maps EVENT:name|key=value|... commands to lines the agent speaks or prompts it sends to the AI.
+    /// Templates use ##key## placeholders (a bare ## is still the user's name) and are parsed once
+    /// when registered. Each template caches what it rendered for a given argument string, so a
+    /// game repeating the same event skips parsing and rendering entirely.
+    /// </summary>
+    public class PipelineEventRegistry
+    {
+        // Rendered results kept per template before its cache is cleared
+        public const int MaxCachedPerTemplate = 256;
+
+        // Per cached render, beside its text: the dictionary node and two strings
+        private const int CacheEntryOverheadBytes = 80;
+
+        private readonly ConcurrentDictionary<string, PipelineEventDefinition> _events = new ConcurrentDictionary<string, PipelineEventDefinition>(StringComparer.OrdinalIgnoreCase);
+        private long _resolved;
+        private long _cacheHits;
+        private long _cacheMisses;
+
+        [ThreadStatic]
+        private static Random _random;
+
+        public int Count => _events.Count;
+        public long Resolved => Interlocked.Read(ref _resolved);
+        public long CacheHits => Interlocked.Read(ref _cacheHits);
+        public long CacheMisses => Interlocked.Read(ref _cacheMisses);
+
+        /// <summary>
+        /// Rough memory held by the render caches
+        /// </summary>
+        public long EstimateCacheBytes()
+        {
+            long bytes = 0;
+            foreach (var template in GetTemplates())
+            {
+                foreach (var entry in template.Cache)
+                {
+                    bytes += CacheEntryOverheadBytes + 2L * (entry.Key.Length + entry.Value.Length);
+                }
+            }
+            return bytes;
+        }
+
+        /// <summary>
+        /// Empties every template's render cache. Returns roughly how much was freed.
+        /// </summary>
+        public long ClearCaches()
+        {
+            long bytes = EstimateCacheBytes();
+            foreach (var template in GetTemplates())
+            {
+                template.Cache.Clear();
+            }
+            return bytes;
+        }
+
+        private IEnumerable<EventTemplate> GetTemplates()
+        {
+            foreach (var definition in _events.Values)
+            {
+                foreach (var line in definition.Lines)
+                {
+                    yield return line;
+                }
+                if (definition.Prompt != null)
+                {
+                    yield return definition.Prompt;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Adds or replaces an event. Either list may be empty, but not both.
+        /// </summary>
+        /// <param name="name">Event name as sent in EVENT:name</param>
+        /// <param name="lines">Lines to pick from at random</param>
+        /// <param name="prompt">AI prompt; used first when set, with the lines as fallback</param>
+        public void Register(string name, IEnumerable<string> lines, string prompt)
+        {
+            if (string.IsNullOrWhiteSpace(name))
+                throw new ArgumentException("Event name is required", nameof(name));
+
+            var templates = new List<EventTemplate>();
+            if (lines != null)
+            {
+                foreach (var line in lines)
+                {
+                    if (!string.IsNullOrWhiteSpace(line))
+                    {
+                        templates.Add(EventTemplate.Parse(line));
+                    }
+                }
+            }
+
+            var promptTemplate = string.IsNullOrWhiteSpace(prompt) ? null : EventTemplate.Parse(prompt);
+            if (templates.Count == 0 && promptTemplate == null)
+                throw new ArgumentException($"Event '{name}' needs at least one line or a prompt");
+
+            _events[name.Trim()] = new PipelineEventDefinition(templates.ToArray(), promptTemplate);
+        }
+
+        public void Clear()
+        {
+            _events.Clear();
+        }
+
+        public bool TryGet(string name, out PipelineEventDefinition definition)
+        {
+            return _events.TryGetValue(name, out definition);
+        }
+
+        /// <summary>
+        /// Renders the event's prompt for the given raw argument string (the part after the first '|')
+        /// </summary>
+        public string RenderPrompt(PipelineEventDefinition definition, string arguments)
+        {
+            Interlocked.Increment(ref _resolved);
+            return Render(definition.Prompt, arguments);
+        }
+
+        /// <summary>
+        /// Picks one of the event's lines at random and renders it for the raw argument string
+        /// </summary>
+        public string RenderLine(PipelineEventDefinition definition, string arguments)
+        {
+            Interlocked.Increment(ref _resolved);
+            var lines = definition.Lines;
+            if (lines.Length == 0)
+                return null;
+
+            var random = _random ?? (_random = new Random(Guid.NewGuid().GetHashCode()));
+            return Render(lines[lines.Length == 1 ? 0 : random.Next(lines.Length)], arguments);
+        }
+
+        private string Render(EventTemplate template, string arguments)
+        {
+            if (!template.HasPlaceholders)
+                return template.Text;
+
+            string key = arguments ?? string.Empty;
+            if (template.Cache.TryGetValue(key, out string rendered))
+            {
+                Interlocked.Increment(ref _cacheHits);
+                return rendered;
+            }
+
+            Interlocked.Increment(ref _cacheMisses);
+            rendered = template.Render(ParseArguments(key));
+
+            // Games with ever-changing values (scores, timers) would otherwise grow this forever
+            if (template.Cache.Count >= MaxCachedPerTemplate)
+            {
+                template.Cache.Clear();
+            }
+            template.Cache[key] = rendered;
+            return rendered;
+        }
+
+        /// <summary>
+        /// Parses key=value|key=value; later duplicates win
+        /// </summary>
+        private static Dictionary<string, string> ParseArguments(string arguments)
+        {
+            var values = new Dictionary<string, string>(StringComparer.OrdinalIgnoreCase);
+            foreach (var pair in arguments.Split('|'))
+            {
+                int equalsIndex = pair.IndexOf('=');
+                if (equalsIndex > 0)
+                {
+                    values[pair.Substring(0, equalsIndex).Trim()] = pair.Substring(equalsIndex + 1).Trim();
+                }
+            }
+            return values;
+        }
+    }
+
+    /// <summary>
+    /// Compiled templates for one event
+    /// </summary>
+    public class PipelineEventDefinition
+    {
+        internal PipelineEventDefinition(EventTemplate[] lines, EventTemplate prompt)
+        {
+            Lines = lines;
+            Prompt = prompt;
+        }
+
+        internal EventTemplate[] Lines { get; }
+        internal EventTemplate Prompt { get; }
+
+        public bool HasLines => Lines.Length > 0;
+        public bool HasPrompt => Prompt != null;
+    }
+
+    /// <summary>
+    /// Template text split into literals and ##key## slots, with its own render cache
+    /// </summary>
+    internal class EventTemplate
+    {
+        private readonly string[] _literals;
+        private readonly string[] _keys;
+
+        private EventTemplate(string text, string[] literals, string[] keys)
+        {
+            Text = text;
+            _literals = literals;
+            _keys = keys;
+        }
+
+        public string Text { get; }
+        public bool HasPlaceholders => _keys.Length > 0;
+
+        /// <summary>
+        /// Rendered text by raw argument string
+        /// </summary>
+        public ConcurrentDictionary<string, string> Cache { get; } = new ConcurrentDictionary<string, string>(StringComparer.Ordinal);
+
+        public static EventTemplate Parse(string text)
+        {
+            var literals = new List<string>();
+            var keys = new List<string>();
+            var literal = new StringBuilder();
+            int i = 0;
+
+            while (i < text.Length)
+            {
+                // ##key## where key is letters, digits or '_'; anything else is left for ProcessText
+                if (text[i] == '#' && i + 1 < text.Length && text[i + 1] == '#')
+                {
+                    int end = i + 2;
+                    while (end < text.Length && (char.IsLetterOrDigit(text[end]) || text[end] == '_'))
+                    {
+                        end++;
+                    }
+                    if (end > i + 2 && end + 1 < text.Length && text[end] == '#' && text[end + 1] == '#')
+                    {
+                        literals.Add(literal.ToString());
+                        literal.Clear();
+                        keys.Add(text.Substring(i + 2, end - i - 2));
+                        i = end + 2;
+                        continue;
+                    }
+                }
+                literal.Append(text[i]);
+                i++;
+            }
+            literals.Add(literal.ToString());
+
+            return new EventTemplate(text, literals.ToArray(), keys.ToArray());
+        }
+
+        /// <summary>
+        /// Fills in the slots; missing keys render as empty text
+        /// </summary>
+        public string Render(Dictionary<string, string> values)
+        {
+            var builder = new StringBuilder(Text.Length + 16);
+            for (int i = 0; i < _keys.Length; i++)
+            {
+                builder.Append(_literals[i]);
+                if (values.TryGetValue(_keys[i], out string value))
+                {
+                    builder.Append(value);
+                }
+            }
+            builder.Append(_literals[_keys.Length]);
+            return builder.ToString();
+        }
+    }
+}
@@ -0,0 +1,639 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Net;
+using System.Net.WebSockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// HTTP and WebSocket front end for the pipeline, for browser overlays and dashboards
+    /// that can't open raw sockets or named pipes.
+    ///
+    /// Routes:
+    /// - POST /command - One command per body line, one response per line
+    /// - GET /stats - Same fields as the STATS command
+    /// - GET /ws - WebSocket; each text message is a command and gets a response message,
+    ///   and agent events are pushed as EVENT:name:data messages
+    ///
+    /// Requests are handled off the accept loop, and every WebSocket has its own bounded
+    /// send queue, so a stalled browser tab is disconnected instead of holding up the others.
+    /// </summary>
+    public class PipelineHttpEndpoint : IDisposable
+    {
+        public const int MaxMessageLength = 8192;
+
+        // Messages allowed to wait for a slow WebSocket before it is dropped
+        private const int SendQueueCapacity = 256;
+        private static readonly TimeSpan KeepAliveInterval = TimeSpan.FromSeconds(30);
+        private static readonly Encoding StrictUtf8 = new UTF8Encoding(false, true);
+
+        private readonly IPAddress _address;
+        private readonly int _port;
+        private readonly Func<string, PipelineConnection, Task<string>> _process;
+        private readonly ConcurrentDictionary<int, WebSocketSession> _sessions = new ConcurrentDictionary<int, WebSocketSession>();
+        private readonly HashSet<string> _allowedOrigins = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+        private HttpListener _listener;
+        private CancellationTokenSource _cancellationTokenSource;
+        private Task _acceptTask;
+        private int _sessionCounter;
+        private volatile bool _draining;
+
+        private long _httpRequests;
+        private long _wsMessages;
+        private long _wsPushed;
+        private long _wsDropped;
+
+        /// <param name="address">Address to listen on; loopback unless the pipeline is configured otherwise</param>
+        /// <param name="port">HTTP port</param>
+        /// <param name="process">Runs one command line for a connection and returns its response</param>
+        public PipelineHttpEndpoint(IPAddress address, int port, Func<string, PipelineConnection, Task<string>> process)
+        {
+            _address = address ?? throw new ArgumentNullException(nameof(address));
+            _port = port;
+            _process = process ?? throw new ArgumentNullException(nameof(process));
+        }
+
+        /// <summary>
+        /// Web page origins allowed besides local files and loopback pages (e.g. "https://overlay.example.com")
+        /// </summary>
+        public void AllowOrigins(IEnumerable<string> origins)
+        {
+            if (origins == null)
+                return;
+
+            foreach (var origin in origins)
+            {
+                if (!string.IsNullOrWhiteSpace(origin))
+                {
+                    _allowedOrigins.Add(origin.Trim().TrimEnd('/'));
+                }
+            }
+        }
+
+        public long HttpRequests => Interlocked.Read(ref _httpRequests);
+        public int WebSocketConnections => _sessions.Count;
+        public int WebSocketTotal => Volatile.Read(ref _sessionCounter);
+        public long WebSocketMessages => Interlocked.Read(ref _wsMessages);
+        public long WebSocketPushed => Interlocked.Read(ref _wsPushed);
+        public long WebSocketDropped => Interlocked.Read(ref _wsDropped);
+
+        /// <summary>
+        /// Called with each request's connection and handler, so the server can drain them on Stop
+        /// </summary>
+        internal Action<PipelineConnection, Task> TrackRequest { get; set; }
+
+        public void Start()
+        {
+            if (_listener != null)
+                return;
+
+            _listener = CreateListener();
+            _cancellationTokenSource = new CancellationTokenSource();
+            var token = _cancellationTokenSource.Token;
+            _acceptTask = Task.Run(() => AcceptLoopAsync(_listener, token));
+        }
+
+        /// <summary>
+        /// Registers the URL prefixes for the configured address and starts listening
+        /// </summary>
+        private HttpListener CreateListener()
+        {
+            var prefixes = new List<string>();
+            if (IPAddress.IsLoopback(_address))
+            {
+                prefixes.Add($"http://localhost:{_port}/");
+                prefixes.Add($"http://127.0.0.1:{_port}/");
+            }
+            else
+            {
+                // Any host name; on Windows this needs a URL reservation (netsh http add urlacl)
+                prefixes.Add($"http://+:{_port}/");
+            }
+
+            var listener = new HttpListener();
+            foreach (var prefix in prefixes)
+            {
+                listener.Prefixes.Add(prefix);
+            }
+
+            try
+            {
+                listener.Start();
+            }
+            catch (HttpListenerException ex) when (prefixes.Count > 1)
+            {
+                // Without a URL reservation Windows only lets normal users register "localhost"
+                Logger.LogWarning($"HTTP Pipeline: Could not register {prefixes[1]} ({ex.Message}), using localhost only");
+                listener.Close();
+                listener = new HttpListener();
+                listener.Prefixes.Add(prefixes[0]);
+                listener.Start();
+            }
+
+            Logger.Log($"HTTP Pipeline: Listening on {string.Join(", ", listener.Prefixes)}");
+            return listener;
+        }
+
+        /// <summary>
+        /// Answers new requests with 503 while the ones already running finish. The listener
+        /// stays open until Stop, since closing it would also cut off their responses.
+        /// </summary>
+        public void BeginDrain()
+        {
+            _draining = true;
+        }
+
+        public void Stop()
+        {
+            var listener = _listener;
+            if (listener == null)
+                return;
+
+            _listener = null;
+            _cancellationTokenSource.Cancel();
+
+            foreach (var session in _sessions.Values)
+            {
+                session.Abort();
+            }
+            _sessions.Clear();
+
+            try
+            {
+                listener.Close();
+                _acceptTask?.Wait(TimeSpan.FromSeconds(2));
+            }
+            catch (Exception)
+            {
+            }
+
+            _cancellationTokenSource.Dispose();
+            _cancellationTokenSource = null;
+
+            Logger.Log("HTTP Pipeline: Stopped");
+        }
+
+        /// <summary>
+        /// Queues a message for every connected WebSocket without waiting for any of them
+        /// </summary>
+        public void Broadcast(string message)
+        {
+            if (_sessions.IsEmpty || string.IsNullOrEmpty(message))
+                return;
+
+            foreach (var session in _sessions.Values)
+            {
+                if (session.TrySend(message))
+                {
+                    Interlocked.Increment(ref _wsPushed);
+                }
+            }
+        }
+
+        private async Task AcceptLoopAsync(HttpListener listener, CancellationToken cancellationToken)
+        {
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                HttpListenerContext context;
+                try
+                {
+                    context = await listener.GetContextAsync();
+                }
+                catch (Exception) when (cancellationToken.IsCancellationRequested || !listener.IsListening)
+                {
+                    break;
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("HTTP Pipeline: Error accepting request", ex);
+                    continue;
+                }
+
+                // Handle each request on its own task so the next one can be accepted right away.
+                // A request counts as one running command until its response is written; a
+                // WebSocket goes idle between messages.
+                var connection = new PipelineConnection(
+                    (context.Request.IsWebSocketRequest ? "ws:" : "http:") + context.Request.RemoteEndPoint);
+                connection.Close = () => TryAbort(context.Response);
+                connection.BeginCommand();
+                var handler = Task.Run(async () =>
+                {
+                    try
+                    {
+                        await HandleContextAsync(context, connection, cancellationToken);
+                    }
+                    catch (Exception ex)
+                    {
+                        Logger.LogError("HTTP Pipeline: Unhandled exception in request handler", ex);
+                        TryAbort(context.Response);
+                    }
+                }, cancellationToken);
+                TrackRequest?.Invoke(connection, handler);
+            }
+        }
+
+        private async Task HandleContextAsync(HttpListenerContext context, PipelineConnection connection, CancellationToken cancellationToken)
+        {
+            var request = context.Request;
+            var response = context.Response;
+            Interlocked.Increment(ref _httpRequests);
+
+            if (_draining)
+            {
+                await WriteTextAsync(response, 503, "ERROR:Server stopping");
+                return;
+            }
+
+            string origin = request.Headers["Origin"];
+            if (!IsOriginAllowed(origin))
+            {
+                Logger.Log($"HTTP Pipeline: Rejected request from origin {origin}");
+                await WriteTextAsync(response, 403, "ERROR:Origin not allowed");
+                return;
+            }
+
+            if (!string.IsNullOrEmpty(origin))
+            {
+                response.AddHeader("Access-Control-Allow-Origin", origin);
+                response.AddHeader("Vary", "Origin");
+            }
+
+            string path = request.Url.AbsolutePath.TrimEnd('/').ToLowerInvariant();
+            switch (path)
+            {
+                case "/ws":
+                    if (!request.IsWebSocketRequest)
+                    {
+                        await WriteTextAsync(response, 400, "ERROR:WebSocket upgrade required");
+                        return;
+                    }
+                    await RunWebSocketAsync(context, connection, cancellationToken);
+                    return;
+
+                case "/command":
+                    if (request.HttpMethod == "OPTIONS")
+                    {
+                        // CORS preflight for fetch() with a JSON or custom content type
+                        response.AddHeader("Access-Control-Allow-Methods", "POST");
+                        response.AddHeader("Access-Control-Allow-Headers", "Content-Type");
+                        response.StatusCode = 204;
+                        response.Close();
+                        return;
+                    }
+                    if (request.HttpMethod != "POST")
+                    {
+                        // Commands change state, so a link or image tag must not be able to send one
+                        response.AddHeader("Allow", "POST");
+                        await WriteTextAsync(response, 405, "ERROR:Use POST");
+                        return;
+                    }
+                    await HandleCommandRequestAsync(context, connection);
+                    return;
+
+                case "/stats":
+                    await WriteTextAsync(response, 200, await _process("STATS", connection));
+                    return;
+
+                default:
+                    await WriteTextAsync(response, 404, "ERROR:Not found");
+                    return;
+            }
+        }
+
+        /// <summary>
+        /// Runs each line of a POST body as a command on one short-lived connection.
+        /// ?session=name gives the request the same quota identity as SESSION:name.
+        /// </summary>
+        private async Task HandleCommandRequestAsync(HttpListenerContext context, PipelineConnection connection)
+        {
+            var request = context.Request;
+
+            if (request.ContentLength64 > MaxMessageLength)
+            {
+                await WriteTextAsync(context.Response, 413, "ERROR:Command too long");
+                return;
+            }
+
+            string body;
+            using (var reader = new StreamReader(request.InputStream, Encoding.UTF8))
+            {
+                var buffer = new char[MaxMessageLength + 1];
+                int total = 0;
+                int read;
+                while (total < buffer.Length && (read = await reader.ReadAsync(buffer, total, buffer.Length - total)) > 0)
+                {
+                    total += read;
+                }
+                if (total > MaxMessageLength)
+                {
+                    await WriteTextAsync(context.Response, 413, "ERROR:Command too long");
+                    return;
+                }
+                body = new string(buffer, 0, total);
+            }
+
+            string session = request.QueryString["session"];
+            if (!string.IsNullOrWhiteSpace(session) && !connection.TrySetSession(session.Trim()))
+            {
+                await WriteTextAsync(context.Response, 400, "ERROR:SESSION names use letters, digits, '-', '_' and '.' (max 64)");
+                return;
+            }
+
+            var responses = new StringBuilder();
+            foreach (var rawLine in body.Split('\n'))
+            {
+                string line = rawLine.TrimEnd('\r');
+                if (line.Length == 0)
+                    continue;
+
+                Logger.Log($"HTTP Pipeline: Received command: {line}");
+                responses.Append(await _process(line, connection)).Append('\n');
+            }
+
+            if (responses.Length == 0)
+            {
+                await WriteTextAsync(context.Response, 400, "ERROR:No command");
+                return;
+            }
+
+            await WriteTextAsync(context.Response, 200, responses.ToString(0, responses.Length - 1));
+        }
+
+        private async Task RunWebSocketAsync(HttpListenerContext context, PipelineConnection connection, CancellationToken cancellationToken)
+        {
+            HttpListenerWebSocketContext wsContext;
+            try
+            {
+                wsContext = await context.AcceptWebSocketAsync(null, KeepAliveInterval);
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("HTTP Pipeline: WebSocket handshake failed", ex);
+                TryAbort(context.Response);
+                return;
+            }
+
+            int sessionId = Interlocked.Increment(ref _sessionCounter);
+            var session = new WebSocketSession(wsContext.WebSocket, this, cancellationToken);
+            _sessions[sessionId] = session;
+            connection.Close = session.Abort;
+            Logger.Log($"WebSocket Pipeline: Client connected from {context.Request.RemoteEndPoint}");
+
+            var sendTask = session.RunSendLoopAsync();
+            try
+            {
+                // The handshake is done; the server may have asked to close meanwhile
+                if (connection.EndCommand())
+                {
+                    await ReceiveLoopAsync(wsContext.WebSocket, session, connection, session.Token);
+                }
+            }
+            catch (Exception ex) when (ex is WebSocketException || ex is OperationCanceledException || ex is ObjectDisposedException)
+            {
+                // Client went away or the server is stopping
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("WebSocket Pipeline: Error handling connection", ex);
+            }
+            finally
+            {
+                _sessions.TryRemove(sessionId, out _);
+                session.Complete();
+                try
+                {
+                    await sendTask;
+                }
+                catch (Exception)
+                {
+                }
+                wsContext.WebSocket.Dispose();
+                session.Dispose();
+                Logger.Log("WebSocket Pipeline: Client disconnected");
+            }
+        }
+
+        private async Task ReceiveLoopAsync(WebSocket socket, WebSocketSession session, PipelineConnection connection, CancellationToken cancellationToken)
+        {
+            var buffer = new byte[MaxMessageLength + 4];
+
+            while (socket.State == WebSocketState.Open && !cancellationToken.IsCancellationRequested)
+            {
+                // Reassemble fragmented messages up to the command size limit
+                int length = 0;
+                WebSocketReceiveResult result;
+                do
+                {
+                    if (length == buffer.Length)
+                    {
+                        Logger.Log("WebSocket Pipeline: Command too long, closing");
+                        await socket.CloseOutputAsync(WebSocketCloseStatus.MessageTooBig, "Command too long", cancellationToken);
+                        return;
+                    }
+                    result = await socket.ReceiveAsync(new ArraySegment<byte>(buffer, length, buffer.Length - length), cancellationToken);
+                    length += result.Count;
+                }
+                while (!result.EndOfMessage && result.MessageType != WebSocketMessageType.Close);
+
+                if (result.MessageType == WebSocketMessageType.Close)
+                {
+                    await socket.CloseOutputAsync(WebSocketCloseStatus.NormalClosure, null, cancellationToken);
+                    return;
+                }
+
+                string line;
+                try
+                {
+                    line = result.MessageType == WebSocketMessageType.Text
+                        ? StrictUtf8.GetString(buffer, 0, length).TrimEnd('\r', '\n')
+                        : null;
+                }
+                catch (DecoderFallbackException)
+                {
+                    line = null;
+                }
+
+                if (string.IsNullOrEmpty(line) || line.Length > MaxMessageLength)
+                {
+                    session.TrySend("ERROR:Expected one text command");
+                    continue;
+                }
+
+                // The server is shutting down and has stopped taking commands
+                if (!connection.BeginCommand())
+                    return;
+
+                Interlocked.Increment(ref _wsMessages);
+                Logger.Log($"WebSocket Pipeline: Received command: {line}");
+
+                session.TrySend(await _process(line, connection));
+
+                // Stop asked this session to close while the command ran; the send loop
+                // still flushes the response
+                if (!connection.EndCommand())
+                    return;
+            }
+        }
+
+        /// <summary>
+        /// Loopback pages may always connect; other web pages only when listed. Requests without
+        /// an Origin come from scripts and tools rather than browsers. "null" is sent by local
+        /// files but also by sandboxed frames on any site, so it has to be listed as well.
+        /// </summary>
+        private bool IsOriginAllowed(string origin)
+        {
+            if (string.IsNullOrEmpty(origin))
+                return true;
+
+            if (origin.StartsWith("file://", StringComparison.OrdinalIgnoreCase))
+                return true;
+
+            if (Uri.TryCreate(origin, UriKind.Absolute, out var uri)
+                && (uri.IsLoopback || uri.Host.Equals("localhost", StringComparison.OrdinalIgnoreCase)))
+                return true;
+
+            return _allowedOrigins.Contains(origin.TrimEnd('/'));
+        }
+
+        private static async Task WriteTextAsync(HttpListenerResponse response, int statusCode, string text)
+        {
+            try
+            {
+                byte[] bytes = Encoding.UTF8.GetBytes(text ?? string.Empty);
+                response.StatusCode = statusCode;
+                response.ContentType = "text/plain; charset=utf-8";
+                response.ContentLength64 = bytes.Length;
+                await response.OutputStream.WriteAsync(bytes, 0, bytes.Length);
+                response.Close();
+            }
+            catch (Exception ex) when (ex is HttpListenerException || ex is IOException || ex is ObjectDisposedException)
+            {
+                // Client disconnected before the response was written
+                TryAbort(response);
+            }
+        }
+
+        private static void TryAbort(HttpListenerResponse response)
+        {
+            try
+            {
+                response.Abort();
+            }
+            catch (Exception)
+            {
+            }
+        }
+
+        public void Dispose()
+        {
+            Stop();
+        }
+
+        /// <summary>
+        /// One WebSocket's outgoing messages. Responses and pushed events share a queue
+        /// drained by a single sender, since a WebSocket allows only one send at a time.
+        /// </summary>
+        private class WebSocketSession : IDisposable
+        {
+            private readonly WebSocket _socket;
+            private readonly PipelineHttpEndpoint _owner;
+            private readonly CancellationTokenSource _abort;
+            private readonly ConcurrentQueue<string> _queue = new ConcurrentQueue<string>();
+            private readonly SemaphoreSlim _queued = new SemaphoreSlim(0);
+            private int _queueLength;
+            private volatile bool _completed;
+
+            public WebSocketSession(WebSocket socket, PipelineHttpEndpoint owner, CancellationToken serverToken)
+            {
+                _socket = socket;
+                _owner = owner;
+                _abort = CancellationTokenSource.CreateLinkedTokenSource(serverToken);
+            }
+
+            /// <summary>
+            /// Cancelled when the session is aborted or the server stops
+            /// </summary>
+            public CancellationToken Token => _abort.Token;
+
+            /// <summary>
+            /// Queues a message, or aborts the socket if the client has stopped reading
+            /// </summary>
+            public bool TrySend(string message)
+            {
+                if (_completed)
+                    return false;
+
+                if (Interlocked.Increment(ref _queueLength) > SendQueueCapacity)
+                {
+                    Interlocked.Decrement(ref _queueLength);
+                    Interlocked.Increment(ref _owner._wsDropped);
+                    Logger.Log("WebSocket Pipeline: Client is not reading, disconnecting");
+                    Abort();
+                    return false;
+                }
+
+                _queue.Enqueue(message);
+                _queued.Release();
+                return true;
+            }
+
+            public async Task RunSendLoopAsync()
+            {
+                var cancellationToken = _abort.Token;
+                while (true)
+                {
+                    await _queued.WaitAsync(cancellationToken);
+                    if (!_queue.TryDequeue(out var message))
+                    {
+                        // Woken by Complete with nothing left to send
+                        if (_completed)
+                            return;
+                        continue;
+                    }
+                    Interlocked.Decrement(ref _queueLength);
+
+                    if (_socket.State != WebSocketState.Open)
+                        continue;
+
+                    byte[] bytes = Encoding.UTF8.GetBytes(message);
+                    await _socket.SendAsync(new ArraySegment<byte>(bytes), WebSocketMessageType.Text, true, cancellationToken);
+                }
+            }
+
+            /// <summary>
+            /// Stops accepting messages and lets the send loop finish
+            /// </summary>
+            public void Complete()
+            {
+                _completed = true;
+                _queued.Release();
+            }
+
+            public void Abort()
+            {
+                _completed = true;
+                try
+                {
+                    // Cancelling pending operations also aborts the socket, which wakes both loops
+                    _abort.Cancel();
+                    _socket.Abort();
+                }
+                catch (Exception)
+                {
+                }
+            }
+
+            public void Dispose()
+            {
+                // The semaphore is left to the GC: a broadcast may still be releasing it
+                _abort.Dispose();
+            }
+        }
+    }
+}
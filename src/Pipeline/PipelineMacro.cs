@@ -0,0 +1,207 @@
+using System;
+using System.Collections.Generic;
+using System.Text;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// A named command sequence defined with DEFINE:name=step|step|... and run with RUN:name|arg|arg.
+    /// Steps are parsed once when the macro is defined; running it only fills {1}..{9} into
+    /// the prepared data templates, so each step skips the command parser.
+    /// </summary>
+    public class PipelineMacro
+    {
+        public const int MaxSteps = 32;
+        public const int MaxParameters = 9;
+
+        private PipelineMacro(string name, string definition, MacroStep[] steps, int parameterCount)
+        {
+            Name = name;
+            Definition = definition;
+            Steps = steps;
+            ParameterCount = parameterCount;
+        }
+
+        public string Name { get; }
+
+        /// <summary>
+        /// Source text after the '=', as persisted in settings
+        /// </summary>
+        public string Definition { get; }
+
+        public IReadOnlyList<MacroStep> Steps { get; }
+
+        /// <summary>
+        /// Highest {n} placeholder used; RUN must supply at least this many arguments
+        /// </summary>
+        public int ParameterCount { get; }
+
+        /// <summary>
+        /// Parses a macro definition into ready-to-dispatch steps
+        /// </summary>
+        public static bool TryCompile(string name, string definition, out PipelineMacro macro, out string error)
+        {
+            macro = null;
+            error = null;
+
+            if (!IsValidName(name))
+            {
+                error = "macro names use letters, digits, '-' and '_' (max 64)";
+                return false;
+            }
+            if (string.IsNullOrWhiteSpace(definition))
+            {
+                error = "macro has no steps";
+                return false;
+            }
+
+            var steps = new List<MacroStep>();
+            int parameterCount = 0;
+            foreach (var part in definition.Split('|'))
+            {
+                if (string.IsNullOrWhiteSpace(part))
+                    continue;
+
+                PipelineServer.ParseCommandLine(part.Trim(), out string command, out string target, out string options, out string data);
+                if (command.Length == 0 || command == "DEFINE" || command == "RUN")
+                {
+                    error = $"step '{part.Trim()}' is not allowed in a macro";
+                    return false;
+                }
+
+                var template = MacroTemplate.Parse(data, ref parameterCount);
+                steps.Add(new MacroStep(command, target, options, template));
+            }
+
+            if (steps.Count == 0)
+            {
+                error = "macro has no steps";
+                return false;
+            }
+            if (steps.Count > MaxSteps)
+            {
+                error = $"macros are limited to {MaxSteps} steps";
+                return false;
+            }
+
+            macro = new PipelineMacro(name, definition, steps.ToArray(), parameterCount);
+            return true;
+        }
+
+        private static bool IsValidName(string name)
+        {
+            if (string.IsNullOrEmpty(name) || name.Length > 64)
+                return false;
+
+            foreach (char c in name)
+            {
+                if (!char.IsLetterOrDigit(c) && c != '-' && c != '_')
+                    return false;
+            }
+            return true;
+        }
+    }
+
+    /// <summary>
+    /// One pre-parsed step of a macro
+    /// </summary>
+    public class MacroStep
+    {
+        public MacroStep(string command, string target, string options, MacroTemplate data)
+        {
+            Command = command;
+            Target = target;
+            Options = options;
+            Data = data;
+        }
+
+        /// <summary>
+        /// Upper-case command name, as the dispatcher expects it
+        /// </summary>
+        public string Command { get; }
+
+        /// <summary>
+        /// Character named with COMMAND@Name, or null to act on the one the macro runs for
+        /// </summary>
+        public string Target { get; }
+
+        public string Options { get; }
+
+        /// <summary>
+        /// Data with placeholders, or null for commands without data
+        /// </summary>
+        public MacroTemplate Data { get; }
+    }
+
+    /// <summary>
+    /// Step data split into literal text and {n} argument slots
+    /// </summary>
+    public class MacroTemplate
+    {
+        private readonly string[] _literals;
+        private readonly int[] _slots;
+        private readonly int _literalLength;
+
+        private MacroTemplate(string[] literals, int[] slots)
+        {
+            _literals = literals;
+            _slots = slots;
+            foreach (var literal in literals)
+            {
+                _literalLength += literal.Length;
+            }
+        }
+
+        /// <summary>
+        /// Parses {1}..{9} placeholders; anything else in braces is kept as text
+        /// </summary>
+        public static MacroTemplate Parse(string text, ref int parameterCount)
+        {
+            if (text == null)
+                return null;
+
+            var literals = new List<string>();
+            var slots = new List<int>();
+            int start = 0;
+
+            for (int i = 0; i + 2 < text.Length; i++)
+            {
+                if (text[i] == '{' && text[i + 2] == '}' && text[i + 1] >= '1' && text[i + 1] <= '0' + PipelineMacro.MaxParameters)
+                {
+                    int slot = text[i + 1] - '1';
+                    literals.Add(text.Substring(start, i - start));
+                    slots.Add(slot);
+                    parameterCount = Math.Max(parameterCount, slot + 1);
+                    start = i + 3;
+                    i += 2;
+                }
+            }
+            literals.Add(text.Substring(start));
+
+            return new MacroTemplate(literals.ToArray(), slots.ToArray());
+        }
+
+        /// <summary>
+        /// Fills in the arguments; the caller has checked there are enough
+        /// </summary>
+        public string Render(string[] arguments)
+        {
+            if (_slots.Length == 0)
+                return _literals[0];
+
+            int length = _literalLength;
+            foreach (int slot in _slots)
+            {
+                length += arguments[slot].Length;
+            }
+
+            var builder = new StringBuilder(length);
+            for (int i = 0; i < _slots.Length; i++)
+            {
+                builder.Append(_literals[i]).Append(arguments[_slots[i]]);
+            }
+            builder.Append(_literals[_slots.Length]);
+            return builder.ToString();
+        }
+    }
+}
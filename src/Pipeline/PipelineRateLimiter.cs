@@ -0,0 +1,230 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Threading;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// What to do with a command over its rate limit
+    /// </summary>
+    public enum RateLimitPolicy
+    {
+        /// <summary>
+        /// Answer ERROR:RATE with how long to wait
+        /// </summary>
+        Reject,
+
+        /// <summary>
+        /// Hold the command until it fits, up to MaxDelay; reject if it would take longer
+        /// </summary>
+        Delay,
+
+        /// <summary>
+        /// Discard the command and answer DROPPED, for fire-and-forget senders
+        /// </summary>
+        Drop
+    }
+
+    /// <summary>
+    /// Outcome of a rate limit check
+    /// </summary>
+    public enum RateDecision
+    {
+        Allowed,
+        Delayed,
+        Rejected,
+        Dropped
+    }
+
+    /// <summary>
+    /// Per-connection and global token buckets for pipeline commands. Each command costs
+    /// tokens (CHAT far more than PING); a command runs only if both its connection's bucket
+    /// and the global one can pay. Checks are lock-free: a dictionary lookup for the cost and
+    /// a compare-and-swap per bucket.
+    /// </summary>
+    public class PipelineRateLimiter
+    {
+        /// <summary>
+        /// Default cost of commands not in the table
+        /// </summary>
+        public const int DefaultCost = 4;
+
+        private static readonly Dictionary<string, int> DefaultCosts = new Dictionary<string, int>(StringComparer.OrdinalIgnoreCase)
+        {
+            ["PING"] = 1,
+            ["VERSION"] = 1,
+            ["STATS"] = 1,
+            ["STATE"] = 1,
+            ["QUERY"] = 1,
+            ["SESSION"] = 1,
+            ["TTL"] = 1,
+            ["MACROS"] = 1,
+            ["CHARACTERS"] = 1,
+            ["CHAT"] = 40,
+            ["POKE"] = 40
+        };
+
+        private volatile Limits _limits;
+        private long _allowed;
+        private long _delayed;
+        private long _rejected;
+        private long _dropped;
+
+        /// <param name="perConnectionRate">Tokens per second for each connection, 0 = unlimited</param>
+        /// <param name="globalRate">Tokens per second shared by all connections, 0 = unlimited</param>
+        /// <param name="burstSeconds">How many seconds of tokens a quiet connection can spend at once</param>
+        public PipelineRateLimiter(double perConnectionRate, double globalRate, double burstSeconds = 2)
+        {
+            Configure(perConnectionRate, globalRate, burstSeconds);
+        }
+
+        public RateLimitPolicy Policy { get; set; } = RateLimitPolicy.Delay;
+
+        /// <summary>
+        /// Longest a command is held under the Delay policy
+        /// </summary>
+        public TimeSpan MaxDelay { get; set; } = TimeSpan.FromMilliseconds(250);
+
+        public long Allowed => Interlocked.Read(ref _allowed);
+        public long Delayed => Interlocked.Read(ref _delayed);
+        public long Rejected => Interlocked.Read(ref _rejected);
+        public long Dropped => Interlocked.Read(ref _dropped);
+
+        /// <summary>
+        /// Changes the rates. Connections pick up new buckets on their next command.
+        /// </summary>
+        public void Configure(double perConnectionRate, double globalRate, double burstSeconds)
+        {
+            burstSeconds = Math.Max(0.1, burstSeconds);
+            var current = _limits;
+            var global = current?.Global;
+            if (globalRate <= 0)
+            {
+                global = null;
+            }
+            else if (global == null || global.TokensPerSecond != globalRate || global.Capacity != Math.Max(1, globalRate * burstSeconds))
+            {
+                global = new TokenBucket(globalRate, globalRate * burstSeconds);
+            }
+
+            _limits = new Limits
+            {
+                PerConnectionRate = Math.Max(0, perConnectionRate),
+                BurstSeconds = burstSeconds,
+                Global = global,
+                Costs = current?.Costs ?? DefaultCosts
+            };
+        }
+
+        /// <summary>
+        /// Replaces the cost table. Commands not listed keep their built-in cost.
+        /// </summary>
+        public void SetCosts(IDictionary<string, int> costs)
+        {
+            var table = new Dictionary<string, int>(DefaultCosts, StringComparer.OrdinalIgnoreCase);
+            if (costs != null)
+            {
+                foreach (var entry in costs)
+                {
+                    table[entry.Key.Trim()] = Math.Max(0, entry.Value);
+                }
+            }
+
+            var current = _limits;
+            _limits = new Limits
+            {
+                PerConnectionRate = current.PerConnectionRate,
+                BurstSeconds = current.BurstSeconds,
+                Global = current.Global,
+                Costs = table
+            };
+        }
+
+        /// <summary>
+        /// Token cost of one command (upper-case name)
+        /// </summary>
+        public int GetCost(string command)
+        {
+            return _limits.Costs.TryGetValue(command, out int cost) ? cost : DefaultCost;
+        }
+
+        /// <summary>
+        /// Charges a command to its connection and to the global bucket. When the result is
+        /// Delayed, the caller must wait out the returned time before running the command;
+        /// when Rejected, it is how long until the command would fit.
+        /// </summary>
+        public RateDecision Acquire(PipelineConnection connection, int cost, out TimeSpan wait)
+        {
+            wait = TimeSpan.Zero;
+            if (cost <= 0)
+                return RateDecision.Allowed;
+
+            var limits = _limits;
+            var policy = Policy;
+            long now = Stopwatch.GetTimestamp();
+            long maxWait = policy == RateLimitPolicy.Delay ? MaxDelay.Ticks * Stopwatch.Frequency / TimeSpan.TicksPerSecond : 0;
+            long connectionWait = 0;
+            long globalWait = 0;
+
+            TokenBucket bucket = null;
+            if (limits.PerConnectionRate > 0)
+            {
+                // Rebuilt after Configure; a race only costs one connection a fresh bucket
+                bucket = connection.RateBucket;
+                double capacity = Math.Max(1, limits.PerConnectionRate * limits.BurstSeconds);
+                if (bucket == null || bucket.TokensPerSecond != limits.PerConnectionRate || bucket.Capacity != capacity)
+                {
+                    bucket = new TokenBucket(limits.PerConnectionRate, capacity);
+                    connection.RateBucket = bucket;
+                }
+
+                if (!bucket.TryTake(cost, now, maxWait, out connectionWait))
+                    return OverLimit(policy, connectionWait, out wait);
+            }
+
+            if (limits.Global != null && !limits.Global.TryTake(cost, now, maxWait, out globalWait))
+            {
+                bucket?.Return(cost);
+                return OverLimit(policy, globalWait, out wait);
+            }
+
+            long waitTicks = Math.Max(connectionWait, globalWait);
+            if (waitTicks > 0)
+            {
+                wait = TimeSpan.FromTicks(waitTicks * TimeSpan.TicksPerSecond / Stopwatch.Frequency);
+                Interlocked.Increment(ref _delayed);
+                return RateDecision.Delayed;
+            }
+
+            Interlocked.Increment(ref _allowed);
+            return RateDecision.Allowed;
+        }
+
+        private RateDecision OverLimit(RateLimitPolicy policy, long waitTicks, out TimeSpan wait)
+        {
+            wait = TimeSpan.FromTicks(waitTicks * TimeSpan.TicksPerSecond / Stopwatch.Frequency);
+            if (policy == RateLimitPolicy.Drop)
+            {
+                Interlocked.Increment(ref _dropped);
+                return RateDecision.Dropped;
+            }
+
+            Interlocked.Increment(ref _rejected);
+            return RateDecision.Rejected;
+        }
+
+        public string FormatStats()
+        {
+            return $"rate.allowed={Allowed};rate.delayed={Delayed};rate.rejected={Rejected};rate.dropped={Dropped}";
+        }
+
+        private class Limits
+        {
+            public double PerConnectionRate;
+            public double BurstSeconds;
+            public TokenBucket Global;
+            public Dictionary<string, int> Costs;
+        }
+    }
+}
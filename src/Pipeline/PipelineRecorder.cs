@@ -0,0 +1,331 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Text;
+using System.Threading;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Records every command that reaches ProcessCommand, with its arrival time and connection,
+    /// to a compact binary log that tools/PipelineReplay can play back. Callers only stamp and
+    /// queue the command; a background thread does the encoding and file writes.
+    ///
+    /// File layout (integers marked varint are LEB128):
+    ///   header:  "MSPL" | byte version | int64 start time (Unix ms, little endian)
+    ///   records: byte type, then
+    ///     1 = connection: varint index | string id
+    ///     2 = command:    varint microseconds since the start | varint connection index | string line
+    ///   strings: varint byte length | UTF-8 bytes
+    /// Commands are stamped on their connection's thread and can reach the writer slightly out of
+    /// order, so each carries its own offset rather than a gap that would have to be clamped.
+    /// Version 1 files stored the gap since the previous command instead.
+    /// </summary>
+    public sealed class PipelineRecorder : IDisposable
+    {
+        public const int Version = 2;
+        internal static readonly byte[] Magic = { (byte)'M', (byte)'S', (byte)'P', (byte)'L' };
+        internal const byte ConnectionRecord = 1;
+        internal const byte CommandRecord = 2;
+
+        // Commands allowed to wait for the writer before new ones are dropped
+        private const int QueueCapacity = 8192;
+
+        private readonly BlockingCollection<Entry> _queue = new BlockingCollection<Entry>(QueueCapacity);
+        private readonly Stream _stream;
+        private readonly Thread _writer;
+        private readonly long _startTimestamp;
+        private long _recorded;
+        private long _dropped;
+        private long _bytes;
+
+        /// <summary>
+        /// Creates (or overwrites) the log file and starts the writer
+        /// </summary>
+        public PipelineRecorder(string path)
+        {
+            Path = path;
+            _stream = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.Read, 64 * 1024);
+
+            var header = new byte[Magic.Length + 1 + 8];
+            Magic.CopyTo(header, 0);
+            header[Magic.Length] = Version;
+            long startMs = (long)(DateTime.UtcNow - new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc)).TotalMilliseconds;
+            _startTimestamp = Stopwatch.GetTimestamp();
+            for (int i = 0; i < 8; i++)
+            {
+                header[Magic.Length + 1 + i] = (byte)(startMs >> (8 * i));
+            }
+            _stream.Write(header, 0, header.Length);
+            _bytes = header.Length;
+
+            _writer = new Thread(WriteLoop) { IsBackground = true, Name = "Pipeline recorder" };
+            _writer.Start();
+            Logger.Log($"Pipeline: Recording commands to {path}");
+        }
+
+        public string Path { get; }
+        public long Recorded => Interlocked.Read(ref _recorded);
+        public long Dropped => Interlocked.Read(ref _dropped);
+        public long Bytes => Interlocked.Read(ref _bytes);
+
+        /// <summary>
+        /// Queues a command. Never blocks; if the writer has fallen behind the command is counted as dropped.
+        /// </summary>
+        public void Record(string connectionId, string line)
+        {
+            var entry = new Entry { Timestamp = Stopwatch.GetTimestamp(), ConnectionId = connectionId, Line = line };
+            try
+            {
+                if (!_queue.TryAdd(entry))
+                {
+                    Interlocked.Increment(ref _dropped);
+                }
+            }
+            catch (InvalidOperationException)
+            {
+                // Recorder is shutting down
+            }
+        }
+
+        private void WriteLoop()
+        {
+            var connections = new Dictionary<string, int>();
+            var buffer = new MemoryStream(256);
+
+            try
+            {
+                foreach (var entry in _queue.GetConsumingEnumerable())
+                {
+                    buffer.SetLength(0);
+
+                    if (!connections.TryGetValue(entry.ConnectionId, out int index))
+                    {
+                        index = connections.Count;
+                        connections[entry.ConnectionId] = index;
+                        buffer.WriteByte(ConnectionRecord);
+                        WriteVarint(buffer, (ulong)index);
+                        WriteString(buffer, entry.ConnectionId);
+                    }
+
+                    long offset = (entry.Timestamp - _startTimestamp) * 1000000 / Stopwatch.Frequency;
+
+                    buffer.WriteByte(CommandRecord);
+                    WriteVarint(buffer, (ulong)Math.Max(0, offset));
+                    WriteVarint(buffer, (ulong)index);
+                    WriteString(buffer, entry.Line);
+
+                    _stream.Write(buffer.GetBuffer(), 0, (int)buffer.Length);
+                    Interlocked.Add(ref _bytes, buffer.Length);
+                    Interlocked.Increment(ref _recorded);
+
+                    // Keep the file current while traffic is light, so a crash loses little
+                    if (_queue.Count == 0)
+                    {
+                        _stream.Flush();
+                    }
+                }
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError($"Pipeline: Recording to {Path} failed", ex);
+            }
+        }
+
+        internal static void WriteVarint(Stream stream, ulong value)
+        {
+            while (value >= 0x80)
+            {
+                stream.WriteByte((byte)(value | 0x80));
+                value >>= 7;
+            }
+            stream.WriteByte((byte)value);
+        }
+
+        private static void WriteString(Stream stream, string value)
+        {
+            var bytes = Encoding.UTF8.GetBytes(value ?? string.Empty);
+            WriteVarint(stream, (ulong)bytes.Length);
+            stream.Write(bytes, 0, bytes.Length);
+        }
+
+        /// <summary>
+        /// Writes what is queued and closes the file
+        /// </summary>
+        public void Dispose()
+        {
+            if (_queue.IsAddingCompleted)
+                return;
+
+            _queue.CompleteAdding();
+            _writer.Join(TimeSpan.FromSeconds(5));
+            _stream.Dispose();
+            Logger.Log($"Pipeline: Recorded {Recorded} commands to {Path} ({Dropped} dropped)");
+        }
+
+        private struct Entry
+        {
+            public long Timestamp;
+            public string ConnectionId;
+            public string Line;
+        }
+    }
+
+    /// <summary>
+    /// One command from a recording
+    /// </summary>
+    public class RecordedCommand
+    {
+        /// <summary>
+        /// Arrival time since recording started (since the first command in version 1 files).
+        /// Commands that arrived close together on different connections may be slightly out of order.
+        /// </summary>
+        public TimeSpan Offset { get; set; }
+
+        public string ConnectionId { get; set; }
+        public string Line { get; set; }
+    }
+
+    /// <summary>
+    /// Reads a log written by PipelineRecorder
+    /// </summary>
+    public sealed class PipelineRecording : IDisposable
+    {
+        // Far above any command the transports accept; guards against a corrupt length
+        private const int MaxStringLength = 1 << 20;
+
+        private readonly Stream _stream;
+        private readonly int _version;
+
+        public PipelineRecording(string path)
+        {
+            _stream = new BufferedStream(File.OpenRead(path), 64 * 1024);
+
+            var header = new byte[PipelineRecorder.Magic.Length + 1 + 8];
+            if (_stream.Read(header, 0, header.Length) != header.Length || !StartsWithMagic(header))
+                throw new InvalidDataException($"{path} is not a pipeline recording");
+            _version = header[PipelineRecorder.Magic.Length];
+            if (_version < 1 || _version > PipelineRecorder.Version)
+                throw new InvalidDataException($"{path} is recording version {_version}, expected 1 to {PipelineRecorder.Version}");
+
+            long startMs = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                startMs = (startMs << 8) | header[PipelineRecorder.Magic.Length + 1 + i];
+            }
+            StartedAt = new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc).AddMilliseconds(startMs);
+        }
+
+        /// <summary>
+        /// When recording started (UTC)
+        /// </summary>
+        public DateTime StartedAt { get; }
+
+        /// <summary>
+        /// Reads the commands in order. A log cut short by a crash ends at its last complete record.
+        /// </summary>
+        public IEnumerable<RecordedCommand> ReadCommands()
+        {
+            var connections = new List<string>();
+            long offsetUs = 0;
+
+            while (true)
+            {
+                int type = _stream.ReadByte();
+                if (type < 0)
+                    yield break;
+
+                RecordedCommand command = null;
+                try
+                {
+                    if (type == PipelineRecorder.ConnectionRecord)
+                    {
+                        int index = (int)ReadVarint();
+                        string id = ReadString();
+                        while (connections.Count <= index)
+                        {
+                            connections.Add(null);
+                        }
+                        connections[index] = id;
+                    }
+                    else if (type == PipelineRecorder.CommandRecord)
+                    {
+                        // Version 1 stored the gap since the previous command
+                        long value = (long)ReadVarint();
+                        offsetUs = _version == 1 ? offsetUs + value : value;
+                        int index = (int)ReadVarint();
+                        string line = ReadString();
+                        command = new RecordedCommand
+                        {
+                            Offset = TimeSpan.FromTicks(offsetUs * 10),
+                            ConnectionId = index < connections.Count ? connections[index] : "unknown",
+                            Line = line
+                        };
+                    }
+                    else
+                    {
+                        throw new InvalidDataException($"Unknown record type {type}");
+                    }
+                }
+                catch (EndOfStreamException)
+                {
+                    yield break;
+                }
+
+                if (command != null)
+                    yield return command;
+            }
+        }
+
+        private ulong ReadVarint()
+        {
+            ulong value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                int b = _stream.ReadByte();
+                if (b < 0)
+                    throw new EndOfStreamException();
+                value |= (ulong)(b & 0x7F) << shift;
+                if (b < 0x80)
+                    return value;
+            }
+            throw new InvalidDataException("Varint too long");
+        }
+
+        private string ReadString()
+        {
+            ulong length64 = ReadVarint();
+            if (length64 > MaxStringLength)
+                throw new InvalidDataException($"String of {length64} bytes in recording");
+            int length = (int)length64;
+            var bytes = new byte[length];
+            int read = 0;
+            while (read < length)
+            {
+                int n = _stream.Read(bytes, read, length - read);
+                if (n <= 0)
+                    throw new EndOfStreamException();
+                read += n;
+            }
+            return Encoding.UTF8.GetString(bytes);
+        }
+
+        private static bool StartsWithMagic(byte[] header)
+        {
+            for (int i = 0; i < PipelineRecorder.Magic.Length; i++)
+            {
+                if (header[i] != PipelineRecorder.Magic[i])
+                    return false;
+            }
+            return true;
+        }
+
+        public void Dispose()
+        {
+            _stream.Dispose();
+        }
+    }
+}
@@ -1,8 +1,12 @@
 using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
 using System.IO.Pipes;
 using System.Net;
 using System.Net.Sockets;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Threading;
 using System.Threading.Tasks;
@@ -12,7 +16,10 @@ namespace MSAgentAI.Pipeline
 {
     /// <summary>
     /// Pipeline server for external application communication.
-    /// Supports both Named Pipes (local) and TCP sockets (network).
+    /// Supports both Named Pipes (local) and TCP sockets (network), plus an optional
+    /// UDP port that takes one command per datagram with no response, an optional
+    /// shared-memory ring for same-machine mods and an optional HTTP/WebSocket
+    /// endpoint for browser sources.
     /// Games and scripts can connect to send commands.
     /// 
     /// Protocol:
@@ -22,6 +29,21 @@ namespace MSAgentAI.Pipeline
     /// - HIDE - Hide the agent
     /// - SHOW - Show the agent
     /// - POKE - Trigger random AI dialog
+    /// - SESSION:name - Name this client so its quota survives reconnects
+    /// - TTL:ms - Default deadline for this connection's CHAT commands (0 = none)
+    /// - STATS - Server and per-client usage statistics
+    /// - DEFINE:name=step|step - Store a macro (steps may use {1}..{9}); DEFINE:name= deletes it
+    /// - RUN:name|arg|arg - Run a macro as one uninterrupted agent sequence
+    /// - MACROS - List defined macro names
+    /// - EVENT:name|key=value|key=value - Speak a line (or ask the AI) configured for a game event
+    /// - STATE - Agent state (visibility, position, current request, queue depth, character)
+    /// - QUERY:key - One field of the agent state
+    /// - CHARACTERS - Names of the loaded characters, the default one first
+    /// 
+    /// Commands may carry options after the name: CHAT;ttl=5000:prompt gives the
+    /// request 5 seconds, CHAT;deadline=1700000000000:prompt an absolute Unix-ms deadline.
+    /// With several characters loaded, COMMAND@Name addresses one of them (SPEAK@Merlin:Hi,
+    /// CHAT@Merlin;ttl=5000:prompt); each character is sequenced and queued on its own.
     /// </summary>
     public class PipelineServer : IDisposable
     {
@@ -31,6 +53,25 @@ namespace MSAgentAI.Pipeline
         private Task _serverTask;
         private bool _isRunning;
         private TcpListener _tcpListener;
+        private UdpCommandListener _udpListener;
+        private PipelineHttpEndpoint _httpEndpoint;
+        private RingCommandListener _ringListener;
+        private PipelineConnection _ringConnection;
+        private volatile PipelineRecorder _recorder;
+        private volatile PipelineEventRegistry _eventRegistry = new PipelineEventRegistry();
+        
+        // Open pipe and TCP connections and the tasks serving them, so Stop can drain them
+        private readonly ConcurrentDictionary<PipelineConnection, Task> _connections = new ConcurrentDictionary<PipelineConnection, Task>();
+        
+        // Serializes Start, Stop and Restart
+        private readonly object _lifecycleLock = new object();
+        
+        // UDP senders, so SESSION/TTL and quotas stick to a source endpoint
+        private readonly ConcurrentDictionary<string, PipelineConnection> _udpSources = new ConcurrentDictionary<string, PipelineConnection>();
+        private const int MaxUdpSources = 256;
+        
+        // A UDP sender quiet for this long is forgotten first when the table is full
+        private static readonly TimeSpan UdpSourceIdleTimeout = TimeSpan.FromMinutes(10);
         
         // Configuration
         private string _protocol;
@@ -38,43 +79,173 @@ namespace MSAgentAI.Pipeline
         private int _port;
         private string _pipeName;
         
+        // Macros by name, compiled when defined
+        private readonly ConcurrentDictionary<string, PipelineMacro> _macros = new ConcurrentDictionary<string, PipelineMacro>(StringComparer.OrdinalIgnoreCase);
+        private const int MaxMacros = 256;
+        
+        // Held per character while a command reaches it, so a RUN sequence isn't interleaved with
+        // other clients' commands for the same character; other characters carry on meanwhile
+        private readonly ConcurrentDictionary<string, object> _sequenceLocks = new ConcurrentDictionary<string, object>(StringComparer.OrdinalIgnoreCase);
+        
+        // Statistics
+        private int _connectionCounter;
+        private int _activeConnections;
+        private long _commandsProcessed;
+        
         /// <summary>
         /// Event raised when a SPEAK command is received
         /// </summary>
-        public event EventHandler<string> OnSpeakCommand;
+        public event EventHandler<PipelineCommand> OnSpeakCommand;
         
         /// <summary>
         /// Event raised when an ANIMATION command is received
         /// </summary>
-        public event EventHandler<string> OnAnimationCommand;
+        public event EventHandler<PipelineCommand> OnAnimationCommand;
         
         /// <summary>
         /// Event raised when a CHAT command is received
         /// </summary>
-        public event EventHandler<string> OnChatCommand;
+        public event EventHandler<PipelineCommand> OnChatCommand;
         
         /// <summary>
         /// Event raised when a HIDE command is received
         /// </summary>
-        public event EventHandler OnHideCommand;
+        public event EventHandler<PipelineCommand> OnHideCommand;
         
         /// <summary>
         /// Event raised when a SHOW command is received
         /// </summary>
-        public event EventHandler OnShowCommand;
+        public event EventHandler<PipelineCommand> OnShowCommand;
         
         /// <summary>
         /// Event raised when a POKE command is received
         /// </summary>
-        public event EventHandler OnPokeCommand;
+        public event EventHandler<PipelineCommand> OnPokeCommand;
         
         /// <summary>
         /// Event raised when a custom command is received (for extensibility)
         /// </summary>
         public event EventHandler<PipelineCommand> OnCustomCommand;
         
+        /// <summary>
+        /// Event raised when a client defines or deletes a macro, so the definitions can be saved
+        /// </summary>
+        public event EventHandler OnMacrosChanged;
+        
         public bool IsRunning => _isRunning;
         
+        /// <summary>
+        /// File being recorded to, or null when not recording
+        /// </summary>
+        public string RecordingPath => _recorder?.Path;
+        
+        /// <summary>
+        /// How long Stop lets connections finish the command they are running before closing them
+        /// </summary>
+        public TimeSpan DrainTimeout { get; set; } = TimeSpan.FromSeconds(5);
+        
+        /// <summary>
+        /// Lines and prompts that EVENT commands resolve to. Replace it whole rather than
+        /// clearing it, so an EVENT arriving meanwhile never finds it half filled. Its
+        /// cache counters in STATS start again from zero.
+        /// </summary>
+        public PipelineEventRegistry EventRegistry
+        {
+            get => _eventRegistry;
+            set => _eventRegistry = value ?? throw new ArgumentNullException(nameof(value));
+        }
+        
+        /// <summary>
+        /// Returns the latest state of a character (null = the default one) as semicolon-separated
+        /// key=value fields. Called on the connection's thread, so it must read a published
+        /// snapshot rather than touch the UI.
+        /// </summary>
+        public Func<string, string> StateProvider { get; set; }
+        
+        /// <summary>
+        /// Maps the name in COMMAND@Name to a loaded character's name, or null if none is loaded
+        /// under it; called with null, returns the default character's name. Called on the
+        /// connection's thread. When unset, addressed commands are refused.
+        /// </summary>
+        public Func<string, string> CharacterResolver { get; set; }
+        
+        /// <summary>
+        /// Names of the loaded characters, the default one first, for the CHARACTERS command
+        /// </summary>
+        public Func<IEnumerable<string>> CharactersProvider { get; set; }
+        
+        /// <summary>
+        /// More semicolon-separated key=value fields for STATS from the host, such as the
+        /// resource governor's. Called on the connection's thread.
+        /// </summary>
+        public Func<string> StatsProvider { get; set; }
+        
+        /// <summary>
+        /// When set, commands are charged against per-connection and global token buckets
+        /// before they run (null = no limits)
+        /// </summary>
+        public PipelineRateLimiter RateLimiter { get; set; }
+        
+        /// <summary>
+        /// When set, CHAT commands are queued here per client instead of raising OnChatCommand
+        /// </summary>
+        public ChatScheduler ChatScheduler { get; set; }
+        
+        /// <summary>
+        /// Deadline applied to CHAT commands that don't set their own (null = none)
+        /// </summary>
+        public TimeSpan? DefaultChatTtl { get; set; }
+        
+        /// <summary>
+        /// Also accept fire-and-forget commands over UDP (one per datagram, no response)
+        /// </summary>
+        public bool UdpEnabled { get; set; }
+        
+        /// <summary>
+        /// UDP port, bound on the same address as TCP mode
+        /// </summary>
+        public int UdpPort { get; set; } = 8766;
+        
+        /// <summary>
+        /// Datagrams allowed to wait for dispatch before new ones are dropped
+        /// </summary>
+        public int UdpQueueCapacity { get; set; } = 1024;
+        
+        /// <summary>
+        /// Also consume fire-and-forget commands from a shared-memory ring (same machine only)
+        /// </summary>
+        public bool RingEnabled { get; set; }
+        
+        /// <summary>
+        /// Name of the ring's memory mapping and wakeup event
+        /// </summary>
+        public string RingName { get; set; } = "MSAgentAI.Ring";
+        
+        /// <summary>
+        /// File backing the ring instead of a named mapping (required outside Windows)
+        /// </summary>
+        public string RingPath { get; set; }
+        
+        /// <summary>
+        /// Ring size in bytes
+        /// </summary>
+        public long RingCapacity { get; set; } = 1 << 20;
+        
+        /// <summary>
+        /// Also serve commands over HTTP and WebSocket, and push events to WebSocket clients
+        /// </summary>
+        public bool HttpEnabled { get; set; }
+        
+        /// <summary>
+        /// HTTP port, on loopback unless TCP mode is configured for another address
+        /// </summary>
+        public int HttpPort { get; set; } = 8767;
+        
+        /// <summary>
+        /// Web page origins allowed to use the HTTP endpoint besides local files and loopback pages
+        /// </summary>
+        public string[] HttpAllowedOrigins { get; set; }
+        
         /// <summary>
         /// Constructor with default configuration (Named Pipe)
         /// </summary>
@@ -101,10 +272,19 @@ namespace MSAgentAI.Pipeline
         /// Starts the pipeline server
         /// </summary>
         public void Start()
+        {
+            lock (_lifecycleLock)
+            {
+                StartLocked();
+            }
+        }
+        
+        private void StartLocked()
         {
             if (_isRunning)
                 return;
                 
+            _cancellationTokenSource?.Dispose();
             _cancellationTokenSource = new CancellationTokenSource();
             _isRunning = true;
             
@@ -118,21 +298,198 @@ namespace MSAgentAI.Pipeline
                 _serverTask = Task.Run(() => RunNamedPipeServerAsync(_cancellationTokenSource.Token));
                 Logger.Log($"Pipeline server started on pipe: \\\\.\\pipe\\{_pipeName}");
             }
+            
+            if (UdpEnabled)
+            {
+                try
+                {
+                    _udpListener = new UdpCommandListener(new IPEndPoint(GetListenAddress(), UdpPort), UdpQueueCapacity, ProcessDatagram);
+                    _udpListener.Start();
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"UDP Pipeline: Failed to listen on port {UdpPort}", ex);
+                    _udpListener?.Dispose();
+                    _udpListener = null;
+                }
+            }
+            
+            if (RingEnabled)
+            {
+                try
+                {
+                    _ringConnection = new PipelineConnection("ring:" + RingName);
+                    _ringListener = new RingCommandListener(RingName, RingPath, RingCapacity, line => ProcessCommand(line, _ringConnection));
+                    _ringListener.Start();
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"Ring Pipeline: Failed to create ring '{RingName}'", ex);
+                    _ringListener?.Dispose();
+                    _ringListener = null;
+                }
+            }
+            
+            if (HttpEnabled)
+            {
+                try
+                {
+                    _httpEndpoint = new PipelineHttpEndpoint(GetListenAddress(), HttpPort, ProcessCommandAsync);
+                    _httpEndpoint.AllowOrigins(HttpAllowedOrigins);
+                    _httpEndpoint.TrackRequest = TrackConnection;
+                    _httpEndpoint.Start();
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"HTTP Pipeline: Failed to listen on port {HttpPort}", ex);
+                    _httpEndpoint?.Dispose();
+                    _httpEndpoint = null;
+                }
+            }
         }
         
         /// <summary>
-        /// Stops the pipeline server
+        /// Stops the pipeline server. New connections are refused at once; idle connections are
+        /// closed, and connections in the middle of a command get up to DrainTimeout to send
+        /// its response before they are cut off.
         /// </summary>
-        public void Stop()
+        public PipelineShutdownResult Stop()
         {
-            if (!_isRunning)
-                return;
+            lock (_lifecycleLock)
+            {
+                if (!_isRunning)
+                    return new PipelineShutdownResult(0, 0, TimeSpan.Zero);
                 
-            _isRunning = false;
-            _cancellationTokenSource?.Cancel();
-            _tcpListener?.Stop();
-            
-            Logger.Log("Pipeline server stopped");
+                var stopwatch = Stopwatch.StartNew();
+                _isRunning = false;
+                
+                // Stop accepting
+                _cancellationTokenSource?.Cancel();
+                _tcpListener?.Stop();
+                _udpListener?.Dispose();
+                _udpListener = null;
+                _udpSources.Clear();
+                _ringListener?.Dispose();
+                _ringListener = null;
+                _httpEndpoint?.BeginDrain();
+                
+                // Idle connections close now, busy ones once their response is written
+                var open = new List<KeyValuePair<PipelineConnection, Task>>(_connections);
+                var pending = new List<Task>();
+                foreach (var entry in open)
+                {
+                    entry.Key.Drain();
+                    pending.Add(entry.Value);
+                }
+                if (_serverTask != null)
+                {
+                    pending.Add(_serverTask);
+                }
+                WaitQuietly(pending, DrainTimeout);
+                
+                int drained = 0;
+                foreach (var entry in open)
+                {
+                    if (entry.Value.IsCompleted)
+                        drained++;
+                }
+                
+                // Out of time: cut off whatever is still running, including any connection
+                // accepted while the listener was shutting down
+                int aborted = 0;
+                pending.Clear();
+                foreach (var entry in _connections)
+                {
+                    if (!entry.Value.IsCompleted)
+                    {
+                        aborted++;
+                        entry.Key.Abort();
+                        pending.Add(entry.Value);
+                        
+                        // Closed already; a handler stuck in its command mustn't count again on the next Stop
+                        _connections.TryRemove(entry.Key, out _);
+                    }
+                }
+                if (pending.Count > 0)
+                {
+                    WaitQuietly(pending, TimeSpan.FromSeconds(1));
+                }
+                
+                // Closing the HTTP listener cuts off its responses, so it goes last
+                _httpEndpoint?.Dispose();
+                _httpEndpoint = null;
+                
+                var result = new PipelineShutdownResult(drained, aborted, stopwatch.Elapsed);
+                Logger.Log($"Pipeline server stopped: {drained} connection(s) drained, {aborted} aborted in {stopwatch.ElapsedMilliseconds} ms");
+                return result;
+            }
+        }
+        
+        /// <summary>
+        /// Drains and stops the server, then starts it again with a new transport configuration
+        /// </summary>
+        public PipelineShutdownResult Restart(string protocol, string ipAddress, int port, string pipeName)
+        {
+            lock (_lifecycleLock)
+            {
+                var result = Stop();
+                _protocol = protocol ?? "NamedPipe";
+                _ipAddress = ipAddress ?? "127.0.0.1";
+                _port = port;
+                _pipeName = pipeName ?? PipeName;
+                StartLocked();
+                return result;
+            }
+        }
+        
+        /// <summary>
+        /// Starts recording every inbound command to a binary log for later replay
+        /// (see tools/PipelineReplay). Replaces any recording in progress.
+        /// </summary>
+        public void StartRecording(string path)
+        {
+            var previous = Interlocked.Exchange(ref _recorder, new PipelineRecorder(path));
+            previous?.Dispose();
+        }
+        
+        /// <summary>
+        /// Stops recording and closes the log
+        /// </summary>
+        public void StopRecording()
+        {
+            Interlocked.Exchange(ref _recorder, null)?.Dispose();
+        }
+        
+        /// <summary>
+        /// Whether the server already uses this transport configuration
+        /// </summary>
+        public bool IsConfiguredFor(string protocol, string ipAddress, int port, string pipeName)
+        {
+            return string.Equals(_protocol, protocol ?? "NamedPipe", StringComparison.OrdinalIgnoreCase)
+                && _ipAddress == (ipAddress ?? "127.0.0.1")
+                && _port == port
+                && _pipeName == (pipeName ?? PipeName);
+        }
+        
+        private static void WaitQuietly(List<Task> tasks, TimeSpan timeout)
+        {
+            try
+            {
+                Task.WaitAll(tasks.ToArray(), timeout);
+            }
+            catch (AggregateException)
+            {
+                // Handlers log their own failures
+            }
+        }
+        
+        /// <summary>
+        /// Remembers a connection until its handler finishes, so Stop can drain it
+        /// </summary>
+        private void TrackConnection(PipelineConnection connection, Task handler)
+        {
+            _connections[connection] = handler;
+            handler.ContinueWith(t => _connections.TryRemove(connection, out _), TaskScheduler.Default);
         }
         
         private async Task RunNamedPipeServerAsync(CancellationToken cancellationToken)
@@ -141,12 +498,13 @@ namespace MSAgentAI.Pipeline
             {
                 try
                 {
-                    // Create a new pipe server for each connection
+                    // Create a new pipe server for each connection. Commands are newline-delimited,
+                    // so byte mode, the only one off Windows, reads them just as well.
                     using (var pipeServer = new NamedPipeServerStream(
                         _pipeName,
                         PipeDirection.InOut,
                         NamedPipeServerStream.MaxAllowedServerInstances,
-                        PipeTransmissionMode.Message,
+                        RuntimeInformation.IsOSPlatform(OSPlatform.Windows) ? PipeTransmissionMode.Message : PipeTransmissionMode.Byte,
                         PipeOptions.Asynchronous))
                     {
                         Logger.Log("Pipeline: Waiting for connection...");
@@ -157,7 +515,11 @@ namespace MSAgentAI.Pipeline
                         Logger.Log("Pipeline: Client connected");
                         
                         // Handle the connection
-                        await HandleNamedPipeConnectionAsync(pipeServer, cancellationToken);
+                        var connection = new PipelineConnection($"pipe#{Interlocked.Increment(ref _connectionCounter)}");
+                        connection.Close = pipeServer.Dispose;
+                        var handler = HandleNamedPipeConnectionAsync(pipeServer, connection, cancellationToken);
+                        TrackConnection(connection, handler);
+                        await handler;
                     }
                 }
                 catch (OperationCanceledException)
@@ -186,12 +548,7 @@ namespace MSAgentAI.Pipeline
         {
             try
             {
-                // Validate and parse IP address
-                if (!IPAddress.TryParse(_ipAddress, out IPAddress ipAddr))
-                {
-                    Logger.LogError($"TCP Pipeline: Invalid IP address '{_ipAddress}'. Using loopback address.", null);
-                    ipAddr = IPAddress.Loopback;
-                }
+                var ipAddr = GetListenAddress();
                 
                 _tcpListener = new TcpListener(ipAddr, _port);
                 _tcpListener.Start();
@@ -204,24 +561,29 @@ namespace MSAgentAI.Pipeline
                     {
                         // Accept client connection
                         var client = await _tcpListener.AcceptTcpClientAsync();
+                        
+                        // Responses are small and flushed one per command, so Nagle would hold
+                        // back all but the first of a pipelined batch until the client's delayed ACK
+                        client.NoDelay = true;
                         Logger.Log($"TCP Pipeline: Client connected from {client.Client.RemoteEndPoint}");
                         
-                        // Handle each client in a separate task with proper exception handling
-                        // Using fire-and-forget pattern is acceptable for server scenarios where:
-                        // 1. Each task fully handles its own exceptions (logged)
-                        // 2. Client disconnection properly disposes resources (using statements)
-                        // 3. Tasks are short-lived and self-contained
-                        _ = Task.Run(async () =>
+                        // Handle each client in a separate task. Each task handles its own
+                        // exceptions and disposes its client; Stop waits for them through
+                        // TrackConnection. The handler checks the token itself, so a client
+                        // accepted during shutdown is still disposed.
+                        var connection = new PipelineConnection($"tcp:{client.Client.RemoteEndPoint}");
+                        connection.Close = client.Dispose;
+                        TrackConnection(connection, Task.Run(async () =>
                         {
                             try
                             {
-                                await HandleTcpConnectionAsync(client, cancellationToken);
+                                await HandleTcpConnectionAsync(client, connection, cancellationToken);
                             }
                             catch (Exception ex)
                             {
                                 Logger.LogError("TCP Pipeline: Unhandled exception in client handler", ex);
                             }
-                        }, cancellationToken);
+                        }));
                     }
                     catch (ObjectDisposedException)
                     {
@@ -243,10 +605,74 @@ namespace MSAgentAI.Pipeline
             }
         }
         
-        private async Task HandleNamedPipeConnectionAsync(NamedPipeServerStream pipeServer, CancellationToken cancellationToken)
+        /// <summary>
+        /// Validates and parses the configured IP address, falling back to loopback
+        /// </summary>
+        private IPAddress GetListenAddress()
+        {
+            if (!IPAddress.TryParse(_ipAddress, out IPAddress ipAddr))
+            {
+                Logger.LogError($"Pipeline: Invalid IP address '{_ipAddress}'. Using loopback address.", null);
+                ipAddr = IPAddress.Loopback;
+            }
+            return ipAddr;
+        }
+        
+        /// <summary>
+        /// Runs a command received over UDP. Responses have nowhere to go and are discarded.
+        /// </summary>
+        private Task ProcessDatagram(string line, EndPoint remote)
+        {
+            string id = "udp:" + remote;
+            if (!_udpSources.TryGetValue(id, out var connection))
+            {
+                // Senders on ephemeral ports can come and go; don't let the table grow unbounded
+                if (_udpSources.Count >= MaxUdpSources)
+                {
+                    EvictUdpSources();
+                }
+                connection = _udpSources.GetOrAdd(id, key => new PipelineConnection(key));
+            }
+            connection.LastActivity = Stopwatch.GetTimestamp();
+            
+            return ProcessCommandAsync(line, connection);
+        }
+        
+        /// <summary>
+        /// Forgets UDP senders that have gone quiet, or the least recently heard one if all are
+        /// active, so the others keep their SESSION and TTL
+        /// </summary>
+        private void EvictUdpSources()
+        {
+            long now = Stopwatch.GetTimestamp();
+            long idleTicks = (long)(UdpSourceIdleTimeout.TotalSeconds * Stopwatch.Frequency);
+            KeyValuePair<string, PipelineConnection> oldest = default;
+            bool removed = false;
+            
+            foreach (var entry in _udpSources)
+            {
+                long lastActivity = entry.Value.LastActivity;
+                if (now - lastActivity > idleTicks)
+                {
+                    removed |= _udpSources.TryRemove(entry.Key, out _);
+                }
+                else if (oldest.Value == null || lastActivity < oldest.Value.LastActivity)
+                {
+                    oldest = entry;
+                }
+            }
+            
+            if (!removed && oldest.Value != null)
+            {
+                _udpSources.TryRemove(oldest.Key, out _);
+            }
+        }
+        
+        private async Task HandleNamedPipeConnectionAsync(NamedPipeServerStream pipeServer, PipelineConnection connection, CancellationToken cancellationToken)
         {
             const int MaxMessageLength = 8192; // 8KB max message size
             
+            Interlocked.Increment(ref _activeConnections);
             try
             {
                 using (var reader = new StreamReader(pipeServer, Encoding.UTF8))
@@ -260,6 +686,10 @@ namespace MSAgentAI.Pipeline
                         if (string.IsNullOrEmpty(line))
                             break;
                         
+                        // The server is shutting down and has stopped taking commands
+                        if (!connection.BeginCommand())
+                            break;
+                        
                         // Enforce message size limit to prevent DoS
                         if (line.Length > MaxMessageLength)
                         {
@@ -271,10 +701,14 @@ namespace MSAgentAI.Pipeline
                         Logger.Log($"Pipeline: Received command: {line}");
                         
                         // Parse and process the command
-                        var response = ProcessCommand(line);
+                        var response = await ProcessCommandAsync(line, connection);
                         
                         // Send response
                         await writer.WriteLineAsync(response);
+                        
+                        // Stop asked this connection to close while the command ran
+                        if (!connection.EndCommand())
+                            break;
                     }
                 }
             }
@@ -283,17 +717,28 @@ namespace MSAgentAI.Pipeline
                 // Client disconnected
                 Logger.Log("Pipeline: Client disconnected");
             }
+            catch (ObjectDisposedException)
+            {
+                // Closed by Stop
+                Logger.Log("Pipeline: Client closed for shutdown");
+            }
             catch (Exception ex)
             {
                 Logger.LogError("Pipeline: Error handling connection", ex);
             }
+            finally
+            {
+                Interlocked.Decrement(ref _activeConnections);
+            }
         }
         
-        private async Task HandleTcpConnectionAsync(TcpClient client, CancellationToken cancellationToken)
+        private async Task HandleTcpConnectionAsync(TcpClient client, PipelineConnection connection, CancellationToken cancellationToken)
         {
             const int MaxMessageLength = 8192; // 8KB max message size
             const int ReadTimeoutMs = 30000; // 30 second timeout
             
+            Interlocked.Increment(ref _connectionCounter);
+            Interlocked.Increment(ref _activeConnections);
             try
             {
                 using (client)
@@ -312,6 +757,10 @@ namespace MSAgentAI.Pipeline
                         if (string.IsNullOrEmpty(line))
                             break;
                         
+                        // The server is shutting down and has stopped taking commands
+                        if (!connection.BeginCommand())
+                            break;
+                        
                         // Enforce message size limit to prevent DoS
                         if (line.Length > MaxMessageLength)
                         {
@@ -323,10 +772,14 @@ namespace MSAgentAI.Pipeline
                         Logger.Log($"TCP Pipeline: Received command: {line}");
                         
                         // Parse and process the command
-                        var response = ProcessCommand(line);
+                        var response = await ProcessCommandAsync(line, connection);
                         
                         // Send response
                         await writer.WriteLineAsync(response);
+                        
+                        // Stop asked this connection to close while the command ran
+                        if (!connection.EndCommand())
+                            break;
                     }
                 }
                 
@@ -337,103 +790,881 @@ namespace MSAgentAI.Pipeline
                 // Client disconnected or timeout
                 Logger.Log($"TCP Pipeline: Client disconnected (IO error: {ex.Message})");
             }
+            catch (ObjectDisposedException)
+            {
+                // Closed by Stop
+                Logger.Log("TCP Pipeline: Client closed for shutdown");
+            }
             catch (Exception ex)
             {
                 Logger.LogError("TCP Pipeline: Error handling connection", ex);
             }
+            finally
+            {
+                Interlocked.Decrement(ref _activeConnections);
+            }
+        }
+        
+        /// <summary>
+        /// Runs a command and returns its response. A command the rate limiter delays waits on
+        /// the calling thread, so this is only for the ring, which reads on a thread of its own;
+        /// the other transports use ProcessCommandAsync.
+        /// </summary>
+        internal string ProcessCommand(string commandLine, PipelineConnection connection)
+        {
+            var pending = AdmitCommand(commandLine, connection);
+            if (pending.Response != null)
+                return pending.Response;
+            
+            if (pending.Delay > TimeSpan.Zero)
+                Thread.Sleep(pending.Delay);
+            return RunCommand(pending, commandLine, connection);
+        }
+        
+        /// <summary>
+        /// Runs a command and returns its response, waiting out any rate limit delay without
+        /// holding a thread
+        /// </summary>
+        internal async Task<string> ProcessCommandAsync(string commandLine, PipelineConnection connection)
+        {
+            var pending = AdmitCommand(commandLine, connection);
+            if (pending.Response != null)
+                return pending.Response;
+            
+            // At most MaxDelay, and not cut short by Stop: a draining connection finishes its command
+            if (pending.Delay > TimeSpan.Zero)
+                await Task.Delay(pending.Delay);
+            return RunCommand(pending, commandLine, connection);
         }
         
-        private string ProcessCommand(string commandLine)
+        /// <summary>
+        /// Records, parses and charges a command to the rate limiter
+        /// </summary>
+        private PendingCommand AdmitCommand(string commandLine, PipelineConnection connection)
         {
+            Interlocked.Increment(ref _commandsProcessed);
+            _recorder?.Record(connection.Id, commandLine);
+            var pending = new PendingCommand();
             try
             {
-                // Parse command: COMMAND:data or just COMMAND
-                string command;
-                string data = null;
-                
-                int colonIndex = commandLine.IndexOf(':');
-                if (colonIndex > 0)
-                {
-                    command = commandLine.Substring(0, colonIndex).Trim().ToUpperInvariant();
-                    data = commandLine.Substring(colonIndex + 1);
-                }
-                else
-                {
-                    command = commandLine.Trim().ToUpperInvariant();
-                }
+                ParseCommandLine(commandLine, out pending.Command, out pending.Target, out pending.Options, out pending.Data);
                 
-                switch (command)
+                var limiter = RateLimiter;
+                if (limiter != null)
                 {
-                    case "SPEAK":
-                        if (!string.IsNullOrEmpty(data))
-                        {
-                            OnSpeakCommand?.Invoke(this, data);
-                            return "OK:SPEAK";
-                        }
-                        return "ERROR:SPEAK requires text";
-                        
-                    case "ANIMATION":
-                    case "ANIM":
-                        if (!string.IsNullOrEmpty(data))
-                        {
-                            OnAnimationCommand?.Invoke(this, data);
-                            return "OK:ANIMATION";
-                        }
-                        return "ERROR:ANIMATION requires animation name";
-                        
-                    case "CHAT":
-                        if (!string.IsNullOrEmpty(data))
-                        {
-                            OnChatCommand?.Invoke(this, data);
-                            return "OK:CHAT";
-                        }
-                        return "ERROR:CHAT requires prompt";
-                        
-                    case "HIDE":
-                        OnHideCommand?.Invoke(this, EventArgs.Empty);
-                        return "OK:HIDE";
-                        
-                    case "SHOW":
-                        OnShowCommand?.Invoke(this, EventArgs.Empty);
-                        return "OK:SHOW";
-                        
-                    case "POKE":
-                        OnPokeCommand?.Invoke(this, EventArgs.Empty);
-                        return "OK:POKE";
-                        
-                    case "PING":
-                        return "PONG";
-                        
-                    case "VERSION":
-                        return "MSAgentAI:1.0.0";
-                        
-                    default:
-                        // Custom command - pass to handlers
-                        var customCmd = new PipelineCommand { Command = command, Data = data };
-                        OnCustomCommand?.Invoke(this, customCmd);
-                        return $"OK:CUSTOM:{command}";
+                    pending.Response = ApplyRateLimit(limiter, pending.Command, pending.Data, connection, out pending.Delay);
                 }
             }
             catch (Exception ex)
             {
                 Logger.LogError($"Pipeline: Error processing command: {commandLine}", ex);
-                return $"ERROR:{ex.Message}";
+                pending.Response = $"ERROR:{ex.Message}";
             }
+            return pending;
         }
         
-        public void Dispose()
+        private string RunCommand(PendingCommand pending, string commandLine, PipelineConnection connection)
         {
-            Stop();
-            _cancellationTokenSource?.Dispose();
-        }
-    }
+            try
+            {
+                string character = null;
+                if (pending.Target != null && !TryResolveCharacter(pending.Target, out character, out string characterError))
+                    return characterError;
+                
+                if (!IsSequenced(pending.Command))
+                    return ExecuteCommand(pending.Command, character, pending.Options, pending.Data, connection);
+                
+                return ExecuteSequenced(pending.Command, character, pending.Options, pending.Data, connection);
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError($"Pipeline: Error processing command: {commandLine}", ex);
+                return $"ERROR:{ex.Message}";
+            }
+        }
+        
+        /// <summary>
+        /// A parsed command, with the response if it must not run or how long to hold it first
+        /// </summary>
+        private struct PendingCommand
+        {
+            public string Command;
+            public string Target;
+            public string Options;
+            public string Data;
+            public string Response;
+            public TimeSpan Delay;
+        }
+        
+        /// <summary>
+        /// Charges a command to the rate limiter. Returns the response for a command that must not
+        /// run, or null to run it once the delay given has passed (outside the sequence lock).
+        /// </summary>
+        private string ApplyRateLimit(PipelineRateLimiter limiter, string command, string data, PipelineConnection connection, out TimeSpan delay)
+        {
+            delay = TimeSpan.Zero;
+            var decision = limiter.Acquire(connection, GetCommandCost(limiter, command, data), out TimeSpan wait);
+            switch (decision)
+            {
+                case RateDecision.Delayed:
+                    delay = wait;
+                    break;
+                    
+                case RateDecision.Rejected:
+                    connection.NoteRateLimited();
+                    return $"ERROR:RATE:{command} over rate limit, retry in {Math.Max(1, (int)Math.Ceiling(wait.TotalMilliseconds))}ms";
+                    
+                case RateDecision.Dropped:
+                    connection.NoteRateLimited();
+                    return $"DROPPED:{command}";
+            }
+            return null;
+        }
+        
+        /// <summary>
+        /// RUN costs what its steps would cost if sent one by one
+        /// </summary>
+        private int GetCommandCost(PipelineRateLimiter limiter, string command, string data)
+        {
+            if (command != "RUN" || !TryGetMacro(data, out var macro))
+                return limiter.GetCost(command);
+            
+            int cost = 0;
+            foreach (var step in macro.Steps)
+            {
+                cost += limiter.GetCost(step.Command);
+            }
+            return Math.Max(cost, limiter.GetCost(command));
+        }
+        
+        /// <summary>
+        /// Splits COMMAND;options:data into an upper-case command name, its options and its data
+        /// </summary>
+        internal static void ParseCommandLine(string commandLine, out string command, out string options, out string data)
+        {
+            ParseCommandLine(commandLine, out command, out _, out options, out data);
+        }
+        
+        /// <summary>
+        /// Splits COMMAND@target;options:data. The target keeps its case and is null when the
+        /// command doesn't name a character.
+        /// </summary>
+        internal static void ParseCommandLine(string commandLine, out string command, out string target, out string options, out string data)
+        {
+            data = null;
+            options = null;
+            target = null;
+            
+            string header;
+            int colonIndex = commandLine.IndexOf(':');
+            if (colonIndex > 0)
+            {
+                header = commandLine.Substring(0, colonIndex).Trim();
+                data = commandLine.Substring(colonIndex + 1);
+            }
+            else
+            {
+                header = commandLine.Trim();
+            }
+            
+            int optionsIndex = header.IndexOf(';');
+            if (optionsIndex >= 0)
+            {
+                options = header.Substring(optionsIndex + 1).ToUpperInvariant();
+                header = header.Substring(0, optionsIndex).Trim();
+            }
+            
+            int targetIndex = header.IndexOf('@');
+            if (targetIndex >= 0)
+            {
+                target = header.Substring(targetIndex + 1).Trim();
+                header = header.Substring(0, targetIndex).Trim();
+                if (target.Length == 0)
+                {
+                    target = null;
+                }
+            }
+            
+            command = header.ToUpperInvariant();
+        }
+        
+        /// <summary>
+        /// Looks up the character a command is addressed to
+        /// </summary>
+        private bool TryResolveCharacter(string target, out string character, out string error)
+        {
+            character = CharacterResolver?.Invoke(target);
+            error = character == null ? $"ERROR:CHARACTER:no character named {target}" : null;
+            return character != null;
+        }
+        
+        /// <summary>
+        /// Runs an agent command holding the sequence lock of every character it acts on. A RUN
+        /// may reach several; their locks are taken in name order so two macros can't deadlock.
+        /// </summary>
+        private string ExecuteSequenced(string command, string character, string options, string data, PipelineConnection connection)
+        {
+            var names = new SortedSet<string>(StringComparer.OrdinalIgnoreCase) { GetSequenceName(character) };
+            if (command == "RUN" && TryGetMacro(data, out var macro))
+            {
+                foreach (var step in macro.Steps)
+                {
+                    if (step.Target != null && IsSequenced(step.Command))
+                    {
+                        names.Add(GetSequenceName(CharacterResolver?.Invoke(step.Target) ?? step.Target));
+                    }
+                }
+            }
+            
+            var held = new List<object>(names.Count);
+            try
+            {
+                foreach (string name in names)
+                {
+                    var sequenceLock = _sequenceLocks.GetOrAdd(name, _ => new object());
+                    Monitor.Enter(sequenceLock);
+                    held.Add(sequenceLock);
+                }
+                return ExecuteCommand(command, character, options, data, connection);
+            }
+            finally
+            {
+                for (int i = held.Count - 1; i >= 0; i--)
+                {
+                    Monitor.Exit(held[i]);
+                }
+            }
+        }
+        
+        /// <summary>
+        /// Untargeted commands share the default character's lock, so SPEAK and SPEAK@Default
+        /// are sequenced together
+        /// </summary>
+        private string GetSequenceName(string character)
+        {
+            return character ?? CharacterResolver?.Invoke(null) ?? string.Empty;
+        }
+        
+        private bool TryGetMacro(string data, out PipelineMacro macro)
+        {
+            macro = null;
+            if (string.IsNullOrWhiteSpace(data))
+                return false;
+            
+            int separator = data.IndexOf('|');
+            string name = (separator >= 0 ? data.Substring(0, separator) : data).Trim();
+            return _macros.TryGetValue(name, out macro);
+        }
+        
+        /// <summary>
+        /// Whether a command acts on the agent and so must not run in the middle of a macro
+        /// </summary>
+        private static bool IsSequenced(string command)
+        {
+            switch (command)
+            {
+                case "PING":
+                case "VERSION":
+                case "STATS":
+                case "SESSION":
+                case "TTL":
+                case "DEFINE":
+                case "MACROS":
+                case "STATE":
+                case "QUERY":
+                case "CHARACTERS":
+                    return false;
+                default:
+                    return true;
+            }
+        }
+        
+        /// <param name="character">Resolved character the command is addressed to, or null for the default one</param>
+        private string ExecuteCommand(string command, string character, string options, string data, PipelineConnection connection)
+        {
+            switch (command)
+            {
+                case "SPEAK":
+                    if (!string.IsNullOrEmpty(data))
+                    {
+                        OnSpeakCommand?.Invoke(this, new PipelineCommand { Command = command, Character = character, Data = data });
+                        return "OK:SPEAK";
+                    }
+                    return "ERROR:SPEAK requires text";
+                    
+                case "ANIMATION":
+                case "ANIM":
+                    if (!string.IsNullOrEmpty(data))
+                    {
+                        OnAnimationCommand?.Invoke(this, new PipelineCommand { Command = "ANIMATION", Character = character, Data = data });
+                        return "OK:ANIMATION";
+                    }
+                    return "ERROR:ANIMATION requires animation name";
+                    
+                case "CHAT":
+                    if (!string.IsNullOrEmpty(data))
+                    {
+                        var scheduler = ChatScheduler;
+                        if (scheduler != null)
+                        {
+                            if (!TryGetDeadline(options, connection, out DateTime? deadline, out string optionError))
+                                return $"ERROR:{optionError}";
+                            
+                            // A character other than the default gets its own queue, so a client
+                            // driving two characters doesn't hold one up behind the other. The
+                            // default goes in as null however it was named, since the scheduler
+                            // runs one request at a time per character.
+                            if (string.Equals(character, CharacterResolver?.Invoke(null), StringComparison.OrdinalIgnoreCase))
+                            {
+                                character = null;
+                            }
+                            string clientId = character == null ? connection.ClientId : connection.ClientId + "@" + character;
+                            var admission = scheduler.Enqueue(clientId, character, data, deadline, out string reason);
+                            if (admission != ChatAdmission.Queued)
+                            {
+                                Logger.Log($"Pipeline: CHAT from {clientId} rejected: {reason}");
+                                return admission == ChatAdmission.DeadlineExceeded
+                                    ? $"ERROR:DEADLINE:{reason}"
+                                    : $"ERROR:QUOTA:{reason}";
+                            }
+                            return "OK:CHAT";
+                        }
+                        
+                        OnChatCommand?.Invoke(this, new PipelineCommand { Command = command, Character = character, Data = data });
+                        return "OK:CHAT";
+                    }
+                    return "ERROR:CHAT requires prompt";
+                    
+                case "HIDE":
+                    OnHideCommand?.Invoke(this, new PipelineCommand { Command = command, Character = character });
+                    return "OK:HIDE";
+                    
+                case "SHOW":
+                    OnShowCommand?.Invoke(this, new PipelineCommand { Command = command, Character = character });
+                    return "OK:SHOW";
+                    
+                case "POKE":
+                    OnPokeCommand?.Invoke(this, new PipelineCommand { Command = command, Character = character });
+                    return "OK:POKE";
+                    
+                case "PING":
+                    return "PONG";
+                    
+                case "VERSION":
+                    return "MSAgentAI:1.0.0";
+                    
+                case "SESSION":
+                    if (string.IsNullOrWhiteSpace(data))
+                        return "ERROR:SESSION requires a name";
+                    if (!connection.TrySetSession(data.Trim()))
+                        return "ERROR:SESSION names use letters, digits, '-', '_' and '.' (max 64)";
+                    return $"OK:SESSION:{data.Trim()}";
+                    
+                case "TTL":
+                    if (int.TryParse(data?.Trim(), out int ttlMs) && ttlMs >= 0)
+                    {
+                        connection.DefaultTtl = ttlMs > 0 ? TimeSpan.FromMilliseconds(ttlMs) : (TimeSpan?)null;
+                        return $"OK:TTL:{ttlMs}";
+                    }
+                    return "ERROR:TTL requires milliseconds";
+                    
+                case "STATS":
+                    return "STATS:" + GetStats();
+                    
+                case "DEFINE":
+                    return DefineMacro(data);
+                    
+                case "RUN":
+                    return RunMacro(character, data, connection);
+                    
+                case "MACROS":
+                    return "MACROS:" + string.Join(",", _macros.Keys);
+                    
+                case "EVENT":
+                    return RaiseEvent(character, options, data, connection);
+                    
+                case "STATE":
+                    return "STATE:" + (StateProvider?.Invoke(character) ?? string.Empty);
+                    
+                case "QUERY":
+                    return QueryState(character, data);
+                    
+                case "CHARACTERS":
+                    return "CHARACTERS:" + string.Join(",", CharactersProvider?.Invoke() ?? new string[0]);
+                    
+                default:
+                    // Custom command - pass to handlers
+                    var customCmd = new PipelineCommand { Command = command, Character = character, Data = data };
+                    OnCustomCommand?.Invoke(this, customCmd);
+                    return $"OK:CUSTOM:{command}";
+            }
+        }
+        
+        /// <summary>
+        /// Handles DEFINE:name=step|step, or DEFINE:name= to delete
+        /// </summary>
+        private string DefineMacro(string data)
+        {
+            int equalsIndex = data?.IndexOf('=') ?? -1;
+            if (equalsIndex <= 0)
+                return "ERROR:DEFINE requires name=step|step";
+            
+            string name = data.Substring(0, equalsIndex).Trim();
+            string definition = data.Substring(equalsIndex + 1).Trim();
+            
+            if (definition.Length == 0)
+            {
+                if (!_macros.TryRemove(name, out _))
+                    return $"ERROR:DEFINE:no macro named {name}";
+                
+                OnMacrosChanged?.Invoke(this, EventArgs.Empty);
+                return $"OK:DEFINE:{name}:0";
+            }
+            
+            if (!PipelineMacro.TryCompile(name, definition, out var macro, out string error))
+                return $"ERROR:DEFINE:{error}";
+            
+            if (_macros.Count >= MaxMacros && !_macros.ContainsKey(name))
+                return $"ERROR:DEFINE:limit of {MaxMacros} macros reached";
+            
+            _macros[name] = macro;
+            OnMacrosChanged?.Invoke(this, EventArgs.Empty);
+            return $"OK:DEFINE:{name}:{macro.Steps.Count}";
+        }
+        
+        /// <summary>
+        /// Handles RUN:name|arg|arg. Runs with the sequence locks held, so no other client's
+        /// agent command lands between the steps. Steps without their own @Name act on the
+        /// character the macro was run for.
+        /// </summary>
+        private string RunMacro(string character, string data, PipelineConnection connection)
+        {
+            if (string.IsNullOrWhiteSpace(data))
+                return "ERROR:RUN requires a macro name";
+            
+            string[] parts = data.Split('|');
+            string name = parts[0].Trim();
+            if (!_macros.TryGetValue(name, out var macro))
+                return $"ERROR:RUN:no macro named {name}";
+            
+            var arguments = new string[parts.Length - 1];
+            Array.Copy(parts, 1, arguments, 0, arguments.Length);
+            if (arguments.Length < macro.ParameterCount)
+                return $"ERROR:RUN:{macro.Name} needs {macro.ParameterCount} argument(s)";
+            
+            for (int i = 0; i < macro.Steps.Count; i++)
+            {
+                var step = macro.Steps[i];
+                string stepCharacter = character;
+                string response = step.Target != null && !TryResolveCharacter(step.Target, out stepCharacter, out string characterError)
+                    ? characterError
+                    : ExecuteCommand(step.Command, stepCharacter, step.Options, step.Data?.Render(arguments), connection);
+                if (response.StartsWith("ERROR:", StringComparison.Ordinal))
+                    return $"ERROR:RUN:{macro.Name}:step {i + 1}:{response.Substring(6)}";
+            }
+            return $"OK:RUN:{macro.Name}";
+        }
+        
+        /// <summary>
+        /// Handles EVENT:name|key=value|key=value. An event with a prompt goes through CHAT, so
+        /// quotas and deadlines apply; if the AI can't take it, or there is no prompt, one of the
+        /// event's lines is spoken instead.
+        /// </summary>
+        private string RaiseEvent(string character, string options, string data, PipelineConnection connection)
+        {
+            if (string.IsNullOrWhiteSpace(data))
+                return "ERROR:EVENT requires an event name";
+            
+            int pipeIndex = data.IndexOf('|');
+            string name = (pipeIndex < 0 ? data : data.Substring(0, pipeIndex)).Trim();
+            string arguments = pipeIndex < 0 ? string.Empty : data.Substring(pipeIndex + 1);
+            
+            var registry = EventRegistry;
+            if (!registry.TryGet(name, out var definition))
+                return $"ERROR:EVENT:unknown event {name}";
+            
+            string response = null;
+            if (definition.HasPrompt)
+            {
+                response = ExecuteCommand("CHAT", character, options, registry.RenderPrompt(definition, arguments), connection);
+            }
+            if (definition.HasLines && (response == null || response.StartsWith("ERROR:", StringComparison.Ordinal)))
+            {
+                response = ExecuteCommand("SPEAK", character, null, registry.RenderLine(definition, arguments), connection);
+            }
+            
+            return response.StartsWith("ERROR:", StringComparison.Ordinal)
+                ? $"ERROR:EVENT:{name}:{response.Substring(6)}"
+                : $"OK:EVENT:{name}";
+        }
+        
+        /// <summary>
+        /// Handles QUERY:key, returning QUERY:key=value from the state snapshot
+        /// </summary>
+        private string QueryState(string character, string data)
+        {
+            string key = data?.Trim();
+            if (string.IsNullOrEmpty(key))
+                return "ERROR:QUERY requires a state key";
+            
+            string state = StateProvider?.Invoke(character);
+            if (state != null)
+            {
+                foreach (var field in state.Split(';'))
+                {
+                    int equalsIndex = field.IndexOf('=');
+                    if (equalsIndex == key.Length && string.Compare(field, 0, key, 0, key.Length, StringComparison.OrdinalIgnoreCase) == 0)
+                        return "QUERY:" + field;
+                }
+            }
+            return $"ERROR:QUERY:unknown key {key}";
+        }
+        
+        /// <summary>
+        /// Replaces all macros with saved definitions (name to step|step text). Definitions that
+        /// no longer compile are logged and skipped.
+        /// </summary>
+        public void LoadMacros(IDictionary<string, string> definitions)
+        {
+            _macros.Clear();
+            if (definitions == null)
+                return;
+            
+            foreach (var entry in definitions)
+            {
+                if (PipelineMacro.TryCompile(entry.Key, entry.Value, out var macro, out string error))
+                {
+                    _macros[entry.Key] = macro;
+                }
+                else
+                {
+                    Logger.LogWarning($"Pipeline: Skipping saved macro '{entry.Key}': {error}");
+                }
+            }
+        }
+        
+        /// <summary>
+        /// Current macro definitions, for saving
+        /// </summary>
+        public Dictionary<string, string> GetMacroDefinitions()
+        {
+            var definitions = new Dictionary<string, string>();
+            foreach (var macro in _macros.Values)
+            {
+                definitions[macro.Name] = macro.Definition;
+            }
+            return definitions;
+        }
+        
+        /// <summary>
+        /// Resolves a command's deadline from its ttl/deadline options, falling back to the
+        /// connection's TTL and then the server default
+        /// </summary>
+        private bool TryGetDeadline(string options, PipelineConnection connection, out DateTime? deadline, out string error)
+        {
+            deadline = null;
+            error = null;
+            var now = DateTime.UtcNow;
+            
+            if (!string.IsNullOrEmpty(options))
+            {
+                foreach (var option in options.Split(';'))
+                {
+                    int equalsIndex = option.IndexOf('=');
+                    if (equalsIndex <= 0)
+                        continue;
+                    
+                    string key = option.Substring(0, equalsIndex).Trim().ToUpperInvariant();
+                    string value = option.Substring(equalsIndex + 1).Trim();
+                    
+                    if (key == "TTL")
+                    {
+                        if (!int.TryParse(value, out int ttlMs) || ttlMs <= 0)
+                        {
+                            error = "ttl must be a positive number of milliseconds";
+                            return false;
+                        }
+                        deadline = now.AddMilliseconds(ttlMs);
+                    }
+                    else if (key == "DEADLINE")
+                    {
+                        if (!long.TryParse(value, out long unixMs) || unixMs <= 0)
+                        {
+                            error = "deadline must be Unix time in milliseconds";
+                            return false;
+                        }
+                        deadline = UnixEpoch.AddMilliseconds(unixMs);
+                    }
+                }
+            }
+            
+            if (!deadline.HasValue)
+            {
+                var ttl = connection.DefaultTtl ?? DefaultChatTtl;
+                if (ttl.HasValue)
+                {
+                    deadline = now + ttl.Value;
+                }
+            }
+            
+            return true;
+        }
+        
+        /// <summary>
+        /// Pushes EVENT:name:data to every connected WebSocket client. Never blocks;
+        /// clients that have stopped reading are disconnected.
+        /// </summary>
+        public void PublishEvent(string name, string data = null)
+        {
+            var endpoint = _httpEndpoint;
+            if (endpoint == null || endpoint.WebSocketConnections == 0)
+                return;
+            
+            // Keep each event on one line, like every other pipeline message
+            if (data != null)
+            {
+                data = data.Replace("\r", " ").Replace("\n", " ");
+            }
+            endpoint.Broadcast(data == null ? $"EVENT:{name}" : $"EVENT:{name}:{data}");
+        }
+        
+        private static readonly DateTime UnixEpoch = new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+        
+        /// <summary>
+        /// Gets server statistics as semicolon-separated key=value fields
+        /// </summary>
+        public string GetStats()
+        {
+            var stats = $"connections={Volatile.Read(ref _activeConnections)};connections.total={Volatile.Read(ref _connectionCounter)};commands={Interlocked.Read(ref _commandsProcessed)}";
+            
+            var udp = _udpListener;
+            if (udp != null)
+            {
+                stats += $";udp.received={udp.Received};udp.processed={udp.Processed};udp.dropped={udp.Dropped};udp.malformed={udp.Malformed};udp.queued={udp.QueueLength}";
+            }
+            
+            var ring = _ringListener;
+            if (ring != null)
+            {
+                stats += $";ring.received={ring.Received};ring.processed={ring.Processed};ring.dropped={ring.Dropped};ring.malformed={ring.Malformed};ring.bytes={ring.QueuedBytes}";
+            }
+            
+            var http = _httpEndpoint;
+            if (http != null)
+            {
+                stats += $";http.requests={http.HttpRequests};ws.connections={http.WebSocketConnections};ws.total={http.WebSocketTotal};ws.messages={http.WebSocketMessages};ws.pushed={http.WebSocketPushed};ws.dropped={http.WebSocketDropped}";
+            }
+            
+            var recorder = _recorder;
+            if (recorder != null)
+            {
+                stats += $";record.commands={recorder.Recorded};record.dropped={recorder.Dropped};record.bytes={recorder.Bytes}";
+            }
+            
+            var events = EventRegistry;
+            if (events.Count > 0)
+            {
+                stats += $";events.resolved={events.Resolved};events.cache.hits={events.CacheHits};events.cache.misses={events.CacheMisses}";
+            }
+            
+            var limiter = RateLimiter;
+            if (limiter != null)
+            {
+                stats += ";" + limiter.FormatStats();
+            }
+            
+            var scheduler = ChatScheduler;
+            if (scheduler != null)
+            {
+                stats += ";" + scheduler.FormatStats();
+            }
+            
+            string hostStats = StatsProvider?.Invoke();
+            if (!string.IsNullOrEmpty(hostStats))
+            {
+                stats += ";" + hostStats;
+            }
+            
+            return stats;
+        }
+        
+        public void Dispose()
+        {
+            Stop();
+            StopRecording();
+            _cancellationTokenSource?.Dispose();
+        }
+    }
+    
+    /// <summary>
+    /// State for one connected client
+    /// </summary>
+    public class PipelineConnection
+    {
+        public PipelineConnection(string id)
+        {
+            Id = id;
+            ClientId = id;
+            ConnectedAt = DateTime.UtcNow;
+        }
+        
+        /// <summary>
+        /// Transport-level identity (pipe instance or remote endpoint)
+        /// </summary>
+        public string Id { get; }
+        
+        /// <summary>
+        /// Identity used for fair sharing and quotas; the connection id unless the client sent SESSION
+        /// </summary>
+        public string ClientId { get; set; }
+        
+        /// <summary>
+        /// Names the client for quotas, like SESSION:name. Names show up in STATS as
+        /// client[session:name], so they are kept to characters that can't break its fields.
+        /// </summary>
+        internal bool TrySetSession(string name)
+        {
+            if (string.IsNullOrEmpty(name) || name.Length > 64)
+                return false;
+            
+            foreach (char c in name)
+            {
+                if (!char.IsLetterOrDigit(c) && c != '-' && c != '_' && c != '.')
+                    return false;
+            }
+            
+            ClientId = "session:" + name;
+            return true;
+        }
+        
+        /// <summary>
+        /// Deadline for CHAT commands sent on this connection without their own (set by TTL:ms)
+        /// </summary>
+        public TimeSpan? DefaultTtl { get; set; }
+        
+        public DateTime ConnectedAt { get; }
+        
+        // 0 = waiting for a command, 1 = running one, 2 = closing
+        private int _state;
+        private long _lastActivity;
+        private long _rateLimitedAt;
+        
+        /// <summary>
+        /// Stopwatch timestamp of the last command, for connectionless senders (UDP)
+        /// </summary>
+        internal long LastActivity
+        {
+            get => Interlocked.Read(ref _lastActivity);
+            set => Interlocked.Exchange(ref _lastActivity, value);
+        }
+        
+        /// <summary>
+        /// Token bucket for this connection's commands, created by the rate limiter
+        /// </summary>
+        internal TokenBucket RateBucket { get; set; }
+        
+        /// <summary>
+        /// Logs that the connection went over its rate limit, at most once every 10 seconds so a
+        /// flood doesn't also flood the log
+        /// </summary>
+        internal void NoteRateLimited()
+        {
+            long now = Stopwatch.GetTimestamp();
+            long last = Interlocked.Read(ref _rateLimitedAt);
+            if (last != 0 && now - last < Stopwatch.Frequency * 10)
+                return;
+            if (Interlocked.CompareExchange(ref _rateLimitedAt, now, last) == last)
+            {
+                Logger.LogWarning($"Pipeline: {Id} is over its rate limit");
+            }
+        }
+        
+        
+        /// <summary>
+        /// Closes the transport, which also ends a pending read
+        /// </summary>
+        internal Action Close { get; set; }
+        
+        /// <summary>
+        /// Marks a command as running; false once the server has asked the connection to close
+        /// </summary>
+        internal bool BeginCommand()
+        {
+            return Interlocked.CompareExchange(ref _state, 1, 0) == 0;
+        }
+        
+        /// <summary>
+        /// Marks the command finished; false if the server asked the connection to close meanwhile
+        /// </summary>
+        internal bool EndCommand()
+        {
+            return Interlocked.CompareExchange(ref _state, 0, 1) == 1;
+        }
+        
+        /// <summary>
+        /// Asks the connection to close: now if it is idle, otherwise after its current response
+        /// </summary>
+        internal void Drain()
+        {
+            if (Interlocked.Exchange(ref _state, 2) == 0)
+            {
+                Abort();
+            }
+        }
+        
+        /// <summary>
+        /// Closes the connection whatever it is doing
+        /// </summary>
+        internal void Abort()
+        {
+            try
+            {
+                Close?.Invoke();
+            }
+            catch (Exception)
+            {
+                // Already closed
+            }
+        }
+    }
+    
+    /// <summary>
+    /// What happened to the open connections when the server stopped
+    /// </summary>
+    public class PipelineShutdownResult
+    {
+        public PipelineShutdownResult(int drained, int aborted, TimeSpan elapsed)
+        {
+            Drained = drained;
+            Aborted = aborted;
+            Elapsed = elapsed;
+        }
+        
+        /// <summary>
+        /// Connections that were idle or finished their command and closed cleanly
+        /// </summary>
+        public int Drained { get; }
+        
+        /// <summary>
+        /// Connections cut off mid-command when the drain timeout ran out
+        /// </summary>
+        public int Aborted { get; }
+        
+        public TimeSpan Elapsed { get; }
+    }
     
     /// <summary>
     /// Represents a pipeline command
     /// </summary>
-    public class PipelineCommand
+    public class PipelineCommand : EventArgs
     {
         public string Command { get; set; }
+        
+        /// <summary>
+        /// Character named with COMMAND@Name, or null for the default character
+        /// </summary>
+        public string Character { get; set; }
+        
         public string Data { get; set; }
     }
 }
@@ -0,0 +1,176 @@
+using System;
+using System.Text;
+using System.Threading;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Consumes fire-and-forget commands from a shared-memory ring written by same-machine mods.
+    /// A dedicated thread drains the ring, spins briefly when it runs dry so bursts are picked up
+    /// without a wakeup, and then sleeps until a producer signals.
+    /// </summary>
+    public class RingCommandListener : IDisposable
+    {
+        // Spins before sleeping; covers the gap between events in a burst
+        private const int SpinIterations = 64;
+        private static readonly TimeSpan IdleWait = TimeSpan.FromMilliseconds(100);
+        private static readonly Encoding StrictUtf8 = new UTF8Encoding(false, true);
+
+        private readonly string _name;
+        private readonly string _path;
+        private readonly long _capacity;
+        private readonly Action<string> _dispatch;
+        private SharedMemoryRing _ring;
+        private Thread _thread;
+        private volatile bool _stopping;
+
+        private long _received;
+        private long _malformed;
+        private long _processed;
+
+        /// <param name="name">Ring name; producers open the same name (and event) to write</param>
+        /// <param name="path">Backing file, or null for a named Windows mapping</param>
+        /// <param name="capacity">Ring size in bytes</param>
+        /// <param name="dispatch">Handles one decoded command line</param>
+        public RingCommandListener(string name, string path, long capacity, Action<string> dispatch)
+        {
+            _name = name;
+            _path = path;
+            _capacity = capacity;
+            _dispatch = dispatch ?? throw new ArgumentNullException(nameof(dispatch));
+        }
+
+        public long Received => Interlocked.Read(ref _received);
+        public long Malformed => Interlocked.Read(ref _malformed);
+        public long Processed => Interlocked.Read(ref _processed);
+        public long Dropped => _ring?.Dropped ?? 0;
+        public long QueuedBytes => _ring?.UsedBytes ?? 0;
+
+        public void Start()
+        {
+            if (_ring != null)
+                return;
+
+            _ring = SharedMemoryRing.Create(_name, _path, _capacity);
+            _stopping = false;
+            _thread = new Thread(ConsumeLoop)
+            {
+                IsBackground = true,
+                Name = "Pipeline ring consumer"
+            };
+            _thread.Start();
+
+            string location = string.IsNullOrEmpty(_path) ? _name : _path;
+            Logger.Log($"Ring Pipeline: Listening on {location} ({_ring.Capacity / 1024} KB{(_ring.HasSignal ? "" : ", polling")})");
+        }
+
+        public void Stop()
+        {
+            if (_ring == null)
+                return;
+
+            _stopping = true;
+            _ring.Wake();
+            bool stopped = _thread.Join(TimeSpan.FromSeconds(2));
+            _thread = null;
+
+            // A consumer still inside a command would read from the view once it returns, so the
+            // mapping is only released after the thread has exited; otherwise it is left to the GC
+            if (stopped)
+            {
+                _ring.Dispose();
+            }
+            else
+            {
+                Logger.LogWarning("Ring Pipeline: Consumer did not stop within 2 seconds, leaving the ring mapped");
+            }
+            _ring = null;
+
+            Logger.Log("Ring Pipeline: Stopped");
+        }
+
+        private void ConsumeLoop()
+        {
+            var ring = _ring;
+            var buffer = new byte[SharedMemoryRing.MaxMessageLength];
+            int idleSpins = 0;
+
+            while (!_stopping)
+            {
+                int length;
+                try
+                {
+                    length = ring.TryRead(buffer);
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("Ring Pipeline: Read error", ex);
+                    break;
+                }
+
+                if (length == 0)
+                {
+                    if (idleSpins++ < SpinIterations)
+                    {
+                        // On one core, spinning would only delay the producer we're waiting for
+                        if (Environment.ProcessorCount > 1)
+                            Thread.SpinWait(20);
+                        else
+                            Thread.Yield();
+                        continue;
+                    }
+                    idleSpins = 0;
+                    ring.WaitForData(IdleWait);
+                    continue;
+                }
+                idleSpins = 0;
+
+                Interlocked.Increment(ref _received);
+                string line = length > 0 ? Decode(buffer, length) : null;
+                if (line == null)
+                {
+                    Interlocked.Increment(ref _malformed);
+                    continue;
+                }
+
+                try
+                {
+                    _dispatch(line);
+                    Interlocked.Increment(ref _processed);
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("Ring Pipeline: Error dispatching command", ex);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Decodes one command, or returns null if the record isn't a single valid UTF-8 line
+        /// </summary>
+        private static string Decode(byte[] buffer, int length)
+        {
+            for (int i = 0; i < length; i++)
+            {
+                byte b = buffer[i];
+                if (b == (byte)'\n' || b == (byte)'\r' || b == 0)
+                    return null;
+            }
+
+            try
+            {
+                return StrictUtf8.GetString(buffer, 0, length);
+            }
+            catch (DecoderFallbackException)
+            {
+                return null;
+            }
+        }
+
+        public void Dispose()
+        {
+            Stop();
+        }
+    }
+}
@@ -0,0 +1,438 @@
+using System;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Multi-producer, single-consumer queue of command lines in shared memory, for mods
+    /// that send events faster than a pipe or socket round trip allows. Producers append
+    /// records with one compare-and-swap and no system call; the consumer is only signalled
+    /// when it has gone to sleep on an empty ring.
+    ///
+    /// Layout (little-endian, offsets in bytes):
+    ///   0   int  magic "MSAR"
+    ///   4   int  version (1)
+    ///   8   long data capacity (power of two)
+    ///   64  long tail - bytes ever reserved by producers
+    ///   128 long head - bytes ever consumed
+    ///   192 int  consumer waiting flag (1 = producer must signal)
+    ///   196 int  dropped - writes refused because the ring was full
+    ///   256      data
+    ///
+    /// Each record starts at an 8-byte boundary with an int header followed by UTF-8 bytes.
+    /// The header is 0 while the record is being written, the byte count once committed,
+    /// or minus the record size for padding that skips to the end of the buffer.
+    /// The consumer zeroes what it has read before advancing head.
+    ///
+    /// A sleeping consumer is woken through a named event on Windows and a futex on the
+    /// waiting flag on Linux, which is used for tests and benchmarks with a file-backed mapping.
+    /// </summary>
+    public sealed unsafe class SharedMemoryRing : IDisposable
+    {
+        public const int Magic = 0x5241534D; // "MSAR"
+        public const int Version = 1;
+        public const int HeaderSize = 256;
+        public const int MaxMessageLength = 8192;
+
+        private const int CapacityOffset = 8;
+        private const int TailOffset = 64;
+        private const int HeadOffset = 128;
+        private const int WaitingOffset = 192;
+        private const int DroppedOffset = 196;
+
+        private readonly MemoryMappedFile _file;
+        private readonly MemoryMappedViewAccessor _view;
+        private readonly EventWaitHandle _signal;
+        private readonly bool _futex;
+        private readonly byte* _base;
+        private readonly byte* _data;
+        private readonly long _capacity;
+        private readonly long _mask;
+        private bool _disposed;
+
+        private SharedMemoryRing(MemoryMappedFile file, EventWaitHandle signal, long capacity, bool initialize)
+        {
+            _file = file;
+            _signal = signal;
+            _futex = signal == null && Futex.IsSupported;
+            _view = file.CreateViewAccessor(0, HeaderSize + capacity);
+
+            byte* pointer = null;
+            _view.SafeMemoryMappedViewHandle.AcquirePointer(ref pointer);
+            _base = pointer + _view.PointerOffset;
+            _data = _base + HeaderSize;
+
+            if (initialize)
+            {
+                for (long i = 0; i < HeaderSize + capacity; i += sizeof(long))
+                {
+                    *(long*)(_base + i) = 0;
+                }
+                *(int*)(_base + 4) = Version;
+                *(long*)(_base + CapacityOffset) = capacity;
+                Volatile.Write(ref *(int*)_base, Magic);
+            }
+            else
+            {
+                if (Volatile.Read(ref *(int*)_base) != Magic || *(int*)(_base + 4) != Version)
+                {
+                    Dispose();
+                    throw new InvalidDataException("Shared memory is not an MSAgentAI command ring");
+                }
+                capacity = *(long*)(_base + CapacityOffset);
+            }
+
+            _capacity = capacity;
+            _mask = capacity - 1;
+        }
+
+        /// <summary>
+        /// Creates the ring for the consumer. With a path the mapping is backed by that file
+        /// (the only option outside Windows); otherwise it is a named Windows mapping.
+        /// Throws PlatformNotSupportedException for a named mapping elsewhere.
+        /// </summary>
+        /// <param name="name">Mapping name, also used to name the wakeup event</param>
+        /// <param name="path">Backing file, or null for a named mapping</param>
+        /// <param name="capacity">Data bytes; rounded up to a power of two</param>
+        public static SharedMemoryRing Create(string name, string path, long capacity)
+        {
+            capacity = RoundUpToPowerOfTwo(Math.Max(capacity, 4 * (MaxMessageLength + 8)));
+
+            MemoryMappedFile file;
+            if (!string.IsNullOrEmpty(path))
+            {
+                using (var stream = new FileStream(path, FileMode.Create, FileAccess.ReadWrite, FileShare.ReadWrite))
+                {
+                    stream.SetLength(HeaderSize + capacity);
+                }
+                file = MemoryMappedFile.CreateFromFile(path, FileMode.Open, null, HeaderSize + capacity, MemoryMappedFileAccess.ReadWrite);
+            }
+            else if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                file = MemoryMappedFile.CreateOrOpen(GetMapName(name), HeaderSize + capacity);
+            }
+            else
+            {
+                throw new PlatformNotSupportedException("Named rings need Windows; give the ring a file path instead");
+            }
+
+            return new SharedMemoryRing(file, CreateSignal(name), capacity, true);
+        }
+
+        /// <summary>
+        /// Opens an existing ring as a producer
+        /// </summary>
+        public static SharedMemoryRing Open(string name, string path)
+        {
+            MemoryMappedFile file;
+            long length;
+            if (!string.IsNullOrEmpty(path))
+            {
+                length = new FileInfo(path).Length;
+                file = MemoryMappedFile.CreateFromFile(path, FileMode.Open, null, 0, MemoryMappedFileAccess.ReadWrite);
+            }
+            else if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                file = MemoryMappedFile.OpenExisting(GetMapName(name));
+                using (var header = file.CreateViewAccessor(0, HeaderSize))
+                {
+                    length = HeaderSize + header.ReadInt64(CapacityOffset);
+                }
+            }
+            else
+            {
+                throw new PlatformNotSupportedException("Named rings need Windows; open the ring by its file path instead");
+            }
+
+            return new SharedMemoryRing(file, CreateSignal(name), length - HeaderSize, false);
+        }
+
+        public long Capacity => _capacity;
+
+        /// <summary>
+        /// Bytes written but not yet consumed
+        /// </summary>
+        public long UsedBytes => Volatile.Read(ref *(long*)(_base + TailOffset)) - Volatile.Read(ref *(long*)(_base + HeadOffset));
+
+        /// <summary>
+        /// Writes refused by producers because the ring was full
+        /// </summary>
+        public int Dropped => Volatile.Read(ref *(int*)(_base + DroppedOffset));
+
+        /// <summary>
+        /// Whether the consumer can be woken by an event; otherwise it polls
+        /// </summary>
+        public bool HasSignal => _signal != null || _futex;
+
+        /// <summary>
+        /// Appends one command. Returns false, and counts a drop, if the ring is full.
+        /// Safe to call from any number of threads and processes at once.
+        /// </summary>
+        public bool TryWrite(string message)
+        {
+            int length = Encoding.UTF8.GetByteCount(message);
+            if (length == 0 || length > MaxMessageLength)
+                throw new ArgumentException($"Message must be 1 to {MaxMessageLength} bytes", nameof(message));
+
+            long size = Align(sizeof(int) + length);
+            long* tail = (long*)(_base + TailOffset);
+            long* head = (long*)(_base + HeadOffset);
+            long position;
+            long padding;
+
+            while (true)
+            {
+                position = Volatile.Read(ref *tail);
+                long offset = position & _mask;
+                padding = offset + size > _capacity ? _capacity - offset : 0;
+
+                if (position + padding + size - Volatile.Read(ref *head) > _capacity)
+                {
+                    Interlocked.Increment(ref *(int*)(_base + DroppedOffset));
+                    return false;
+                }
+
+                if (Interlocked.CompareExchange(ref *tail, position + padding + size, position) == position)
+                    break;
+            }
+
+            if (padding > 0)
+            {
+                // Doesn't fit before the end of the buffer; skip to the start
+                Volatile.Write(ref *(int*)(_data + (position & _mask)), (int)-padding);
+                position += padding;
+            }
+
+            byte* record = _data + (position & _mask);
+            fixed (char* chars = message)
+            {
+                Encoding.UTF8.GetBytes(chars, message.Length, record + sizeof(int), length);
+            }
+            Volatile.Write(ref *(int*)record, length);
+
+            // Only pay for a system call when the consumer has gone to sleep
+            int* waiting = (int*)(_base + WaitingOffset);
+            if (Volatile.Read(ref *waiting) != 0 && Interlocked.Exchange(ref *waiting, 0) != 0)
+            {
+                Signal(waiting);
+            }
+            return true;
+        }
+
+        /// <summary>
+        /// Copies the next committed record into buffer. Returns its length, 0 if the ring is
+        /// empty or the next record is still being written, or -1 if a producer wrote a bad
+        /// header and everything queued was discarded. Single consumer only.
+        /// </summary>
+        public int TryRead(byte[] buffer)
+        {
+            long* head = (long*)(_base + HeadOffset);
+
+            while (true)
+            {
+                long position = *head;
+                long tailPosition = Volatile.Read(ref *(long*)(_base + TailOffset));
+                if (position == tailPosition)
+                    return 0;
+
+                long offset = position & _mask;
+                byte* record = _data + offset;
+                int header = Volatile.Read(ref *(int*)record);
+                if (header == 0)
+                    return 0;
+
+                if (header > MaxMessageLength || (header < 0 && (-header & 7) != 0) || (header < 0 && -header > _capacity - offset))
+                {
+                    Discard(position, tailPosition);
+                    return -1;
+                }
+
+                long size;
+                int length = 0;
+                if (header < 0)
+                {
+                    size = -header;
+                }
+                else
+                {
+                    length = Math.Min(header, buffer.Length);
+                    fixed (byte* destination = buffer)
+                    {
+                        Buffer.MemoryCopy(record + sizeof(int), destination, buffer.Length, length);
+                    }
+                    size = Align(sizeof(int) + header);
+                }
+
+                // Producers rely on unread space being zero
+                for (long i = 0; i < size; i += sizeof(long))
+                {
+                    *(long*)(record + i) = 0;
+                }
+                Volatile.Write(ref *head, position + size);
+
+                if (header > 0)
+                    return length;
+            }
+        }
+
+        /// <summary>
+        /// Zeroes and skips everything up to tailPosition so the ring can recover from a bad record
+        /// </summary>
+        private void Discard(long position, long tailPosition)
+        {
+            for (long i = position; i < tailPosition; i += sizeof(long))
+            {
+                *(long*)(_data + (i & _mask)) = 0;
+            }
+            Volatile.Write(ref *(long*)(_base + HeadOffset), tailPosition);
+        }
+
+        /// <summary>
+        /// Blocks until a producer signals or the timeout passes. Call only after TryRead
+        /// returned 0; the ring is checked again after announcing the wait so a write can't be missed.
+        /// </summary>
+        public void WaitForData(TimeSpan timeout)
+        {
+            if (!HasSignal)
+            {
+                Thread.Sleep(1);
+                return;
+            }
+
+            int* waiting = (int*)(_base + WaitingOffset);
+            Interlocked.Exchange(ref *waiting, 1);
+
+            long headPosition = *(long*)(_base + HeadOffset);
+            if (headPosition == Volatile.Read(ref *(long*)(_base + TailOffset)))
+            {
+                if (_signal != null)
+                {
+                    _signal.WaitOne(timeout);
+                }
+                else
+                {
+                    // Returns at once if a producer already cleared the flag
+                    Futex.Wait(waiting, 1, timeout);
+                }
+            }
+            Interlocked.Exchange(ref *waiting, 0);
+        }
+
+        /// <summary>
+        /// Wakes a consumer blocked in WaitForData, e.g. so it can shut down
+        /// </summary>
+        public void Wake()
+        {
+            int* waiting = (int*)(_base + WaitingOffset);
+            Interlocked.Exchange(ref *waiting, 0);
+            Signal(waiting);
+        }
+
+        private void Signal(int* waiting)
+        {
+            if (_signal != null)
+            {
+                _signal.Set();
+            }
+            else if (_futex)
+            {
+                Futex.Wake(waiting);
+            }
+        }
+
+        private static EventWaitHandle CreateSignal(string name)
+        {
+            // Named events only exist on Windows; Linux uses a futex and anything else polls
+            if (Environment.OSVersion.Platform != PlatformID.Win32NT)
+                return null;
+
+            return new EventWaitHandle(false, EventResetMode.AutoReset, GetMapName(name) + ".Signal");
+        }
+
+        /// <summary>
+        /// Linux futex on a word in shared memory (not FUTEX_PRIVATE, so it works across processes)
+        /// </summary>
+        private static class Futex
+        {
+            private const int FutexWait = 0;
+            private const int FutexWake = 1;
+
+            public static readonly bool IsSupported =
+                RuntimeInformation.IsOSPlatform(OSPlatform.Linux) && SyscallNumber != 0;
+
+            private static long SyscallNumber
+            {
+                get
+                {
+                    switch (RuntimeInformation.ProcessArchitecture)
+                    {
+                        case Architecture.X64: return 202;
+                        case Architecture.Arm64: return 98;
+                        default: return 0;
+                    }
+                }
+            }
+
+            public static void Wait(int* address, int expected, TimeSpan timeout)
+            {
+                var timespec = new Timespec
+                {
+                    Seconds = (long)timeout.TotalSeconds,
+                    Nanoseconds = (timeout.Ticks % TimeSpan.TicksPerSecond) * 100
+                };
+                syscall(SyscallNumber, address, FutexWait, expected, &timespec, IntPtr.Zero, 0);
+            }
+
+            public static void Wake(int* address)
+            {
+                syscall(SyscallNumber, address, FutexWake, 1, null, IntPtr.Zero, 0);
+            }
+
+            [StructLayout(LayoutKind.Sequential)]
+            private struct Timespec
+            {
+                public long Seconds;
+                public long Nanoseconds;
+            }
+
+            [DllImport("libc", SetLastError = true)]
+            private static extern long syscall(long number, int* address, int operation, int value, Timespec* timeout, IntPtr address2, int value3);
+        }
+
+        private static string GetMapName(string name)
+        {
+            return "Local\\" + (string.IsNullOrEmpty(name) ? "MSAgentAI.Ring" : name);
+        }
+
+        private static long Align(long size)
+        {
+            return (size + 7) & ~7L;
+        }
+
+        private static long RoundUpToPowerOfTwo(long value)
+        {
+            long result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        public void Dispose()
+        {
+            if (_disposed)
+                return;
+
+            _disposed = true;
+            _view.SafeMemoryMappedViewHandle.ReleasePointer();
+            _view.Dispose();
+            _file.Dispose();
+            _signal?.Dispose();
+        }
+    }
+}
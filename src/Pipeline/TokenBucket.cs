@@ -0,0 +1,71 @@
+using System;
+using System.Diagnostics;
+using System.Threading;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Lock-free token bucket. Instead of a token count and a refill time, it keeps one value:
+    /// the Stopwatch time at which the bucket would be full again (the generic cell rate
+    /// algorithm). Taking tokens pushes that time forward, so a take is a single
+    /// compare-and-swap and needs no refill timer.
+    /// </summary>
+    public sealed class TokenBucket
+    {
+        private readonly double _ticksPerToken;
+        private readonly long _capacityTicks;
+        private long _fullAt;
+
+        /// <param name="tokensPerSecond">Sustained rate</param>
+        /// <param name="capacity">Tokens available at once after a quiet period</param>
+        public TokenBucket(double tokensPerSecond, double capacity)
+        {
+            if (tokensPerSecond <= 0)
+                throw new ArgumentOutOfRangeException(nameof(tokensPerSecond));
+
+            TokensPerSecond = tokensPerSecond;
+            Capacity = Math.Max(1, capacity);
+            _ticksPerToken = Stopwatch.Frequency / tokensPerSecond;
+            _capacityTicks = (long)(Capacity * _ticksPerToken);
+        }
+
+        public double TokensPerSecond { get; }
+        public double Capacity { get; }
+
+        /// <summary>
+        /// Takes tokens if they are available now, or will be within maxWaitTicks. On success
+        /// waitTicks is how long the caller must wait before acting (0 if none); on failure it is
+        /// how long until the tokens would be available.
+        /// </summary>
+        public bool TryTake(int tokens, long now, long maxWaitTicks, out long waitTicks)
+        {
+            long cost = (long)(tokens * _ticksPerToken);
+            while (true)
+            {
+                long fullAt = Volatile.Read(ref _fullAt);
+                long next = Math.Max(fullAt, now) + cost;
+                long excess = next - now - _capacityTicks;
+
+                if (excess > maxWaitTicks)
+                {
+                    waitTicks = excess;
+                    return false;
+                }
+
+                if (Interlocked.CompareExchange(ref _fullAt, next, fullAt) == fullAt)
+                {
+                    waitTicks = Math.Max(0, excess);
+                    return true;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gives back tokens taken by TryTake, when a later check failed
+        /// </summary>
+        public void Return(int tokens)
+        {
+            Interlocked.Add(ref _fullAt, -(long)(tokens * _ticksPerToken));
+        }
+    }
+}
@@ -0,0 +1,284 @@
+using System;
+using System.Collections.Concurrent;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Pipeline
+{
+    /// <summary>
+    /// Fire-and-forget UDP ingest for pipeline commands.
+    /// Each datagram carries one command and gets no response. Datagrams are received
+    /// into pooled buffers and handed to a single dispatcher through a bounded queue;
+    /// when the dispatcher can't keep up, new datagrams are dropped rather than queued,
+    /// so a game emitting events every frame can never back up the agent.
+    /// </summary>
+    public class UdpCommandListener : IDisposable
+    {
+        // Matches the line limit of the stream transports, plus room for a trailing newline
+        public const int MaxDatagramLength = 8192 + 2;
+
+        private static readonly Encoding StrictUtf8 = new UTF8Encoding(false, true);
+
+        private readonly IPEndPoint _endPoint;
+        private readonly int _queueCapacity;
+        private readonly Func<string, EndPoint, Task> _dispatch;
+        private readonly ConcurrentQueue<Datagram> _queue = new ConcurrentQueue<Datagram>();
+        private readonly ConcurrentBag<byte[]> _bufferPool = new ConcurrentBag<byte[]>();
+        private readonly SemaphoreSlim _queued = new SemaphoreSlim(0);
+        private CancellationTokenSource _cancellationTokenSource;
+        private Socket _socket;
+        private Task _receiveTask;
+        private Task _dispatchTask;
+        private int _queueLength;
+
+        private long _received;
+        private long _dropped;
+        private long _malformed;
+        private long _processed;
+
+        /// <param name="endPoint">Address and port to bind</param>
+        /// <param name="queueCapacity">Datagrams allowed to wait for dispatch before new ones are dropped</param>
+        /// <param name="dispatch">Handles one decoded command line and its sender; the next waits for it</param>
+        public UdpCommandListener(IPEndPoint endPoint, int queueCapacity, Func<string, EndPoint, Task> dispatch)
+        {
+            _endPoint = endPoint ?? throw new ArgumentNullException(nameof(endPoint));
+            _queueCapacity = Math.Max(1, queueCapacity);
+            _dispatch = dispatch ?? throw new ArgumentNullException(nameof(dispatch));
+        }
+
+        public long Received => Interlocked.Read(ref _received);
+        public long Dropped => Interlocked.Read(ref _dropped);
+        public long Malformed => Interlocked.Read(ref _malformed);
+        public long Processed => Interlocked.Read(ref _processed);
+        public int QueueLength => Volatile.Read(ref _queueLength);
+
+        public void Start()
+        {
+            if (_socket != null)
+                return;
+
+            _cancellationTokenSource = new CancellationTokenSource();
+            _socket = new Socket(_endPoint.AddressFamily, SocketType.Dgram, ProtocolType.Udp);
+
+            // A larger kernel buffer absorbs bursts while the dispatcher is busy on the UI thread
+            _socket.ReceiveBufferSize = 1 << 20;
+            _socket.Bind(_endPoint);
+
+            var token = _cancellationTokenSource.Token;
+            _receiveTask = Task.Factory.StartNew(() => ReceiveLoop(token), token, TaskCreationOptions.LongRunning, TaskScheduler.Default);
+            _dispatchTask = Task.Run(() => DispatchLoopAsync(token));
+
+            Logger.Log($"UDP Pipeline: Listening on {_endPoint}");
+        }
+
+        public void Stop()
+        {
+            if (_socket == null)
+                return;
+
+            _cancellationTokenSource.Cancel();
+
+            // Closing the socket unblocks ReceiveFrom
+            _socket.Close();
+            _socket = null;
+
+            try
+            {
+                Task.WaitAll(new[] { _receiveTask, _dispatchTask }, TimeSpan.FromSeconds(2));
+            }
+            catch (AggregateException)
+            {
+            }
+
+            _cancellationTokenSource.Dispose();
+            _cancellationTokenSource = null;
+
+            // Return anything still queued to the pool
+            while (_queue.TryDequeue(out var datagram))
+            {
+                ReturnBuffer(datagram.Buffer);
+            }
+            Interlocked.Exchange(ref _queueLength, 0);
+
+            Logger.Log("UDP Pipeline: Stopped");
+        }
+
+        private void ReceiveLoop(CancellationToken cancellationToken)
+        {
+            var socket = _socket;
+            EndPoint anyEndPoint = new IPEndPoint(_endPoint.AddressFamily == AddressFamily.InterNetworkV6 ? IPAddress.IPv6Any : IPAddress.Any, 0);
+
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                byte[] buffer = RentBuffer();
+                EndPoint remote = anyEndPoint;
+                int length;
+
+                try
+                {
+                    length = socket.ReceiveFrom(buffer, 0, buffer.Length, SocketFlags.None, ref remote);
+                }
+                catch (SocketException ex) when (ex.SocketErrorCode == SocketError.MessageSize)
+                {
+                    // Longer than any valid command (Windows reports truncation as an error)
+                    Interlocked.Increment(ref _received);
+                    Interlocked.Increment(ref _malformed);
+                    ReturnBuffer(buffer);
+                    continue;
+                }
+                catch (SocketException ex) when (ex.SocketErrorCode == SocketError.ConnectionReset)
+                {
+                    // ICMP port unreachable from an earlier send; irrelevant for a receive-only socket
+                    ReturnBuffer(buffer);
+                    continue;
+                }
+                catch (Exception) when (cancellationToken.IsCancellationRequested)
+                {
+                    ReturnBuffer(buffer);
+                    break;
+                }
+                catch (ObjectDisposedException)
+                {
+                    ReturnBuffer(buffer);
+                    break;
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("UDP Pipeline: Receive error", ex);
+                    ReturnBuffer(buffer);
+                    continue;
+                }
+
+                Interlocked.Increment(ref _received);
+
+                // A full buffer means the datagram may have been truncated
+                if (length == 0 || length >= buffer.Length)
+                {
+                    Interlocked.Increment(ref _malformed);
+                    ReturnBuffer(buffer);
+                    continue;
+                }
+
+                // Drop on overload: never block the receive loop waiting for the dispatcher
+                if (Interlocked.Increment(ref _queueLength) > _queueCapacity)
+                {
+                    Interlocked.Decrement(ref _queueLength);
+                    Interlocked.Increment(ref _dropped);
+                    ReturnBuffer(buffer);
+                    continue;
+                }
+
+                _queue.Enqueue(new Datagram { Buffer = buffer, Length = length, Remote = remote });
+                _queued.Release();
+            }
+        }
+
+        private async Task DispatchLoopAsync(CancellationToken cancellationToken)
+        {
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                try
+                {
+                    await _queued.WaitAsync(cancellationToken);
+                }
+                catch (OperationCanceledException)
+                {
+                    break;
+                }
+
+                if (!_queue.TryDequeue(out var datagram))
+                    continue;
+
+                Interlocked.Decrement(ref _queueLength);
+
+                string line;
+                try
+                {
+                    line = Decode(datagram.Buffer, datagram.Length);
+                }
+                finally
+                {
+                    ReturnBuffer(datagram.Buffer);
+                }
+
+                if (line == null)
+                {
+                    Interlocked.Increment(ref _malformed);
+                    continue;
+                }
+
+                try
+                {
+                    await _dispatch(line, datagram.Remote);
+                    Interlocked.Increment(ref _processed);
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("UDP Pipeline: Error dispatching command", ex);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Decodes one command, or returns null if the datagram isn't a single valid UTF-8 line
+        /// </summary>
+        private static string Decode(byte[] buffer, int length)
+        {
+            // Allow one trailing newline, as senders often reuse their line-based code
+            if (length > 0 && buffer[length - 1] == (byte)'\n')
+                length--;
+            if (length > 0 && buffer[length - 1] == (byte)'\r')
+                length--;
+
+            if (length == 0 || length > MaxDatagramLength - 2)
+                return null;
+
+            for (int i = 0; i < length; i++)
+            {
+                byte b = buffer[i];
+                if (b == (byte)'\n' || b == (byte)'\r' || b == 0)
+                    return null;
+            }
+
+            try
+            {
+                return StrictUtf8.GetString(buffer, 0, length);
+            }
+            catch (DecoderFallbackException)
+            {
+                return null;
+            }
+        }
+
+        private byte[] RentBuffer()
+        {
+            return _bufferPool.TryTake(out var buffer) ? buffer : new byte[MaxDatagramLength + 1];
+        }
+
+        private void ReturnBuffer(byte[] buffer)
+        {
+            // Keep enough buffers for a full queue plus the one being received into
+            if (_bufferPool.Count <= _queueCapacity)
+            {
+                _bufferPool.Add(buffer);
+            }
+        }
+
+        public void Dispose()
+        {
+            Stop();
+            _queued.Dispose();
+        }
+
+        private struct Datagram
+        {
+            public byte[] Buffer;
+            public int Length;
+            public EndPoint Remote;
+        }
+    }
+}
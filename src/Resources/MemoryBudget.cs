@@ -0,0 +1,465 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+using MSAgentAI.Logging;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Resources
+{
+    /// <summary>
+    /// Which caches give memory back first
+    /// </summary>
+    public enum CachePriority
+    {
+        // Cheap to rebuild, such as thumbnails read back from disk
+        Low,
+
+        // Costs something to lose, such as old conversation the AI no longer sees
+        Normal,
+
+        // Only given up when the system is short of memory
+        High
+    }
+
+    /// <summary>
+    /// One budget for every cache in a process that runs for weeks. Caches register a size
+    /// estimate and a way to give memory back. When their total goes over BudgetBytes, or the
+    /// system's memory load passes HighMemoryLoadPercent, the budget asks them to free memory,
+    /// lowest priority and largest first. Memory load is checked on a timer and after every
+    /// full GC. The process working set is sampled on the same timer, for the trend in STATS.
+    /// </summary>
+    public sealed class MemoryBudget : IDisposable
+    {
+        public static readonly TimeSpan SampleInterval = TimeSpan.FromSeconds(30);
+
+        // Working set samples kept for the trend: two hours at the sample interval
+        private const int TrendSamples = 240;
+
+        // Over budget, caches are trimmed to this share of it, so they don't go over again at once
+        private const double TrimTarget = 0.75;
+
+        private const long MB = 1024 * 1024;
+
+        private readonly object _lock = new object();
+        private readonly IClock _clock;
+        private readonly IClockTimer _timer;
+        private readonly List<Registration> _caches = new List<Registration>();
+        private readonly DateTime[] _sampleTimes = new DateTime[TrendSamples];
+        private readonly long[] _sampleBytes = new long[TrendSamples];
+        private int _sampleCount;
+        private int _sampleNext;
+        private int _checking;
+        private int _gen2Pending;
+        private long _trims;
+        private long _freed;
+        private int _memoryLoad = -1;
+        private long _workingSet;
+        private int _gen2Generation;
+        private bool _started;
+        private bool _disposed;
+
+        /// <param name="clock">Times the samples; the thread pool clock keeps them off the UI thread</param>
+        public MemoryBudget(IClock clock)
+        {
+            _clock = clock ?? throw new ArgumentNullException(nameof(clock));
+            _timer = clock.CreateTimer(SampleInterval, () => Check(false));
+        }
+
+        /// <summary>
+        /// Total the registered caches may hold
+        /// </summary>
+        public long BudgetBytes { get; set; } = 128 * MB;
+
+        /// <summary>
+        /// System memory use, as a percentage, at which every cache is asked to give back half
+        /// </summary>
+        public int HighMemoryLoadPercent { get; set; } = 90;
+
+        /// <summary>
+        /// Adds a cache. Dispose the result to remove it again.
+        /// </summary>
+        /// <param name="name">Shown in STATS as cache[name]</param>
+        /// <param name="estimateBytes">Roughly how much the cache holds now; called on the sampling thread</param>
+        /// <param name="release">Frees at least the given bytes if it can, returning how much it freed</param>
+        public IDisposable Register(string name, CachePriority priority, Func<long> estimateBytes, Func<long, long> release)
+        {
+            var registration = new Registration(this, name, priority,
+                estimateBytes ?? throw new ArgumentNullException(nameof(estimateBytes)),
+                release ?? throw new ArgumentNullException(nameof(release)));
+            lock (_lock)
+            {
+                _caches.Add(registration);
+            }
+            return registration;
+        }
+
+        public void Start()
+        {
+            lock (_lock)
+            {
+                if (_disposed || _started)
+                    return;
+                _started = true;
+
+                // Left unreferenced on purpose: the finalizer is the notification
+                new Gen2Callback(this, ++_gen2Generation);
+            }
+            _timer.Start();
+
+            // A first sample, so STATS has figures before the timer comes round
+            Check(false);
+        }
+
+        public void Stop()
+        {
+            _timer.Stop();
+            lock (_lock)
+            {
+                if (_started)
+                {
+                    _started = false;
+
+                    // The running callback sees the generation has moved on and stops re-registering
+                    _gen2Generation++;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Samples memory and trims caches if over budget or the system is short of memory
+        /// </summary>
+        /// <param name="afterFullGc">Called after a full GC, so only memory load is of interest</param>
+        public void Check(bool afterFullGc)
+        {
+            // One check at a time; a GC notification during a timed check adds nothing
+            if (Interlocked.Exchange(ref _checking, 1) == 1)
+                return;
+
+            try
+            {
+                int memoryLoad = GetMemoryLoadPercent();
+                Volatile.Write(ref _memoryLoad, memoryLoad);
+                if (!afterFullGc)
+                    SampleWorkingSet();
+
+                var caches = Estimate();
+                long total = 0;
+                foreach (var cache in caches)
+                {
+                    total += cache.Bytes;
+                }
+
+                if (memoryLoad >= HighMemoryLoadPercent)
+                {
+                    Trim(caches, total / 2, CachePriority.High, $"system memory load {memoryLoad}%");
+                }
+                else if (total > BudgetBytes)
+                {
+                    Trim(caches, total - (long)(BudgetBytes * TrimTarget), CachePriority.Normal, $"caches over budget ({FormatMB(total)} MB of {FormatMB(BudgetBytes)} MB)");
+                }
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("Memory budget check failed", ex);
+            }
+            finally
+            {
+                Volatile.Write(ref _checking, 0);
+            }
+        }
+
+        private List<CacheSize> Estimate()
+        {
+            Registration[] caches;
+            lock (_lock)
+            {
+                caches = _caches.ToArray();
+            }
+
+            var sizes = new List<CacheSize>(caches.Length);
+            foreach (var cache in caches)
+            {
+                long bytes;
+                try
+                {
+                    bytes = Math.Max(0, cache.EstimateBytes());
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"Estimating cache {cache.Name} failed", ex);
+                    bytes = 0;
+                }
+                cache.LastBytes = bytes;
+                sizes.Add(new CacheSize(cache, bytes));
+            }
+            return sizes;
+        }
+
+        /// <summary>
+        /// Asks caches up to the given priority to free the bytes wanted, lowest priority and
+        /// then largest first
+        /// </summary>
+        private void Trim(List<CacheSize> caches, long wanted, CachePriority highest, string reason)
+        {
+            caches.Sort((x, y) => x.Cache.Priority != y.Cache.Priority
+                ? x.Cache.Priority.CompareTo(y.Cache.Priority)
+                : y.Bytes.CompareTo(x.Bytes));
+
+            long freed = 0;
+            foreach (var entry in caches)
+            {
+                if (freed >= wanted)
+                    break;
+                if (entry.Cache.Priority > highest || entry.Bytes == 0)
+                    continue;
+
+                long released;
+                try
+                {
+                    released = Math.Max(0, entry.Cache.Release(Math.Min(entry.Bytes, wanted - freed)));
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"Trimming cache {entry.Cache.Name} failed", ex);
+                    continue;
+                }
+                entry.Cache.Trims++;
+                entry.Cache.Freed += released;
+                entry.Cache.LastBytes = Math.Max(0, entry.Bytes - released);
+                freed += released;
+            }
+
+            Interlocked.Increment(ref _trims);
+            Interlocked.Add(ref _freed, freed);
+            Logger.Log($"Freed {FormatMB(freed)} MB of caches: {reason}");
+        }
+
+        private void SampleWorkingSet()
+        {
+            long workingSet;
+            using (var process = Process.GetCurrentProcess())
+            {
+                workingSet = process.WorkingSet64;
+            }
+
+            lock (_lock)
+            {
+                _workingSet = workingSet;
+                _sampleTimes[_sampleNext] = _clock.UtcNow;
+                _sampleBytes[_sampleNext] = workingSet;
+                _sampleNext = (_sampleNext + 1) % TrendSamples;
+                _sampleCount = Math.Min(_sampleCount + 1, TrendSamples);
+            }
+        }
+
+        /// <summary>
+        /// Least-squares slope of the working set samples, in bytes per hour. Called with the lock held.
+        /// </summary>
+        private double GetTrendPerHour(out long min, out long max)
+        {
+            min = long.MaxValue;
+            max = 0;
+            if (_sampleCount == 0)
+            {
+                min = 0;
+                return 0;
+            }
+
+            int oldest = (_sampleNext - _sampleCount + TrendSamples) % TrendSamples;
+            var origin = _sampleTimes[oldest];
+            double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+            for (int i = 0; i < _sampleCount; i++)
+            {
+                int index = (oldest + i) % TrendSamples;
+                double hours = (_sampleTimes[index] - origin).TotalHours;
+                double bytes = _sampleBytes[index];
+                sumX += hours;
+                sumY += bytes;
+                sumXX += hours * hours;
+                sumXY += hours * bytes;
+                min = Math.Min(min, _sampleBytes[index]);
+                max = Math.Max(max, _sampleBytes[index]);
+            }
+
+            double n = _sampleCount;
+            double denominator = n * sumXX - sumX * sumX;
+            return denominator > 0 ? (n * sumXY - sumX * sumY) / denominator : 0;
+        }
+
+        /// <summary>
+        /// Memory use, its trend and the caches as semicolon-separated key=value fields, for STATS
+        /// </summary>
+        public string FormatStats()
+        {
+            var sb = new StringBuilder();
+            lock (_lock)
+            {
+                double trend = GetTrendPerHour(out long min, out long max);
+                double window = _sampleCount > 1 ? (_sampleCount - 1) * SampleInterval.TotalMinutes : 0;
+                sb.Append(string.Format(CultureInfo.InvariantCulture,
+                    "memory.ws.mb={0};memory.ws.min.mb={1};memory.ws.max.mb={2};memory.ws.trend.mbh={3:+0.0;-0.0;0.0};memory.ws.window.min={4:0};" +
+                    "memory.managed.mb={5};memory.load={6};memory.gen2={7};memory.budget.mb={8};memory.trims={9};memory.freed.mb={10}",
+                    FormatMB(_workingSet), FormatMB(min), FormatMB(max), trend / MB, window,
+                    FormatMB(GC.GetTotalMemory(false)), FormatLoad(Volatile.Read(ref _memoryLoad)), GC.CollectionCount(2), FormatMB(BudgetBytes),
+                    Interlocked.Read(ref _trims), FormatMB(Interlocked.Read(ref _freed))));
+
+                foreach (var cache in _caches)
+                {
+                    sb.Append(string.Format(CultureInfo.InvariantCulture, ";cache[{0}]=kb:{1},priority:{2},trims:{3},freed.kb:{4}",
+                        cache.Name, cache.LastBytes / 1024, cache.Priority.ToString().ToLowerInvariant(), cache.Trims, cache.Freed / 1024));
+                }
+            }
+            return sb.ToString();
+        }
+
+        private static string FormatLoad(int percent)
+        {
+            return percent < 0 ? "?" : percent.ToString(CultureInfo.InvariantCulture);
+        }
+
+        private static string FormatMB(long bytes)
+        {
+            return (bytes / (double)MB).ToString("0.0", CultureInfo.InvariantCulture);
+        }
+
+        /// <summary>
+        /// System memory in use as a percentage, or -1 when unknown
+        /// </summary>
+        private static int GetMemoryLoadPercent()
+        {
+#if NET
+            var info = GC.GetGCMemoryInfo();
+            if (info.TotalAvailableMemoryBytes > 0 && info.MemoryLoadBytes > 0)
+                return (int)(100 * info.MemoryLoadBytes / info.TotalAvailableMemoryBytes);
+            return -1;
+#else
+            if (!RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+                return -1;
+
+            var status = new MemoryStatusEx { Length = (uint)Marshal.SizeOf(typeof(MemoryStatusEx)) };
+            return GlobalMemoryStatusEx(ref status) ? (int)status.MemoryLoad : -1;
+#endif
+        }
+
+        private void OnFullGc()
+        {
+            // The finalizer thread mustn't wait on caches; one queued check is enough
+            if (Interlocked.Exchange(ref _gen2Pending, 1) == 0)
+            {
+                ThreadPool.QueueUserWorkItem(_ =>
+                {
+                    Volatile.Write(ref _gen2Pending, 0);
+                    Check(true);
+                });
+            }
+        }
+
+        private void Unregister(Registration registration)
+        {
+            lock (_lock)
+            {
+                _caches.Remove(registration);
+            }
+        }
+
+        public void Dispose()
+        {
+            lock (_lock)
+            {
+                _disposed = true;
+            }
+            Stop();
+            _timer.Dispose();
+        }
+
+        private struct CacheSize
+        {
+            public CacheSize(Registration cache, long bytes)
+            {
+                Cache = cache;
+                Bytes = bytes;
+            }
+
+            public Registration Cache { get; }
+            public long Bytes { get; }
+        }
+
+        private sealed class Registration : IDisposable
+        {
+            private readonly MemoryBudget _owner;
+
+            public Registration(MemoryBudget owner, string name, CachePriority priority, Func<long> estimateBytes, Func<long, long> release)
+            {
+                _owner = owner;
+                Name = name;
+                Priority = priority;
+                EstimateBytes = estimateBytes;
+                Release = release;
+            }
+
+            public string Name { get; }
+            public CachePriority Priority { get; }
+            public Func<long> EstimateBytes { get; }
+            public Func<long, long> Release { get; }
+
+            // Only touched by the one check running at a time
+            public long LastBytes { get; set; }
+            public long Trims { get; set; }
+            public long Freed { get; set; }
+
+            public void Dispose()
+            {
+                _owner.Unregister(this);
+            }
+        }
+
+        /// <summary>
+        /// Unreachable from the start, so it is finalized after every collection that reaches its
+        /// generation, which once promoted is every full GC; it registers itself again each time
+        /// </summary>
+        private sealed class Gen2Callback
+        {
+            private readonly WeakReference _owner;
+            private readonly int _generation;
+
+            public Gen2Callback(MemoryBudget owner, int generation)
+            {
+                _owner = new WeakReference(owner);
+                _generation = generation;
+            }
+
+            ~Gen2Callback()
+            {
+                if (Environment.HasShutdownStarted)
+                    return;
+
+                if (_owner.Target is MemoryBudget owner && Volatile.Read(ref owner._gen2Generation) == _generation)
+                {
+                    owner.OnFullGc();
+                    GC.ReRegisterForFinalize(this);
+                }
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct MemoryStatusEx
+        {
+            public uint Length;
+            public uint MemoryLoad;
+            public ulong TotalPhys;
+            public ulong AvailPhys;
+            public ulong TotalPageFile;
+            public ulong AvailPageFile;
+            public ulong TotalVirtual;
+            public ulong AvailVirtual;
+            public ulong AvailExtendedVirtual;
+        }
+
+        [DllImport("kernel32.dll", SetLastError = true)]
+        private static extern bool GlobalMemoryStatusEx(ref MemoryStatusEx status);
+    }
+}
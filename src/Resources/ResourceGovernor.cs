@@ -0,0 +1,335 @@
+using System;
+using System.Globalization;
+using System.Threading;
+using MSAgentAI.Logging;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Resources
+{
+    public enum GovernorState
+    {
+        // Background work runs as usual
+        Normal,
+
+        // The system is busy: no unprompted AI, indexing on one low-priority thread
+        Throttled,
+
+        // A full-screen program is in front: no background work at all
+        Paused
+    }
+
+    /// <summary>
+    /// Work nobody is waiting on, which the governor may hold back
+    /// </summary>
+    public enum BackgroundWork
+    {
+        // Unprompted AI lines
+        RandomDialog,
+
+        // Character preview generation
+        Indexing
+    }
+
+    /// <summary>
+    /// Samples system CPU and whether a full-screen program (usually a game) is in front, and
+    /// tells background work when to hold back. Throttles as soon as the system is busy, and
+    /// only returns to normal once it has been quiet for ResumeDelay, so work doesn't flap on
+    /// and off through a loading screen. Nothing the user asked for is held back.
+    /// </summary>
+    public sealed class ResourceGovernor : IDisposable
+    {
+        public static readonly TimeSpan SampleInterval = TimeSpan.FromSeconds(2);
+
+        private readonly object _lock = new object();
+        private readonly IClock _clock;
+        private readonly ISystemLoadSampler _sampler;
+        private readonly IClockTimer _timer;
+        private readonly long[] _allowed = new long[2];
+        private readonly long[] _deferred = new long[2];
+        private readonly TimeSpan[] _timeIn = new TimeSpan[3];
+        private GovernorState _state = GovernorState.Normal;
+        private SystemLoad _load = new SystemLoad(double.NaN, false);
+        private DateTime _lastSample;
+        private DateTime? _quietSince;
+        private long _samples;
+        private long _changes;
+        private bool _enabled = true;
+
+        /// <param name="clock">Times the samples; the thread pool clock keeps them off the UI thread</param>
+        /// <param name="sampler">Reads the system load, or null for the real one</param>
+        public ResourceGovernor(IClock clock, ISystemLoadSampler sampler = null)
+        {
+            _clock = clock ?? throw new ArgumentNullException(nameof(clock));
+            _sampler = sampler ?? new SystemLoadSampler();
+            _timer = clock.CreateTimer(SampleInterval, Sample);
+        }
+
+        /// <summary>
+        /// When off, everything runs as usual
+        /// </summary>
+        public bool Enabled
+        {
+            get { lock (_lock) return _enabled; }
+            set
+            {
+                lock (_lock)
+                {
+                    _enabled = value;
+                }
+                if (!value)
+                    Update(new SystemLoad(double.NaN, false), force: true);
+            }
+        }
+
+        /// <summary>
+        /// System CPU percentage at which background work is throttled
+        /// </summary>
+        public double BusyCpuPercent { get; set; } = 70;
+
+        /// <summary>
+        /// System CPU percentage below which it may resume
+        /// </summary>
+        public double IdleCpuPercent { get; set; } = 40;
+
+        /// <summary>
+        /// How long the system has to stay quiet before background work resumes
+        /// </summary>
+        public TimeSpan ResumeDelay { get; set; } = TimeSpan.FromSeconds(15);
+
+        /// <summary>
+        /// Pause background work while another program is full-screen
+        /// </summary>
+        public bool PauseWhenFullScreen { get; set; } = true;
+
+        public GovernorState State
+        {
+            get { lock (_lock) return _state; }
+        }
+
+        /// <summary>
+        /// The last sample taken
+        /// </summary>
+        public SystemLoad Load
+        {
+            get { lock (_lock) return _load; }
+        }
+
+        /// <summary>
+        /// Raised on the sampling thread when the state changes
+        /// </summary>
+        public event EventHandler<GovernorState> StateChanged;
+
+        public void Start()
+        {
+            lock (_lock)
+            {
+                _lastSample = _clock.UtcNow;
+            }
+            _timer.Start();
+        }
+
+        public void Stop()
+        {
+            _timer.Stop();
+            Update(new SystemLoad(double.NaN, false), force: true);
+        }
+
+        /// <summary>
+        /// Whether work of this kind should run now. Counts the answer for the stats, so ask
+        /// once per job.
+        /// </summary>
+        public bool ShouldRun(BackgroundWork work)
+        {
+            bool run = Allows(State, work);
+            Interlocked.Increment(ref (run ? _allowed : _deferred)[(int)work]);
+            return run;
+        }
+
+        private static bool Allows(GovernorState state, BackgroundWork work)
+        {
+            return state == GovernorState.Normal
+                || (state == GovernorState.Throttled && work == BackgroundWork.Indexing);
+        }
+
+        /// <summary>
+        /// Threads to use for work that would normally use the given number
+        /// </summary>
+        public int LimitParallelism(int parallelism)
+        {
+            return State == GovernorState.Normal ? parallelism : 1;
+        }
+
+        /// <summary>
+        /// Priority for background worker threads in the current state
+        /// </summary>
+        public ThreadPriority WorkerPriority
+        {
+            get { return State == GovernorState.Normal ? ThreadPriority.BelowNormal : ThreadPriority.Lowest; }
+        }
+
+        /// <summary>
+        /// Runs a background job on the calling worker thread at WorkerPriority, first waiting
+        /// until the governor allows it. Returns false, without running it, if cancelled while
+        /// waiting.
+        /// </summary>
+        public bool Run(BackgroundWork work, Action job, CancellationToken cancellationToken)
+        {
+            if (!ShouldRun(work))
+            {
+                // Look again each sample; a paused worker thread costs nothing meanwhile
+                while (!Allows(State, work))
+                {
+                    if (cancellationToken.WaitHandle.WaitOne(SampleInterval))
+                        return false;
+                }
+            }
+
+            var thread = Thread.CurrentThread;
+            var priority = thread.Priority;
+            SetPriority(thread, WorkerPriority);
+            try
+            {
+                job();
+            }
+            finally
+            {
+                SetPriority(thread, priority);
+            }
+            return true;
+        }
+
+        private static void SetPriority(Thread thread, ThreadPriority priority)
+        {
+            try
+            {
+                thread.Priority = priority;
+            }
+            catch (ThreadStateException)
+            {
+            }
+        }
+
+        private void Sample()
+        {
+            SystemLoad load;
+            try
+            {
+                load = _sampler.Sample();
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("Sampling system load failed", ex);
+                load = new SystemLoad(double.NaN, false);
+            }
+            Update(load);
+        }
+
+        /// <summary>
+        /// Moves to the state the sample calls for; force skips the resume delay
+        /// </summary>
+        internal void Update(SystemLoad load, bool force = false)
+        {
+            GovernorState previous, next;
+            lock (_lock)
+            {
+                var now = _clock.UtcNow;
+                if (_lastSample != default(DateTime) && now > _lastSample)
+                    _timeIn[(int)_state] += now - _lastSample;
+                _lastSample = now;
+                _load = load;
+                _samples++;
+
+                previous = _state;
+                next = Decide(load, now, force);
+                if (next != previous)
+                {
+                    _state = next;
+                    _changes++;
+                }
+            }
+
+            if (next == previous)
+                return;
+
+            Logger.Log($"Background work {next.ToString().ToLowerInvariant()}: CPU {FormatCpu(load.CpuPercent)}%{(load.FullScreen ? ", full-screen program in front" : "")}");
+            StateChanged?.Invoke(this, next);
+        }
+
+        /// <summary>
+        /// Called with the lock held
+        /// </summary>
+        private GovernorState Decide(SystemLoad load, DateTime now, bool force)
+        {
+            if (!_enabled)
+            {
+                _quietSince = null;
+                return GovernorState.Normal;
+            }
+
+            bool busy = !double.IsNaN(load.CpuPercent) && load.CpuPercent >= BusyCpuPercent;
+            bool quiet = double.IsNaN(load.CpuPercent) || load.CpuPercent < IdleCpuPercent;
+
+            if (load.FullScreen && PauseWhenFullScreen)
+            {
+                _quietSince = null;
+                return GovernorState.Paused;
+            }
+            if (busy)
+            {
+                _quietSince = null;
+                return GovernorState.Throttled;
+            }
+            if (_state == GovernorState.Normal || force)
+            {
+                _quietSince = null;
+                return GovernorState.Normal;
+            }
+
+            // Held back: stay there until it has been quiet for long enough
+            if (!quiet)
+            {
+                _quietSince = null;
+                return GovernorState.Throttled;
+            }
+            if (_quietSince == null)
+                _quietSince = now;
+            return now - _quietSince.Value >= ResumeDelay ? GovernorState.Normal : GovernorState.Throttled;
+        }
+
+        /// <summary>
+        /// Governor state and decisions as semicolon-separated key=value fields, for STATS
+        /// </summary>
+        public string FormatStats()
+        {
+            lock (_lock)
+            {
+                var now = _clock.UtcNow;
+                var current = _lastSample != default(DateTime) && now > _lastSample ? now - _lastSample : TimeSpan.Zero;
+                var throttled = _timeIn[(int)GovernorState.Throttled] + (_state == GovernorState.Throttled ? current : TimeSpan.Zero);
+                var paused = _timeIn[(int)GovernorState.Paused] + (_state == GovernorState.Paused ? current : TimeSpan.Zero);
+
+                return string.Format(CultureInfo.InvariantCulture,
+                    "governor.state={0};governor.cpu={1};governor.fullscreen={2};governor.samples={3};governor.changes={4};governor.throttled.s={5:0};governor.paused.s={6:0};" +
+                    "governor.randomdialog.run={7};governor.randomdialog.deferred={8};governor.indexing.run={9};governor.indexing.deferred={10}",
+                    _state.ToString().ToLowerInvariant(), FormatCpu(_load.CpuPercent), _load.FullScreen ? 1 : 0, _samples, _changes,
+                    throttled.TotalSeconds, paused.TotalSeconds,
+                    Interlocked.Read(ref _allowed[(int)BackgroundWork.RandomDialog]), Interlocked.Read(ref _deferred[(int)BackgroundWork.RandomDialog]),
+                    Interlocked.Read(ref _allowed[(int)BackgroundWork.Indexing]), Interlocked.Read(ref _deferred[(int)BackgroundWork.Indexing]));
+            }
+        }
+
+        private static string FormatCpu(double cpuPercent)
+        {
+            return double.IsNaN(cpuPercent) ? "?" : cpuPercent.ToString("0", CultureInfo.InvariantCulture);
+        }
+
+        /// <summary>
+        /// Stops sampling and lets anything waiting run
+        /// </summary>
+        public void Dispose()
+        {
+            Stop();
+            _timer.Dispose();
+        }
+    }
+}
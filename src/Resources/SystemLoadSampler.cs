@@ -0,0 +1,206 @@
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace MSAgentAI.Resources
+{
+    /// <summary>
+    /// How busy the machine is at one moment
+    /// </summary>
+    public struct SystemLoad
+    {
+        public SystemLoad(double cpuPercent, bool fullScreen)
+        {
+            CpuPercent = cpuPercent;
+            FullScreen = fullScreen;
+        }
+
+        /// <summary>
+        /// CPU use of the whole system since the previous sample, 0-100, or NaN when unknown
+        /// </summary>
+        public double CpuPercent { get; }
+
+        /// <summary>
+        /// Whether another program's window covers its whole monitor, as games do
+        /// </summary>
+        public bool FullScreen { get; }
+    }
+
+    public interface ISystemLoadSampler
+    {
+        SystemLoad Sample();
+    }
+
+    /// <summary>
+    /// Reads system CPU time from GetSystemTimes on Windows and /proc/stat on Linux, and checks
+    /// whether the foreground window is full-screen on Windows. Elsewhere the CPU is unknown.
+    /// </summary>
+    public sealed class SystemLoadSampler : ISystemLoadSampler
+    {
+        private static readonly bool IsWindows = RuntimeInformation.IsOSPlatform(OSPlatform.Windows);
+        private static readonly bool IsLinux = RuntimeInformation.IsOSPlatform(OSPlatform.Linux);
+
+        private readonly int _processId = Process.GetCurrentProcess().Id;
+        private ulong _lastIdle;
+        private ulong _lastTotal;
+
+        public SystemLoad Sample()
+        {
+            return new SystemLoad(SampleCpu(), IsWindows && IsForegroundFullScreen());
+        }
+
+        private double SampleCpu()
+        {
+            ulong idle, total;
+            try
+            {
+                if (IsWindows)
+                {
+                    if (!GetSystemTimes(out long idleTime, out long kernelTime, out long userTime))
+                        return double.NaN;
+
+                    // Kernel time includes idle time
+                    idle = (ulong)idleTime;
+                    total = (ulong)kernelTime + (ulong)userTime;
+                }
+                else if (IsLinux)
+                {
+                    if (!ReadProcStat(out idle, out total))
+                        return double.NaN;
+                }
+                else
+                {
+                    return double.NaN;
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is UnauthorizedAccessException || ex is EntryPointNotFoundException || ex is DllNotFoundException)
+            {
+                return double.NaN;
+            }
+
+            ulong idleDelta = idle - _lastIdle;
+            ulong totalDelta = total - _lastTotal;
+            bool first = _lastTotal == 0;
+            _lastIdle = idle;
+            _lastTotal = total;
+
+            if (first || totalDelta == 0 || idleDelta > totalDelta)
+                return double.NaN;
+            return 100.0 * (totalDelta - idleDelta) / totalDelta;
+        }
+
+        /// <summary>
+        /// The aggregate "cpu" line: user nice system idle iowait irq softirq steal, in ticks
+        /// </summary>
+        private static bool ReadProcStat(out ulong idle, out ulong total)
+        {
+            idle = total = 0;
+            string line;
+            using (var reader = new StreamReader("/proc/stat"))
+            {
+                line = reader.ReadLine();
+            }
+            if (line == null || !line.StartsWith("cpu ", StringComparison.Ordinal))
+                return false;
+
+            string[] fields = line.Split(new[] { ' ' }, StringSplitOptions.RemoveEmptyEntries);
+            for (int i = 1; i < fields.Length && i <= 8; i++)
+            {
+                if (!ulong.TryParse(fields[i], NumberStyles.Integer, CultureInfo.InvariantCulture, out ulong value))
+                    return false;
+                total += value;
+                if (i == 4 || i == 5)
+                    idle += value;
+            }
+            return true;
+        }
+
+        /// <summary>
+        /// A window of another process in front, covering its whole monitor. The desktop
+        /// and shell don't count, even though they cover the screen.
+        /// </summary>
+        private bool IsForegroundFullScreen()
+        {
+            try
+            {
+                IntPtr window = GetForegroundWindow();
+                if (window == IntPtr.Zero || window == GetDesktopWindow() || window == GetShellWindow())
+                    return false;
+
+                GetWindowThreadProcessId(window, out uint processId);
+                if (processId == (uint)_processId)
+                    return false;
+
+                var className = new StringBuilder(64);
+                GetClassName(window, className, className.Capacity);
+                string name = className.ToString();
+                if (name == "WorkerW" || name == "Progman")
+                    return false;
+
+                if (!GetWindowRect(window, out Rect rect))
+                    return false;
+
+                var monitor = new MonitorInfo { Size = Marshal.SizeOf(typeof(MonitorInfo)) };
+                if (!GetMonitorInfo(MonitorFromWindow(window, MonitorDefaultToNearest), ref monitor))
+                    return false;
+
+                return rect.Left <= monitor.Monitor.Left && rect.Top <= monitor.Monitor.Top
+                    && rect.Right >= monitor.Monitor.Right && rect.Bottom >= monitor.Monitor.Bottom;
+            }
+            catch (Exception ex) when (ex is EntryPointNotFoundException || ex is DllNotFoundException)
+            {
+                return false;
+            }
+        }
+
+        private const uint MonitorDefaultToNearest = 2;
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct Rect
+        {
+            public int Left;
+            public int Top;
+            public int Right;
+            public int Bottom;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct MonitorInfo
+        {
+            public int Size;
+            public Rect Monitor;
+            public Rect WorkArea;
+            public uint Flags;
+        }
+
+        [DllImport("kernel32.dll", SetLastError = true)]
+        private static extern bool GetSystemTimes(out long idleTime, out long kernelTime, out long userTime);
+
+        [DllImport("user32.dll")]
+        private static extern IntPtr GetForegroundWindow();
+
+        [DllImport("user32.dll")]
+        private static extern IntPtr GetDesktopWindow();
+
+        [DllImport("user32.dll")]
+        private static extern IntPtr GetShellWindow();
+
+        [DllImport("user32.dll")]
+        private static extern uint GetWindowThreadProcessId(IntPtr window, out uint processId);
+
+        [DllImport("user32.dll", CharSet = CharSet.Unicode)]
+        private static extern int GetClassName(IntPtr window, StringBuilder className, int maxCount);
+
+        [DllImport("user32.dll")]
+        private static extern bool GetWindowRect(IntPtr window, out Rect rect);
+
+        [DllImport("user32.dll")]
+        private static extern IntPtr MonitorFromWindow(IntPtr window, uint flags);
+
+        [DllImport("user32.dll", CharSet = CharSet.Unicode)]
+        private static extern bool GetMonitorInfo(IntPtr monitor, ref MonitorInfo info);
+    }
+}
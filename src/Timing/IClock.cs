@@ -0,0 +1,45 @@
+using System;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Timing
+{
+    /// <summary>
+    /// The time, timers and delays that idle lines, random dialog, cooldowns, silence detection
+    /// and speech waits run on. SystemClock is the real one; VirtualClock only moves when told
+    /// to, so a day of behavior can be simulated in seconds.
+    /// </summary>
+    public interface IClock
+    {
+        DateTime Now { get; }
+        DateTime UtcNow { get; }
+
+        /// <summary>
+        /// Creates a stopped timer that calls tick every interval once started. Ticks of one
+        /// timer never overlap.
+        /// </summary>
+        IClockTimer CreateTimer(TimeSpan interval, Action tick);
+
+        Task Delay(TimeSpan delay, CancellationToken cancellationToken = default);
+    }
+
+    /// <summary>
+    /// A repeating timer from an IClock, started and stopped like a WinForms timer
+    /// </summary>
+    public interface IClockTimer : IDisposable
+    {
+        /// <summary>
+        /// Time between ticks; changing it while running starts the wait again
+        /// </summary>
+        TimeSpan Interval { get; set; }
+
+        bool Enabled { get; }
+
+        /// <summary>
+        /// Starts ticking after one interval; does nothing if already running
+        /// </summary>
+        void Start();
+
+        void Stop();
+    }
+}
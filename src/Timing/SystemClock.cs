@@ -0,0 +1,179 @@
+using System;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Logging;
+
+namespace MSAgentAI.Timing
+{
+    /// <summary>
+    /// The real clock. Timer ticks run on the synchronization context given, such as the UI
+    /// thread's, as WinForms timers do, or on the thread pool without one.
+    /// </summary>
+    public sealed class SystemClock : IClock
+    {
+        /// <summary>
+        /// Ticks on the thread pool
+        /// </summary>
+        public static readonly SystemClock Instance = new SystemClock(null);
+
+        private readonly SynchronizationContext _context;
+
+        /// <param name="context">Where timer ticks run, or null for the thread pool</param>
+        public SystemClock(SynchronizationContext context)
+        {
+            _context = context;
+        }
+
+        public DateTime Now => DateTime.Now;
+        public DateTime UtcNow => DateTime.UtcNow;
+
+        public IClockTimer CreateTimer(TimeSpan interval, Action tick)
+        {
+            return new SystemTimer(interval, tick ?? throw new ArgumentNullException(nameof(tick)), _context);
+        }
+
+        public Task Delay(TimeSpan delay, CancellationToken cancellationToken = default)
+        {
+            return Task.Delay(delay, cancellationToken);
+        }
+
+        /// <summary>
+        /// One-shot System.Threading.Timer armed again after each tick returns, so a slow tick
+        /// delays the next one instead of overlapping it
+        /// </summary>
+        private sealed class SystemTimer : IClockTimer
+        {
+            private readonly object _lock = new object();
+            private readonly Timer _timer;
+            private readonly Action _tick;
+            private readonly SynchronizationContext _context;
+            private TimeSpan _interval;
+            private bool _enabled;
+            private bool _disposed;
+
+            // Bumped whenever the timer is armed or stopped, so a tick already on its way is dropped
+            private long _generation;
+
+            public SystemTimer(TimeSpan interval, Action tick, SynchronizationContext context)
+            {
+                _interval = CheckInterval(interval);
+                _tick = tick;
+                _context = context;
+                _timer = new Timer(OnElapsed, null, Timeout.Infinite, Timeout.Infinite);
+            }
+
+            public TimeSpan Interval
+            {
+                get { lock (_lock) return _interval; }
+                set
+                {
+                    lock (_lock)
+                    {
+                        _interval = CheckInterval(value);
+                        if (_enabled)
+                            Arm();
+                    }
+                }
+            }
+
+            public bool Enabled
+            {
+                get { lock (_lock) return _enabled; }
+            }
+
+            public void Start()
+            {
+                lock (_lock)
+                {
+                    if (_enabled || _disposed)
+                        return;
+                    _enabled = true;
+                    Arm();
+                }
+            }
+
+            public void Stop()
+            {
+                lock (_lock)
+                {
+                    if (!_enabled)
+                        return;
+                    _enabled = false;
+                    _generation++;
+                    if (!_disposed)
+                        _timer.Change(Timeout.Infinite, Timeout.Infinite);
+                }
+            }
+
+            /// <summary>
+            /// Called with the lock held
+            /// </summary>
+            private void Arm()
+            {
+                _generation++;
+                _timer.Change(_interval, Timeout.InfiniteTimeSpan);
+            }
+
+            private void OnElapsed(object state)
+            {
+                long generation;
+                lock (_lock)
+                {
+                    if (!_enabled)
+                        return;
+                    generation = _generation;
+                }
+
+                if (_context != null)
+                    _context.Post(_ => Run(generation), null);
+                else
+                    Run(generation);
+            }
+
+            private void Run(long generation)
+            {
+                lock (_lock)
+                {
+                    if (!_enabled || generation != _generation)
+                        return;
+                }
+
+                try
+                {
+                    _tick();
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("Timer tick failed", ex);
+                }
+
+                lock (_lock)
+                {
+                    // Not if the tick stopped, restarted or disposed the timer itself
+                    if (_enabled && generation == _generation)
+                        Arm();
+                }
+            }
+
+            public void Dispose()
+            {
+                lock (_lock)
+                {
+                    if (_disposed)
+                        return;
+                    _enabled = false;
+                    _disposed = true;
+                    _generation++;
+                }
+                _timer.Dispose();
+            }
+        }
+
+        internal static TimeSpan CheckInterval(TimeSpan interval)
+        {
+            if (interval < TimeSpan.Zero)
+                throw new ArgumentOutOfRangeException(nameof(interval), "A timer interval can't be negative");
+            return interval;
+        }
+    }
+}
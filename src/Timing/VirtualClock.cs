@@ -0,0 +1,261 @@
+using System;
+using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Timing
+{
+    /// <summary>
+    /// A clock that stands still until advanced. Timers and delays that fall due on the way run
+    /// in time order on the thread calling Advance or AdvanceTo, with Now set to when they were
+    /// due, so whatever they start (a delay, a stubbed reply) is scheduled from that moment.
+    /// </summary>
+    public sealed class VirtualClock : IClock
+    {
+        private readonly object _lock = new object();
+        private readonly SortedSet<Entry> _queue = new SortedSet<Entry>(EntryComparer.Instance);
+        private DateTime _now;
+        private long _sequence;
+
+        /// <param name="start">Local time the clock starts at</param>
+        public VirtualClock(DateTime start)
+        {
+            _now = DateTime.SpecifyKind(start, DateTimeKind.Local);
+        }
+
+        public DateTime Now
+        {
+            get { lock (_lock) return _now; }
+        }
+
+        public DateTime UtcNow => Now.ToUniversalTime();
+
+        /// <summary>
+        /// Timer ticks and delays waiting to fall due
+        /// </summary>
+        public int Pending
+        {
+            get { lock (_lock) return _queue.Count; }
+        }
+
+        public IClockTimer CreateTimer(TimeSpan interval, Action tick)
+        {
+            return new VirtualTimer(this, SystemClock.CheckInterval(interval), tick ?? throw new ArgumentNullException(nameof(tick)));
+        }
+
+        public Task Delay(TimeSpan delay, CancellationToken cancellationToken = default)
+        {
+            if (cancellationToken.IsCancellationRequested)
+                return Task.FromCanceled(cancellationToken);
+            if (delay == Timeout.InfiniteTimeSpan && !cancellationToken.CanBeCanceled)
+                return new TaskCompletionSource<bool>().Task;
+            if (delay <= TimeSpan.Zero && delay != Timeout.InfiniteTimeSpan)
+                return Task.CompletedTask;
+
+            // Continuations run inline, still inside AdvanceTo and at the time the delay ended
+            var completion = new TaskCompletionSource<bool>();
+            Entry entry = null;
+            if (delay != Timeout.InfiniteTimeSpan)
+            {
+                entry = Schedule(delay, () => completion.TrySetResult(true));
+            }
+            if (cancellationToken.CanBeCanceled)
+            {
+                var registration = cancellationToken.Register(() =>
+                {
+                    if (entry != null)
+                        Cancel(entry);
+                    completion.TrySetCanceled(cancellationToken);
+                });
+                completion.Task.ContinueWith(_ => registration.Dispose(), TaskContinuationOptions.ExecuteSynchronously);
+            }
+            return completion.Task;
+        }
+
+        public void Advance(TimeSpan time)
+        {
+            if (time < TimeSpan.Zero)
+                throw new ArgumentOutOfRangeException(nameof(time), "The clock can't go back");
+            AdvanceTo(Now + time);
+        }
+
+        /// <summary>
+        /// Moves the clock to the given time, running everything that falls due up to and
+        /// including it. Returns how many timer ticks and delays ran.
+        /// </summary>
+        public int AdvanceTo(DateTime time)
+        {
+            int ran = 0;
+            while (true)
+            {
+                Entry next;
+                lock (_lock)
+                {
+                    if (time < _now)
+                        throw new ArgumentOutOfRangeException(nameof(time), "The clock can't go back");
+
+                    if (_queue.Count == 0 || _queue.Min.Due > time)
+                    {
+                        _now = time;
+                        return ran;
+                    }
+
+                    next = _queue.Min;
+                    _queue.Remove(next);
+                    _now = next.Due;
+                }
+
+                next.Run();
+                ran++;
+            }
+        }
+
+        private Entry Schedule(TimeSpan delay, Action run)
+        {
+            lock (_lock)
+            {
+                var entry = new Entry(_now + delay, ++_sequence, run);
+                _queue.Add(entry);
+                return entry;
+            }
+        }
+
+        private void Cancel(Entry entry)
+        {
+            lock (_lock)
+            {
+                _queue.Remove(entry);
+            }
+        }
+
+        private sealed class Entry
+        {
+            public Entry(DateTime due, long sequence, Action run)
+            {
+                Due = due;
+                Sequence = sequence;
+                Run = run;
+            }
+
+            public DateTime Due { get; }
+            public long Sequence { get; }
+            public Action Run { get; }
+        }
+
+        /// <summary>
+        /// By due time, then in the order scheduled
+        /// </summary>
+        private sealed class EntryComparer : IComparer<Entry>
+        {
+            public static readonly EntryComparer Instance = new EntryComparer();
+
+            public int Compare(Entry x, Entry y)
+            {
+                int byDue = x.Due.CompareTo(y.Due);
+                return byDue != 0 ? byDue : x.Sequence.CompareTo(y.Sequence);
+            }
+        }
+
+        private sealed class VirtualTimer : IClockTimer
+        {
+            private readonly VirtualClock _clock;
+            private readonly Action _tick;
+            private TimeSpan _interval;
+            private Entry _next;
+            private bool _disposed;
+
+            public VirtualTimer(VirtualClock clock, TimeSpan interval, Action tick)
+            {
+                _clock = clock;
+                _interval = interval;
+                _tick = tick;
+            }
+
+            public TimeSpan Interval
+            {
+                get { lock (_clock._lock) return _interval; }
+                set
+                {
+                    lock (_clock._lock)
+                    {
+                        _interval = SystemClock.CheckInterval(value);
+                        if (_next != null)
+                        {
+                            _clock._queue.Remove(_next);
+                            Arm();
+                        }
+                    }
+                }
+            }
+
+            public bool Enabled
+            {
+                get { lock (_clock._lock) return _next != null; }
+            }
+
+            public void Start()
+            {
+                lock (_clock._lock)
+                {
+                    if (_next == null && !_disposed)
+                        Arm();
+                }
+            }
+
+            public void Stop()
+            {
+                lock (_clock._lock)
+                {
+                    if (_next != null)
+                    {
+                        _clock._queue.Remove(_next);
+                        _next = null;
+                    }
+                }
+            }
+
+            /// <summary>
+            /// Called with the clock's lock held
+            /// </summary>
+            private void Arm()
+            {
+                Entry entry = null;
+                entry = new Entry(_clock._now + _interval, ++_clock._sequence, () => Fire(entry));
+                _next = entry;
+                _clock._queue.Add(entry);
+            }
+
+            private void Fire(Entry entry)
+            {
+                lock (_clock._lock)
+                {
+                    if (_next != entry)
+                        return;
+                }
+
+                try
+                {
+                    _tick();
+                }
+                finally
+                {
+                    lock (_clock._lock)
+                    {
+                        // Not if the tick stopped, restarted or disposed the timer itself
+                        if (_next == entry)
+                            Arm();
+                    }
+                }
+            }
+
+            public void Dispose()
+            {
+                lock (_clock._lock)
+                {
+                    _disposed = true;
+                }
+                Stop();
+            }
+        }
+    }
+}
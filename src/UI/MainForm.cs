@@ -1,15 +1,20 @@
 using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
 using System.Drawing;
 using System.IO;
+using System.Linq;
 using System.Threading;
 using System.Threading.Tasks;
 using System.Windows.Forms;
+using MSAgentAI.Acs;
 using MSAgentAI.Agent;
 using MSAgentAI.AI;
 using MSAgentAI.Config;
 using MSAgentAI.Logging;
 using MSAgentAI.Pipeline;
+using MSAgentAI.Resources;
+using MSAgentAI.Timing;
 using MSAgentAI.Voice;
 
 namespace MSAgentAI.UI
@@ -22,21 +27,34 @@ namespace MSAgentAI.UI
         // Constants
         private const int IdleDialogChancePercent = 20; // 20% chance when idle timer ticks
 
+        // A client setting up macros sends a burst of DEFINEs; they are saved once it's over
+        private static readonly TimeSpan MacroSaveDelay = TimeSpan.FromSeconds(2);
+
+        // Timers, cooldowns and waits; ticks arrive on the UI thread
+        private IClock _clock;
+
         private AgentManager _agentManager;
+        private CharacterRoster _characters;
         private Sapi4Manager _voiceManager;
         private OllamaClient _ollamaClient;
         private MemoryManager _memoryManager;
         private AppSettings _settings;
         private SpeechRecognitionManager _speechRecognition;
         private PipelineServer _pipelineServer;
+        private ChatScheduler _chatScheduler;
+        private IClockTimer _macroSaveTimer;
+        private AcsPreviewCache _previewCache;
         private bool _inCallMode;
 
+        // Conversations of the extra characters by name; the primary one uses the client's own
+        private readonly ConcurrentDictionary<string, ChatSession> _chatSessions = new ConcurrentDictionary<string, ChatSession>(StringComparer.OrdinalIgnoreCase);
+
         private NotifyIcon _trayIcon;
         private ContextMenuStrip _trayMenu;
         private ToolStripMenuItem _callModeItem;
-        private System.Windows.Forms.Timer _idleTimer;
-        private System.Windows.Forms.Timer _randomDialogTimer;
-        private Random _random = new Random();
+        private AgentBehavior _behavior;
+        private ResourceGovernor _governor;
+        private MemoryBudget _memoryBudget;
 
         private CancellationTokenSource _cancellationTokenSource;
 
@@ -66,6 +84,8 @@ namespace MSAgentAI.UI
 
         private void InitializeApplication()
         {
+            _clock = new SystemClock(SynchronizationContext.Current);
+
             // Load settings
             _settings = AppSettings.Load();
 
@@ -92,7 +112,7 @@ namespace MSAgentAI.UI
         {
             try
             {
-                _agentManager = new AgentManager
+                _agentManager = new AgentManager(_clock)
                 {
                     DefaultCharacterPath = _settings.CharacterPath
                 };
@@ -100,6 +120,8 @@ namespace MSAgentAI.UI
                 // Subscribe to agent events
                 _agentManager.OnClick += OnAgentClicked;
                 _agentManager.OnDragComplete += OnAgentMoved;
+                
+                _characters = new CharacterRoster(_agentManager);
             }
             catch (Exception ex)
             {
@@ -136,14 +158,24 @@ namespace MSAgentAI.UI
             {
                 BaseUrl = _settings.OllamaUrl,
                 Model = _settings.OllamaModel,
-                PersonalityPrompt = _settings.PersonalityPrompt
+                PersonalityPrompt = _settings.PersonalityPrompt,
+                AdaptiveContext = _settings.OllamaAdaptiveContext
             };
+            _ollamaClient.ContextBudget.MaxContextLength = _settings.OllamaMaxContextLength;
+            _ollamaClient.ContextBudget.RandomDialogMaxTokens = _settings.RandomDialogMaxTokens;
+
+            // Keep the model inventory and load state warm in the background
+            if (_settings.EnableOllamaChat)
+            {
+                _ollamaClient.Models.StartBackgroundRefresh(TimeSpan.FromSeconds(30));
+            }
             
             // Initialize memory manager
             _memoryManager = new MemoryManager
             {
                 Enabled = _settings.EnableMemories,
-                MemoryThreshold = _settings.MemoryThreshold
+                MemoryThreshold = _settings.MemoryThreshold,
+                Clock = _clock
             };
             
             // Link memory manager and user description to Ollama client
@@ -209,23 +241,88 @@ namespace MSAgentAI.UI
 
         private void InitializeTimers()
         {
-            // Idle timer - triggers idle lines periodically (60 seconds - more spaced out)
-            _idleTimer = new System.Windows.Forms.Timer
+            // Samples CPU and full-screen state every 2 seconds, on the thread pool
+            _governor = new ResourceGovernor(SystemClock.Instance);
+            ApplyGovernorSettings();
+            _governor.Start();
+
+            // Samples memory every 30 seconds and after full GCs, trimming caches over budget
+            _memoryBudget = new MemoryBudget(SystemClock.Instance);
+            ApplyMemoryBudgetSettings();
+            RegisterCaches();
+            _memoryBudget.Start();
+
+            // Idle lines every 60 seconds, random dialog checked every second
+            _behavior = new AgentBehavior(_settings, _ollamaClient, _clock)
             {
-                Interval = 60000 // 60 seconds - spaced out more
+                Speak = (text, animation) => SpeakWithAnimations(text, animation),
+                IsLoaded = () => _agentManager?.IsLoaded == true,
+                CancellationToken = _cancellationTokenSource.Token,
+                Governor = _governor
             };
-            _idleTimer.Tick += OnIdleTimerTick;
-            _idleTimer.Start();
+            _behavior.Start();
+        }
 
-            // Random dialog timer - checks every second for random dialog
-            _randomDialogTimer = new System.Windows.Forms.Timer
-            {
-                Interval = 1000 // 1 second
-            };
-            _randomDialogTimer.Tick += OnRandomDialogTimerTick;
-            if (_settings.EnableRandomDialog)
+        private void ApplyGovernorSettings()
+        {
+            if (_governor == null)
+                return;
+
+            _governor.BusyCpuPercent = _settings.GovernorBusyCpuPercent;
+            _governor.IdleCpuPercent = Math.Min(_settings.GovernorIdleCpuPercent, _settings.GovernorBusyCpuPercent);
+            _governor.ResumeDelay = TimeSpan.FromSeconds(Math.Max(0, _settings.GovernorResumeDelaySeconds));
+            _governor.PauseWhenFullScreen = _settings.GovernorPauseWhenFullScreen;
+            _governor.Enabled = _settings.GovernorEnabled;
+        }
+
+        private void ApplyMemoryBudgetSettings()
+        {
+            if (_memoryBudget == null)
+                return;
+
+            _memoryBudget.BudgetBytes = Math.Max(1, _settings.MemoryBudgetMb) * 1024L * 1024L;
+            _memoryBudget.HighMemoryLoadPercent = _settings.MemoryHighLoadPercent;
+        }
+
+        /// <summary>
+        /// Caches that grow over weeks. The previews and pipeline are created later, so each
+        /// is looked up when the budget asks.
+        /// </summary>
+        private void RegisterCaches()
+        {
+            _memoryBudget.Register("chat.history", CachePriority.Normal, () => {
+                long bytes = 0;
+                foreach (var session in GetAllChatSessions())
+                {
+                    bytes += session.EstimatedBytes;
+                }
+                return bytes;
+            }, wanted => {
+                // Only the newest messages are ever sent, so the rest can go
+                long freed = 0;
+                foreach (var session in GetAllChatSessions())
+                {
+                    long before = session.EstimatedBytes;
+                    session.TrimHistory(OllamaClient.MaxHistoryMessages);
+                    freed += before - session.EstimatedBytes;
+                }
+                return freed;
+            });
+            _memoryBudget.Register("previews", CachePriority.Low,
+                () => _previewCache?.ThumbnailBytes ?? 0,
+                wanted => _previewCache?.ReleaseThumbnails() ?? 0);
+            _memoryBudget.Register("pipeline.events", CachePriority.Low,
+                () => _pipelineServer?.EventRegistry.EstimateCacheBytes() ?? 0,
+                wanted => _pipelineServer?.EventRegistry.ClearCaches() ?? 0);
+        }
+
+        private IEnumerable<ChatSession> GetAllChatSessions()
+        {
+            if (_ollamaClient != null)
+                yield return _ollamaClient.DefaultSession;
+            foreach (var session in _chatSessions.Values)
             {
-                _randomDialogTimer.Start();
+                yield return session;
             }
         }
 
@@ -242,63 +339,71 @@ namespace MSAgentAI.UI
                     _settings.PipelinePort,
                     _settings.PipelineName
                 );
+                ApplyPipelineListenerSettings();
+                _pipelineServer.DrainTimeout = GetPipelineDrainTimeout();
                 
-                // Wire up pipeline events
-                _pipelineServer.OnSpeakCommand += (s, text) => {
-                    if (this.InvokeRequired)
-                        this.Invoke((Action)(() => SpeakWithAnimations(text)));
-                    else
-                        SpeakWithAnimations(text);
-                };
+                // Wire up pipeline events; COMMAND@Name commands go to that character
+                _pipelineServer.OnSpeakCommand += (s, command) => RunOnCharacter(command, agent => SpeakWithAnimations(agent, command.Data));
                 
-                _pipelineServer.OnAnimationCommand += (s, animName) => {
-                    if (this.InvokeRequired)
-                        this.Invoke((Action)(() => _agentManager?.PlayAnimation(animName)));
-                    else
-                        _agentManager?.PlayAnimation(animName);
-                };
+                _pipelineServer.OnAnimationCommand += (s, command) => RunOnCharacter(command, agent => {
+                    agent.PlayAnimation(command.Data);
+                    _pipelineServer.PublishEvent(GetEventName("ANIMATION", agent), command.Data);
+                });
                 
-                _pipelineServer.OnChatCommand += async (s, prompt) => {
-                    try
+                // CHAT requests are queued per client (and per extra character) so one chatty
+                // client or busy character can't starve the others. Each character answers in
+                // its own conversation.
+                _chatScheduler = new ChatScheduler(async (item, ct) => {
+                    var agent = FindCharacter(item.Character);
+                    var usage = new OllamaUsage();
+                    var response = await _ollamaClient.ChatAsync(GetChatSession(agent), item.Prompt, usage, ct);
+                    if (!string.IsNullOrEmpty(response) && agent?.IsLoaded == true)
                     {
-                        var response = await _ollamaClient.ChatAsync(prompt, _cancellationTokenSource.Token);
-                        if (!string.IsNullOrEmpty(response) && _agentManager?.IsLoaded == true)
-                        {
-                            if (this.InvokeRequired)
-                                this.Invoke((Action)(() => SpeakWithAnimations(response)));
-                            else
-                                SpeakWithAnimations(response);
-                        }
+                        if (this.InvokeRequired)
+                            this.Invoke((Action)(() => SpeakWithAnimations(agent, response)));
+                        else
+                            SpeakWithAnimations(agent, response);
                     }
-                    catch (Exception ex)
-                    {
-                        Logger.LogError("Pipeline: Chat command failed", ex);
-                    }
-                };
+                    return usage.TotalTokens;
+                });
+                _chatScheduler.EstimateCost = prompt => _ollamaClient.EstimateChatCost(prompt);
+                _chatScheduler.TokensPerMinute = _settings.PipelineChatTokensPerMinute;
+                _chatScheduler.MaxQueuedPerClient = _settings.PipelineChatQueueLimit;
+                _pipelineServer.ChatScheduler = _chatScheduler;
+                _pipelineServer.DefaultChatTtl = GetDefaultChatTtl();
                 
-                _pipelineServer.OnHideCommand += (s, e) => {
-                    if (this.InvokeRequired)
-                        this.Invoke((Action)(() => _agentManager?.Hide(false)));
-                    else
-                        _agentManager?.Hide(false);
-                };
+                _pipelineServer.OnHideCommand += (s, command) => RunOnCharacter(command, agent => agent.Hide(false));
                 
-                _pipelineServer.OnShowCommand += (s, e) => {
-                    if (this.InvokeRequired)
-                        this.Invoke((Action)(() => _agentManager?.Show(false)));
-                    else
-                        _agentManager?.Show(false);
+                _pipelineServer.OnShowCommand += (s, command) => RunOnCharacter(command, agent => agent.Show(false));
+                
+                // STATE, QUERY and character lookups read published snapshots, never the UI thread
+                _pipelineServer.StateProvider = character => (FindCharacter(character)?.State ?? AgentState.Unloaded).Format();
+                _pipelineServer.CharacterResolver = name => {
+                    var state = FindCharacter(name)?.State;
+                    return state != null && state.IsLoaded ? state.Character : null;
                 };
+                _pipelineServer.CharactersProvider = () => _characters?.GetNames() ?? new List<string>();
+                _pipelineServer.StatsProvider = () => string.Join(";",
+                    new[] { _governor?.FormatStats(), _memoryBudget?.FormatStats() }.Where(stats => !string.IsNullOrEmpty(stats)));
                 
-                _pipelineServer.OnPokeCommand += (s, e) => {
-                    if (this.InvokeRequired)
-                        this.Invoke((Action)(() => OnPoke(s, e)));
+                _pipelineServer.OnPokeCommand += (s, command) => RunOnCharacter(command, agent => {
+                    if (agent == _agentManager)
+                        OnPoke(s, command);
                     else
-                        OnPoke(s, e);
-                };
+                        PokeCharacter(agent);
+                });
+                
+                // Macros defined by clients survive restarts
+                _pipelineServer.LoadMacros(_settings.PipelineMacros);
+                _macroSaveTimer = _clock.CreateTimer(MacroSaveDelay, SavePipelineMacros);
+                _pipelineServer.OnMacrosChanged += (s, e) => _macroSaveTimer.Start();
+                
+                RegisterPipelineEvents();
+                ApplyPipelineRateLimits();
                 
                 // Start the pipeline server
                 _pipelineServer.Start();
+                ApplyPipelineRecording();
                 
                 Logger.Log("Communication pipeline initialized");
             }
@@ -308,6 +413,255 @@ namespace MSAgentAI.UI
             }
         }
 
+        /// <summary>
+        /// Copies the UDP, ring and HTTP settings to the server; they take effect on its next start
+        /// </summary>
+        private void ApplyPipelineListenerSettings()
+        {
+            _pipelineServer.UdpEnabled = _settings.PipelineUdpEnabled;
+            _pipelineServer.UdpPort = _settings.PipelineUdpPort;
+            _pipelineServer.RingEnabled = _settings.PipelineRingEnabled;
+            _pipelineServer.RingName = _settings.PipelineRingName;
+            _pipelineServer.RingCapacity = Math.Max(64, _settings.PipelineRingSizeKb) * 1024L;
+            _pipelineServer.HttpEnabled = _settings.PipelineHttpEnabled;
+            _pipelineServer.HttpPort = _settings.PipelineHttpPort;
+            _pipelineServer.HttpAllowedOrigins = _settings.PipelineHttpAllowedOrigins?.ToArray();
+        }
+
+        private TimeSpan GetPipelineDrainTimeout()
+        {
+            return TimeSpan.FromMilliseconds(Math.Max(0, _settings.PipelineDrainTimeoutMs));
+        }
+
+        /// <summary>
+        /// Restarts the pipeline if any of its listener settings changed. Connections are drained
+        /// off the UI thread, since the commands they are finishing may be waiting to run on it.
+        /// </summary>
+        private void RestartPipelineIfChanged()
+        {
+            var server = _pipelineServer;
+            string origins = string.Join(",", server.HttpAllowedOrigins ?? new string[0]);
+            bool changed = !server.IsConfiguredFor(_settings.PipelineProtocol, _settings.PipelineIPAddress, _settings.PipelinePort, _settings.PipelineName)
+                || server.UdpEnabled != _settings.PipelineUdpEnabled
+                || server.UdpPort != _settings.PipelineUdpPort
+                || server.RingEnabled != _settings.PipelineRingEnabled
+                || server.RingName != _settings.PipelineRingName
+                || server.RingCapacity != Math.Max(64, _settings.PipelineRingSizeKb) * 1024L
+                || server.HttpEnabled != _settings.PipelineHttpEnabled
+                || server.HttpPort != _settings.PipelineHttpPort
+                || origins != string.Join(",", _settings.PipelineHttpAllowedOrigins ?? new List<string>());
+            if (!changed)
+                return;
+
+            ApplyPipelineListenerSettings();
+            string protocol = _settings.PipelineProtocol;
+            string ipAddress = _settings.PipelineIPAddress;
+            int port = _settings.PipelinePort;
+            string pipeName = _settings.PipelineName;
+
+            Task.Run(() => {
+                try
+                {
+                    var result = server.Restart(protocol, ipAddress, port, pipeName);
+                    Logger.Log($"Pipeline restarted with new settings ({result.Drained} drained, {result.Aborted} aborted)");
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError("Failed to restart communication pipeline", ex);
+                }
+            });
+        }
+
+        /// <summary>
+        /// Starts or stops recording pipeline traffic. Each recording gets its own timestamped
+        /// file so one captured in the field isn't overwritten on the next start.
+        /// </summary>
+        private void ApplyPipelineRecording()
+        {
+            try
+            {
+                if (_settings.PipelineRecordEnabled && _pipelineServer.RecordingPath == null)
+                {
+                    string folder = Path.Combine(AppDomain.CurrentDomain.BaseDirectory, "recordings");
+                    Directory.CreateDirectory(folder);
+                    _pipelineServer.StartRecording(Path.Combine(folder, $"pipeline-{DateTime.Now:yyyyMMdd-HHmmss}.pipelog"));
+                }
+                else if (!_settings.PipelineRecordEnabled && _pipelineServer.RecordingPath != null)
+                {
+                    _pipelineServer.StopRecording();
+                }
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError("Failed to start pipeline recording", ex);
+            }
+        }
+
+        /// <summary>
+        /// Creates, updates or removes the pipeline's rate limiter. Updating keeps the counters;
+        /// connections move to the new rates on their next command.
+        /// </summary>
+        private void ApplyPipelineRateLimits()
+        {
+            if (!_settings.PipelineRateLimitEnabled)
+            {
+                _pipelineServer.RateLimiter = null;
+                return;
+            }
+
+            if (!Enum.TryParse(_settings.PipelineRateLimitPolicy, true, out RateLimitPolicy policy))
+            {
+                Logger.LogWarning($"Unknown pipeline rate limit policy '{_settings.PipelineRateLimitPolicy}', using Delay");
+                policy = RateLimitPolicy.Delay;
+            }
+
+            var limiter = _pipelineServer.RateLimiter;
+            if (limiter == null)
+            {
+                limiter = new PipelineRateLimiter(_settings.PipelineRateLimitPerConnection, _settings.PipelineRateLimitGlobal, _settings.PipelineRateLimitBurstSeconds);
+            }
+            else
+            {
+                limiter.Configure(_settings.PipelineRateLimitPerConnection, _settings.PipelineRateLimitGlobal, _settings.PipelineRateLimitBurstSeconds);
+            }
+            limiter.SetCosts(_settings.PipelineCommandCosts);
+            limiter.Policy = policy;
+            limiter.MaxDelay = TimeSpan.FromMilliseconds(Math.Max(0, _settings.PipelineRateLimitMaxDelayMs));
+            _pipelineServer.RateLimiter = limiter;
+        }
+
+        /// <summary>
+        /// Writes the macros to the settings file, once per burst of DEFINE commands
+        /// </summary>
+        private void SavePipelineMacros()
+        {
+            _macroSaveTimer.Stop();
+            _settings.PipelineMacros = _pipelineServer.GetMacroDefinitions();
+            _settings.Save();
+        }
+
+        /// <summary>
+        /// Compiles the EVENT lines and prompts from settings into the pipeline's registry
+        /// </summary>
+        private void RegisterPipelineEvents()
+        {
+            // Filled before it's swapped in, so EVENTs arriving meanwhile see the old events
+            var registry = new PipelineEventRegistry();
+            if (_settings.PipelineEvents != null)
+            {
+                foreach (var entry in _settings.PipelineEvents)
+                {
+                    try
+                    {
+                        registry.Register(entry.Key, entry.Value?.Lines, entry.Value?.Prompt);
+                    }
+                    catch (ArgumentException ex)
+                    {
+                        Logger.LogWarning($"Pipeline: Skipping event '{entry.Key}': {ex.Message}");
+                    }
+                }
+            }
+            _pipelineServer.EventRegistry = registry;
+        }
+
+        private TimeSpan? GetDefaultChatTtl()
+        {
+            return _settings.PipelineChatDefaultTtlMs > 0
+                ? TimeSpan.FromMilliseconds(_settings.PipelineChatDefaultTtlMs)
+                : (TimeSpan?)null;
+        }
+
+        /// <summary>
+        /// The loaded character with this name, or the primary one for null. Safe off the UI thread.
+        /// </summary>
+        private AgentManager FindCharacter(string name)
+        {
+            return _characters != null ? _characters.Find(name) : (name == null ? _agentManager : null);
+        }
+
+        /// <summary>
+        /// Runs a pipeline command on the UI thread against the character it was addressed to
+        /// </summary>
+        private void RunOnCharacter(PipelineCommand command, Action<AgentManager> action)
+        {
+            Action run = () => {
+                var agent = FindCharacter(command.Character);
+                if (agent != null)
+                    action(agent);
+            };
+            if (this.InvokeRequired)
+                this.Invoke(run);
+            else
+                run();
+        }
+
+        /// <summary>
+        /// Overlay event name for something a character did: NAME for the primary character,
+        /// NAME@Character for the others, matching how commands address them
+        /// </summary>
+        private string GetEventName(string name, AgentManager agent)
+        {
+            return agent == _agentManager ? name : name + "@" + agent.State.Character;
+        }
+
+        /// <summary>
+        /// The conversation a character answers in. The primary character shares the client's own
+        /// with the chat window; each extra character keeps a separate one in its own persona.
+        /// </summary>
+        private ChatSession GetChatSession(AgentManager agent)
+        {
+            if (agent == null || agent == _agentManager)
+                return null;
+
+            return _chatSessions.GetOrAdd(agent.State.Character, name => new ChatSession(name)
+            {
+                PersonalityPrompt = BuildCharacterPersonality(name)
+            });
+        }
+
+        private string BuildCharacterPersonality(string name)
+        {
+            return $"{_settings.PersonalityPrompt}\n\nYou are {name}. Other characters share the screen with you; stay in character as {name}.".Trim();
+        }
+
+        /// <summary>
+        /// Loads and unloads the extra characters to match settings. They keep their own default
+        /// voice so they don't all sound like the primary character.
+        /// </summary>
+        private void LoadExtraCharacters()
+        {
+            if (_characters == null)
+                return;
+
+            foreach (var agent in _characters.Sync(_settings.AdditionalCharacterFiles))
+            {
+                try
+                {
+                    agent.Show(false);
+                    agent.IdleOn = true;
+                    if (_settings.AgentSize != 100)
+                    {
+                        agent.SetSize(_settings.AgentSize);
+                    }
+                    GetChatSession(agent).AvailableAnimations = agent.GetAnimations();
+                }
+                catch (Exception ex)
+                {
+                    Logger.LogError($"Failed to show extra character {agent.State.Character}", ex);
+                }
+            }
+
+            // Conversations of characters no longer on screen are dropped
+            var names = new HashSet<string>(_characters.GetNames(), StringComparer.OrdinalIgnoreCase);
+            foreach (string name in _chatSessions.Keys)
+            {
+                if (!names.Contains(name))
+                {
+                    _chatSessions.TryRemove(name, out _);
+                }
+            }
+        }
+
         private void LoadAgentFromSettings()
         {
             if (_agentManager != null && !string.IsNullOrEmpty(_settings.SelectedCharacterFile))
@@ -341,6 +695,8 @@ namespace MSAgentAI.UI
                     ShowError("Character Load Error", $"Failed to load character: {ex.Message}");
                 }
             }
+
+            LoadExtraCharacters();
         }
 
         private void ShowWelcomeMessage()
@@ -362,35 +718,46 @@ namespace MSAgentAI.UI
         /// </summary>
         private void SpeakWithAnimations(string text, string defaultAnimation = null)
         {
-            if (_agentManager?.IsLoaded != true || string.IsNullOrEmpty(text))
+            SpeakWithAnimations(_agentManager, text, defaultAnimation);
+        }
+        
+        /// <summary>
+        /// Speaks text with animation support on the given character
+        /// </summary>
+        private void SpeakWithAnimations(AgentManager agent, string text, string defaultAnimation = null)
+        {
+            if (agent?.IsLoaded != true || string.IsNullOrEmpty(text))
                 return;
                 
             // Extract animation triggers (&&AnimationName)
             var (cleanText, animations) = AppSettings.ExtractAnimationTriggers(text);
             
+            // Captions for browser overlays, without the speech markup added below
+            string caption = string.IsNullOrWhiteSpace(_settings.UserName) ? cleanText : cleanText.Replace("##", _settings.UserName);
+            
             // Process text for ## name replacement and /emp/ emphasis
             cleanText = _settings.ProcessText(cleanText);
             
             // Play ONLY THE FIRST animation (MS Agent limitation)
-            if (animations.Count > 0)
+            string animation = animations.Count > 0 ? animations[0] : defaultAnimation;
+            if (!string.IsNullOrEmpty(animation))
             {
-                _agentManager.PlayAnimation(animations[0]);
-            }
-            else if (!string.IsNullOrEmpty(defaultAnimation))
-            {
-                _agentManager.PlayAnimation(defaultAnimation);
+                agent.PlayAnimation(animation);
+                _pipelineServer?.PublishEvent(GetEventName("ANIMATION", agent), animation);
             }
             
             // Speak the processed text - check if truncation is enabled
             if (_settings.TruncateSpeech)
             {
                 var sentences = AppSettings.SplitIntoSentences(cleanText);
-                _agentManager.SpeakSentences(sentences);
+                agent.SpeakSentences(sentences);
             }
             else
             {
-                _agentManager.Speak(cleanText);
+                agent.Speak(cleanText);
             }
+            
+            _pipelineServer?.PublishEvent(GetEventName("SPEAK", agent), caption);
         }
         
         /// <summary>
@@ -419,7 +786,16 @@ namespace MSAgentAI.UI
 
         private void OnOpenSettings(object sender, EventArgs e)
         {
-            using (var settingsForm = new SettingsForm(_settings, _agentManager, _voiceManager, _ollamaClient))
+            // Created on first use and kept, so thumbnails read once stay in memory
+            if (_previewCache == null)
+            {
+                _previewCache = new AcsPreviewCache(AcsPreviewCache.DefaultDirectory)
+                {
+                    Governor = _governor
+                };
+            }
+
+            using (var settingsForm = new SettingsForm(_settings, _agentManager, _voiceManager, _ollamaClient, _previewCache))
             {
                 if (settingsForm.ShowDialog() == DialogResult.OK)
                 {
@@ -561,6 +937,30 @@ namespace MSAgentAI.UI
             }
         }
 
+        /// <summary>
+        /// POKE for an extra character: a random line in its own persona. Quiet on failure,
+        /// since it comes from a pipeline client rather than someone at the tray menu.
+        /// </summary>
+        private async void PokeCharacter(AgentManager agent)
+        {
+            var prompt = GetRandomLine(_settings.RandomDialogPrompts);
+            if (!_settings.EnableOllamaChat || string.IsNullOrEmpty(prompt))
+                return;
+
+            try
+            {
+                var response = await _ollamaClient.GenerateRandomDialogAsync(prompt, GetChatSession(agent), _cancellationTokenSource.Token);
+                if (!string.IsNullOrEmpty(response) && agent.IsLoaded)
+                {
+                    SpeakWithAnimations(agent, response);
+                }
+            }
+            catch (Exception ex)
+            {
+                Logger.LogError($"Poke for {agent.State.Character} failed", ex);
+            }
+        }
+
         /// <summary>
         /// Toggle Call Mode - voice-activated chat with the AI
         /// </summary>
@@ -618,7 +1018,7 @@ namespace MSAgentAI.UI
                 SpeakWithAnimations("I'm listening. Go ahead and speak!", "Listen");
                 
                 // Start listening after a short delay to let the TTS finish
-                Task.Delay(2000).ContinueWith(_ => {
+                _clock.Delay(TimeSpan.FromSeconds(2)).ContinueWith(_ => {
                     if (_inCallMode)
                     {
                         _speechRecognition.StartListening();
@@ -680,14 +1080,14 @@ namespace MSAgentAI.UI
                     int estimatedDuration = Math.Max(3000, response.Length * 80);
                     Logger.Log($"Call Mode - Waiting {estimatedDuration}ms for TTS to complete...");
                     
-                    await Task.Delay(estimatedDuration);
+                    await _clock.Delay(TimeSpan.FromMilliseconds(estimatedDuration));
                     
                     // Resume listening if still in call mode
                     if (_inCallMode)
                     {
                         Logger.Log("Call Mode - Resuming listening after AI response...");
                         // Add a small buffer delay to ensure TTS is fully done
-                        await Task.Delay(500);
+                        await _clock.Delay(TimeSpan.FromMilliseconds(500));
                         _speechRecognition?.StartListening();
                         Logger.Log("Call Mode - Listening resumed");
                     }
@@ -698,7 +1098,7 @@ namespace MSAgentAI.UI
                     if (_inCallMode)
                     {
                         Logger.Log("Call Mode - No response, resuming listening...");
-                        await Task.Delay(500);
+                        await _clock.Delay(TimeSpan.FromMilliseconds(500));
                         _speechRecognition?.StartListening();
                     }
                 }
@@ -710,7 +1110,7 @@ namespace MSAgentAI.UI
                 // Resume listening on error
                 if (_inCallMode)
                 {
-                    await Task.Delay(1000);
+                    await _clock.Delay(TimeSpan.FromSeconds(1));
                     Logger.Log("Call Mode - Resuming listening after error...");
                     _speechRecognition?.StartListening();
                 }
@@ -759,15 +1159,14 @@ namespace MSAgentAI.UI
                 {
                     SpeakWithAnimations(exitLine, "Wave");
                     // Use a timer to wait for speech before exiting instead of blocking the UI
-                    var exitTimer = new System.Windows.Forms.Timer { Interval = 2000 };
-                    exitTimer.Tick += (s, args) =>
+                    IClockTimer exitTimer = null;
+                    exitTimer = _clock.CreateTimer(TimeSpan.FromSeconds(2), () =>
                     {
-                        exitTimer.Stop();
                         exitTimer.Dispose();
                         _agentManager?.Hide(false);
                         CleanUp();
                         Application.Exit();
-                    };
+                    });
                     exitTimer.Start();
                     return;
                 }
@@ -784,72 +1183,16 @@ namespace MSAgentAI.UI
             OnOpenSettings(sender, e);
         }
 
-        private void OnIdleTimerTick(object sender, EventArgs e)
-        {
-            // Only use prewritten idle if enabled
-            if (_agentManager?.IsLoaded == true && _settings.EnablePrewrittenIdle)
-            {
-                // 1 in N chance (configurable)
-                if (_random.Next(_settings.PrewrittenIdleChance) == 0)
-                {
-                    var idleLine = GetRandomLine(_settings.IdleLines);
-                    if (!string.IsNullOrEmpty(idleLine))
-                    {
-                        SpeakWithAnimations(idleLine, "Idle1_1");
-                    }
-                }
-            }
-        }
-
-        private async void OnRandomDialogTimerTick(object sender, EventArgs e)
-        {
-            if (!_settings.EnableRandomDialog || !_settings.EnableOllamaChat)
-                return;
-
-            // 1 in N chance (default 9000)
-            if (_random.Next(_settings.RandomDialogChance) == 0)
-            {
-                try
-                {
-                    var prompt = GetRandomLine(_settings.RandomDialogPrompts);
-                    if (!string.IsNullOrEmpty(prompt))
-                    {
-                        var response = await _ollamaClient.GenerateRandomDialogAsync(prompt, _cancellationTokenSource.Token);
-                        if (!string.IsNullOrEmpty(response) && _agentManager?.IsLoaded == true)
-                        {
-                            SpeakWithAnimations(response);
-                        }
-                    }
-                }
-                catch (Exception ex)
-                {
-                    System.Diagnostics.Debug.WriteLine($"Random dialog error: {ex.Message}");
-                }
-            }
-        }
-
         private void OnAgentClicked(object sender, Agent.AgentEventArgs e)
         {
-            if (_agentManager?.IsLoaded == true)
-            {
-                var clickedLine = GetRandomLine(_settings.ClickedLines);
-                if (!string.IsNullOrEmpty(clickedLine))
-                {
-                    SpeakWithAnimations(clickedLine, "Surprised");
-                }
-            }
+            _pipelineServer?.PublishEvent("CLICK");
+            _behavior?.OnClicked();
         }
 
         private void OnAgentMoved(object sender, Agent.AgentEventArgs e)
         {
-            if (_agentManager?.IsLoaded == true)
-            {
-                var movedLine = GetRandomLine(_settings.MovedLines);
-                if (!string.IsNullOrEmpty(movedLine))
-                {
-                    SpeakWithAnimations(movedLine);
-                }
-            }
+            _pipelineServer?.PublishEvent("MOVED");
+            _behavior?.OnMoved();
         }
 
         #endregion
@@ -879,6 +1222,14 @@ namespace MSAgentAI.UI
                 _ollamaClient.Model = _settings.OllamaModel;
                 _ollamaClient.PersonalityPrompt = _settings.PersonalityPrompt;
                 _ollamaClient.UserDescription = _settings.UserDescription;
+                _ollamaClient.AdaptiveContext = _settings.OllamaAdaptiveContext;
+                _ollamaClient.ContextBudget.MaxContextLength = _settings.OllamaMaxContextLength;
+                _ollamaClient.ContextBudget.RandomDialogMaxTokens = _settings.RandomDialogMaxTokens;
+
+                if (_settings.EnableOllamaChat)
+                    _ollamaClient.Models.StartBackgroundRefresh(TimeSpan.FromSeconds(30));
+                else
+                    _ollamaClient.Models.StopBackgroundRefresh();
                 
                 // Update available animations for AI to use
                 if (_agentManager?.IsLoaded == true)
@@ -887,6 +1238,22 @@ namespace MSAgentAI.UI
                 }
             }
             
+            // Update pipeline CHAT quotas, deadlines and events
+            if (_chatScheduler != null)
+            {
+                _chatScheduler.TokensPerMinute = _settings.PipelineChatTokensPerMinute;
+                _chatScheduler.MaxQueuedPerClient = _settings.PipelineChatQueueLimit;
+            }
+            if (_pipelineServer != null)
+            {
+                _pipelineServer.DefaultChatTtl = GetDefaultChatTtl();
+                _pipelineServer.DrainTimeout = GetPipelineDrainTimeout();
+                RegisterPipelineEvents();
+                ApplyPipelineRateLimits();
+                RestartPipelineIfChanged();
+                ApplyPipelineRecording();
+            }
+            
             // Update memory manager settings
             if (_memoryManager != null)
             {
@@ -894,15 +1261,10 @@ namespace MSAgentAI.UI
                 _memoryManager.MemoryThreshold = _settings.MemoryThreshold;
             }
 
-            // Update random dialog timer
-            if (_settings.EnableRandomDialog)
-            {
-                _randomDialogTimer.Start();
-            }
-            else
-            {
-                _randomDialogTimer.Stop();
-            }
+            // Update random dialog timer and background work thresholds
+            _behavior?.ApplySettings();
+            ApplyGovernorSettings();
+            ApplyMemoryBudgetSettings();
 
             // Reload character if changed
             if (!string.IsNullOrEmpty(_settings.SelectedCharacterFile))
@@ -925,6 +1287,12 @@ namespace MSAgentAI.UI
                     System.Diagnostics.Debug.WriteLine($"Failed to reload character: {ex.Message}");
                 }
             }
+            
+            LoadExtraCharacters();
+            foreach (var session in _chatSessions.Values)
+            {
+                session.PersonalityPrompt = BuildCharacterPersonality(session.Name);
+            }
 
             // Save settings
             _settings.Save();
@@ -963,8 +1331,9 @@ namespace MSAgentAI.UI
         private void CleanUp()
         {
             _cancellationTokenSource?.Cancel();
-            _idleTimer?.Stop();
-            _randomDialogTimer?.Stop();
+            _behavior?.Stop();
+            _governor?.Dispose();
+            _memoryBudget?.Dispose();
 
             // Stop call mode if active
             if (_inCallMode)
@@ -974,10 +1343,27 @@ namespace MSAgentAI.UI
             }
             _speechRecognition?.Dispose();
 
-            // Stop the communication pipeline
-            _pipelineServer?.Dispose();
+            // Stop the communication pipeline, letting clients finish their current command.
+            // Their SPEAK and ANIMATION handlers invoke onto this thread, so keep it pumping.
+            if (_pipelineServer != null)
+            {
+                var stopping = Task.Run(() => _pipelineServer.Dispose());
+                while (!stopping.Wait(15))
+                {
+                    Application.DoEvents();
+                }
+            }
+            _chatScheduler?.Dispose();
+
+            // Macros defined since the last save go out with the final save below
+            _macroSaveTimer?.Dispose();
+            if (_pipelineServer != null && _settings != null)
+            {
+                _settings.PipelineMacros = _pipelineServer.GetMacroDefinitions();
+            }
 
             _trayIcon?.Dispose();
+            _characters?.Dispose();
             _agentManager?.Dispose();
             _voiceManager?.Dispose();
             _ollamaClient?.Dispose();
@@ -178,7 +178,7 @@ namespace MSAgentAI.UI
         {
             if (_settings == null) return;
             
-            var colors = AppSettings.GetThemeColors(_settings.UITheme);
+            var colors = ThemeColors.ForTheme(_settings.UITheme);
             this.BackColor = colors.Background;
             this.ForeColor = colors.Foreground;
             
@@ -1,14 +1,19 @@
 using System;
 using System.Collections.Generic;
 using System.Drawing;
+using System.Drawing.Imaging;
 using System.IO;
 using System.Linq;
+using System.Runtime.InteropServices;
+using System.Threading;
 using System.Threading.Tasks;
 using System.Windows.Forms;
 using System.Xml.Linq;
+using MSAgentAI.Acs;
 using MSAgentAI.Agent;
 using MSAgentAI.AI;
 using MSAgentAI.Config;
+using MSAgentAI.Logging;
 using MSAgentAI.Voice;
 
 namespace MSAgentAI.UI
@@ -25,6 +30,7 @@ namespace MSAgentAI.UI
         private AgentManager _agentManager;
         private Sapi4Manager _voiceManager;
         private OllamaClient _ollamaClient;
+        private AcsPreviewCache _previewCache;
 
         // Tabs
         private TabControl _tabControl;
@@ -44,6 +50,15 @@ namespace MSAgentAI.UI
         private Label _characterInfoLabel;
         private ListBox _animationsListBox;
         private Button _playAnimationButton;
+        private PictureBox _characterPreviewBox;
+
+        // Character previews: list thumbnails by path, and the frames being played
+        private readonly Dictionary<string, Image> _thumbnailImages = new Dictionary<string, Image>(StringComparer.OrdinalIgnoreCase);
+        private CancellationTokenSource _previewCancellation;
+        private AcsPreview _selectedPreview;
+        private List<Image> _previewFrames = new List<Image>();
+        private int _previewFrameIndex;
+        private System.Windows.Forms.Timer _previewTimer;
 
         // Name system controls
         private TextBox _userNameTextBox;
@@ -104,6 +119,10 @@ namespace MSAgentAI.UI
         private TextBox _pipelineIpTextBox;
         private NumericUpDown _pipelinePortNumeric;
         private TextBox _pipelineNameTextBox;
+        private CheckBox _pipelineUdpCheckBox;
+        private NumericUpDown _pipelineUdpPortNumeric;
+        private CheckBox _pipelineHttpCheckBox;
+        private NumericUpDown _pipelineHttpPortNumeric;
         private Label _pipelineStatusLabel;
 
         // Dialog buttons
@@ -111,12 +130,17 @@ namespace MSAgentAI.UI
         private Button _cancelButton;
         private Button _applyButton;
 
-        public SettingsForm(AppSettings settings, AgentManager agentManager, Sapi4Manager voiceManager, OllamaClient ollamaClient)
+        public SettingsForm(AppSettings settings, AgentManager agentManager, Sapi4Manager voiceManager, OllamaClient ollamaClient, AcsPreviewCache previewCache = null)
         {
             _settings = settings;
             _agentManager = agentManager;
             _voiceManager = voiceManager;
             _ollamaClient = ollamaClient;
+            _previewCache = previewCache;
+            if (_previewCache != null)
+            {
+                _previewCache.PreviewReady += OnPreviewReady;
+            }
 
             InitializeComponent();
             LoadSettings();
@@ -128,7 +152,7 @@ namespace MSAgentAI.UI
         /// </summary>
         private void ApplyTheme()
         {
-            var theme = AppSettings.GetThemeColors(_settings.UITheme);
+            var theme = ThemeColors.ForTheme(_settings.UITheme);
             ApplyThemeToControl(this, theme);
         }
         
@@ -321,9 +345,12 @@ namespace MSAgentAI.UI
             _characterListBox = new ListBox
             {
                 Location = new Point(15, 112),
-                Size = new Size(200, 200)
+                Size = new Size(200, 200),
+                DrawMode = DrawMode.OwnerDrawFixed,
+                ItemHeight = 36
             };
             _characterListBox.SelectedIndexChanged += OnCharacterSelectionChanged;
+            _characterListBox.DrawItem += OnCharacterDrawItem;
 
             _previewButton = new Button
             {
@@ -343,14 +370,25 @@ namespace MSAgentAI.UI
             };
             _selectButton.Click += OnSelectCharacterClick;
 
+            _characterPreviewBox = new PictureBox
+            {
+                Location = new Point(225, 112),
+                Size = new Size(80, 80),
+                SizeMode = PictureBoxSizeMode.CenterImage,
+                BorderStyle = BorderStyle.FixedSingle
+            };
+
             _characterInfoLabel = new Label
             {
                 Text = "Select a character to see information",
-                Location = new Point(225, 112),
-                Size = new Size(170, 80),
+                Location = new Point(310, 112),
+                Size = new Size(85, 80),
                 BorderStyle = BorderStyle.FixedSingle
             };
 
+            _previewTimer = new System.Windows.Forms.Timer { Interval = 150 };
+            _previewTimer.Tick += OnPreviewTimerTick;
+
             // Animations list
             var animLabel = new Label
             {
@@ -364,6 +402,7 @@ namespace MSAgentAI.UI
                 Location = new Point(225, 217),
                 Size = new Size(170, 100)
             };
+            _animationsListBox.SelectedIndexChanged += OnAnimationSelectionChanged;
 
             _playAnimationButton = new Button
             {
@@ -443,7 +482,7 @@ namespace MSAgentAI.UI
             {
                 pathLabel, _characterPathTextBox, _browsePathButton, refreshButton,
                 nameLabel, _userNameTextBox, pronunciationLabel, _userNamePronunciationTextBox, _testNameButton, nameHintLabel,
-                listLabel, _characterListBox, _previewButton, _selectButton, _characterInfoLabel,
+                listLabel, _characterListBox, _previewButton, _selectButton, _characterPreviewBox, _characterInfoLabel,
                 animLabel, _animationsListBox, _playAnimationButton, empHintLabel,
                 agentSizeLabel, _agentSizeTrackBar, _agentSizeValueLabel,
                 descLabel, descHintLabel
@@ -1213,11 +1252,47 @@ namespace MSAgentAI.UI
                 AutoSize = false
             };
 
+            // UDP ingest (alongside either protocol)
+            _pipelineUdpCheckBox = new CheckBox
+            {
+                Text = "Also accept UDP datagrams (one command each, no reply) on port:",
+                Location = new Point(15, 247),
+                Size = new Size(400, 22)
+            };
+            _pipelineUdpCheckBox.CheckedChanged += (s, e) => _pipelineUdpPortNumeric.Enabled = _pipelineUdpCheckBox.Checked;
+
+            _pipelineUdpPortNumeric = new NumericUpDown
+            {
+                Location = new Point(420, 246),
+                Size = new Size(90, 23),
+                Minimum = 1,
+                Maximum = 65535,
+                Value = 8766
+            };
+
+            // HTTP/WebSocket endpoint for browser sources (alongside either protocol)
+            _pipelineHttpCheckBox = new CheckBox
+            {
+                Text = "Also serve HTTP and WebSocket (browser overlays) on port:",
+                Location = new Point(15, 275),
+                Size = new Size(400, 22)
+            };
+            _pipelineHttpCheckBox.CheckedChanged += (s, e) => _pipelineHttpPortNumeric.Enabled = _pipelineHttpCheckBox.Checked;
+
+            _pipelineHttpPortNumeric = new NumericUpDown
+            {
+                Location = new Point(420, 274),
+                Size = new Size(90, 23),
+                Minimum = 1,
+                Maximum = 65535,
+                Value = 8767
+            };
+
             _pipelineStatusLabel = new Label
             {
                 Text = "Pipeline server will restart when settings are applied.",
-                Location = new Point(15, 250),
-                Size = new Size(570, 40),
+                Location = new Point(15, 305),
+                Size = new Size(570, 30),
                 ForeColor = System.Drawing.Color.DarkOrange,
                 AutoSize = false
             };
@@ -1225,7 +1300,7 @@ namespace MSAgentAI.UI
             var examplesLabel = new Label
             {
                 Text = "Connection Examples:",
-                Location = new Point(15, 295),
+                Location = new Point(15, 340),
                 Size = new Size(200, 20),
                 Font = new System.Drawing.Font(this.Font, System.Drawing.FontStyle.Bold)
             };
@@ -1234,9 +1309,11 @@ namespace MSAgentAI.UI
             {
                 Text = "Named Pipe (Python): win32file.CreateFile(r'\\\\.\\pipe\\MSAgentAI', ...)\n" +
                        "TCP Socket (Python): socket.connect(('127.0.0.1', 8765))\n" +
+                       "UDP (Python): sock.sendto(b'ANIMATION:Wave', ('127.0.0.1', 8766))\n" +
+                       "Browser (JavaScript): new WebSocket('ws://localhost:8767/ws')\n" +
                        "See PIPELINE.md for complete examples in multiple languages.",
-                Location = new Point(15, 320),
-                Size = new Size(570, 60),
+                Location = new Point(15, 362),
+                Size = new Size(570, 85),
                 ForeColor = System.Drawing.Color.Gray,
                 AutoSize = false
             };
@@ -1246,6 +1323,8 @@ namespace MSAgentAI.UI
                 descLabel, protocolLabel, _pipelineProtocolComboBox,
                 pipeNameLabel, _pipelineNameTextBox, pipeHelpLabel,
                 ipLabel, _pipelineIpTextBox, portLabel, _pipelinePortNumeric, tcpHelpLabel,
+                _pipelineUdpCheckBox, _pipelineUdpPortNumeric,
+                _pipelineHttpCheckBox, _pipelineHttpPortNumeric,
                 _pipelineStatusLabel, examplesLabel, examplesText
             });
         }
@@ -1412,6 +1491,14 @@ namespace MSAgentAI.UI
             _pipelinePortNumeric.Value = Math.Max(_pipelinePortNumeric.Minimum, 
                 Math.Min(_pipelinePortNumeric.Maximum, _settings.PipelinePort));
             _pipelineNameTextBox.Text = _settings.PipelineName ?? "MSAgentAI";
+            _pipelineUdpPortNumeric.Value = Math.Max(_pipelineUdpPortNumeric.Minimum,
+                Math.Min(_pipelineUdpPortNumeric.Maximum, _settings.PipelineUdpPort));
+            _pipelineUdpCheckBox.Checked = _settings.PipelineUdpEnabled;
+            _pipelineUdpPortNumeric.Enabled = _settings.PipelineUdpEnabled;
+            _pipelineHttpPortNumeric.Value = Math.Max(_pipelineHttpPortNumeric.Minimum,
+                Math.Min(_pipelineHttpPortNumeric.Maximum, _settings.PipelineHttpPort));
+            _pipelineHttpCheckBox.Checked = _settings.PipelineHttpEnabled;
+            _pipelineHttpPortNumeric.Enabled = _settings.PipelineHttpEnabled;
             OnPipelineProtocolChanged(null, EventArgs.Empty); // Update UI based on protocol
         }
 
@@ -1535,6 +1622,10 @@ namespace MSAgentAI.UI
                 _pipelineNameTextBox.Text = pipeName; // Update UI to show the fallback value
             }
             _settings.PipelineName = pipeName;
+            _settings.PipelineUdpEnabled = _pipelineUdpCheckBox.Checked;
+            _settings.PipelineUdpPort = (int)_pipelineUdpPortNumeric.Value;
+            _settings.PipelineHttpEnabled = _pipelineHttpCheckBox.Checked;
+            _settings.PipelineHttpPort = (int)_pipelineHttpPortNumeric.Value;
 
             _settings.Save();
         }
@@ -1589,6 +1680,8 @@ namespace MSAgentAI.UI
             if (_agentManager != null)
             {
                 var characters = _agentManager.GetAvailableCharacters(_characterPathTextBox.Text);
+                WarmPreviews(characters);
+
                 foreach (var charPath in characters)
                 {
                     var item = new CharacterItem
@@ -1607,6 +1700,179 @@ namespace MSAgentAI.UI
             }
         }
 
+        /// <summary>
+        /// Shows cached thumbnails straight away and builds the missing ones in the background
+        /// </summary>
+        private void WarmPreviews(List<string> characters)
+        {
+            if (_previewCache == null)
+                return;
+
+            _previewCancellation?.Cancel();
+            _previewCancellation = new CancellationTokenSource();
+            LoadCachedThumbnails(characters);
+
+            _ = _previewCache.WarmAsync(characters, _previewCancellation.Token).ContinueWith(task =>
+            {
+                if (task.IsFaulted)
+                {
+                    Logger.LogError("Building character previews failed", task.Exception?.GetBaseException());
+                }
+            }, TaskScheduler.Default);
+        }
+
+        private void LoadCachedThumbnails(IEnumerable<string> characters)
+        {
+            foreach (var path in characters)
+            {
+                if (!_thumbnailImages.ContainsKey(path) && _previewCache.TryGetThumbnail(path, out var preview))
+                {
+                    _thumbnailImages[path] = CreateBitmap(preview, preview.Thumbnail);
+                }
+            }
+            _characterListBox.Invalidate();
+        }
+
+        private void OnPreviewReady(string path, AcsPreview preview)
+        {
+            if (IsDisposed || !IsHandleCreated)
+                return;
+
+            try
+            {
+                BeginInvoke(new Action(() =>
+                {
+                    if (IsDisposed || _thumbnailImages.ContainsKey(path))
+                        return;
+
+                    _thumbnailImages[path] = CreateBitmap(preview, preview.Thumbnail);
+                    _characterListBox.Invalidate();
+                    if (_characterListBox.SelectedItem is CharacterItem item && string.Equals(item.FilePath, path, StringComparison.OrdinalIgnoreCase))
+                    {
+                        ShowCharacterPreview(item);
+                    }
+                }));
+            }
+            catch (InvalidOperationException)
+            {
+                // The dialog closed while this preview was being built
+            }
+        }
+
+        /// <summary>
+        /// Converts a preview image to a bitmap with transparency
+        /// </summary>
+        private static Bitmap CreateBitmap(AcsPreview preview, byte[] indices)
+        {
+            var pixels = preview.ToPixels(indices, AcsPixelFormat.Bgra);
+            var argb = new int[pixels.Length];
+            Buffer.BlockCopy(pixels, 0, argb, 0, pixels.Length * 4);
+
+            var bitmap = new Bitmap(preview.Width, preview.Height, PixelFormat.Format32bppArgb);
+            var data = bitmap.LockBits(new Rectangle(0, 0, preview.Width, preview.Height), ImageLockMode.WriteOnly, PixelFormat.Format32bppArgb);
+            try
+            {
+                Marshal.Copy(argb, 0, data.Scan0, argb.Length);
+            }
+            finally
+            {
+                bitmap.UnlockBits(data);
+            }
+            return bitmap;
+        }
+
+        private void OnCharacterDrawItem(object sender, DrawItemEventArgs e)
+        {
+            e.DrawBackground();
+            if (e.Index >= 0 && _characterListBox.Items[e.Index] is CharacterItem item)
+            {
+                var thumbnailBounds = new Rectangle(e.Bounds.X + 2, e.Bounds.Y + 2, e.Bounds.Height - 4, e.Bounds.Height - 4);
+                if (_thumbnailImages.TryGetValue(item.FilePath, out var thumbnail))
+                {
+                    e.Graphics.DrawImage(thumbnail, thumbnailBounds);
+                }
+
+                var textBounds = new Rectangle(thumbnailBounds.Right + 4, e.Bounds.Y, e.Bounds.Width - thumbnailBounds.Width - 8, e.Bounds.Height);
+                TextRenderer.DrawText(e.Graphics, item.Name, e.Font, textBounds, e.ForeColor,
+                    TextFormatFlags.VerticalCenter | TextFormatFlags.EndEllipsis);
+            }
+            e.DrawFocusRectangle();
+        }
+
+        /// <summary>
+        /// Shows the selected character's thumbnail and loads its animation strips
+        /// </summary>
+        private async void ShowCharacterPreview(CharacterItem item)
+        {
+            _selectedPreview = null;
+            StopPreviewAnimation();
+
+            // Only read strips for characters already cached; the rest arrive via OnPreviewReady
+            if (_previewCache == null || !_thumbnailImages.ContainsKey(item.FilePath))
+                return;
+
+            var preview = await Task.Run(() => _previewCache.GetPreview(item.FilePath));
+            if (IsDisposed || preview == null || !(_characterListBox.SelectedItem is CharacterItem selected) || selected != item)
+                return;
+
+            _selectedPreview = preview;
+            _characterInfoLabel.Text = $"Name: {preview.Name}\n\n{preview.Description}";
+            RefreshAnimationsList();
+        }
+
+        /// <summary>
+        /// Plays an animation's preview strip in the preview box
+        /// </summary>
+        private bool PlayPreviewAnimation(string animation)
+        {
+            StopPreviewAnimation();
+            if (_selectedPreview == null || animation == null)
+                return false;
+
+            var strip = _selectedPreview.GetStrip(animation);
+            if (strip.Count == 0)
+                return false;
+
+            foreach (var frame in strip)
+            {
+                _previewFrames.Add(CreateBitmap(_selectedPreview, frame));
+            }
+            _previewFrameIndex = 0;
+            _characterPreviewBox.Image = _previewFrames[0];
+            _previewTimer.Start();
+            return true;
+        }
+
+        /// <summary>
+        /// Stops any strip and goes back to the selected character's thumbnail
+        /// </summary>
+        private void StopPreviewAnimation()
+        {
+            _previewTimer?.Stop();
+            _characterPreviewBox.Image = _characterListBox.SelectedItem is CharacterItem item && _thumbnailImages.TryGetValue(item.FilePath, out var thumbnail)
+                ? thumbnail
+                : null;
+
+            foreach (var frame in _previewFrames)
+            {
+                frame.Dispose();
+            }
+            _previewFrames.Clear();
+        }
+
+        private void OnPreviewTimerTick(object sender, EventArgs e)
+        {
+            if (_previewFrames.Count == 0)
+            {
+                _previewTimer.Stop();
+                return;
+            }
+
+            // Plays through once and holds the last frame for a beat before looping
+            _previewFrameIndex = (_previewFrameIndex + 1) % (_previewFrames.Count + 3);
+            _characterPreviewBox.Image = _previewFrames[Math.Min(_previewFrameIndex, _previewFrames.Count - 1)];
+        }
+
         #region Event Handlers
 
         private void OnBrowsePathClick(object sender, EventArgs e)
@@ -1640,6 +1906,7 @@ namespace MSAgentAI.UI
                 _characterInfoLabel.Text = $"Name: {item.Name}\n\nPath: {item.FilePath}";
                 
                 // Load animations for the selected character
+                ShowCharacterPreview(item);
                 RefreshAnimationsList();
             }
         }
@@ -1649,7 +1916,17 @@ namespace MSAgentAI.UI
             _animationsListBox.Items.Clear();
             _playAnimationButton.Enabled = false;
 
-            if (_agentManager != null && _agentManager.IsLoaded)
+            // The selected character's own animations when its preview is loaded; playing
+            // still goes to the loaded agent
+            if (_selectedPreview != null)
+            {
+                foreach (var anim in _selectedPreview.Animations)
+                {
+                    _animationsListBox.Items.Add(anim);
+                }
+                _playAnimationButton.Enabled = _agentManager?.IsLoaded == true && _animationsListBox.Items.Count > 0;
+            }
+            else if (_agentManager != null && _agentManager.IsLoaded)
             {
                 var animations = _agentManager.GetAnimations();
                 foreach (var anim in animations)
@@ -1660,6 +1937,11 @@ namespace MSAgentAI.UI
             }
         }
 
+        private void OnAnimationSelectionChanged(object sender, EventArgs e)
+        {
+            PlayPreviewAnimation(_animationsListBox.SelectedItem?.ToString());
+        }
+
         private void OnPlayAnimationClick(object sender, EventArgs e)
         {
             if (_animationsListBox.SelectedItem != null && _agentManager?.IsLoaded == true)
@@ -1748,6 +2030,10 @@ namespace MSAgentAI.UI
 
         private void OnPreviewClick(object sender, EventArgs e)
         {
+            // The cached strip plays instantly; loading through the Agent server takes seconds
+            if (_selectedPreview != null && (PlayPreviewAnimation("Greet") || PlayPreviewAnimation(_selectedPreview.Animations.FirstOrDefault())))
+                return;
+
             if (_characterListBox.SelectedItem is CharacterItem item && _agentManager != null)
             {
                 try
@@ -1819,10 +2105,10 @@ namespace MSAgentAI.UI
 
         private async void OnRefreshModelsClick(object sender, EventArgs e)
         {
-            await RefreshOllamaModels();
+            await RefreshOllamaModels(forceRefresh: true);
         }
 
-        private async Task RefreshOllamaModels()
+        private async Task RefreshOllamaModels(bool forceRefresh = false)
         {
             _refreshModelsButton.Enabled = false;
             _refreshModelsButton.Text = "...";
@@ -1830,7 +2116,7 @@ namespace MSAgentAI.UI
             try
             {
                 _ollamaClient.BaseUrl = _ollamaUrlTextBox.Text;
-                var models = await _ollamaClient.GetAvailableModelsAsync();
+                var models = await _ollamaClient.GetAvailableModelsAsync(forceRefresh);
 
                 _ollamaModelComboBox.Items.Clear();
                 foreach (var model in models)
@@ -1863,6 +2149,41 @@ namespace MSAgentAI.UI
 
         #endregion
 
+        protected override void OnShown(EventArgs e)
+        {
+            base.OnShown(e);
+
+            // Previews finished before the window existed couldn't be posted to it
+            if (_previewCache != null)
+            {
+                LoadCachedThumbnails(_characterListBox.Items.OfType<CharacterItem>().Select(character => character.FilePath));
+                if (_selectedPreview == null && _characterListBox.SelectedItem is CharacterItem item)
+                {
+                    ShowCharacterPreview(item);
+                }
+            }
+        }
+
+        protected override void OnFormClosed(FormClosedEventArgs e)
+        {
+            // The cache outlives the dialog; stop building for it and let go of its events
+            if (_previewCache != null)
+            {
+                _previewCache.PreviewReady -= OnPreviewReady;
+            }
+            _previewCancellation?.Cancel();
+            StopPreviewAnimation();
+            _previewTimer?.Dispose();
+            _characterPreviewBox.Image = null;
+            foreach (var image in _thumbnailImages.Values)
+            {
+                image.Dispose();
+            }
+            _thumbnailImages.Clear();
+
+            base.OnFormClosed(e);
+        }
+
         private class CharacterItem
         {
             public string Name { get; set; }
@@ -0,0 +1,97 @@
+using System.Drawing;
+
+namespace MSAgentAI.UI
+{
+    /// <summary>
+    /// Theme color definition
+    /// </summary>
+    public class ThemeColors
+    {
+        public Color Background { get; set; }
+        public Color Foreground { get; set; }
+        public Color ButtonBackground { get; set; }
+        public Color ButtonForeground { get; set; }
+        public Color InputBackground { get; set; }
+        public Color InputForeground { get; set; }
+
+        /// <summary>
+        /// Gets the colors for a theme in AppSettings.AvailableThemes
+        /// </summary>
+        public static ThemeColors ForTheme(string themeName)
+        {
+            switch (themeName)
+            {
+                case "Dark":
+                    return new ThemeColors
+                    {
+                        Background = Color.FromArgb(45, 45, 48),
+                        Foreground = Color.White,
+                        ButtonBackground = Color.FromArgb(60, 60, 65),
+                        ButtonForeground = Color.White,
+                        InputBackground = Color.FromArgb(30, 30, 30),
+                        InputForeground = Color.White
+                    };
+                case "Deep Blue":
+                    return new ThemeColors
+                    {
+                        Background = Color.FromArgb(20, 30, 60),
+                        Foreground = Color.White,
+                        ButtonBackground = Color.FromArgb(30, 50, 100),
+                        ButtonForeground = Color.White,
+                        InputBackground = Color.FromArgb(15, 25, 50),
+                        InputForeground = Color.LightCyan
+                    };
+                case "Deep Purple":
+                    return new ThemeColors
+                    {
+                        Background = Color.FromArgb(40, 20, 60),
+                        Foreground = Color.White,
+                        ButtonBackground = Color.FromArgb(70, 40, 100),
+                        ButtonForeground = Color.White,
+                        InputBackground = Color.FromArgb(30, 15, 45),
+                        InputForeground = Color.Lavender
+                    };
+                case "Wine Red":
+                    return new ThemeColors
+                    {
+                        Background = Color.FromArgb(60, 20, 30),
+                        Foreground = Color.White,
+                        ButtonBackground = Color.FromArgb(100, 40, 50),
+                        ButtonForeground = Color.White,
+                        InputBackground = Color.FromArgb(45, 15, 25),
+                        InputForeground = Color.MistyRose
+                    };
+                case "Deep Green":
+                    return new ThemeColors
+                    {
+                        Background = Color.FromArgb(20, 50, 30),
+                        Foreground = Color.White,
+                        ButtonBackground = Color.FromArgb(40, 80, 50),
+                        ButtonForeground = Color.White,
+                        InputBackground = Color.FromArgb(15, 40, 25),
+                        InputForeground = Color.LightGreen
+                    };
+                case "Pure Black":
+                    return new ThemeColors
+                    {
+                        Background = Color.Black,
+                        Foreground = Color.White,
+                        ButtonBackground = Color.FromArgb(30, 30, 30),
+                        ButtonForeground = Color.White,
+                        InputBackground = Color.FromArgb(10, 10, 10),
+                        InputForeground = Color.White
+                    };
+                default: // Default system theme
+                    return new ThemeColors
+                    {
+                        Background = SystemColors.Control,
+                        Foreground = SystemColors.ControlText,
+                        ButtonBackground = SystemColors.Control,
+                        ButtonForeground = SystemColors.ControlText,
+                        InputBackground = SystemColors.Window,
+                        InputForeground = SystemColors.WindowText
+                    };
+            }
+        }
+    }
+}
@@ -4,6 +4,7 @@ using System.Speech.Recognition;
 using System.Threading;
 using System.Threading.Tasks;
 using MSAgentAI.Logging;
+using MSAgentAI.Timing;
 
 namespace MSAgentAI.Voice
 {
@@ -18,7 +19,7 @@ namespace MSAgentAI.Voice
         private bool _isListening;
         private DateTime _lastSpeechTime;
         private string _currentUtterance;
-        private Timer _silenceTimer;
+        private IClockTimer _silenceTimer;
         private int _silenceThresholdMs = 1500; // Default 1.5 seconds
         private double _minConfidenceThreshold = 0.2; // Default 0.2
         private bool _speechInProgress;
@@ -44,6 +45,11 @@ namespace MSAgentAI.Voice
             get => _minConfidenceThreshold; 
             set => _minConfidenceThreshold = Math.Max(0.0, Math.Min(1.0, value)); 
         }
+        
+        /// <summary>
+        /// Times silence after speech; its timer ticks on the thread pool by default
+        /// </summary>
+        public IClock Clock { get; set; } = SystemClock.Instance;
 
         public SpeechRecognitionManager()
         {
@@ -122,7 +128,7 @@ namespace MSAgentAI.Voice
             // If audio level is significant, mark as speech in progress
             if (e.AudioLevel > 10)
             {
-                _lastSpeechTime = DateTime.Now;
+                _lastSpeechTime = Clock.Now;
                 _speechInProgress = true;
             }
         }
@@ -133,7 +139,7 @@ namespace MSAgentAI.Voice
             if (e.AudioState == AudioState.Speech)
             {
                 _speechInProgress = true;
-                _lastSpeechTime = DateTime.Now;
+                _lastSpeechTime = Clock.Now;
             }
         }
 
@@ -163,7 +169,7 @@ namespace MSAgentAI.Voice
             {
                 Logger.Log("Starting speech recognition...");
                 _currentUtterance = "";
-                _lastSpeechTime = DateTime.Now;
+                _lastSpeechTime = Clock.Now;
                 _speechInProgress = false;
                 
                 // Stop any previous timer
@@ -177,7 +183,8 @@ namespace MSAgentAI.Voice
                 _recognizer.RecognizeAsync(RecognizeMode.Multiple);
 
                 // Start silence detection timer (check more frequently)
-                _silenceTimer = new Timer(CheckSilence, null, 250, 250);
+                _silenceTimer = Clock.CreateTimer(TimeSpan.FromMilliseconds(250), CheckSilence);
+                _silenceTimer.Start();
 
                 OnListeningStarted?.Invoke(this, EventArgs.Empty);
                 Logger.Log("Speech recognition started - listening for input");
@@ -232,7 +239,7 @@ namespace MSAgentAI.Voice
         {
             if (e.Result != null && e.Result.Confidence >= _minConfidenceThreshold)
             {
-                _lastSpeechTime = DateTime.Now;
+                _lastSpeechTime = Clock.Now;
                 _speechInProgress = true;
                 _currentUtterance += " " + e.Result.Text;
                 Logger.Log($"Speech recognized: \"{e.Result.Text}\" (confidence: {e.Result.Confidence:F2})");
@@ -245,7 +252,7 @@ namespace MSAgentAI.Voice
 
         private void OnSpeechHypothesized(object sender, SpeechHypothesizedEventArgs e)
         {
-            _lastSpeechTime = DateTime.Now;
+            _lastSpeechTime = Clock.Now;
             _speechInProgress = true;
             // Log hypothesized speech for debugging
             if (e.Result != null && e.Result.Confidence >= 0.1)
@@ -256,7 +263,7 @@ namespace MSAgentAI.Voice
 
         private void OnSpeechDetected(object sender, SpeechDetectedEventArgs e)
         {
-            _lastSpeechTime = DateTime.Now;
+            _lastSpeechTime = Clock.Now;
         }
 
         private void OnRecognizeCompleted(object sender, RecognizeCompletedEventArgs e)
@@ -267,11 +274,11 @@ namespace MSAgentAI.Voice
             }
         }
 
-        private void CheckSilence(object state)
+        private void CheckSilence()
         {
             if (!_isListening) return;
 
-            var silenceTime = (DateTime.Now - _lastSpeechTime).TotalMilliseconds;
+            var silenceTime = (Clock.Now - _lastSpeechTime).TotalMilliseconds;
             
             // Only trigger if we had speech in progress and now have silence
             if (_speechInProgress && silenceTime >= _silenceThresholdMs && !string.IsNullOrWhiteSpace(_currentUtterance))
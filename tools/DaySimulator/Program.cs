@@ -0,0 +1,96 @@
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+
+namespace MSAgentAI.Tools.DaySimulator
+{
+    /// <summary>
+    /// Replays a day of usage against the character's behavior, the AI client and memories on
+    /// a virtual clock, so idle lines, random dialog and memory aging can be checked in seconds.
+    /// </summary>
+    public static class Program
+    {
+        public static int Main(string[] args)
+        {
+            SimulatorOptions options;
+            try
+            {
+                options = SimulatorOptions.Parse(args);
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                Console.Error.WriteLine();
+                Console.Error.WriteLine(SimulatorOptions.Usage);
+                return 2;
+            }
+
+            var wall = Stopwatch.StartNew();
+            try
+            {
+                var duration = TimeSpan.FromHours(options.Hours);
+                var usage = options.UsagePath != null
+                    ? UsageScript.Load(options.UsagePath)
+                    : UsageScript.Generate(new Random(options.Seed), options.Start, duration);
+
+                using (var simulation = new Simulation(options))
+                {
+                    string source = options.UsagePath ?? $"generated usage, seed {options.Seed}";
+                    Console.WriteLine($"Simulating {options.Hours:0.##} h of {simulation.Character} from {options.Start:yyyy-MM-dd HH:mm} ({usage.Count} events, {source})");
+                    Console.WriteLine();
+                    Console.WriteLine("Hour     Idle  Random  Click  Move  Chats  Pokes  LLM  LLM busy  Memories");
+
+                    var reports = simulation.Run(usage, report => Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+                        "{0:HH:mm}  {1,5}  {2,6}  {3,5}  {4,4}  {5,5}  {6,5}  {7,3}  {8,7:F1}s  {9,8}",
+                        report.Start, report.IdleLines, report.RandomDialogs, report.ClickedLines, report.MovedLines,
+                        report.Chats, report.Pokes, report.LlmRequests, report.LlmBusy.TotalSeconds, report.Memories)));
+
+                    wall.Stop();
+                    Console.WriteLine(string.Format(CultureInfo.InvariantCulture,
+                        "Total  {0,5}  {1,6}  {2,5}  {3,4}  {4,5}  {5,5}  {6,3}  {7,7:F1}s",
+                        reports.Sum(r => r.IdleLines), reports.Sum(r => r.RandomDialogs), reports.Sum(r => r.ClickedLines),
+                        reports.Sum(r => r.MovedLines), reports.Sum(r => r.Chats), reports.Sum(r => r.Pokes),
+                        reports.Sum(r => r.LlmRequests), reports.Sum(r => r.LlmBusy.TotalSeconds)));
+
+                    if (simulation.Unfinished > 0)
+                        Console.WriteLine($"{simulation.Unfinished} conversation(s) were still waiting on the model at the end");
+                    if (simulation.Llm.LoadStatePolls > 0)
+                        Console.WriteLine($"Model unloaded in {simulation.Llm.ColdPolls} of {simulation.Llm.LoadStatePolls} load state polls");
+
+                    var top = simulation.Memories.GetRelevantMemories(5);
+                    if (top.Count > 0)
+                    {
+                        Console.WriteLine();
+                        Console.WriteLine("Most relevant memories at the end:");
+                        foreach (var memory in top)
+                        {
+                            Console.WriteLine($"  {memory.Importance,4:0.0}  {memory.Timestamp:HH:mm}  x{memory.AccessCount,-4} {memory.Content}");
+                        }
+                    }
+
+                    Console.WriteLine();
+                    double speedup = duration.TotalSeconds / Math.Max(0.001, wall.Elapsed.TotalSeconds);
+                    Console.WriteLine($"Simulated {options.Hours:0.##} h in {wall.Elapsed.TotalSeconds:F2} s ({speedup:N0}x real time)");
+
+                    // Random dialog fires mostly while idle, when the model has been unloaded.
+                    // With a few lines expected, none at all means something is holding it back.
+                    long randomDialogs = reports.Sum(r => r.RandomDialogs);
+                    if (randomDialogs == 0 && simulation.MinExpectedRandomDialogs >= 3)
+                    {
+                        Console.Error.WriteLine($"Random dialog never fired; at least {simulation.MinExpectedRandomDialogs:0.#} lines were expected");
+                        return 1;
+                    }
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is FormatException || ex is UnauthorizedAccessException)
+            {
+                Console.Error.WriteLine(ex.Message);
+                return 1;
+            }
+
+            return 0;
+        }
+    }
+}
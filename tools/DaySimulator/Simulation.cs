@@ -0,0 +1,341 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Agent;
+using MSAgentAI.AI;
+using MSAgentAI.Config;
+using MSAgentAI.Daemon;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Tools.DaySimulator
+{
+    /// <summary>
+    /// One hour of a simulated day
+    /// </summary>
+    public sealed class HourReport
+    {
+        public DateTime Start { get; set; }
+        public long IdleLines { get; set; }
+        public long RandomDialogs { get; set; }
+        public long ClickedLines { get; set; }
+        public long MovedLines { get; set; }
+        public int Chats { get; set; }
+        public int Pokes { get; set; }
+        public long LlmRequests { get; set; }
+        public TimeSpan LlmBusy { get; set; }
+        public int Memories { get; set; }
+    }
+
+    /// <summary>
+    /// Runs AgentBehavior, OllamaClient and MemoryManager against a headless character and a
+    /// stub model on a VirtualClock, replaying usage hour by hour. Nothing waits on real time,
+    /// so a day takes seconds.
+    /// </summary>
+    public sealed class Simulation : IDisposable
+    {
+        // As AgentManager: drags closer together than this raise one move event
+        private static readonly TimeSpan MoveEventCooldown = TimeSpan.FromMilliseconds(2000);
+
+        private readonly SimulatorOptions _options;
+        private readonly VirtualClock _clock;
+        private readonly AppSettings _settings;
+        private readonly StubLlmHandler _llm;
+        private readonly OllamaClient _ollamaClient;
+        private readonly MemoryManager _memoryManager;
+        private readonly ConsoleAgentBackend _agent;
+        private readonly AgentBehavior _behavior;
+        private readonly TextWriter _transcript;
+        private readonly string _memoriesPath;
+        private readonly List<Task> _conversations = new List<Task>();
+        private DateTime _lastMove = DateTime.MinValue;
+        private int _chats;
+        private int _pokes;
+
+        public Simulation(SimulatorOptions options)
+        {
+            _options = options;
+            _clock = new VirtualClock(options.Start);
+            _settings = LoadSettings(options.SettingsPath);
+
+            _llm = new StubLlmHandler(_clock, _settings.OllamaModel)
+            {
+                TokensPerSecond = options.TokensPerSecond,
+                PromptEvalRate = options.PromptEvalRate
+            };
+            _ollamaClient = new OllamaClient(_llm, _clock)
+            {
+                BaseUrl = _settings.OllamaUrl,
+                Model = _settings.OllamaModel,
+                PersonalityPrompt = _settings.PersonalityPrompt,
+                AdaptiveContext = _settings.OllamaAdaptiveContext,
+                UserDescription = _settings.UserDescription
+            };
+            _ollamaClient.ContextBudget.MaxContextLength = _settings.OllamaMaxContextLength;
+            _ollamaClient.ContextBudget.RandomDialogMaxTokens = _settings.RandomDialogMaxTokens;
+
+            // A fresh memories file per run, so runs with the same seed match
+            _memoriesPath = Path.Combine(Path.GetTempPath(), $"msagentai-daysim-{Guid.NewGuid():N}.json");
+            _memoryManager = new MemoryManager(_memoriesPath)
+            {
+                Clock = _clock,
+                Enabled = _settings.EnableMemories,
+                MemoryThreshold = _settings.MemoryThreshold
+            };
+            _ollamaClient.MemoryManager = _memoryManager;
+
+            if (options.TranscriptPath != null)
+            {
+                _transcript = new TranscriptWriter(new StreamWriter(options.TranscriptPath, false, new UTF8Encoding(false)), _clock);
+            }
+
+            _agent = new ConsoleAgentBackend(_transcript ?? TextWriter.Null, _clock)
+            {
+                WordsPerMinute = _settings.VoiceSpeed > 0 ? _settings.VoiceSpeed : 150
+            };
+            string character = string.IsNullOrWhiteSpace(_settings.SelectedCharacterFile) ? "Agent" : _settings.SelectedCharacterFile;
+            _agent.LoadCharacter(character);
+            _agent.Show(false);
+            _ollamaClient.AvailableAnimations = _agent.GetAnimations();
+
+            _behavior = new AgentBehavior(_settings, _ollamaClient, _clock, new Random(options.Seed))
+            {
+                Speak = SpeakWithAnimations,
+                IsLoaded = () => _agent.IsLoaded
+            };
+        }
+
+        public DateTime Now => _clock.Now;
+        public StubLlmHandler Llm => _llm;
+        public MemoryManager Memories => _memoryManager;
+        public string Character => _agent.State.Character;
+
+        /// <summary>
+        /// Random dialog lines a run this long should see at the least: the 1-in-N chance
+        /// every second, backed off as if the model were always cold
+        /// </summary>
+        public double MinExpectedRandomDialogs
+        {
+            get
+            {
+                if (!_settings.EnableRandomDialog || !_settings.EnableOllamaChat || _settings.RandomDialogChance <= 0)
+                    return 0;
+
+                double chance = _settings.RandomDialogChance * (_settings.RandomDialogColdBackoff ? AgentBehavior.ColdModelChanceFactor : 1);
+                return _options.Hours * 3600 / chance;
+            }
+        }
+
+        /// <summary>
+        /// Replays the usage, reporting after each simulated hour
+        /// </summary>
+        public List<HourReport> Run(IReadOnlyList<UsageEvent> usage, Action<HourReport> onHour)
+        {
+            var reports = new List<HourReport>();
+            var start = _clock.Now;
+            var end = start + TimeSpan.FromHours(_options.Hours);
+            int next = 0;
+
+            // Load state polled as the app does, so random dialog sees the model go cold
+            if (_settings.EnableOllamaChat)
+                _ollamaClient.Models.StartBackgroundRefresh(TimeSpan.FromSeconds(30));
+            _behavior.Start();
+            var hourStart = start;
+            while (hourStart < end)
+            {
+                var hourEnd = hourStart.AddHours(1) < end ? hourStart.AddHours(1) : end;
+                var before = Snapshot(hourStart);
+
+                while (next < usage.Count && start + usage[next].At < hourEnd)
+                {
+                    _clock.AdvanceTo(start + usage[next].At);
+                    Dispatch(usage[next]);
+                    next++;
+                }
+                _clock.AdvanceTo(hourEnd);
+
+                var after = Snapshot(hourStart);
+                var report = new HourReport
+                {
+                    Start = hourStart,
+                    IdleLines = after.IdleLines - before.IdleLines,
+                    RandomDialogs = after.RandomDialogs - before.RandomDialogs,
+                    ClickedLines = after.ClickedLines - before.ClickedLines,
+                    MovedLines = after.MovedLines - before.MovedLines,
+                    Chats = after.Chats - before.Chats,
+                    Pokes = after.Pokes - before.Pokes,
+                    LlmRequests = after.LlmRequests - before.LlmRequests,
+                    LlmBusy = after.LlmBusy - before.LlmBusy,
+                    Memories = after.Memories
+                };
+                reports.Add(report);
+                onHour?.Invoke(report);
+                hourStart = hourEnd;
+            }
+            _behavior.Stop();
+            _ollamaClient.Models.StopBackgroundRefresh();
+
+            // Replies still being generated at the end are left unsaid, as when the app exits
+            _conversations.RemoveAll(t => t.IsCompleted);
+            return reports;
+        }
+
+        /// <summary>
+        /// Conversations still waiting on the model when the run ended
+        /// </summary>
+        public int Unfinished => _conversations.Count;
+
+        private HourReport Snapshot(DateTime start)
+        {
+            return new HourReport
+            {
+                Start = start,
+                IdleLines = _behavior.IdleLines,
+                RandomDialogs = _behavior.RandomDialogs,
+                ClickedLines = _behavior.ClickedLines,
+                MovedLines = _behavior.MovedLines,
+                Chats = _chats,
+                Pokes = _pokes,
+                LlmRequests = _llm.ChatRequests,
+                LlmBusy = _llm.BusyTime,
+                Memories = _memoryManager.GetAllMemories().Count
+            };
+        }
+
+        private void Dispatch(UsageEvent e)
+        {
+            switch (e.Kind)
+            {
+                case UsageKind.Click:
+                    _behavior.OnClicked();
+                    break;
+                case UsageKind.Move:
+                    if (_clock.Now - _lastMove >= MoveEventCooldown)
+                    {
+                        _lastMove = _clock.Now;
+                        _behavior.OnMoved();
+                    }
+                    break;
+                case UsageKind.Chat:
+                    _transcript?.WriteLine($"[User] {e.Text}");
+                    _conversations.Add(ChatAsync(e.Text));
+                    break;
+                case UsageKind.Poke:
+                    _conversations.Add(PokeAsync());
+                    break;
+            }
+        }
+
+        private async Task ChatAsync(string message)
+        {
+            if (!_settings.EnableOllamaChat)
+                return;
+
+            string response = await _ollamaClient.ChatAsync(message, CancellationToken.None);
+            Interlocked.Increment(ref _chats);
+            SpeakWithAnimations(response, null);
+        }
+
+        private async Task PokeAsync()
+        {
+            var prompt = AppSettings.GetRandomLine(_settings.RandomDialogPrompts);
+            if (!_settings.EnableOllamaChat || string.IsNullOrEmpty(prompt))
+                return;
+
+            string response = await _ollamaClient.GenerateRandomDialogAsync(prompt, CancellationToken.None);
+            Interlocked.Increment(ref _pokes);
+            SpeakWithAnimations(response, null);
+        }
+
+        /// <summary>
+        /// Plays the first &amp;&amp;Animation trigger, or the default, and speaks the rest, as MainForm does
+        /// </summary>
+        private void SpeakWithAnimations(string text, string defaultAnimation)
+        {
+            if (!_agent.IsLoaded || string.IsNullOrEmpty(text))
+                return;
+
+            var (cleanText, animations) = AppSettings.ExtractAnimationTriggers(text);
+            cleanText = _settings.ProcessText(cleanText);
+
+            string animation = animations.Count > 0 ? animations[0] : defaultAnimation;
+            if (!string.IsNullOrEmpty(animation))
+                _agent.PlayAnimation(animation);
+
+            if (_settings.TruncateSpeech)
+                _agent.SpeakSentences(AppSettings.SplitIntoSentences(cleanText));
+            else
+                _agent.Speak(cleanText);
+        }
+
+        /// <summary>
+        /// The given settings file, or the defaults with chat and memories turned on
+        /// </summary>
+        private static AppSettings LoadSettings(string path)
+        {
+            if (path != null)
+            {
+                if (!File.Exists(path))
+                    throw new FileNotFoundException($"Settings file not found: {path}", path);
+                return AppSettings.Load(path);
+            }
+
+            var settings = new AppSettings();
+            settings.EnableOllamaChat = true;
+            settings.EnableMemories = true;
+            settings.UserName = "Sam";
+            return settings;
+        }
+
+        public void Dispose()
+        {
+            _behavior.Dispose();
+            _agent.Dispose();
+            _ollamaClient.Dispose();
+            _transcript?.Dispose();
+            try
+            {
+                File.Delete(_memoriesPath);
+            }
+            catch (IOException)
+            {
+            }
+        }
+
+        /// <summary>
+        /// Puts the simulated time in front of each line
+        /// </summary>
+        private sealed class TranscriptWriter : TextWriter
+        {
+            private readonly TextWriter _inner;
+            private readonly IClock _clock;
+
+            public TranscriptWriter(TextWriter inner, IClock clock)
+            {
+                _inner = inner;
+                _clock = clock;
+            }
+
+            public override Encoding Encoding => _inner.Encoding;
+
+            public override void Write(char value)
+            {
+                _inner.Write(value);
+            }
+
+            public override void WriteLine(string value)
+            {
+                _inner.WriteLine($"{_clock.Now:HH:mm:ss.fff} {value}");
+            }
+
+            protected override void Dispose(bool disposing)
+            {
+                if (disposing)
+                    _inner.Dispose();
+                base.Dispose(disposing);
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+using System;
+using System.Globalization;
+
+namespace MSAgentAI.Tools.DaySimulator
+{
+    /// <summary>
+    /// Command line options for the simulator
+    /// </summary>
+    public class SimulatorOptions
+    {
+        public double Hours { get; set; } = 24;
+
+        // Local time the simulated day starts at
+        public DateTime Start { get; set; } = DateTime.Today;
+
+        // Seeds the generated usage and the 1-in-N chances
+        public int Seed { get; set; } = 1;
+
+        // Settings file to run with; null runs the defaults with chat and memories on
+        public string SettingsPath { get; set; }
+
+        // Usage script to replay; null generates a day of usage from the seed
+        public string UsagePath { get; set; }
+
+        // Where to write what the character says and plays, with the simulated time
+        public string TranscriptPath { get; set; }
+
+        // Stub model timing, in simulated time
+        public double TokensPerSecond { get; set; } = 30;
+        public double PromptEvalRate { get; set; } = 500;
+
+        public const string Usage =
+@"Usage: DaySimulator [options]
+
+  --hours <n>              Simulated hours (default 24)
+  --start <yyyy-MM-dd[THH:mm]>  Local time to start at (default today 00:00)
+  --seed <n>               Seeds the generated usage and random chances (default 1)
+  --settings <file>        settings.json to run with (default: defaults, chat and memories on)
+  --usage <file>           Usage script to replay instead of a generated day
+  --transcript <file>      Write what the character says and plays, with simulated times
+  --tokens-per-sec <n>     Stub model generation rate (default 30)
+  --prompt-eval-rate <n>   Stub model prompt tokens per second (default 500)";
+
+        /// <summary>
+        /// Parses command line arguments, throwing ArgumentException on bad input
+        /// </summary>
+        public static SimulatorOptions Parse(string[] args)
+        {
+            var options = new SimulatorOptions();
+
+            for (int i = 0; i < args.Length; i++)
+            {
+                string arg = args[i];
+                string Next()
+                {
+                    if (i + 1 >= args.Length)
+                        throw new ArgumentException($"{arg} requires a value");
+                    return args[++i];
+                }
+
+                switch (arg)
+                {
+                    case "--hours":
+                        options.Hours = ParseDouble(arg, Next(), 0.01);
+                        break;
+                    case "--start":
+                        options.Start = ParseStart(Next());
+                        break;
+                    case "--seed":
+                        options.Seed = ParseInt(arg, Next(), int.MinValue, int.MaxValue);
+                        break;
+                    case "--settings":
+                        options.SettingsPath = Next();
+                        break;
+                    case "--usage":
+                        options.UsagePath = Next();
+                        break;
+                    case "--transcript":
+                        options.TranscriptPath = Next();
+                        break;
+                    case "--tokens-per-sec":
+                        options.TokensPerSecond = ParseDouble(arg, Next(), 0.1);
+                        break;
+                    case "--prompt-eval-rate":
+                        options.PromptEvalRate = ParseDouble(arg, Next(), 0.1);
+                        break;
+                    default:
+                        throw new ArgumentException($"Unknown option '{arg}'");
+                }
+            }
+
+            return options;
+        }
+
+        private static DateTime ParseStart(string value)
+        {
+            if (!DateTime.TryParseExact(value, new[] { "yyyy-MM-dd", "yyyy-MM-dd'T'HH:mm" }, CultureInfo.InvariantCulture, DateTimeStyles.AssumeLocal, out DateTime start))
+                throw new ArgumentException("--start must be yyyy-MM-dd or yyyy-MM-ddTHH:mm");
+            return start;
+        }
+
+        private static int ParseInt(string name, string value, int min, int max)
+        {
+            if (!int.TryParse(value, NumberStyles.Integer, CultureInfo.InvariantCulture, out int result) || result < min || result > max)
+                throw new ArgumentException($"{name} must be between {min} and {max}");
+            return result;
+        }
+
+        private static double ParseDouble(string name, string value, double min)
+        {
+            if (!double.TryParse(value, NumberStyles.Float, CultureInfo.InvariantCulture, out double result) || result < min)
+                throw new ArgumentException($"{name} must be at least {min}");
+            return result;
+        }
+    }
+}
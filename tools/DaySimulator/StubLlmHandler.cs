@@ -0,0 +1,141 @@
+using System;
+using System.Globalization;
+using System.Net;
+using System.Net.Http;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Timing;
+
+namespace MSAgentAI.Tools.DaySimulator
+{
+    /// <summary>
+    /// Answers OllamaClient in-process, taking as long as a small local model would on the
+    /// simulated clock: prompt evaluation by its size, then the reply a token at a time.
+    /// Replies come round in order, so a run with the same seed says the same things. Like
+    /// Ollama, it unloads the model once it has gone KeepAlive without a chat, and /api/ps
+    /// stops listing it.
+    /// </summary>
+    public sealed class StubLlmHandler : HttpMessageHandler
+    {
+        private const string TagsResponse = "{\"models\":[{\"name\":\"{0}\",\"size\":1000000,\"details\":{\"parameter_size\":\"1B\",\"quantization_level\":\"Q4_0\"}}]}";
+        private const string ShowResponse = "{\"model_info\":{\"general.architecture\":\"llama\",\"llama.context_length\":8192}}";
+        private const string PsResponse = "{\"models\":[{\"name\":\"{0}\"}]}";
+        private const string PsEmptyResponse = "{\"models\":[]}";
+
+        // No quotes or backslashes, so they go into the JSON as they are
+        private static readonly string[] Replies =
+        {
+            "&&Wave Hello there, /emp/lovely to see you!",
+            "That sounds like a great plan.",
+            "&&Think Hmm, let me think about that for a moment.",
+            "I could watch the cursor move all day.",
+            "&&Pleased Oh, I /emp/really like that idea.",
+            "Did you know octopuses have three hearts?",
+            "&&Surprised Really? Tell me more!",
+            "I will keep that in mind for you."
+        };
+
+        private readonly IClock _clock;
+        private readonly string _model;
+        private long _requests;
+        private long _chatRequests;
+        private long _busyTicks;
+        private long _loadedUntilTicks;
+        private long _loadStatePolls;
+        private long _coldPolls;
+
+        public StubLlmHandler(IClock clock, string model)
+        {
+            _clock = clock;
+            _model = model;
+        }
+
+        /// <summary>
+        /// Reply tokens generated per simulated second
+        /// </summary>
+        public double TokensPerSecond { get; set; } = 30;
+
+        /// <summary>
+        /// Prompt tokens evaluated per simulated second
+        /// </summary>
+        public double PromptEvalRate { get; set; } = 500;
+
+        /// <summary>
+        /// How long the model stays loaded after a chat, as Ollama's keep_alive
+        /// </summary>
+        public TimeSpan KeepAlive { get; set; } = TimeSpan.FromMinutes(5);
+
+        public long Requests => Interlocked.Read(ref _requests);
+        public long ChatRequests => Interlocked.Read(ref _chatRequests);
+
+        /// <summary>
+        /// Simulated time spent answering chats
+        /// </summary>
+        public TimeSpan BusyTime => TimeSpan.FromTicks(Interlocked.Read(ref _busyTicks));
+
+        /// <summary>
+        /// /api/ps requests, and those answered with the model unloaded
+        /// </summary>
+        public long LoadStatePolls => Interlocked.Read(ref _loadStatePolls);
+        public long ColdPolls => Interlocked.Read(ref _coldPolls);
+
+        protected override async Task<HttpResponseMessage> SendAsync(HttpRequestMessage request, CancellationToken cancellationToken)
+        {
+            Interlocked.Increment(ref _requests);
+            switch (request.RequestUri.AbsolutePath)
+            {
+                case "/api/chat":
+                    return await ChatAsync(request, cancellationToken);
+                case "/api/tags":
+                    return Json(TagsResponse.Replace("{0}", _model));
+                case "/api/show":
+                    return Json(ShowResponse);
+                case "/api/ps":
+                    Interlocked.Increment(ref _loadStatePolls);
+                    if (_clock.UtcNow.Ticks >= Interlocked.Read(ref _loadedUntilTicks))
+                    {
+                        Interlocked.Increment(ref _coldPolls);
+                        return Json(PsEmptyResponse);
+                    }
+                    return Json(PsResponse.Replace("{0}", _model));
+                default:
+                    return new HttpResponseMessage(HttpStatusCode.NotFound);
+            }
+        }
+
+        private async Task<HttpResponseMessage> ChatAsync(HttpRequestMessage request, CancellationToken cancellationToken)
+        {
+            long number = Interlocked.Increment(ref _chatRequests);
+            string body = request.Content != null ? await request.Content.ReadAsStringAsync() : "";
+            string reply = Replies[(number - 1) % Replies.Length];
+
+            // About four characters a token, as ContextBudget estimates
+            int promptTokens = Math.Max(1, body.Length / 4);
+            int replyTokens = Math.Max(1, reply.Length / 4);
+            var promptTime = TimeSpan.FromSeconds(promptTokens / PromptEvalRate);
+            var replyTime = TimeSpan.FromSeconds(replyTokens / TokensPerSecond);
+
+            await _clock.Delay(promptTime + replyTime, cancellationToken);
+            Interlocked.Add(ref _busyTicks, (promptTime + replyTime).Ticks);
+            Interlocked.Exchange(ref _loadedUntilTicks, (_clock.UtcNow + KeepAlive).Ticks);
+
+            var json = new StringBuilder();
+            json.Append("{\"model\":\"").Append(_model).Append("\",\"message\":{\"role\":\"assistant\",\"content\":\"").Append(reply).Append("\"},");
+            json.Append("\"done\":true,\"done_reason\":\"stop\",");
+            json.Append("\"prompt_eval_count\":").Append(promptTokens.ToString(CultureInfo.InvariantCulture)).Append(',');
+            json.Append("\"prompt_eval_duration\":").Append((promptTime.Ticks * 100).ToString(CultureInfo.InvariantCulture)).Append(',');
+            json.Append("\"eval_count\":").Append(replyTokens.ToString(CultureInfo.InvariantCulture)).Append(',');
+            json.Append("\"eval_duration\":").Append((replyTime.Ticks * 100).ToString(CultureInfo.InvariantCulture)).Append('}');
+            return Json(json.ToString());
+        }
+
+        private static HttpResponseMessage Json(string json)
+        {
+            return new HttpResponseMessage(HttpStatusCode.OK)
+            {
+                Content = new StringContent(json, Encoding.UTF8, "application/json")
+            };
+        }
+    }
+}
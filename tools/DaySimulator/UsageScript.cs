@@ -0,0 +1,152 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+
+namespace MSAgentAI.Tools.DaySimulator
+{
+    public enum UsageKind
+    {
+        Click,
+        Move,
+        Chat,
+        Poke
+    }
+
+    /// <summary>
+    /// Something the user does, at a time from the start of the simulation
+    /// </summary>
+    public sealed class UsageEvent
+    {
+        public UsageEvent(TimeSpan at, UsageKind kind, string text)
+        {
+            At = at;
+            Kind = kind;
+            Text = text;
+        }
+
+        public TimeSpan At { get; }
+        public UsageKind Kind { get; }
+        public string Text { get; }
+    }
+
+    /// <summary>
+    /// Reads usage scripts and makes up a plausible day when there isn't one.
+    /// A script has one event per line: <c>[d.]hh:mm[:ss] KIND [text]</c>, KIND being CLICK,
+    /// MOVE, CHAT (with the message) or POKE. Blank lines and lines starting with # are skipped.
+    /// </summary>
+    public static class UsageScript
+    {
+        private static readonly string[] TimeFormats = { @"hh\:mm", @"hh\:mm\:ss", @"d\.hh\:mm", @"d\.hh\:mm\:ss" };
+
+        // How busy the user is by hour of day, 0 being asleep or away
+        private static readonly double[] Activity =
+        {
+            0, 0, 0, 0, 0, 0, 0, 0.2,
+            0.5, 0.8, 1, 1, 0.6, 0.8, 1, 1,
+            0.9, 0.7, 0.4, 0.6, 0.8, 0.6, 0.3, 0.1
+        };
+
+        // Some of these trip the memory heuristics in OllamaClient, so memories build up and age
+        private static readonly string[] ChatMessages =
+        {
+            "Good morning! What should I work on first?",
+            "I like playing chess in the evening.",
+            "Remember that my sister's birthday is on Friday.",
+            "Can you tell me a joke?",
+            "My favorite food is ramen.",
+            "What's the weather like where you are?",
+            "I'm learning to play the guitar.",
+            "Did I tell you about my trip to Lisbon?",
+            "I never drink coffee after six.",
+            "How are you today?",
+            "Keep in mind that I have a dentist appointment on Tuesday.",
+            "What do you think about space travel?",
+            "I hate waiting for builds to finish.",
+            "Tell me something interesting.",
+            "Goodnight, see you tomorrow."
+        };
+
+        /// <summary>
+        /// Reads a usage script, in time order
+        /// </summary>
+        public static List<UsageEvent> Load(string path)
+        {
+            var events = new List<UsageEvent>();
+            int lineNumber = 0;
+            foreach (string rawLine in File.ReadLines(path))
+            {
+                lineNumber++;
+                string line = rawLine.Trim();
+                if (line.Length == 0 || line.StartsWith("#", StringComparison.Ordinal))
+                    continue;
+
+                string[] parts = line.Split(new[] { ' ', '\t' }, 3, StringSplitOptions.RemoveEmptyEntries);
+                if (parts.Length < 2 || !TimeSpan.TryParseExact(parts[0], TimeFormats, CultureInfo.InvariantCulture, out TimeSpan at))
+                    throw new FormatException($"{path}:{lineNumber}: expected '[d.]hh:mm[:ss] KIND [text]'");
+
+                if (!Enum.TryParse(parts[1], true, out UsageKind kind) || !Enum.IsDefined(typeof(UsageKind), kind))
+                    throw new FormatException($"{path}:{lineNumber}: unknown event '{parts[1]}'");
+
+                string text = parts.Length > 2 ? parts[2] : null;
+                if (kind == UsageKind.Chat && string.IsNullOrEmpty(text))
+                    throw new FormatException($"{path}:{lineNumber}: CHAT needs a message");
+
+                events.Add(new UsageEvent(at, kind, text));
+            }
+
+            return SortByTime(events);
+        }
+
+        /// <summary>
+        /// Makes up usage for the given span: a few clicks, drags, chats and pokes a minute at
+        /// busy hours, nothing at night
+        /// </summary>
+        public static List<UsageEvent> Generate(Random random, DateTime start, TimeSpan duration)
+        {
+            var events = new List<UsageEvent>();
+            int minutes = (int)Math.Ceiling(duration.TotalMinutes);
+            for (int minute = 0; minute < minutes; minute++)
+            {
+                double activity = Activity[start.AddMinutes(minute).Hour];
+                if (activity <= 0)
+                    continue;
+
+                AddMaybe(events, random, minute, 0.02 * activity, UsageKind.Click, null);
+                AddMaybe(events, random, minute, 0.01 * activity, UsageKind.Move, null);
+                AddMaybe(events, random, minute, 0.015 * activity, UsageKind.Chat, ChatMessages[random.Next(ChatMessages.Length)]);
+                AddMaybe(events, random, minute, 0.004 * activity, UsageKind.Poke, null);
+            }
+
+            events.RemoveAll(e => e.At >= duration);
+            return SortByTime(events);
+        }
+
+        private static void AddMaybe(List<UsageEvent> events, Random random, int minute, double chance, UsageKind kind, string text)
+        {
+            if (random.NextDouble() < chance)
+            {
+                var at = TimeSpan.FromMinutes(minute) + TimeSpan.FromSeconds(random.Next(60));
+                events.Add(new UsageEvent(at, kind, text));
+            }
+        }
+
+        /// <summary>
+        /// Stable, so events at the same time keep their order
+        /// </summary>
+        private static List<UsageEvent> SortByTime(List<UsageEvent> events)
+        {
+            var indexed = new List<KeyValuePair<int, UsageEvent>>(events.Count);
+            for (int i = 0; i < events.Count; i++)
+            {
+                indexed.Add(new KeyValuePair<int, UsageEvent>(i, events[i]));
+            }
+            indexed.Sort((x, y) =>
+            {
+                int byTime = x.Value.At.CompareTo(y.Value.At);
+                return byTime != 0 ? byTime : x.Key.CompareTo(y.Key);
+            });
+            return indexed.ConvertAll(pair => pair.Value);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Tools.OllamaStub
+{
+    /// <summary>
+    /// Stand-in Ollama server so pipeline and chat benchmarks run without a GPU
+    /// and give the same numbers from run to run.
+    /// </summary>
+    public static class Program
+    {
+        public static async Task<int> Main(string[] args)
+        {
+            StubOptions options;
+            try
+            {
+                options = StubOptions.Parse(args);
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                Console.Error.WriteLine();
+                Console.Error.WriteLine(StubOptions.Usage);
+                return 2;
+            }
+
+            using (var cts = new CancellationTokenSource())
+            using (var server = new StubServer(options))
+            using (PosixSignalRegistration.Create(PosixSignal.SIGTERM, ctx =>
+            {
+                // Stop cleanly so a recording's gzip trailer is written
+                ctx.Cancel = true;
+                cts.Cancel();
+            }))
+            {
+                Console.CancelKeyPress += (s, e) =>
+                {
+                    e.Cancel = true;
+                    cts.Cancel();
+                };
+
+                server.Start();
+
+                string mode = options.Mode.ToString().ToLowerInvariant();
+                switch (options.Mode)
+                {
+                    case StubMode.Replay:
+                        Console.WriteLine($"Replaying {server.SessionCount} recorded exchanges from {options.SessionPath} at {options.Speed}x");
+                        break;
+                    case StubMode.Record:
+                        Console.WriteLine($"Recording {options.UpstreamUrl} to {options.SessionPath}");
+                        break;
+                    default:
+                        Console.WriteLine($"Synthesizing '{options.Model}' at {options.TokensPerSecond} tokens/s");
+                        break;
+                }
+                Console.WriteLine($"Listening on {options.Prefix} ({mode}, {options.Parallel} parallel). Press Ctrl+C to stop.");
+
+                await server.RunAsync(cts.Token);
+
+                Console.WriteLine($"Served {server.RequestCount} requests");
+                if (options.Mode == StubMode.Record)
+                {
+                    Console.WriteLine($"Recorded {server.SessionCount} exchanges");
+                }
+            }
+
+            return 0;
+        }
+    }
+}
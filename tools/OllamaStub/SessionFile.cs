@@ -0,0 +1,241 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.Security.Cryptography;
+using System.Text;
+using Newtonsoft.Json;
+using Newtonsoft.Json.Linq;
+
+namespace MSAgentAI.Tools.OllamaStub
+{
+    /// <summary>
+    /// One recorded request/response exchange.
+    /// Sessions are stored one entry per line (optionally gzipped), with streamed
+    /// tokens kept as parallel delay/text arrays so a long chat stays compact.
+    /// </summary>
+    public class SessionEntry
+    {
+        [JsonProperty("path")]
+        public string Path { get; set; }
+
+        /// <summary>
+        /// Request fingerprint used to match replays (see SessionKeys)
+        /// </summary>
+        [JsonProperty("key")]
+        public string Key { get; set; }
+
+        [JsonProperty("model", NullValueHandling = NullValueHandling.Ignore)]
+        public string Model { get; set; }
+
+        [JsonProperty("status")]
+        public int Status { get; set; } = 200;
+
+        /// <summary>
+        /// Milliseconds from request to first token (or to the whole body for non-streamed endpoints)
+        /// </summary>
+        [JsonProperty("first_ms")]
+        public int FirstMs { get; set; }
+
+        /// <summary>
+        /// Milliseconds between consecutive streamed tokens (first entry is always 0)
+        /// </summary>
+        [JsonProperty("delays", NullValueHandling = NullValueHandling.Ignore)]
+        public List<int> Delays { get; set; }
+
+        [JsonProperty("tokens", NullValueHandling = NullValueHandling.Ignore)]
+        public List<string> Tokens { get; set; }
+
+        /// <summary>
+        /// Final chat statistics (done_reason, durations, token counts)
+        /// </summary>
+        [JsonProperty("done", NullValueHandling = NullValueHandling.Ignore)]
+        public JObject Done { get; set; }
+
+        /// <summary>
+        /// Response body for non-chat endpoints
+        /// </summary>
+        [JsonProperty("body", NullValueHandling = NullValueHandling.Ignore)]
+        public JToken Body { get; set; }
+    }
+
+    /// <summary>
+    /// Appends session entries to a file as they complete
+    /// </summary>
+    public class SessionWriter : IDisposable
+    {
+        private readonly object _lock = new object();
+        private readonly StreamWriter _writer;
+
+        public SessionWriter(string path)
+        {
+            Stream stream = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.Read);
+            if (path.EndsWith(".gz", StringComparison.OrdinalIgnoreCase))
+            {
+                stream = new GZipStream(stream, CompressionLevel.Optimal);
+            }
+            _writer = new StreamWriter(stream, new UTF8Encoding(false));
+        }
+
+        public int Count { get; private set; }
+
+        public void Append(SessionEntry entry)
+        {
+            var line = JsonConvert.SerializeObject(entry, Formatting.None);
+            lock (_lock)
+            {
+                _writer.WriteLine(line);
+                _writer.Flush();
+                Count++;
+            }
+        }
+
+        public void Dispose()
+        {
+            lock (_lock)
+            {
+                _writer.Dispose();
+            }
+        }
+    }
+
+    /// <summary>
+    /// Serves recorded entries back in request order, matched by request fingerprint
+    /// </summary>
+    public class SessionLibrary
+    {
+        private readonly Dictionary<string, List<SessionEntry>> _byKey = new Dictionary<string, List<SessionEntry>>();
+        private readonly Dictionary<string, List<SessionEntry>> _byPath = new Dictionary<string, List<SessionEntry>>();
+        private readonly Dictionary<string, int> _cursors = new Dictionary<string, int>();
+        private readonly object _lock = new object();
+
+        public int Count { get; private set; }
+
+        public static SessionLibrary Load(string path)
+        {
+            var library = new SessionLibrary();
+
+            Stream stream = File.OpenRead(path);
+            if (path.EndsWith(".gz", StringComparison.OrdinalIgnoreCase))
+            {
+                stream = new GZipStream(stream, CompressionMode.Decompress);
+            }
+
+            using (var reader = new StreamReader(stream, Encoding.UTF8))
+            {
+                string line;
+                while ((line = reader.ReadLine()) != null)
+                {
+                    if (string.IsNullOrWhiteSpace(line))
+                        continue;
+
+                    var entry = JsonConvert.DeserializeObject<SessionEntry>(line);
+                    if (entry?.Path != null)
+                    {
+                        library.Add(entry);
+                    }
+                }
+            }
+
+            return library;
+        }
+
+        private void Add(SessionEntry entry)
+        {
+            GetList(_byPath, entry.Path).Add(entry);
+            if (!string.IsNullOrEmpty(entry.Key))
+            {
+                GetList(_byKey, entry.Path + "|" + entry.Key).Add(entry);
+            }
+            Count++;
+        }
+
+        /// <summary>
+        /// Gets the next recording for a request. Exact fingerprint matches are served
+        /// first; otherwise recordings for the same endpoint are cycled in order.
+        /// Returns null if nothing was recorded for the endpoint.
+        /// </summary>
+        public SessionEntry Next(string path, string key)
+        {
+            lock (_lock)
+            {
+                if (!string.IsNullOrEmpty(key) && _byKey.TryGetValue(path + "|" + key, out var matches))
+                {
+                    return Cycle("key:" + path + "|" + key, matches);
+                }
+
+                if (_byPath.TryGetValue(path, out var entries))
+                {
+                    return Cycle("path:" + path, entries);
+                }
+
+                return null;
+            }
+        }
+
+        private SessionEntry Cycle(string cursorName, List<SessionEntry> entries)
+        {
+            _cursors.TryGetValue(cursorName, out int cursor);
+            _cursors[cursorName] = cursor + 1;
+            return entries[cursor % entries.Count];
+        }
+
+        private static List<SessionEntry> GetList(Dictionary<string, List<SessionEntry>> map, string key)
+        {
+            if (!map.TryGetValue(key, out var list))
+            {
+                list = new List<SessionEntry>();
+                map[key] = list;
+            }
+            return list;
+        }
+    }
+
+    /// <summary>
+    /// Request fingerprints shared by record and replay
+    /// </summary>
+    public static class SessionKeys
+    {
+        /// <summary>
+        /// Fingerprints a request by model and the part of the body that determines the answer:
+        /// the last user message for chat, the input for embeddings
+        /// </summary>
+        public static string For(string path, JObject request)
+        {
+            if (request == null)
+                return null;
+
+            string model = (string)request["model"] ?? "";
+            string subject = null;
+
+            if (path == "/api/chat" && request["messages"] is JArray messages)
+            {
+                for (int i = messages.Count - 1; i >= 0; i--)
+                {
+                    if ((string)messages[i]["role"] == "user")
+                    {
+                        subject = (string)messages[i]["content"];
+                        break;
+                    }
+                }
+            }
+            else if (request["input"] != null)
+            {
+                subject = request["input"].ToString(Formatting.None);
+            }
+            else if (request["prompt"] != null)
+            {
+                subject = (string)request["prompt"];
+            }
+
+            if (subject == null)
+                subject = request.ToString(Formatting.None);
+
+            using (var sha = SHA256.Create())
+            {
+                var hash = sha.ComputeHash(Encoding.UTF8.GetBytes(model + "\n" + subject));
+                return BitConverter.ToString(hash, 0, 8).Replace("-", "").ToLowerInvariant();
+            }
+        }
+    }
+}
@@ -0,0 +1,171 @@
+using System;
+using System.Globalization;
+
+namespace MSAgentAI.Tools.OllamaStub
+{
+    /// <summary>
+    /// How the stub produces responses
+    /// </summary>
+    public enum StubMode
+    {
+        Synth,
+        Replay,
+        Record
+    }
+
+    /// <summary>
+    /// Command line options for the stub server
+    /// </summary>
+    public class StubOptions
+    {
+        public StubMode Mode { get; set; } = StubMode.Synth;
+        public string Host { get; set; } = "127.0.0.1";
+        public int Port { get; set; } = 11435;
+
+        // Session file to replay from or record to
+        public string SessionPath { get; set; }
+
+        // Real Ollama server used in record mode
+        public string UpstreamUrl { get; set; } = "http://localhost:11434";
+
+        // Model name reported by /api/tags and /api/ps in synth mode
+        public string Model { get; set; } = "stub:latest";
+        public int ContextLength { get; set; } = 8192;
+
+        // Synthetic timing
+        public double TokensPerSecond { get; set; } = 30;
+        public double PromptEvalRate { get; set; } = 500;
+        public int LoadMs { get; set; }
+        public int ResponseTokens { get; set; } = 40;
+        public int EmbedDimensions { get; set; } = 384;
+
+        // Replay timing multiplier (2 = twice as fast, 0 = no delays)
+        public double Speed { get; set; } = 1.0;
+
+        // Requests served at once; Ollama defaults to one per model
+        public int Parallel { get; set; } = 1;
+
+        public string Prefix => $"http://{Host}:{Port}/";
+
+        public const string Usage =
+@"Usage: OllamaStub [--mode synth|replay|record] [options]
+
+  --host <addr>            Listen address (default 127.0.0.1)
+  --port <n>               Listen port (default 11435)
+  --parallel <n>           Requests served concurrently (default 1)
+
+Synth mode:
+  --model <name>           Model name to report (default stub:latest)
+  --context <n>            Context length reported by /api/show (default 8192)
+  --tokens-per-sec <n>     Generation rate (default 30)
+  --prompt-eval-rate <n>   Prompt tokens evaluated per second (default 500)
+  --load-ms <n>            Simulated model load on first request (default 0)
+  --response-tokens <n>    Tokens per response before num_predict (default 40)
+  --embed-dim <n>          Embedding dimensions (default 384)
+
+Replay mode:
+  --session <file>         Recorded session (.ndjson or .ndjson.gz)
+  --speed <x>              Timing multiplier, 0 = no delays (default 1)
+
+Record mode:
+  --session <file>         Output session file
+  --upstream <url>         Real Ollama server (default http://localhost:11434)";
+
+        /// <summary>
+        /// Parses command line arguments, throwing ArgumentException on bad input
+        /// </summary>
+        public static StubOptions Parse(string[] args)
+        {
+            var options = new StubOptions();
+
+            for (int i = 0; i < args.Length; i++)
+            {
+                string arg = args[i];
+                string Next()
+                {
+                    if (i + 1 >= args.Length)
+                        throw new ArgumentException($"{arg} requires a value");
+                    return args[++i];
+                }
+
+                switch (arg)
+                {
+                    case "--mode":
+                        options.Mode = ParseMode(Next());
+                        break;
+                    case "--host":
+                        options.Host = Next();
+                        break;
+                    case "--port":
+                        options.Port = ParseInt(arg, Next(), 1, 65535);
+                        break;
+                    case "--parallel":
+                        options.Parallel = ParseInt(arg, Next(), 1, 64);
+                        break;
+                    case "--session":
+                        options.SessionPath = Next();
+                        break;
+                    case "--upstream":
+                        options.UpstreamUrl = Next().TrimEnd('/');
+                        break;
+                    case "--model":
+                        options.Model = Next();
+                        break;
+                    case "--context":
+                        options.ContextLength = ParseInt(arg, Next(), 256, 1 << 20);
+                        break;
+                    case "--tokens-per-sec":
+                        options.TokensPerSecond = ParseDouble(arg, Next(), 0.1);
+                        break;
+                    case "--prompt-eval-rate":
+                        options.PromptEvalRate = ParseDouble(arg, Next(), 0.1);
+                        break;
+                    case "--load-ms":
+                        options.LoadMs = ParseInt(arg, Next(), 0, 600000);
+                        break;
+                    case "--response-tokens":
+                        options.ResponseTokens = ParseInt(arg, Next(), 1, 100000);
+                        break;
+                    case "--embed-dim":
+                        options.EmbedDimensions = ParseInt(arg, Next(), 1, 16384);
+                        break;
+                    case "--speed":
+                        options.Speed = ParseDouble(arg, Next(), 0);
+                        break;
+                    default:
+                        throw new ArgumentException($"Unknown option '{arg}'");
+                }
+            }
+
+            if (options.Mode != StubMode.Synth && string.IsNullOrEmpty(options.SessionPath))
+                throw new ArgumentException($"--session is required in {options.Mode.ToString().ToLowerInvariant()} mode");
+
+            return options;
+        }
+
+        private static StubMode ParseMode(string value)
+        {
+            switch (value.ToLowerInvariant())
+            {
+                case "synth": return StubMode.Synth;
+                case "replay": return StubMode.Replay;
+                case "record": return StubMode.Record;
+                default: throw new ArgumentException($"Unknown mode '{value}'");
+            }
+        }
+
+        private static int ParseInt(string name, string value, int min, int max)
+        {
+            if (!int.TryParse(value, NumberStyles.Integer, CultureInfo.InvariantCulture, out int result) || result < min || result > max)
+                throw new ArgumentException($"{name} must be between {min} and {max}");
+            return result;
+        }
+
+        private static double ParseDouble(string name, string value, double min)
+        {
+            if (!double.TryParse(value, NumberStyles.Float, CultureInfo.InvariantCulture, out double result) || result < min)
+                throw new ArgumentException($"{name} must be at least {min}");
+            return result;
+        }
+    }
+}
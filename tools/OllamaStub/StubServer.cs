@@ -0,0 +1,704 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Net;
+using System.Net.Http;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.AspNetCore.Builder;
+using Microsoft.AspNetCore.Hosting;
+using Microsoft.AspNetCore.Http;
+using Microsoft.Extensions.Logging;
+using Newtonsoft.Json;
+using Newtonsoft.Json.Linq;
+
+namespace MSAgentAI.Tools.OllamaStub
+{
+    /// <summary>
+    /// Minimal Ollama-compatible HTTP server for deterministic benchmarks.
+    /// Speaks /api/chat (streamed NDJSON and non-streamed), /api/tags, /api/show,
+    /// /api/ps, /api/embed and /api/version, and either synthesizes responses at a
+    /// fixed token rate, replays a recorded session with its original timing, or
+    /// proxies to a real server while recording.
+    /// Hosted on Kestrel rather than HttpListener because Kestrel disables Nagle;
+    /// with it on, small NDJSON chunks get coalesced and token timing is lost.
+    /// </summary>
+    public class StubServer : IDisposable
+    {
+        private static readonly string[] Words =
+        {
+            "the", "agent", "waves", "at", "you", "and", "says", "hello", "again", "today",
+            "is", "a", "fine", "day", "for", "some", "retro", "desktop", "fun", "with",
+            "bananas", "dial-up", "modems", "and", "tiny", "purple", "friends", "who", "talk", "a", "lot"
+        };
+
+        private readonly StubOptions _options;
+        private readonly WebApplication _app;
+        private readonly SemaphoreSlim _slots;
+        private readonly HashSet<string> _loadedModels = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+        private readonly object _lock = new object();
+        private readonly SessionLibrary _library;
+        private readonly SessionWriter _recorder;
+        private readonly HttpClient _upstream;
+        private long _requests;
+
+        public StubServer(StubOptions options)
+        {
+            _options = options;
+            _slots = new SemaphoreSlim(options.Parallel, options.Parallel);
+            var builder = WebApplication.CreateSlimBuilder();
+            builder.Logging.ClearProviders();
+            builder.WebHost.UseKestrel(kestrel =>
+            {
+                if (options.Host == "localhost")
+                    kestrel.ListenLocalhost(options.Port);
+                else if (options.Host == "0.0.0.0" || options.Host == "*" || options.Host == "+")
+                    kestrel.ListenAnyIP(options.Port);
+                else
+                    kestrel.Listen(IPAddress.Parse(options.Host), options.Port);
+            });
+            _app = builder.Build();
+            _app.Run(HandleAsync);
+
+            switch (options.Mode)
+            {
+                case StubMode.Replay:
+                    _library = SessionLibrary.Load(options.SessionPath);
+                    break;
+                case StubMode.Record:
+                    _recorder = new SessionWriter(options.SessionPath);
+                    _upstream = new HttpClient { Timeout = Timeout.InfiniteTimeSpan };
+                    break;
+            }
+        }
+
+        /// <summary>
+        /// Number of entries loaded (replay) or written (record)
+        /// </summary>
+        public int SessionCount => _library?.Count ?? _recorder?.Count ?? 0;
+
+        public long RequestCount => Interlocked.Read(ref _requests);
+
+        public void Start()
+        {
+            _app.StartAsync().GetAwaiter().GetResult();
+        }
+
+        /// <summary>
+        /// Serves requests until cancelled
+        /// </summary>
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            try
+            {
+                await Task.Delay(Timeout.Infinite, cancellationToken);
+            }
+            catch (OperationCanceledException)
+            {
+            }
+
+            using (var timeout = new CancellationTokenSource(TimeSpan.FromSeconds(5)))
+            {
+                await _app.StopAsync(timeout.Token);
+            }
+        }
+
+        private async Task HandleAsync(HttpContext context)
+        {
+            Interlocked.Increment(ref _requests);
+            var cancellationToken = context.RequestAborted;
+            string path = (context.Request.Path.Value ?? "").TrimEnd('/');
+
+            try
+            {
+                string body;
+                using (var reader = new StreamReader(context.Request.Body, Encoding.UTF8))
+                {
+                    body = await reader.ReadToEndAsync();
+                }
+
+                if (_options.Mode == StubMode.Record)
+                {
+                    await RecordAsync(context, path, body, cancellationToken);
+                    return;
+                }
+
+                // Only generation and embedding occupy the model; metadata is always answered
+                bool usesModel = path == "/api/chat" || path == "/api/embed";
+                if (usesModel)
+                {
+                    await _slots.WaitAsync(cancellationToken);
+                }
+
+                try
+                {
+                    var request = ParseBody(body);
+                    if (_options.Mode == StubMode.Replay && await TryReplayAsync(context, path, request, cancellationToken))
+                        return;
+
+                    await SynthesizeAsync(context, path, request, cancellationToken);
+                }
+                finally
+                {
+                    if (usesModel)
+                    {
+                        _slots.Release();
+                    }
+                }
+            }
+            catch (OperationCanceledException)
+            {
+                // Client went away mid-stream
+                context.Abort();
+            }
+            catch (Exception ex)
+            {
+                Console.Error.WriteLine($"{path}: {ex.Message}");
+                if (context.Response.HasStarted)
+                {
+                    context.Abort();
+                }
+                else
+                {
+                    await WriteJsonAsync(context, 500, new JObject { ["error"] = ex.Message });
+                }
+            }
+        }
+
+        #region Synthesized responses
+
+        private async Task SynthesizeAsync(HttpContext context, string path, JObject request, CancellationToken cancellationToken)
+        {
+            switch (path)
+            {
+                case "/api/chat":
+                    await SynthesizeChatAsync(context, request, cancellationToken);
+                    break;
+                case "/api/embed":
+                    await SynthesizeEmbedAsync(context, request, cancellationToken);
+                    break;
+                case "/api/tags":
+                    await WriteJsonAsync(context, 200, new JObject { ["models"] = new JArray(DescribeModel(_options.Model)) });
+                    break;
+                case "/api/show":
+                    await WriteJsonAsync(context, 200, ShowModel((string)request?["model"] ?? (string)request?["name"] ?? _options.Model));
+                    break;
+                case "/api/ps":
+                    await WriteJsonAsync(context, 200, RunningModels());
+                    break;
+                case "/api/version":
+                    await WriteJsonAsync(context, 200, new JObject { ["version"] = "0.0.0-stub" });
+                    break;
+                default:
+                    await WriteJsonAsync(context, 404, new JObject { ["error"] = $"unsupported endpoint {path}" });
+                    break;
+            }
+        }
+
+        private async Task SynthesizeChatAsync(HttpContext context, JObject request, CancellationToken cancellationToken)
+        {
+            var clock = Stopwatch.StartNew();
+            string model = (string)request?["model"] ?? _options.Model;
+            bool stream = request?["stream"]?.Value<bool?>() ?? true;
+
+            // Prompt size from message text, roughly four characters per token plus template overhead
+            var messages = request?["messages"] as JArray ?? new JArray();
+            int promptChars = messages.Sum(m => ((string)m["content"] ?? "").Length);
+            int promptTokens = Math.Max(1, promptChars / 4) + messages.Count * 4;
+
+            int tokens = _options.ResponseTokens;
+            string doneReason = "stop";
+            int numPredict = request?["options"]?["num_predict"]?.Value<int?>() ?? -1;
+            if (numPredict > 0 && numPredict < tokens)
+            {
+                tokens = numPredict;
+                doneReason = "length";
+            }
+
+            double loadMs = MarkLoaded(model) ? _options.LoadMs : 0;
+            double promptMs = promptTokens * 1000.0 / _options.PromptEvalRate;
+            double tokenMs = 1000.0 / _options.TokensPerSecond;
+            var words = GenerateWords(SessionKeys.For("/api/chat", request), tokens);
+
+            var done = new JObject
+            {
+                ["done_reason"] = doneReason,
+                ["total_duration"] = ToNanoseconds(loadMs + promptMs + tokens * tokenMs),
+                ["load_duration"] = ToNanoseconds(loadMs),
+                ["prompt_eval_count"] = promptTokens,
+                ["prompt_eval_duration"] = ToNanoseconds(promptMs),
+                ["eval_count"] = tokens,
+                ["eval_duration"] = ToNanoseconds(tokens * tokenMs)
+            };
+
+            var delays = new List<double>(tokens);
+            for (int i = 0; i < tokens; i++)
+            {
+                delays.Add(i == 0 ? loadMs + promptMs + tokenMs : tokenMs);
+            }
+
+            await WriteChatAsync(context, model, stream, words, delays, 1.0, done, clock, cancellationToken);
+        }
+
+        private async Task SynthesizeEmbedAsync(HttpContext context, JObject request, CancellationToken cancellationToken)
+        {
+            var clock = Stopwatch.StartNew();
+            string model = (string)request?["model"] ?? _options.Model;
+
+            var inputs = new List<string>();
+            var input = request?["input"];
+            if (input is JArray array)
+                inputs.AddRange(array.Select(t => (string)t ?? ""));
+            else if (input != null)
+                inputs.Add((string)input ?? "");
+
+            int promptTokens = inputs.Sum(s => Math.Max(1, s.Length / 4));
+            double loadMs = MarkLoaded(model) ? _options.LoadMs : 0;
+            double evalMs = promptTokens * 1000.0 / _options.PromptEvalRate;
+
+            var embeddings = new JArray();
+            foreach (var text in inputs)
+            {
+                embeddings.Add(new JArray(GenerateEmbedding(model, text)));
+            }
+
+            await DelayUntilAsync(clock, loadMs + evalMs, 1.0, cancellationToken);
+
+            await WriteJsonAsync(context, 200, new JObject
+            {
+                ["model"] = model,
+                ["embeddings"] = embeddings,
+                ["total_duration"] = ToNanoseconds(loadMs + evalMs),
+                ["load_duration"] = ToNanoseconds(loadMs),
+                ["prompt_eval_count"] = promptTokens
+            });
+        }
+
+        private JObject DescribeModel(string model)
+        {
+            return new JObject
+            {
+                ["name"] = model,
+                ["model"] = model,
+                ["modified_at"] = new DateTime(2024, 1, 1, 0, 0, 0, DateTimeKind.Utc).ToString("o"),
+                ["size"] = 1L << 30,
+                ["digest"] = "stub" + SessionKeys.For("/api/tags", new JObject { ["model"] = model }),
+                ["details"] = new JObject
+                {
+                    ["format"] = "gguf",
+                    ["family"] = "stub",
+                    ["parameter_size"] = "1B",
+                    ["quantization_level"] = "Q4_0"
+                }
+            };
+        }
+
+        private JObject ShowModel(string model)
+        {
+            return new JObject
+            {
+                ["parameters"] = "stop \"<|end|>\"",
+                ["details"] = DescribeModel(model)["details"],
+                ["model_info"] = new JObject
+                {
+                    ["general.architecture"] = "stub",
+                    ["stub.context_length"] = _options.ContextLength
+                }
+            };
+        }
+
+        private JObject RunningModels()
+        {
+            var models = new JArray();
+            lock (_lock)
+            {
+                foreach (var model in _loadedModels)
+                {
+                    var entry = DescribeModel(model);
+                    entry["size_vram"] = entry["size"];
+                    entry["expires_at"] = DateTime.UtcNow.AddMinutes(5).ToString("o");
+                    models.Add(entry);
+                }
+            }
+            return new JObject { ["models"] = models };
+        }
+
+        /// <summary>
+        /// Marks a model as loaded, returning true if this request pays the load cost
+        /// </summary>
+        private bool MarkLoaded(string model)
+        {
+            lock (_lock)
+            {
+                return _loadedModels.Add(model);
+            }
+        }
+
+        private static List<string> GenerateWords(string key, int count)
+        {
+            // Seeded from the request so identical prompts get identical answers
+            var random = new Random(StableSeed(key));
+            var words = new List<string>(count);
+            for (int i = 0; i < count; i++)
+            {
+                string word = Words[random.Next(Words.Length)];
+                words.Add(i == 0 ? char.ToUpperInvariant(word[0]) + word.Substring(1) : " " + word);
+            }
+            if (count > 0)
+            {
+                words[count - 1] += ".";
+            }
+            return words;
+        }
+
+        private float[] GenerateEmbedding(string model, string text)
+        {
+            var key = SessionKeys.For("/api/embed", new JObject { ["model"] = model, ["input"] = text });
+            var random = new Random(StableSeed(key));
+            var vector = new float[_options.EmbedDimensions];
+            double norm = 0;
+            for (int i = 0; i < vector.Length; i++)
+            {
+                vector[i] = (float)(random.NextDouble() * 2 - 1);
+                norm += vector[i] * vector[i];
+            }
+            norm = Math.Sqrt(norm);
+            for (int i = 0; i < vector.Length; i++)
+            {
+                vector[i] = (float)(vector[i] / norm);
+            }
+            return vector;
+        }
+
+        #endregion
+
+        #region Replay
+
+        private async Task<bool> TryReplayAsync(HttpContext context, string path, JObject request, CancellationToken cancellationToken)
+        {
+            var entry = _library.Next(path, SessionKeys.For(path, request));
+            if (entry == null)
+                return false;
+
+            var clock = Stopwatch.StartNew();
+
+            if (path == "/api/chat" && entry.Status == 200 && entry.Tokens != null)
+            {
+                bool stream = request?["stream"]?.Value<bool?>() ?? true;
+                string model = (string)request?["model"] ?? entry.Model ?? _options.Model;
+
+                var delays = new List<double>(entry.Tokens.Count);
+                for (int i = 0; i < entry.Tokens.Count; i++)
+                {
+                    int delay = entry.Delays != null && i < entry.Delays.Count ? entry.Delays[i] : 0;
+                    delays.Add(i == 0 ? entry.FirstMs + delay : delay);
+                }
+
+                await WriteChatAsync(context, model, stream, entry.Tokens, delays, _options.Speed,
+                    entry.Done ?? new JObject { ["done_reason"] = "stop" }, clock, cancellationToken);
+                return true;
+            }
+
+            await DelayUntilAsync(clock, entry.FirstMs, _options.Speed, cancellationToken);
+            await WriteJsonAsync(context, entry.Status, entry.Body ?? new JObject());
+            return true;
+        }
+
+        #endregion
+
+        #region Record
+
+        private async Task RecordAsync(HttpContext context, string path, string body, CancellationToken cancellationToken)
+        {
+            var request = ParseBody(body);
+            var entry = new SessionEntry
+            {
+                Path = path,
+                Key = SessionKeys.For(path, request),
+                Model = (string)request?["model"]
+            };
+
+            if (path == "/api/chat" && request != null)
+            {
+                await RecordChatAsync(context, request, entry, cancellationToken);
+            }
+            else
+            {
+                var clock = Stopwatch.StartNew();
+                var method = new HttpMethod(context.Request.Method);
+                using (var upstreamRequest = new HttpRequestMessage(method, _options.UpstreamUrl + path))
+                {
+                    if (method != HttpMethod.Get && method != HttpMethod.Head)
+                    {
+                        upstreamRequest.Content = new StringContent(body, Encoding.UTF8, "application/json");
+                    }
+
+                    using (var response = await _upstream.SendAsync(upstreamRequest, cancellationToken))
+                    {
+                        string responseBody = await response.Content.ReadAsStringAsync();
+                        entry.Status = (int)response.StatusCode;
+                        entry.FirstMs = (int)clock.ElapsedMilliseconds;
+                        entry.Body = ParseBody(responseBody) ?? (JToken)responseBody;
+
+                        await WriteRawAsync(context, entry.Status, responseBody);
+                    }
+                }
+            }
+
+            _recorder.Append(entry);
+        }
+
+        private async Task RecordChatAsync(HttpContext context, JObject request, SessionEntry entry, CancellationToken cancellationToken)
+        {
+            bool clientStream = request["stream"]?.Value<bool?>() ?? true;
+
+            // Always stream from upstream so per-token timing is captured,
+            // then reassemble a single body for clients that didn't ask for a stream
+            request["stream"] = true;
+
+            var clock = Stopwatch.StartNew();
+            using (var upstreamRequest = new HttpRequestMessage(HttpMethod.Post, _options.UpstreamUrl + "/api/chat"))
+            {
+                upstreamRequest.Content = new StringContent(request.ToString(Formatting.None), Encoding.UTF8, "application/json");
+
+                using (var response = await _upstream.SendAsync(upstreamRequest, HttpCompletionOption.ResponseHeadersRead, cancellationToken))
+                {
+                    entry.Status = (int)response.StatusCode;
+                    if (!response.IsSuccessStatusCode)
+                    {
+                        string error = await response.Content.ReadAsStringAsync();
+                        entry.FirstMs = (int)clock.ElapsedMilliseconds;
+                        entry.Body = ParseBody(error) ?? (JToken)error;
+                        await WriteRawAsync(context, entry.Status, error);
+                        return;
+                    }
+
+                    entry.Delays = new List<int>();
+                    entry.Tokens = new List<string>();
+                    var content = new StringBuilder();
+                    double previous = -1;
+
+                    if (clientStream)
+                    {
+                        BeginStream(context);
+                    }
+
+                    using (var stream = await response.Content.ReadAsStreamAsync())
+                    using (var reader = new StreamReader(stream, Encoding.UTF8))
+                    {
+                        string line;
+                        while ((line = await reader.ReadLineAsync()) != null)
+                        {
+                            if (string.IsNullOrWhiteSpace(line))
+                                continue;
+
+                            double now = clock.Elapsed.TotalMilliseconds;
+                            var chunk = JObject.Parse(line);
+
+                            if (clientStream)
+                            {
+                                await WriteLineAsync(context, line, cancellationToken);
+                            }
+
+                            if (chunk["done"]?.Value<bool>() == true)
+                            {
+                                chunk.Remove("message");
+                                chunk.Remove("model");
+                                chunk.Remove("created_at");
+                                chunk.Remove("done");
+                                entry.Done = chunk;
+                                break;
+                            }
+
+                            string token = (string)chunk["message"]?["content"] ?? "";
+                            if (previous < 0)
+                            {
+                                entry.FirstMs = (int)Math.Round(now);
+                                entry.Delays.Add(0);
+                            }
+                            else
+                            {
+                                entry.Delays.Add((int)Math.Round(now - previous));
+                            }
+                            previous = now;
+                            entry.Tokens.Add(token);
+                            content.Append(token);
+                        }
+                    }
+
+                    if (!clientStream)
+                    {
+                        var result = new JObject
+                        {
+                            ["model"] = entry.Model,
+                            ["created_at"] = DateTime.UtcNow.ToString("o"),
+                            ["message"] = new JObject { ["role"] = "assistant", ["content"] = content.ToString() },
+                            ["done"] = true
+                        };
+                        if (entry.Done != null)
+                        {
+                            result.Merge(entry.Done);
+                        }
+                        await WriteJsonAsync(context, 200, result);
+                    }
+                }
+            }
+        }
+
+        #endregion
+
+        #region Output
+
+        /// <summary>
+        /// Writes a chat response, either as NDJSON chunks on a schedule or as one body
+        /// once the whole schedule has elapsed
+        /// </summary>
+        private async Task WriteChatAsync(HttpContext context, string model, bool stream,
+            IList<string> tokens, IList<double> delays, double speed, JObject done, Stopwatch clock, CancellationToken cancellationToken)
+        {
+            double due = 0;
+
+            if (stream)
+            {
+                BeginStream(context);
+                for (int i = 0; i < tokens.Count; i++)
+                {
+                    due += delays[i];
+                    await DelayUntilAsync(clock, due, speed, cancellationToken);
+
+                    var chunk = new JObject
+                    {
+                        ["model"] = model,
+                        ["created_at"] = DateTime.UtcNow.ToString("o"),
+                        ["message"] = new JObject { ["role"] = "assistant", ["content"] = tokens[i] },
+                        ["done"] = false
+                    };
+                    await WriteLineAsync(context, chunk.ToString(Formatting.None), cancellationToken);
+                }
+
+                var final = new JObject
+                {
+                    ["model"] = model,
+                    ["created_at"] = DateTime.UtcNow.ToString("o"),
+                    ["message"] = new JObject { ["role"] = "assistant", ["content"] = "" },
+                    ["done"] = true
+                };
+                final.Merge(done);
+                await WriteLineAsync(context, final.ToString(Formatting.None), cancellationToken);
+                return;
+            }
+
+            foreach (var delay in delays)
+            {
+                due += delay;
+            }
+            await DelayUntilAsync(clock, due, speed, cancellationToken);
+
+            var result = new JObject
+            {
+                ["model"] = model,
+                ["created_at"] = DateTime.UtcNow.ToString("o"),
+                ["message"] = new JObject { ["role"] = "assistant", ["content"] = string.Concat(tokens) },
+                ["done"] = true
+            };
+            result.Merge(done);
+            await WriteJsonAsync(context, 200, result);
+        }
+
+        private static void BeginStream(HttpContext context)
+        {
+            // No Content-Length, so Kestrel sends the body chunked
+            context.Response.StatusCode = 200;
+            context.Response.ContentType = "application/x-ndjson";
+        }
+
+        private static async Task WriteLineAsync(HttpContext context, string line, CancellationToken cancellationToken)
+        {
+            var bytes = Encoding.UTF8.GetBytes(line + "\n");
+            await context.Response.Body.WriteAsync(bytes, 0, bytes.Length, cancellationToken);
+            await context.Response.Body.FlushAsync(cancellationToken);
+        }
+
+        private static Task WriteJsonAsync(HttpContext context, int status, JToken body)
+        {
+            return WriteRawAsync(context, status, body.ToString(Formatting.None));
+        }
+
+        private static async Task WriteRawAsync(HttpContext context, int status, string body)
+        {
+            var bytes = Encoding.UTF8.GetBytes(body);
+            context.Response.StatusCode = status;
+            context.Response.ContentType = "application/json; charset=utf-8";
+            context.Response.ContentLength = bytes.Length;
+            await context.Response.Body.WriteAsync(bytes, 0, bytes.Length);
+        }
+
+        #endregion
+
+        /// <summary>
+        /// Waits until the given offset from the start of the request. Sleeps for the bulk
+        /// of the wait and spins for the last couple of milliseconds, since timer resolution
+        /// alone would add several milliseconds of jitter per token.
+        /// </summary>
+        private static async Task DelayUntilAsync(Stopwatch clock, double dueMs, double speed, CancellationToken cancellationToken)
+        {
+            if (speed <= 0)
+                return;
+
+            double target = dueMs / speed;
+            double remaining = target - clock.Elapsed.TotalMilliseconds;
+            if (remaining > 3)
+            {
+                await Task.Delay(TimeSpan.FromMilliseconds(remaining - 2), cancellationToken);
+            }
+
+            var spinner = new SpinWait();
+            while (clock.Elapsed.TotalMilliseconds < target)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                spinner.SpinOnce();
+            }
+        }
+
+        /// <summary>
+        /// Seed from a session key; string.GetHashCode is randomized per process on .NET Core
+        /// </summary>
+        private static int StableSeed(string key)
+        {
+            if (string.IsNullOrEmpty(key))
+                return 0;
+            return (int)Convert.ToUInt32(key.Substring(0, Math.Min(8, key.Length)), 16);
+        }
+
+        private static long ToNanoseconds(double milliseconds)
+        {
+            return (long)(milliseconds * 1000000);
+        }
+
+        private static JObject ParseBody(string body)
+        {
+            if (string.IsNullOrWhiteSpace(body))
+                return null;
+
+            try
+            {
+                return JObject.Parse(body);
+            }
+            catch (JsonException)
+            {
+                return null;
+            }
+        }
+
+        public void Dispose()
+        {
+            ((IDisposable)_app).Dispose();
+            _recorder?.Dispose();
+            _upstream?.Dispose();
+            _slots.Dispose();
+        }
+    }
+}
@@ -0,0 +1,100 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Text;
+
+namespace MSAgentAI.Tools.PipelineReplay
+{
+    /// <summary>
+    /// Latency samples grouped by command name, printed as a markdown table in microseconds
+    /// </summary>
+    public class LatencyReport
+    {
+        private readonly Dictionary<string, List<long>> _samples = new Dictionary<string, List<long>>();
+        private readonly List<long> _all = new List<long>();
+        private readonly object _lock = new object();
+
+        /// <summary>
+        /// Records one sample measured with Stopwatch.GetTimestamp
+        /// </summary>
+        public void Add(string command, long startTimestamp, long endTimestamp)
+        {
+            long elapsed = endTimestamp - startTimestamp;
+            lock (_lock)
+            {
+                if (!_samples.TryGetValue(command, out var list))
+                {
+                    list = new List<long>();
+                    _samples[command] = list;
+                }
+                list.Add(elapsed);
+                _all.Add(elapsed);
+            }
+        }
+
+        public int Count
+        {
+            get
+            {
+                lock (_lock)
+                {
+                    return _all.Count;
+                }
+            }
+        }
+
+        public string Format(string firstColumn)
+        {
+            var builder = new StringBuilder();
+            builder.AppendLine(string.Format(CultureInfo.InvariantCulture, "| {0,-16} | {1,8} | {2,9} | {3,9} | {4,9} | {5,9} | {6,9} |",
+                firstColumn, "n", "mean us", "p50 us", "p90 us", "p99 us", "max us"));
+            builder.AppendLine("|------------------|---------:|----------:|----------:|----------:|----------:|----------:|");
+
+            lock (_lock)
+            {
+                var names = new List<string>(_samples.Keys);
+                names.Sort(StringComparer.Ordinal);
+                foreach (var name in names)
+                {
+                    builder.AppendLine(Row(name, _samples[name]));
+                }
+                if (names.Count > 1)
+                {
+                    builder.AppendLine(Row("(all)", _all));
+                }
+            }
+            return builder.ToString();
+        }
+
+        private static string Row(string name, List<long> samples)
+        {
+            var sorted = samples.ToArray();
+            Array.Sort(sorted);
+
+            double total = 0;
+            foreach (long sample in sorted)
+            {
+                total += sample;
+            }
+
+            return string.Format(CultureInfo.InvariantCulture, "| {0,-16} | {1,8} | {2,9:F1} | {3,9:F1} | {4,9:F1} | {5,9:F1} | {6,9:F1} |",
+                name, sorted.Length, ToMicroseconds(total / Math.Max(1, sorted.Length)),
+                Percentile(sorted, 50), Percentile(sorted, 90), Percentile(sorted, 99), Percentile(sorted, 100));
+        }
+
+        private static double Percentile(long[] sorted, double p)
+        {
+            if (sorted.Length == 0)
+                return 0;
+
+            int index = (int)Math.Ceiling(p / 100.0 * sorted.Length) - 1;
+            return ToMicroseconds(sorted[Math.Max(0, Math.Min(sorted.Length - 1, index))]);
+        }
+
+        private static double ToMicroseconds(double ticks)
+        {
+            return ticks * 1_000_000.0 / Stopwatch.Frequency;
+        }
+    }
+}
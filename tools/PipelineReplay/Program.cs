@@ -0,0 +1,71 @@
+using System;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MSAgentAI.Tools.PipelineReplay
+{
+    /// <summary>
+    /// Plays back a pipeline recording so lag reported from the field can be reproduced
+    /// and measured away from the game that caused it.
+    /// </summary>
+    public static class Program
+    {
+        public static async Task<int> Main(string[] args)
+        {
+            ReplayOptions options;
+            try
+            {
+                options = ReplayOptions.Parse(args);
+            }
+            catch (ArgumentException ex)
+            {
+                Console.Error.WriteLine(ex.Message);
+                Console.Error.WriteLine();
+                Console.Error.WriteLine(ReplayOptions.Usage);
+                return 2;
+            }
+
+            using (var cts = new CancellationTokenSource())
+            {
+                Console.CancelKeyPress += (s, e) =>
+                {
+                    e.Cancel = true;
+                    cts.Cancel();
+                };
+
+                var replayer = new Replayer(options);
+                string target = options.Headless ? "headless server" : $"{options.Host}:{options.Port}";
+                string speed = options.Speed > 0 ? $"{options.Speed}x" : "no delays";
+                Console.WriteLine($"Replaying {options.FilePath} against {target} ({speed})");
+
+                try
+                {
+                    await replayer.RunAsync(cts.Token);
+                }
+                catch (OperationCanceledException)
+                {
+                    Console.WriteLine("Cancelled");
+                    return 1;
+                }
+                catch (Exception ex)
+                {
+                    Console.Error.WriteLine(ex.Message);
+                    return 1;
+                }
+
+                Console.WriteLine($"Recorded {replayer.RecordingStartedAt.ToLocalTime():yyyy-MM-dd HH:mm:ss}, {replayer.RecordedDuration.TotalSeconds:F1} s, {replayer.ConnectionCount} connection(s)");
+                Console.WriteLine($"Replayed in {replayer.ReplayDuration.TotalSeconds:F1} s: {replayer.Sent} sent, {replayer.Failed} failed, {replayer.Unanswered} unanswered");
+                Console.WriteLine();
+                Console.WriteLine("Send time to response, by command:");
+                Console.WriteLine();
+                Console.Write(replayer.Latency.Format("Command"));
+                Console.WriteLine();
+                Console.WriteLine("How late commands were sent compared with the recording:");
+                Console.WriteLine();
+                Console.Write(replayer.ScheduleLag.Format("Schedule"));
+            }
+
+            return 0;
+        }
+    }
+}
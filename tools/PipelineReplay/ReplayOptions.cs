@@ -0,0 +1,106 @@
+using System;
+using System.Globalization;
+
+namespace MSAgentAI.Tools.PipelineReplay
+{
+    /// <summary>
+    /// Command line options for the replayer
+    /// </summary>
+    public class ReplayOptions
+    {
+        // Recording written by PipelineServer.StartRecording
+        public string FilePath { get; set; }
+
+        // Server to replay against; null runs an in-process headless server
+        public string Host { get; set; }
+        public int Port { get; set; } = 8765;
+
+        // Timing multiplier (2 = twice as fast, 0 = no delays)
+        public double Speed { get; set; } = 1.0;
+
+        // How long to wait for outstanding responses once everything is sent
+        public int DrainMs { get; set; } = 10000;
+
+        public bool Headless => Host == null;
+
+        public const string Usage =
+@"Usage: PipelineReplay --file <recording.pipelog> [options]
+
+  --file <path>      Recording made with PipelineRecordEnabled
+  --target <t>       headless (default) or host:port of a running TCP pipeline
+  --speed <x>        Timing multiplier, 0 = no delays (default 1)
+  --drain-ms <n>     Wait for outstanding responses after the last send (default 10000)";
+
+        /// <summary>
+        /// Parses command line arguments, throwing ArgumentException on bad input
+        /// </summary>
+        public static ReplayOptions Parse(string[] args)
+        {
+            var options = new ReplayOptions();
+
+            for (int i = 0; i < args.Length; i++)
+            {
+                string arg = args[i];
+                string Next()
+                {
+                    if (i + 1 >= args.Length)
+                        throw new ArgumentException($"{arg} requires a value");
+                    return args[++i];
+                }
+
+                switch (arg)
+                {
+                    case "--file":
+                        options.FilePath = Next();
+                        break;
+                    case "--target":
+                        ParseTarget(options, Next());
+                        break;
+                    case "--speed":
+                        options.Speed = ParseDouble(arg, Next(), 0);
+                        break;
+                    case "--drain-ms":
+                        options.DrainMs = ParseInt(arg, Next(), 0, 600000);
+                        break;
+                    default:
+                        throw new ArgumentException($"Unknown option '{arg}'");
+                }
+            }
+
+            if (string.IsNullOrEmpty(options.FilePath))
+                throw new ArgumentException("--file is required");
+
+            return options;
+        }
+
+        private static void ParseTarget(ReplayOptions options, string value)
+        {
+            if (value.Equals("headless", StringComparison.OrdinalIgnoreCase))
+            {
+                options.Host = null;
+                return;
+            }
+
+            int colon = value.LastIndexOf(':');
+            if (colon <= 0)
+                throw new ArgumentException("--target must be headless or host:port");
+
+            options.Host = value.Substring(0, colon);
+            options.Port = ParseInt("--target port", value.Substring(colon + 1), 1, 65535);
+        }
+
+        private static int ParseInt(string name, string value, int min, int max)
+        {
+            if (!int.TryParse(value, NumberStyles.Integer, CultureInfo.InvariantCulture, out int result) || result < min || result > max)
+                throw new ArgumentException($"{name} must be between {min} and {max}");
+            return result;
+        }
+
+        private static double ParseDouble(string name, string value, double min)
+        {
+            if (!double.TryParse(value, NumberStyles.Float, CultureInfo.InvariantCulture, out double result) || result < min)
+                throw new ArgumentException($"{name} must be at least {min}");
+            return result;
+        }
+    }
+}
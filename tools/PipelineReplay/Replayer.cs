@@ -0,0 +1,296 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using MSAgentAI.Pipeline;
+
+namespace MSAgentAI.Tools.PipelineReplay
+{
+    /// <summary>
+    /// Sends a recording's commands to a TCP pipeline at their recorded times (scaled by
+    /// the speed), one TCP connection per recorded connection, and measures each command
+    /// from send to response.
+    /// </summary>
+    public class Replayer
+    {
+        private readonly ReplayOptions _options;
+        private readonly Dictionary<string, ReplayConnection> _connections = new Dictionary<string, ReplayConnection>();
+
+        public Replayer(ReplayOptions options)
+        {
+            _options = options;
+        }
+
+        /// <summary>
+        /// Command round trips, by command name
+        /// </summary>
+        public LatencyReport Latency { get; } = new LatencyReport();
+
+        /// <summary>
+        /// How late each command was sent relative to its scaled recorded time
+        /// </summary>
+        public LatencyReport ScheduleLag { get; } = new LatencyReport();
+
+        public int Sent { get; private set; }
+        public int Failed { get; private set; }
+        public int Unanswered { get; private set; }
+        public TimeSpan RecordedDuration { get; private set; }
+        public TimeSpan ReplayDuration { get; private set; }
+        public DateTime RecordingStartedAt { get; private set; }
+        public int ConnectionCount => _connections.Count;
+
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            List<RecordedCommand> commands;
+            using (var recording = new PipelineRecording(_options.FilePath))
+            {
+                RecordingStartedAt = recording.StartedAt;
+                // Commands from different connections can be written slightly out of order; the
+                // sort is stable, so each connection keeps its own order
+                commands = recording.ReadCommands().OrderBy(c => c.Offset).ToList();
+            }
+            if (commands.Count == 0)
+                return;
+            var origin = commands[0].Offset;
+            RecordedDuration = commands[commands.Count - 1].Offset - origin;
+
+            PipelineServer server = null;
+            string host = _options.Host;
+            int port = _options.Port;
+            if (_options.Headless)
+            {
+                // No UI or AI behind it, so this measures the pipeline alone
+                host = "127.0.0.1";
+                port = GetFreePort();
+                server = new PipelineServer("TCP", host, port, null) { DrainTimeout = TimeSpan.Zero };
+                server.Start();
+                await WaitForListenerAsync(host, port, cancellationToken);
+            }
+
+            try
+            {
+                var stopwatch = Stopwatch.StartNew();
+                long startTimestamp = Stopwatch.GetTimestamp();
+
+                foreach (var command in commands)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+
+                    long due = startTimestamp;
+                    if (_options.Speed > 0)
+                    {
+                        due += (long)((command.Offset - origin).Ticks / _options.Speed * Stopwatch.Frequency / TimeSpan.TicksPerSecond);
+                        await WaitUntilAsync(due, cancellationToken);
+                    }
+
+                    var connection = await GetConnectionAsync(command.ConnectionId, host, port);
+                    long sent = Stopwatch.GetTimestamp();
+                    if (connection != null && await connection.SendAsync(command.Line, sent))
+                    {
+                        Sent++;
+                        ScheduleLag.Add("lag", due, sent);
+                    }
+                    else
+                    {
+                        Failed++;
+                    }
+                }
+
+                // Wait for the last responses
+                var drainUntil = Stopwatch.GetTimestamp() + _options.DrainMs * Stopwatch.Frequency / 1000;
+                while (Stopwatch.GetTimestamp() < drainUntil && PendingCount() > 0)
+                {
+                    await Task.Delay(5, cancellationToken);
+                }
+                ReplayDuration = stopwatch.Elapsed;
+                Unanswered = PendingCount();
+            }
+            finally
+            {
+                foreach (var connection in _connections.Values)
+                {
+                    connection.Dispose();
+                }
+                server?.Dispose();
+            }
+        }
+
+        private int PendingCount()
+        {
+            int pending = 0;
+            foreach (var connection in _connections.Values)
+            {
+                pending += connection.Pending;
+            }
+            return pending;
+        }
+
+        /// <summary>
+        /// Sleeps most of the way, then spins so commands leave within microseconds of their time
+        /// </summary>
+        private static async Task WaitUntilAsync(long timestamp, CancellationToken cancellationToken)
+        {
+            long remaining = timestamp - Stopwatch.GetTimestamp();
+            long twoMs = Stopwatch.Frequency / 500;
+            if (remaining > twoMs)
+            {
+                await Task.Delay(TimeSpan.FromTicks((remaining - twoMs) * TimeSpan.TicksPerSecond / Stopwatch.Frequency), cancellationToken);
+            }
+
+            var spin = new SpinWait();
+            while (Stopwatch.GetTimestamp() < timestamp)
+            {
+                spin.SpinOnce(-1);
+            }
+        }
+
+        /// <summary>
+        /// Opens the connection standing in for a recorded one the first time it is used.
+        /// Commands that came in over UDP, the ring or HTTP are replayed over TCP too.
+        /// </summary>
+        private async Task<ReplayConnection> GetConnectionAsync(string id, string host, int port)
+        {
+            if (_connections.TryGetValue(id, out var connection))
+                return connection.IsOpen ? connection : null;
+
+            try
+            {
+                connection = await ReplayConnection.ConnectAsync(host, port, Latency);
+            }
+            catch (SocketException ex)
+            {
+                Console.Error.WriteLine($"Could not connect for {id}: {ex.Message}");
+                connection = ReplayConnection.Closed;
+            }
+            _connections[id] = connection;
+            return connection.IsOpen ? connection : null;
+        }
+
+        private static int GetFreePort()
+        {
+            var listener = new TcpListener(IPAddress.Loopback, 0);
+            listener.Start();
+            int port = ((IPEndPoint)listener.LocalEndpoint).Port;
+            listener.Stop();
+            return port;
+        }
+
+        private static async Task WaitForListenerAsync(string host, int port, CancellationToken cancellationToken)
+        {
+            for (int attempt = 0; attempt < 50; attempt++)
+            {
+                try
+                {
+                    using (var probe = new TcpClient())
+                    {
+                        await probe.ConnectAsync(host, port);
+                        return;
+                    }
+                }
+                catch (SocketException)
+                {
+                    await Task.Delay(20, cancellationToken);
+                }
+            }
+            throw new IOException($"Headless server did not start on {host}:{port}");
+        }
+
+        /// <summary>
+        /// One replayed connection. Responses arrive in the order the commands were sent,
+        /// so each one is matched to the oldest outstanding command.
+        /// </summary>
+        private sealed class ReplayConnection : IDisposable
+        {
+            public static readonly ReplayConnection Closed = new ReplayConnection();
+
+            private readonly TcpClient _client;
+            private readonly StreamWriter _writer;
+            private readonly ConcurrentQueue<Outstanding> _outstanding = new ConcurrentQueue<Outstanding>();
+            private readonly LatencyReport _latency;
+            private int _pending;
+            private volatile bool _open;
+
+            private ReplayConnection()
+            {
+            }
+
+            private ReplayConnection(TcpClient client, LatencyReport latency)
+            {
+                _client = client;
+                _latency = latency;
+                var stream = client.GetStream();
+                _writer = new StreamWriter(stream, new UTF8Encoding(false)) { AutoFlush = true };
+                _open = true;
+                _ = ReadResponsesAsync(new StreamReader(stream, Encoding.UTF8));
+            }
+
+            public bool IsOpen => _open;
+            public int Pending => Volatile.Read(ref _pending);
+
+            public static async Task<ReplayConnection> ConnectAsync(string host, int port, LatencyReport latency)
+            {
+                var client = new TcpClient { NoDelay = true };
+                await client.ConnectAsync(host, port);
+                return new ReplayConnection(client, latency);
+            }
+
+            public async Task<bool> SendAsync(string line, long timestamp)
+            {
+                PipelineServer.ParseCommandLine(line, out string command, out _, out _);
+                _outstanding.Enqueue(new Outstanding { Command = command, Timestamp = timestamp });
+                Interlocked.Increment(ref _pending);
+                try
+                {
+                    await _writer.WriteLineAsync(line);
+                    return true;
+                }
+                catch (Exception ex) when (ex is IOException || ex is ObjectDisposedException)
+                {
+                    _open = false;
+                    return false;
+                }
+            }
+
+            private async Task ReadResponsesAsync(StreamReader reader)
+            {
+                try
+                {
+                    string response;
+                    while ((response = await reader.ReadLineAsync()) != null)
+                    {
+                        long received = Stopwatch.GetTimestamp();
+                        if (_outstanding.TryDequeue(out var outstanding))
+                        {
+                            Interlocked.Decrement(ref _pending);
+                            _latency.Add(outstanding.Command, outstanding.Timestamp, received);
+                        }
+                    }
+                }
+                catch (Exception ex) when (ex is IOException || ex is ObjectDisposedException)
+                {
+                    // Connection closed
+                }
+                _open = false;
+            }
+
+            public void Dispose()
+            {
+                _open = false;
+                _client?.Dispose();
+            }
+
+            private struct Outstanding
+            {
+                public string Command;
+                public long Timestamp;
+            }
+        }
+    }
+}